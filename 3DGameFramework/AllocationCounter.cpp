@@ -0,0 +1,74 @@
+﻿#include "AllocationCounter.h"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace
+{
+	// ヒープ確保の回数
+	std::atomic<uint64_t> g_allocationCount(0);
+}
+
+// ヒープを確保する(配列版などの既定の実装もここを経由する)
+void* operator new(size_t size)
+{
+	g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	void* memory = malloc(size != 0 ? size : 1);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+// ヒープを解放する
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+// サイズ付きでヒープを解放する(C++14以降のコンパイラは既知のサイズの解放にこちらを使う)
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+// 既定より大きい合わせでヒープを確保する(alignasで合わせを指定した型のnewが使う。配列版の既定の実装もここを経由する)
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	size_t bytes = size_t(alignment);
+#ifdef _WIN32
+	void* memory = _aligned_malloc(size != 0 ? size : 1, bytes);
+#else
+	// aligned_allocのサイズは0でない合わせの倍数にする
+	size_t rounded = size != 0 ? (size + bytes - 1) / bytes * bytes : bytes;
+	void* memory = aligned_alloc(bytes, rounded);
+#endif
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+// 合わせを指定して確保したヒープを解放する
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+}
+
+// 合わせを指定して確保したヒープをサイズ付きで解放する
+void operator delete(void* memory, size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(memory, alignment);
+}
+
+// プログラム開始からのヒープ確保の回数を取得する
+uint64_t AllocationCounter::GetCount()
+{
+	return g_allocationCount.load(std::memory_order_relaxed);
+}
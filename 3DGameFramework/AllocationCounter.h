@@ -0,0 +1,16 @@
+﻿#pragma once
+#ifndef ALLOCATIONCOUNTER_DEFINED
+#define ALLOCATIONCOUNTER_DEFINED
+
+#include <stdint.h>
+
+// グローバルなoperator newの呼び出し回数を数える
+// (AllocationCounter.cppでoperator newとoperator deleteを置き換えている。定常状態のフレームがヒープを使っていないことの確認に使う)
+class AllocationCounter
+{
+public:
+	// プログラム開始からのヒープ確保の回数を取得する
+	static uint64_t GetCount();
+};
+
+#endif	// ALLOCATIONCOUNTER_DEFINED
@@ -0,0 +1,490 @@
+﻿#include "BoundingVolumeHierarchy.h"
+#include <algorithm>
+#include <array>
+#include <float.h>
+#include <math.h>
+#include <stdexcept>
+#include <string.h>
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "LinearArena.h"
+
+namespace
+{
+	// ビン
+	struct Bin
+	{
+		// 境界ボックス
+		MeshBounds bounds;
+		// プリミティブ数
+		uint32_t count;
+	};
+
+	// 範囲の集計結果
+	struct RangeInfo
+	{
+		// 境界ボックス
+		MeshBounds bounds;
+		// 中心の境界ボックス
+		MeshBounds centroidBounds;
+	};
+
+	// 空の境界ボックスを取得する
+	inline MeshBounds EmptyBounds()
+	{
+		return { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+	}
+
+	// 境界ボックスを広げる
+	inline void Grow(MeshBounds& bounds, const MeshBounds& other)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			bounds.minimum[axis] = std::min(bounds.minimum[axis], other.minimum[axis]);
+			bounds.maximum[axis] = std::max(bounds.maximum[axis], other.maximum[axis]);
+		}
+	}
+
+	// 点を含むように境界ボックスを広げる
+	inline void Grow(MeshBounds& bounds, const float* point)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			bounds.minimum[axis] = std::min(bounds.minimum[axis], point[axis]);
+			bounds.maximum[axis] = std::max(bounds.maximum[axis], point[axis]);
+		}
+	}
+
+	// 表面積の半分を取得する(空の場合は0)
+	inline float HalfArea(const MeshBounds& bounds)
+	{
+		float x = bounds.maximum[0] - bounds.minimum[0];
+		float y = bounds.maximum[1] - bounds.minimum[1];
+		float z = bounds.maximum[2] - bounds.minimum[2];
+		if (x < 0.0f || y < 0.0f || z < 0.0f)
+			return 0.0f;
+		return x * y + y * z + z * x;
+	}
+
+	// 境界ボックスが重なるかどうか
+	inline bool Overlaps(const MeshBounds& a, const MeshBounds& b)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (a.maximum[axis] < b.minimum[axis] || a.minimum[axis] > b.maximum[axis])
+				return false;
+		}
+		return true;
+	}
+
+	// レイと境界ボックスが交差する距離を取得する(交差しない場合はFLT_MAX)
+	inline float IntersectRay(const MeshBounds& bounds, const float* origin, const float* inverseDirection, float maxDistance)
+	{
+		float entry = 0.0f, leave = maxDistance;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float t0 = (bounds.minimum[axis] - origin[axis]) * inverseDirection[axis];
+			float t1 = (bounds.maximum[axis] - origin[axis]) * inverseDirection[axis];
+			if (t0 > t1)
+				std::swap(t0, t1);
+			entry = std::max(entry, t0);
+			leave = std::min(leave, t1);
+		}
+		return entry <= leave ? entry : FLT_MAX;
+	}
+
+	// ビン番号を取得する
+	inline uint32_t GetBin(float centroid, float minimum, float scale)
+	{
+		int bin = int((centroid - minimum) * scale);
+		return uint32_t(std::min(std::max(bin, 0), int(BoundingVolumeHierarchy::BIN_COUNT) - 1));
+	}
+
+	// 範囲を分割して並列または逐次に集計する
+	template <typename Result, typename Body, typename Merge>
+	Result Reduce(JobSystem* jobSystem, uint32_t start, uint32_t count, const Result& initial, Body body, Merge merge)
+	{
+		if (jobSystem == nullptr || count < BoundingVolumeHierarchy::PARALLEL_BINNING_SIZE)
+		{
+			Result result = initial;
+			body(start, start + count, result);
+			return result;
+		}
+
+		// 部分結果はスレッドの作業用アリーナに置き、構築のたびにヒープを使わないようにする
+		const size_t grainSize = BoundingVolumeHierarchy::PARALLEL_BINNING_SIZE / 4;
+		const size_t partialCount = (count + grainSize - 1) / grainSize;
+		LinearArena& arena = LinearArena::GetThreadArena();
+		ArenaScope scope(arena);
+		Result* partials = arena.AllocateArray<Result>(partialCount);
+		std::fill(partials, partials + partialCount, initial);
+		jobSystem->ParallelFor(count, grainSize, [&](size_t begin, size_t end)
+		{
+			body(start + uint32_t(begin), start + uint32_t(end), partials[begin / grainSize]);
+		});
+		Result result = initial;
+		for (size_t i = 0; i < partialCount; i++)
+		{
+			merge(result, partials[i]);
+		}
+		return result;
+	}
+}
+
+// コンストラクタ
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+	: m_usedNodes(0)
+{
+}
+
+// 境界ボックスの配列から構築する
+void BoundingVolumeHierarchy::Build(const MeshBounds* bounds, size_t count, JobSystem* jobSystem)
+{
+	if (count >= UINT32_MAX / 2)
+	{
+		throw std::length_error("BoundingVolumeHierarchy: too many primitives");
+	}
+
+	m_primitiveBounds.assign(bounds, bounds + count);
+	m_buildPrimitives.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		BuildPrimitive& primitive = m_buildPrimitives[i];
+		primitive.bounds = bounds[i];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			primitive.centroid[axis] = (bounds[i].minimum[axis] + bounds[i].maximum[axis]) * 0.5f;
+		}
+		primitive.index = uint32_t(i);
+	}
+
+	// ノード数は最大で2n-1になる
+	m_nodes.resize(std::max<size_t>(count * 2, 1));
+	m_usedNodes = 1;
+	BuildNode(0, 0, uint32_t(count), jobSystem);
+	m_nodes.resize(m_usedNodes);
+
+	// 葉の順に並んだプリミティブ番号を取り出す
+	m_primitives.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		m_primitives[i] = m_buildPrimitives[i].index;
+	}
+	m_buildPrimitives.clear();
+	m_buildPrimitives.shrink_to_fit();
+}
+
+// ノードを構築する
+void BoundingVolumeHierarchy::BuildNode(uint32_t nodeIndex, uint32_t start, uint32_t count, JobSystem* jobSystem)
+{
+	// 範囲の境界ボックスと中心の境界ボックスを求める
+	RangeInfo range = Reduce(jobSystem, start, count, RangeInfo{ EmptyBounds(), EmptyBounds() },
+		[this](uint32_t begin, uint32_t end, RangeInfo& info)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				Grow(info.bounds, m_buildPrimitives[i].bounds);
+				Grow(info.centroidBounds, m_buildPrimitives[i].centroid);
+			}
+		},
+		[](RangeInfo& result, const RangeInfo& partial)
+		{
+			Grow(result.bounds, partial.bounds);
+			Grow(result.centroidBounds, partial.centroidBounds);
+		});
+
+	BvhNode& node = m_nodes[nodeIndex];
+	node.bounds = count > 0 ? range.bounds : MeshBounds{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+	node.left = 0;
+	node.start = start;
+	node.count = count;
+	if (count <= MIN_SPLIT_SIZE)
+		return;
+
+	// 各軸のビンにプリミティブを振り分ける
+	typedef std::array<Bin, BIN_COUNT * 3> Bins;
+	float scales[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = range.centroidBounds.maximum[axis] - range.centroidBounds.minimum[axis];
+		scales[axis] = extent > 0.0f ? float(BIN_COUNT) / extent : 0.0f;
+	}
+	Bins emptyBins;
+	emptyBins.fill(Bin{ EmptyBounds(), 0 });
+	Bins bins = Reduce(jobSystem, start, count, emptyBins,
+		[this, &range, &scales](uint32_t begin, uint32_t end, Bins& result)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				const BuildPrimitive& primitive = m_buildPrimitives[i];
+				for (int axis = 0; axis < 3; axis++)
+				{
+					if (scales[axis] == 0.0f)
+						continue;
+					Bin& bin = result[axis * BIN_COUNT + GetBin(primitive.centroid[axis], range.centroidBounds.minimum[axis], scales[axis])];
+					Grow(bin.bounds, primitive.bounds);
+					bin.count++;
+				}
+			}
+		},
+		[](Bins& result, const Bins& partial)
+		{
+			for (size_t i = 0; i < result.size(); i++)
+			{
+				Grow(result[i].bounds, partial[i].bounds);
+				result[i].count += partial[i].count;
+			}
+		});
+
+	// ビンの境界ごとにSAHのコストを評価して最も安い分割を選ぶ
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	uint32_t bestSplit = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (scales[axis] == 0.0f)
+			continue;
+
+		const Bin* axisBins = &bins[axis * BIN_COUNT];
+		float rightCosts[BIN_COUNT];
+		MeshBounds rightBounds = EmptyBounds();
+		uint32_t rightCount = 0;
+		for (uint32_t i = BIN_COUNT - 1; i > 0; i--)
+		{
+			Grow(rightBounds, axisBins[i].bounds);
+			rightCount += axisBins[i].count;
+			rightCosts[i] = HalfArea(rightBounds) * float(rightCount);
+		}
+
+		MeshBounds leftBounds = EmptyBounds();
+		uint32_t leftCount = 0;
+		for (uint32_t split = 1; split < BIN_COUNT; split++)
+		{
+			Grow(leftBounds, axisBins[split - 1].bounds);
+			leftCount += axisBins[split - 1].count;
+			if (leftCount == 0 || leftCount == count)
+				continue;
+			float cost = HalfArea(leftBounds) * float(leftCount) + rightCosts[split];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	// 分割しない方が安い場合は葉にする
+	float leafCost = HalfArea(range.bounds) * float(count);
+	if (bestAxis >= 0 && bestCost >= leafCost && count <= MAX_LEAF_SIZE)
+		return;
+
+	// プリミティブを分割位置で並べ替える(分割できない場合は中央で分ける)
+	uint32_t leftCount = count / 2;
+	if (bestAxis >= 0)
+	{
+		float minimum = range.centroidBounds.minimum[bestAxis];
+		float scale = scales[bestAxis];
+		BuildPrimitive* first = &m_buildPrimitives[start];
+		BuildPrimitive* middle = std::partition(first, first + count, [&](const BuildPrimitive& primitive)
+		{
+			return GetBin(primitive.centroid[bestAxis], minimum, scale) < bestSplit;
+		});
+		leftCount = uint32_t(middle - first);
+	}
+	else if (count <= MAX_LEAF_SIZE)
+	{
+		return;
+	}
+
+	// 子は並んだ2つのノードに割り当てる
+	uint32_t left = m_usedNodes.fetch_add(2);
+	node.left = left;
+	if (jobSystem && count >= PARALLEL_BUILD_SIZE)
+	{
+		JobCounter counter;
+		jobSystem->Run([this, left, start, leftCount, jobSystem]() { BuildNode(left, start, leftCount, jobSystem); }, counter);
+		BuildNode(left + 1, start + leftCount, count - leftCount, jobSystem);
+		jobSystem->Wait(counter);
+	}
+	else
+	{
+		BuildNode(left, start, leftCount, jobSystem);
+		BuildNode(left + 1, start + leftCount, count - leftCount, jobSystem);
+	}
+}
+
+// 木の構造を保ったまま境界ボックスを更新する
+void BoundingVolumeHierarchy::Refit(const MeshBounds* bounds)
+{
+	std::copy(bounds, bounds + m_primitiveBounds.size(), m_primitiveBounds.begin());
+
+	// 子は親より後ろにあるので末尾から順に更新する
+	for (size_t i = m_nodes.size(); i-- > 0;)
+	{
+		BvhNode& node = m_nodes[i];
+		if (node.count == 0)
+			continue;
+
+		if (node.left == 0)
+		{
+			node.bounds = EmptyBounds();
+			for (uint32_t n = 0; n < node.count; n++)
+			{
+				Grow(node.bounds, m_primitiveBounds[m_primitives[node.start + n]]);
+			}
+		}
+		else
+		{
+			node.bounds = m_nodes[node.left].bounds;
+			Grow(node.bounds, m_nodes[node.left + 1].bounds);
+		}
+	}
+}
+
+// 視錐台と交差するプリミティブを判定する
+size_t BoundingVolumeHierarchy::CullFrustum(const FrustumCuller& culler, uint8_t* visible) const
+{
+	size_t primitiveCount = m_primitiveBounds.size();
+	memset(visible, 0, primitiveCount);
+	if (primitiveCount == 0)
+		return 0;
+
+	// ノードとまだ判定が必要な平面のビットマスクの組を辿る
+	const uint32_t allPlanes = (1u << FrustumCuller::PLANE_COUNT) - 1;
+	std::pair<uint32_t, uint32_t> stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = std::make_pair(0u, allPlanes);
+	size_t visibleCount = 0;
+	while (stackSize > 0)
+	{
+		uint32_t nodeIndex = stack[stackSize - 1].first;
+		uint32_t planeMask = stack[stackSize - 1].second;
+		stackSize--;
+		const BvhNode& node = m_nodes[nodeIndex];
+
+		float center[3], extent[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			center[axis] = (node.bounds.maximum[axis] + node.bounds.minimum[axis]) * 0.5f;
+			extent[axis] = (node.bounds.maximum[axis] - node.bounds.minimum[axis]) * 0.5f;
+		}
+
+		bool outside = false;
+		for (int p = 0; p < FrustumCuller::PLANE_COUNT && !outside; p++)
+		{
+			if ((planeMask & (1u << p)) == 0)
+				continue;
+			const float* plane = culler.GetPlane(p);
+			float distance = plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3];
+			float radius = fabsf(plane[0]) * extent[0] + fabsf(plane[1]) * extent[1] + fabsf(plane[2]) * extent[2];
+			outside = distance + radius < 0.0f;
+			// 平面の内側に完全に含まれる場合は子孫でその平面を判定しない
+			if (distance - radius >= 0.0f)
+				planeMask &= ~(1u << p);
+		}
+		if (outside)
+			continue;
+
+		// 完全に視錐台に含まれる場合と葉の場合は子孫のプリミティブをすべて見えるとする
+		if (planeMask == 0 || node.left == 0 || stackSize + 2 > 64)
+		{
+			bool test = planeMask != 0;
+			for (uint32_t n = 0; n < node.count; n++)
+			{
+				uint32_t primitive = m_primitives[node.start + n];
+				visible[primitive] = test ? uint8_t(culler.IsVisible(m_primitiveBounds[primitive])) : 1;
+				visibleCount += visible[primitive];
+			}
+			continue;
+		}
+		stack[stackSize++] = std::make_pair(node.left + 1, planeMask);
+		stack[stackSize++] = std::make_pair(node.left, planeMask);
+	}
+	return visibleCount;
+}
+
+// レイと最も近くで交差する境界ボックスのプリミティブ番号を取得する
+uint32_t BoundingVolumeHierarchy::Raycast(const float origin[3], const float direction[3], float maxDistance, float* hitDistance) const
+{
+	uint32_t result = NO_PRIMITIVE;
+	if (m_nodes.empty() || m_primitiveBounds.empty())
+		return result;
+
+	float inverseDirection[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		inverseDirection[axis] = direction[axis] != 0.0f ? 1.0f / direction[axis] : FLT_MAX;
+	}
+
+	float closest = maxDistance;
+	uint32_t stack[64];
+	int stackSize = 0;
+	if (IntersectRay(m_nodes[0].bounds, origin, inverseDirection, closest) != FLT_MAX)
+		stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BvhNode& node = m_nodes[stack[--stackSize]];
+		if (IntersectRay(node.bounds, origin, inverseDirection, closest) == FLT_MAX)
+			continue;
+
+		if (node.left == 0 || stackSize + 2 > 64)
+		{
+			for (uint32_t n = 0; n < node.count; n++)
+			{
+				uint32_t primitive = m_primitives[node.start + n];
+				float distance = IntersectRay(m_primitiveBounds[primitive], origin, inverseDirection, closest);
+				if (distance < closest || (distance == closest && distance != FLT_MAX && primitive < result))
+				{
+					closest = distance;
+					result = primitive;
+				}
+			}
+			continue;
+		}
+
+		// 近い子を先に辿る
+		float leftDistance = IntersectRay(m_nodes[node.left].bounds, origin, inverseDirection, closest);
+		float rightDistance = IntersectRay(m_nodes[node.left + 1].bounds, origin, inverseDirection, closest);
+		uint32_t nearChild = leftDistance <= rightDistance ? node.left : node.left + 1;
+		uint32_t farChild = leftDistance <= rightDistance ? node.left + 1 : node.left;
+		if (std::max(leftDistance, rightDistance) != FLT_MAX)
+			stack[stackSize++] = farChild;
+		if (std::min(leftDistance, rightDistance) != FLT_MAX)
+			stack[stackSize++] = nearChild;
+	}
+
+	if (hitDistance && result != NO_PRIMITIVE)
+		*hitDistance = closest;
+	return result;
+}
+
+// 境界ボックスと重なるプリミティブ番号を追加する
+void BoundingVolumeHierarchy::QueryOverlap(const MeshBounds& bounds, std::vector<uint32_t>& results) const
+{
+	if (m_nodes.empty() || m_primitiveBounds.empty())
+		return;
+
+	uint32_t stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BvhNode& node = m_nodes[stack[--stackSize]];
+		if (!Overlaps(node.bounds, bounds))
+			continue;
+
+		if (node.left == 0 || stackSize + 2 > 64)
+		{
+			for (uint32_t n = 0; n < node.count; n++)
+			{
+				uint32_t primitive = m_primitives[node.start + n];
+				if (Overlaps(m_primitiveBounds[primitive], bounds))
+					results.push_back(primitive);
+			}
+			continue;
+		}
+		stack[stackSize++] = node.left + 1;
+		stack[stackSize++] = node.left;
+	}
+}
@@ -0,0 +1,104 @@
+﻿#pragma once
+#ifndef BOUNDINGVOLUMEHIERARCHY_DEFINED
+#define BOUNDINGVOLUMEHIERARCHY_DEFINED
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "MeshData.h"
+
+class FrustumCuller;
+class JobSystem;
+
+// 境界ボリューム階層のノード
+struct BvhNode
+{
+	// 子孫のプリミティブをすべて含む境界ボックス
+	MeshBounds bounds;
+	// 左の子のノード番号(右の子は+1、葉の場合は0)
+	uint32_t left;
+	// 子孫のプリミティブの開始位置(プリミティブ番号配列内)
+	uint32_t start;
+	// 子孫のプリミティブ数
+	uint32_t count;
+};
+
+// 境界ボックスの配列からビン分割SAHで構築する境界ボリューム階層
+// 子のノード番号は常に親より大きく、各ノードの子孫のプリミティブはプリミティブ番号配列内で連続する
+class BoundingVolumeHierarchy
+{
+public:
+	// SAHのビン数
+	static const uint32_t BIN_COUNT = 16;
+	// 必ず葉にするプリミティブ数
+	static const uint32_t MIN_SPLIT_SIZE = 4;
+	// SAHで分割しない方が良い場合でも分割するプリミティブ数
+	static const uint32_t MAX_LEAF_SIZE = 16;
+	// 子をジョブとして並列に構築するプリミティブ数
+	static const uint32_t PARALLEL_BUILD_SIZE = 4096;
+	// ビン分割を並列に計算するプリミティブ数
+	static const uint32_t PARALLEL_BINNING_SIZE = 65536;
+	// 見つからないことを表すプリミティブ番号
+	static const uint32_t NO_PRIMITIVE = UINT32_MAX;
+
+	// コンストラクタ
+	BoundingVolumeHierarchy();
+
+	// 境界ボックスの配列から構築する(jobSystemが指定された場合は並列に構築する)
+	void Build(const MeshBounds* bounds, size_t count, JobSystem* jobSystem = nullptr);
+	// 木の構造を保ったまま境界ボックスを更新する(構築時と同じ数の境界ボックスを渡す)
+	void Refit(const MeshBounds* bounds);
+
+	// 視錐台と交差するプリミティブには1、それ以外には0を書き込む(交差する数を返す)
+	size_t CullFrustum(const FrustumCuller& culler, uint8_t* visible) const;
+	// レイと最も近くで交差する境界ボックスのプリミティブ番号を取得する(無い場合はNO_PRIMITIVE)
+	uint32_t Raycast(const float origin[3], const float direction[3], float maxDistance, float* hitDistance = nullptr) const;
+	// 境界ボックスと重なるプリミティブ番号を追加する
+	void QueryOverlap(const MeshBounds& bounds, std::vector<uint32_t>& results) const;
+
+	// ノード数を取得する
+	size_t GetNodeCount() const
+	{
+		return m_nodes.size();
+	}
+	// ノード配列を取得する
+	const BvhNode* GetNodes() const
+	{
+		return m_nodes.data();
+	}
+	// プリミティブ数を取得する
+	size_t GetPrimitiveCount() const
+	{
+		return m_primitiveBounds.size();
+	}
+
+private:
+	// 構築中のプリミティブ(連続したメモリ上で並べ替えるため境界ボックスと中心を持たせる)
+	struct BuildPrimitive
+	{
+		// 境界ボックス
+		MeshBounds bounds;
+		// 中心
+		float centroid[3];
+		// プリミティブ番号
+		uint32_t index;
+	};
+
+	// ノードを構築する
+	void BuildNode(uint32_t nodeIndex, uint32_t start, uint32_t count, JobSystem* jobSystem);
+
+private:
+	// ノード配列(0番が根)
+	std::vector<BvhNode> m_nodes;
+	// 葉の順に並べたプリミティブ番号
+	std::vector<uint32_t> m_primitives;
+	// プリミティブの境界ボックス
+	std::vector<MeshBounds> m_primitiveBounds;
+	// 構築中のプリミティブ
+	std::vector<BuildPrimitive> m_buildPrimitives;
+	// 構築中に使用したノード数
+	std::atomic<uint32_t> m_usedNodes;
+};
+
+#endif	// BOUNDINGVOLUMEHIERARCHY_DEFINED
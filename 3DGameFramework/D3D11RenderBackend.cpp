@@ -0,0 +1,110 @@
+﻿#include "D3D11RenderBackend.h"
+#include <algorithm>
+#include "InstancedEffect.h"
+
+// コンストラクタ
+D3D11RenderBackend::D3D11RenderBackend(ID3D11DeviceContext* context)
+	: m_context(context), m_shader(nullptr), m_mesh(nullptr), m_drawCalls(0), m_triangles(0)
+{
+}
+
+// シェーダを登録して番号を返す
+uint32_t D3D11RenderBackend::AddShader(DirectX::IEffect* effect, ID3D11InputLayout* inputLayout)
+{
+	m_shaders.push_back({ effect, dynamic_cast<DirectX::IEffectMatrices*>(effect), inputLayout });
+	return uint32_t(m_shaders.size() - 1);
+}
+
+// マテリアルを登録して番号を返す
+uint32_t D3D11RenderBackend::AddMaterial(ID3D11BlendState* blendState, ID3D11DepthStencilState* depthStencilState, ID3D11RasterizerState* rasterizerState)
+{
+	m_materials.push_back({ blendState, depthStencilState, rasterizerState });
+	return uint32_t(m_materials.size() - 1);
+}
+
+// メッシュを登録して番号を返す
+uint32_t D3D11RenderBackend::AddMesh(const StaticMesh* mesh)
+{
+	m_meshes.push_back(mesh);
+	return uint32_t(m_meshes.size() - 1);
+}
+
+// ビュー行列と射影行列を設定する
+void D3D11RenderBackend::SetViewProjection(const DirectX::SimpleMath::Matrix& view, const DirectX::SimpleMath::Matrix& projection)
+{
+	m_view = view;
+	m_projection = projection;
+}
+
+// パスを開始する
+void D3D11RenderBackend::BeginPass(uint32_t pass)
+{
+	// パスの間で他の描画が状態を変えている可能性があるので、設定中の状態を忘れる
+	m_shader = nullptr;
+	m_mesh = nullptr;
+}
+
+// シェーダを設定する
+void D3D11RenderBackend::SetShader(uint32_t shader)
+{
+	m_shader = &m_shaders.at(shader);
+	if (m_shader->matrices)
+	{
+		m_shader->matrices->SetView(m_view);
+		m_shader->matrices->SetProjection(m_projection);
+	}
+	m_context->IASetInputLayout(m_shader->inputLayout);
+}
+
+// マテリアルを設定する
+void D3D11RenderBackend::SetMaterial(uint32_t material)
+{
+	const Material& states = m_materials.at(material);
+	m_context->OMSetBlendState(states.blendState, nullptr, 0xFFFFFFFF);
+	m_context->OMSetDepthStencilState(states.depthStencilState, 0);
+	m_context->RSSetState(states.rasterizerState);
+}
+
+// メッシュを設定する
+void D3D11RenderBackend::SetMesh(uint32_t mesh)
+{
+	m_mesh = m_meshes.at(mesh);
+	m_mesh->Bind(m_context);
+}
+
+// 設定された状態で描画する
+void D3D11RenderBackend::Draw(const float* world)
+{
+	// ワールド行列は描画ごとに変わるので定数バッファの更新はここでおこなう
+	if (m_shader->matrices && world)
+	{
+		m_shader->matrices->SetWorld(DirectX::SimpleMath::Matrix(world));
+	}
+	m_shader->effect->Apply(m_context);
+	m_mesh->DrawRanges(m_context);
+	m_drawCalls += uint32_t(m_mesh->GetDrawCount());
+	m_triangles += m_mesh->GetTriangleCount();
+}
+
+// 設定された状態でインスタンスの数だけ描画する
+void D3D11RenderBackend::DrawInstanced(const InstanceData* instances, uint32_t count)
+{
+	if (!m_instanceBuffer)
+	{
+		Microsoft::WRL::ComPtr<ID3D11Device> device;
+		m_context->GetDevice(device.GetAddressOf());
+		m_instanceBuffer = std::make_unique<InstanceRingBuffer>(device.Get());
+	}
+
+	// 行列はインスタンスデータから読むので、エフェクトの設定は1回でよい
+	m_shader->effect->Apply(m_context);
+	// リングバッファの容量を超えるインスタンスは分けて描画する
+	for (uint32_t first = 0; first < count; first += m_instanceBuffer->GetCapacity())
+	{
+		UINT chunk = std::min(count - first, m_instanceBuffer->GetCapacity());
+		m_instanceBuffer->Append(m_context, InstancedEffect::INSTANCE_SLOT, instances + first, chunk);
+		m_mesh->DrawRangesInstanced(m_context, chunk);
+		m_drawCalls += uint32_t(m_mesh->GetDrawCount());
+		m_triangles += uint64_t(m_mesh->GetTriangleCount()) * chunk;
+	}
+}
@@ -0,0 +1,105 @@
+﻿#pragma once
+#ifndef D3D11RENDERBACKEND_DEFINED
+#define D3D11RENDERBACKEND_DEFINED
+
+#include <memory>
+#include <vector>
+#include "InstanceRingBuffer.h"
+#include "RenderQueue.h"
+#include "StaticMesh.h"
+
+// 描画コマンドをDirect3D 11とDirectXTKのエフェクトで実行するバックエンド
+// インスタンス描画はインスタンスデータをリングバッファに流し込み、InstancedEffect::INSTANCE_SLOTのスロットに設定して描画する
+class D3D11RenderBackend : public RenderBackend
+{
+public:
+	// コンストラクタ
+	D3D11RenderBackend(ID3D11DeviceContext* context);
+
+	// シェーダを登録して番号を返す
+	uint32_t AddShader(DirectX::IEffect* effect, ID3D11InputLayout* inputLayout);
+	// マテリアルを登録して番号を返す
+	uint32_t AddMaterial(ID3D11BlendState* blendState, ID3D11DepthStencilState* depthStencilState, ID3D11RasterizerState* rasterizerState);
+	// メッシュを登録して番号を返す
+	uint32_t AddMesh(const StaticMesh* mesh);
+	// ビュー行列と射影行列を設定する
+	void SetViewProjection(const DirectX::SimpleMath::Matrix& view, const DirectX::SimpleMath::Matrix& projection);
+
+	// パスを開始する
+	void BeginPass(uint32_t pass) override;
+	// シェーダを設定する
+	void SetShader(uint32_t shader) override;
+	// マテリアルを設定する
+	void SetMaterial(uint32_t material) override;
+	// メッシュを設定する
+	void SetMesh(uint32_t mesh) override;
+	// 設定された状態で描画する
+	void Draw(const float* world) override;
+	// 設定された状態でインスタンスの数だけ描画する(インスタンス描画用のシェーダが設定されていること)
+	void DrawInstanced(const InstanceData* instances, uint32_t count) override;
+
+	// 描画呼び出し数と三角形の数を0に戻す
+	void ResetStatistics()
+	{
+		m_drawCalls = 0;
+		m_triangles = 0;
+	}
+	// ResetStatisticsからの描画呼び出し数を取得する
+	uint32_t GetDrawCalls() const
+	{
+		return m_drawCalls;
+	}
+	// ResetStatisticsからの三角形の数を取得する
+	uint64_t GetTriangles() const
+	{
+		return m_triangles;
+	}
+
+private:
+	// シェーダ
+	struct Shader
+	{
+		// エフェクト
+		DirectX::IEffect* effect;
+		// 行列を設定するインターフェース(無い場合はnullptr)
+		DirectX::IEffectMatrices* matrices;
+		// インプットレイアウト
+		ID3D11InputLayout* inputLayout;
+	};
+	// マテリアル
+	struct Material
+	{
+		// ブレンドステート
+		ID3D11BlendState* blendState;
+		// 深度ステンシルステート
+		ID3D11DepthStencilState* depthStencilState;
+		// ラスタライザステート
+		ID3D11RasterizerState* rasterizerState;
+	};
+
+private:
+	// デバイスコンテキスト
+	ID3D11DeviceContext* m_context;
+	// シェーダ
+	std::vector<Shader> m_shaders;
+	// マテリアル
+	std::vector<Material> m_materials;
+	// メッシュ
+	std::vector<const StaticMesh*> m_meshes;
+	// ビュー行列
+	DirectX::SimpleMath::Matrix m_view;
+	// 射影行列
+	DirectX::SimpleMath::Matrix m_projection;
+	// 設定中のシェーダ
+	const Shader* m_shader;
+	// 設定中のメッシュ
+	const StaticMesh* m_mesh;
+	// インスタンスデータのリングバッファ(最初のインスタンス描画で生成する)
+	std::unique_ptr<InstanceRingBuffer> m_instanceBuffer;
+	// 描画呼び出し数
+	uint32_t m_drawCalls;
+	// 三角形の数
+	uint64_t m_triangles;
+};
+
+#endif	// D3D11RENDERBACKEND_DEFINED
@@ -4,13 +4,13 @@ const float DebugCamera::CAMERA_DISTANCE = 5.0f;
 
 // コンストラクタ
 DebugCamera::DebugCamera(int width, int height)
-	: m_yAngle(0.0f), m_xAngle(0.0f), m_xTmp(0.0f), m_yTmp(0.0f), m_x(0), m_y(0), m_scrollWheelValue(0)
+	: m_yAngle(0.0f), m_xAngle(0.0f), m_xTmp(0.0f), m_yTmp(0.0f), m_x(0), m_y(0), m_scrollWheelValue(0), m_scrollWheelOrigin(0)
 {
 	AdjustWindowScale(width, height);
 }
 
 // 更新する
-void DebugCamera::Update()
+void DebugCamera::Update(const InputState& input)
 {
 	// 視点ベクトル
 	DirectX::SimpleMath::Vector3 eye(0.0f, 0.0f, 1.0f);
@@ -19,44 +19,34 @@ void DebugCamera::Update()
 	// 上向きベクトル
 	DirectX::SimpleMath::Vector3 up(0.0f, 1.0f, 0.0f);
 
-	// マウスの状態を取得する
-	DirectX::Mouse::State state = DirectX::Mouse::Get().GetState();
-
-	// 相対モードの場合に戻る
-	if (state.positionMode == DirectX::Mouse::MODE_RELATIVE)
-		return;
-
-	// トラッキングを更新する
-	m_tracker.Update(state);
-
 	// マウスの左ボタンが押された場合
-	if (m_tracker.leftButton == DirectX::Mouse::ButtonStateTracker::ButtonState::PRESSED)
+	if (input.IsMousePressed(InputState::MOUSE_LEFT))
 	{
 		// マウスの座標を取得する
-		m_x = state.x;
-		m_y = state.y;
+		m_x = input.GetMouseX();
+		m_y = input.GetMouseY();
 	}
 	// マウスの左ボタンが解放された場合
-	else if (m_tracker.leftButton == DirectX::Mouse::ButtonStateTracker::ButtonState::RELEASED)
+	else if (input.IsMouseReleased(InputState::MOUSE_LEFT))
 	{
 		// 現在の回転を保存する
 		m_xAngle = m_xTmp;
 		m_yAngle = m_yTmp;
 	}
 	// マウスのボタンが押されていたらカメラを移動させる
-	if (state.leftButton)
+	if (input.IsMouseDown(InputState::MOUSE_LEFT))
 	{
-		Motion(state.x, state.y);
+		Motion(input.GetMouseX(), input.GetMouseY());
 	}
 
-	// マウスのホイール値を取得する
-	m_scrollWheelValue = state.scrollWheelValue;
+	// マウスのホイール値を取得する(入力は記録・再生するため、デバイスのホイール値はリセットせずに基準を移す)
+	m_scrollWheelValue = input.GetScrollWheel() - m_scrollWheelOrigin;
 	if (m_scrollWheelValue > 0)
 	{
 		// ホイール値を初期化する
 		m_scrollWheelValue = 0;
-		// スクロールホイール値をリセットする
-		DirectX::Mouse::Get().ResetScrollWheelValue();
+		// スクロールホイール値の基準を現在の値にする
+		m_scrollWheelOrigin = input.GetScrollWheel();
 	}
 
 	// ビュー行列を計算する
@@ -1,6 +1,8 @@
 ﻿#ifndef DEBUG_CAMERA
 #define DEBUG_CAMERA
 
+#include "InputState.h"
+
 class DebugCamera
 {
 private:
@@ -10,8 +12,8 @@ private:
 public:
 	// コンストラクタ
 	DebugCamera(int width, int height);
-	// デバッグカメラを更新する
-	void Update();
+	// 更新ごとの入力でデバッグカメラを更新する
+	void Update(const InputState& input);
 	// デバッグカメラのビュー行列を取得する
 	DirectX::SimpleMath::Matrix GetCameraMatrix() const;
 	// デバッグカメラの位置を取得する
@@ -37,12 +39,12 @@ private:
 	DirectX::SimpleMath::Matrix m_view;
 	// スクロールホイール値
 	int m_scrollWheelValue;
+	// スクロールホイール値の基準(ホイールを奥に回した累積値をここに戻す)
+	int m_scrollWheelOrigin;
 	// 視点
 	DirectX::SimpleMath::Vector3 m_eye;
 	// 注視点
 	DirectX::SimpleMath::Vector3 m_target;
-	// マウストラッカー
-	DirectX::Mouse::ButtonStateTracker m_tracker;
 };
 
 #endif	// DEBUG_CAMERA
@@ -0,0 +1,302 @@
+﻿#include "DebugDraw.h"
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+	// 番号を割り当てたデバッグ表示の数
+	std::atomic<uint64_t> s_instanceCount(0);
+	// 現在のスレッドのバッファを持つデバッグ表示の番号
+	thread_local uint64_t t_owner = 0;
+	// 現在のスレッドのバッファ
+	thread_local void* t_buffer = nullptr;
+
+	// 頂点を設定する
+	void SetVertex(MeshVertex& vertex, float x, float y, float z, const float color[4])
+	{
+		vertex = { { x, y, z }, { color[0], color[1], color[2], color[3] } };
+	}
+
+	// 単位円の座標を取得する(最初の呼び出しで計算する)
+	const float* GetUnitCircle()
+	{
+		struct UnitCircle
+		{
+			float points[DebugDraw::SPHERE_SEGMENTS][2];
+			UnitCircle()
+			{
+				for (int i = 0; i < DebugDraw::SPHERE_SEGMENTS; i++)
+				{
+					float angle = 6.2831853f * float(i) / float(DebugDraw::SPHERE_SEGMENTS);
+					points[i][0] = cosf(angle);
+					points[i][1] = sinf(angle);
+				}
+			}
+		};
+		static const UnitCircle circle;
+		return &circle.points[0][0];
+	}
+
+	// 4x4行列の逆行列を余因子展開で求める(行列式が0の場合はfalseを返す)
+	bool Invert(const float m[16], float result[16])
+	{
+		float inverse[16];
+		inverse[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+		inverse[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+		inverse[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+		inverse[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+		inverse[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+		inverse[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+		inverse[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+		inverse[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+		inverse[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+		inverse[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+		inverse[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+		inverse[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+		inverse[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+		inverse[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+		inverse[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+		inverse[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+		float determinant = m[0] * inverse[0] + m[1] * inverse[4] + m[2] * inverse[8] + m[3] * inverse[12];
+		if (determinant == 0.0f)
+			return false;
+		for (int i = 0; i < 16; i++)
+			result[i] = inverse[i] / determinant;
+		return true;
+	}
+
+	// 8頂点の直方体の12本の辺の頂点を書き込む(頂点番号のビット0がX、ビット1がY、ビット2がZ)
+	void SetBoxEdges(const float corners[8][3], const float color[4], MeshVertex vertices[24])
+	{
+		int count = 0;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			for (int bit = 1; bit < 8; bit <<= 1)
+			{
+				if (corner & bit)
+					continue;
+				const float* from = corners[corner];
+				const float* to = corners[corner | bit];
+				SetVertex(vertices[count++], from[0], from[1], from[2], color);
+				SetVertex(vertices[count++], to[0], to[1], to[2], color);
+			}
+		}
+	}
+}
+
+// 空にする
+void DebugDrawList::Clear()
+{
+	for (std::vector<MeshVertex>& vertices : lines)
+		vertices.clear();
+	labels.clear();
+	text.clear();
+}
+
+// 線分の数を取得する
+size_t DebugDrawList::GetLineCount() const
+{
+	size_t count = 0;
+	for (const std::vector<MeshVertex>& vertices : lines)
+		count += vertices.size() / 2;
+	return count;
+}
+
+// 共有のデバッグ表示を取得する
+DebugDraw& DebugDraw::Get()
+{
+	static DebugDraw debugDraw;
+	return debugDraw;
+}
+
+// コンストラクタ
+DebugDraw::DebugDraw()
+	: m_id(++s_instanceCount), m_enabled(true)
+{
+}
+
+// 現在のスレッドのバッファを取得する
+DebugDraw::ThreadBuffer& DebugDraw::GetThreadBuffer()
+{
+	if (t_owner != m_id)
+	{
+		// 別のデバッグ表示に積んでいたスレッドは、このデバッグ表示のバッファを探す
+		std::thread::id thread = std::this_thread::get_id();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		ThreadBuffer* found = nullptr;
+		for (const std::unique_ptr<ThreadBuffer>& buffer : m_buffers)
+		{
+			if (buffer->thread == thread)
+			{
+				found = buffer.get();
+				break;
+			}
+		}
+		if (found == nullptr)
+		{
+			// スレッドが終了してもバッファは残し、次のCollectで回収する
+			m_buffers.push_back(std::make_unique<ThreadBuffer>());
+			found = m_buffers.back().get();
+			found->thread = thread;
+		}
+		t_owner = m_id;
+		t_buffer = found;
+	}
+	return *static_cast<ThreadBuffer*>(t_buffer);
+}
+
+// 線分の頂点を積む
+void DebugDraw::AddVertices(const MeshVertex* vertices, size_t count, DebugDrawList::DepthMode depth)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.list.lines[depth].insert(buffer.list.lines[depth].end(), vertices, vertices + count);
+}
+
+// 線分を積む
+void DebugDraw::AddLine(const float from[3], const float to[3], const float color[4], DebugDrawList::DepthMode depth)
+{
+	if (!IsEnabled())
+		return;
+
+	MeshVertex vertices[2];
+	SetVertex(vertices[0], from[0], from[1], from[2], color);
+	SetVertex(vertices[1], to[0], to[1], to[2], color);
+	AddVertices(vertices, 2, depth);
+}
+
+// 軸平行境界ボックスを積む
+void DebugDraw::AddBox(const MeshBounds& bounds, const float color[4], DebugDrawList::DepthMode depth)
+{
+	if (!IsEnabled())
+		return;
+
+	float corners[8][3];
+	for (int corner = 0; corner < 8; corner++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+			corners[corner][axis] = (corner >> axis) & 1 ? bounds.maximum[axis] : bounds.minimum[axis];
+	}
+	MeshVertex vertices[24];
+	SetBoxEdges(corners, color, vertices);
+	AddVertices(vertices, 24, depth);
+}
+
+// 球を座標軸に垂直な3つの円で積む
+void DebugDraw::AddSphere(const float center[3], float radius, const float color[4], DebugDrawList::DepthMode depth)
+{
+	if (!IsEnabled())
+		return;
+
+	const float* circle = GetUnitCircle();
+	MeshVertex vertices[SPHERE_SEGMENTS * 6];
+	int count = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		// 円の面を張る2軸
+		int u = (axis + 1) % 3;
+		int v = (axis + 2) % 3;
+		for (int i = 0; i < SPHERE_SEGMENTS; i++)
+		{
+			int next = (i + 1) % SPHERE_SEGMENTS;
+			for (int end : { i, next })
+			{
+				float point[3] = { center[0], center[1], center[2] };
+				point[u] += circle[end * 2] * radius;
+				point[v] += circle[end * 2 + 1] * radius;
+				SetVertex(vertices[count++], point[0], point[1], point[2], color);
+			}
+		}
+	}
+	AddVertices(vertices, count, depth);
+}
+
+// ビュー射影行列の視錐台を積む
+void DebugDraw::AddFrustum(const float viewProjection[16], const float color[4], DebugDrawList::DepthMode depth)
+{
+	if (!IsEnabled())
+		return;
+
+	float inverse[16];
+	if (!Invert(viewProjection, inverse))
+		return;
+
+	// クリップ空間の立方体の頂点をワールド座標に戻す
+	float corners[8][3];
+	for (int corner = 0; corner < 8; corner++)
+	{
+		float clip[4] = { corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : 0.0f, 1.0f };
+		float world[4];
+		for (int column = 0; column < 4; column++)
+		{
+			world[column] = clip[0] * inverse[column] + clip[1] * inverse[4 + column] + clip[2] * inverse[8 + column] + clip[3] * inverse[12 + column];
+		}
+		for (int axis = 0; axis < 3; axis++)
+			corners[corner][axis] = world[axis] / world[3];
+	}
+	MeshVertex vertices[24];
+	SetBoxEdges(corners, color, vertices);
+	AddVertices(vertices, 24, depth);
+}
+
+// ワールド行列の座標軸を積む
+void DebugDraw::AddAxes(const float world[16], float length, DebugDrawList::DepthMode depth)
+{
+	if (!IsEnabled())
+		return;
+
+	const float colors[3][4] = { { 1.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f, 1.0f } };
+	MeshVertex vertices[6];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float* direction = world + axis * 4;
+		SetVertex(vertices[axis * 2], world[12], world[13], world[14], colors[axis]);
+		SetVertex(vertices[axis * 2 + 1], world[12] + direction[0] * length, world[13] + direction[1] * length,
+			world[14] + direction[2] * length, colors[axis]);
+	}
+	AddVertices(vertices, 6, depth);
+}
+
+// 文字列を積む
+void DebugDraw::AddText(const float position[3], const char* text, const float color[4])
+{
+	if (!IsEnabled())
+		return;
+
+	size_t length = strlen(text);
+	if (length > MAX_LABEL_LENGTH)
+		length = MAX_LABEL_LENGTH;
+
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	DebugDrawList& list = buffer.list;
+	list.labels.push_back({ { position[0], position[1], position[2] }, { color[0], color[1], color[2], color[3] },
+		uint32_t(list.text.size()), uint32_t(length) });
+	list.text.insert(list.text.end(), text, text + length);
+}
+
+// すべてのスレッドのバッファをリストにまとめ、バッファを空にする
+void DebugDraw::Collect(DebugDrawList& list)
+{
+	list.Clear();
+
+	// バッファは作成された順(そのデバッグ表示に初めて積んだスレッドの順)にまとめる
+	// ジョブシステムのワーカーから積んだ場合はワーカーへの仕事の割り振りが実行ごとに変わるので、リストの中の順は決まらない(描画結果は順に依存しない)
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const std::unique_ptr<ThreadBuffer>& buffer : m_buffers)
+	{
+		std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+		DebugDrawList& source = buffer->list;
+		for (int depth = 0; depth < DebugDrawList::DEPTH_MODE_COUNT; depth++)
+			list.lines[depth].insert(list.lines[depth].end(), source.lines[depth].begin(), source.lines[depth].end());
+		uint32_t textOffset = uint32_t(list.text.size());
+		for (const DebugLabel& label : source.labels)
+		{
+			list.labels.push_back(label);
+			list.labels.back().textOffset += textOffset;
+		}
+		list.text.insert(list.text.end(), source.text.begin(), source.text.end());
+		source.Clear();
+	}
+}
@@ -0,0 +1,125 @@
+﻿#pragma once
+#ifndef DEBUGDRAW_DEFINED
+#define DEBUGDRAW_DEFINED
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include "MeshData.h"
+#include "NonCopyable.h"
+
+// 文字列の表示位置
+struct DebugLabel
+{
+	// ワールド座標
+	float position[3];
+	// 色
+	float color[4];
+	// 文字列の開始位置(DebugDrawList::textの添字)
+	uint32_t textOffset;
+	// 文字列の長さ
+	uint32_t textLength;
+};
+
+// 1フレーム分のデバッグ表示(線分は深度の扱いごとに1回で描画できる線分リスト)
+struct DebugDrawList
+{
+	// 深度の扱い
+	enum DepthMode
+	{
+		// 深度テストをおこなう
+		DEPTH_TEST,
+		// 深度テストをおこなわずに手前に描く
+		NO_DEPTH,
+		// 種類の数
+		DEPTH_MODE_COUNT,
+	};
+
+	// 線分の頂点(2頂点で1本の線分)
+	std::vector<MeshVertex> lines[DEPTH_MODE_COUNT];
+	// 文字列の表示位置
+	std::vector<DebugLabel> labels;
+	// 文字列(終端文字を含まない)
+	std::vector<char> text;
+
+	// 空にする(確保した領域は残す)
+	void Clear();
+	// 線分の数を取得する
+	size_t GetLineCount() const;
+};
+
+// どのスレッドからでも呼び出せる即時モードのデバッグ表示
+// 呼び出しはスレッドごとのバッファに積まれ、Collectでまとめて深度の扱いごとに1つの線分リストになる
+class DebugDraw : public NonCopyable
+{
+public:
+	// 球を描く円の分割数
+	static const int SPHERE_SEGMENTS = 24;
+	// 文字列の最大長(これを超える部分は切り捨てる)
+	static const size_t MAX_LABEL_LENGTH = 64;
+
+	// 共有のデバッグ表示を取得する
+	static DebugDraw& Get();
+
+	// コンストラクタ
+	DebugDraw();
+
+	// 積むかどうか
+	bool IsEnabled() const
+	{
+		return m_enabled.load(std::memory_order_relaxed);
+	}
+	// 積むかどうかを設定する(無効な間の呼び出しはフラグの読み込み1回だけで戻る)
+	void SetEnabled(bool enabled)
+	{
+		m_enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	// 線分を積む
+	void AddLine(const float from[3], const float to[3], const float color[4], DebugDrawList::DepthMode depth = DebugDrawList::DEPTH_TEST);
+	// 軸平行境界ボックスを積む
+	void AddBox(const MeshBounds& bounds, const float color[4], DebugDrawList::DepthMode depth = DebugDrawList::DEPTH_TEST);
+	// 球を座標軸に垂直な3つの円で積む
+	void AddSphere(const float center[3], float radius, const float color[4], DebugDrawList::DepthMode depth = DebugDrawList::DEPTH_TEST);
+	// ビュー射影行列の視錐台を積む(行ベクトル規約、クリップ空間のzは0～w。逆行列が無い場合は何もしない)
+	void AddFrustum(const float viewProjection[16], const float color[4], DebugDrawList::DepthMode depth = DebugDrawList::DEPTH_TEST);
+	// ワールド行列の座標軸をX軸は赤、Y軸は緑、Z軸は青で積む
+	void AddAxes(const float world[16], float length, DebugDrawList::DepthMode depth = DebugDrawList::DEPTH_TEST);
+	// 文字列を積む(常に手前に表示する)
+	void AddText(const float position[3], const char* text, const float color[4]);
+
+	// すべてのスレッドのバッファをリストにまとめ、バッファを空にする(リストは先に空にされる。同じスレッドから積んだものは積んだ順に並ぶが、スレッドをまたいだ順は決まらない)
+	void Collect(DebugDrawList& list);
+
+private:
+	// スレッドごとのバッファ
+	struct ThreadBuffer
+	{
+		// 積む側とまとめる側の排他(所有スレッドとCollectしか使わないので通常は競合しない)
+		std::mutex mutex;
+		// 所有スレッド
+		std::thread::id thread;
+		// 積まれたデバッグ表示
+		DebugDrawList list;
+	};
+
+	// 現在のスレッドのバッファを取得する(初めて積むスレッドでは作成する)
+	ThreadBuffer& GetThreadBuffer();
+	// 線分の頂点を積む
+	void AddVertices(const MeshVertex* vertices, size_t count, DebugDrawList::DepthMode depth);
+
+private:
+	// スレッドごとのバッファを見分ける番号
+	uint64_t m_id;
+	// 積むかどうか
+	std::atomic<bool> m_enabled;
+	// スレッドごとのバッファ
+	std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+	// バッファの一覧を保護するミューテックス
+	std::mutex m_mutex;
+};
+
+#endif	// DEBUGDRAW_DEFINED
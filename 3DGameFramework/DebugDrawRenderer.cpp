@@ -0,0 +1,77 @@
+﻿#include "DebugDrawRenderer.h"
+
+// コンストラクタ
+DebugDrawRenderer::DebugDrawRenderer(ID3D11Device* device, DirectX::CommonStates* states)
+	: m_states(states),
+	m_depthTestedLines(GeometryBuffer::DYNAMIC, sizeof(DirectX::VertexPositionColor), D3D11_PRIMITIVE_TOPOLOGY_LINELIST),
+	m_overlayLines(GeometryBuffer::DYNAMIC, sizeof(DirectX::VertexPositionColor), D3D11_PRIMITIVE_TOPOLOGY_LINELIST)
+{
+	static_assert(sizeof(MeshVertex) == sizeof(DirectX::VertexPositionColor), "MeshVertex must match VertexPositionColor layout");
+
+	// 頂点カラーで描画するエフェクトを生成する
+	m_basicEffect = std::make_unique<DirectX::BasicEffect>(device);
+	m_basicEffect->SetVertexColorEnabled(true);
+	void const* shaderByteCode;
+	size_t byteCodeLength;
+	m_basicEffect->GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
+	// インプットレイアウトを生成する
+	DX::ThrowIfFailed(device->CreateInputLayout(DirectX::VertexPositionColor::InputElements,
+		DirectX::VertexPositionColor::InputElementCount,
+		shaderByteCode, byteCodeLength,
+		m_inputLayout.ReleaseAndGetAddressOf()));
+}
+
+// 描画する
+void DebugDrawRenderer::Render(ID3D11DeviceContext* context, const DebugDrawList& list, const DirectX::SimpleMath::Matrix& view, const DirectX::SimpleMath::Matrix& projection,
+	DirectX::SpriteBatch* spriteBatch, DirectX::SpriteFont* spriteFont, int width, int height)
+{
+	const std::vector<MeshVertex>& depthTested = list.lines[DebugDrawList::DEPTH_TEST];
+	const std::vector<MeshVertex>& overlay = list.lines[DebugDrawList::NO_DEPTH];
+	if (!depthTested.empty() || !overlay.empty())
+	{
+		m_basicEffect->SetWorld(DirectX::SimpleMath::Matrix::Identity);
+		m_basicEffect->SetView(view);
+		m_basicEffect->SetProjection(projection);
+		m_basicEffect->Apply(context);
+		context->IASetInputLayout(m_inputLayout.Get());
+		context->OMSetBlendState(m_states->Opaque(), nullptr, 0xFFFFFFFF);
+		context->RSSetState(m_states->CullNone());
+
+		// 深度テストをおこなう線分を描画してから、手前に描く線分を描画する
+		m_depthTestedLines.SetVertices(context, depthTested.data(), UINT(depthTested.size()));
+		context->OMSetDepthStencilState(m_states->DepthDefault(), 0);
+		m_depthTestedLines.Draw(context);
+		m_overlayLines.SetVertices(context, overlay.data(), UINT(overlay.size()));
+		context->OMSetDepthStencilState(m_states->DepthNone(), 0);
+		m_overlayLines.Draw(context);
+	}
+
+	if (!list.labels.empty())
+		RenderLabels(list, view * projection, spriteBatch, spriteFont, width, height);
+}
+
+// 文字列を描画する
+void DebugDrawRenderer::RenderLabels(const DebugDrawList& list, const DirectX::SimpleMath::Matrix& viewProjection,
+	DirectX::SpriteBatch* spriteBatch, DirectX::SpriteFont* spriteFont, int width, int height)
+{
+	spriteBatch->Begin(DirectX::SpriteSortMode_Deferred, m_states->NonPremultiplied());
+	wchar_t text[DebugDraw::MAX_LABEL_LENGTH + 1];
+	for (const DebugLabel& label : list.labels)
+	{
+		// カメラの後ろにある文字列は描画しない
+		DirectX::SimpleMath::Vector4 clip = DirectX::SimpleMath::Vector4::Transform(
+			DirectX::SimpleMath::Vector4(label.position[0], label.position[1], label.position[2], 1.0f), viewProjection);
+		if (clip.w <= 0.0f)
+			continue;
+
+		// 文字列はASCIIとしてワイド文字に広げる
+		const char* source = list.text.data() + label.textOffset;
+		for (uint32_t i = 0; i < label.textLength; i++)
+			text[i] = wchar_t(static_cast<unsigned char>(source[i]));
+		text[label.textLength] = L'\0';
+
+		DirectX::SimpleMath::Vector2 position((clip.x / clip.w * 0.5f + 0.5f) * float(width), (0.5f - clip.y / clip.w * 0.5f) * float(height));
+		spriteFont->DrawString(spriteBatch, text, position, DirectX::XMVectorSet(label.color[0], label.color[1], label.color[2], label.color[3]));
+	}
+	spriteBatch->End();
+}
@@ -0,0 +1,37 @@
+﻿#pragma once
+#ifndef DEBUGDRAWRENDERER_DEFINED
+#define DEBUGDRAWRENDERER_DEFINED
+
+#include "DebugDraw.h"
+#include "GeometryBuffer.h"
+
+// まとめたデバッグ表示を描画する
+// 線分は深度テストあり・なしの動的頂点バッファにそれぞれ1回で描画し、文字列はSpriteBatchでまとめて描画する
+class DebugDrawRenderer
+{
+public:
+	// コンストラクタ
+	DebugDrawRenderer(ID3D11Device* device, DirectX::CommonStates* states);
+	// 描画する
+	void Render(ID3D11DeviceContext* context, const DebugDrawList& list, const DirectX::SimpleMath::Matrix& view, const DirectX::SimpleMath::Matrix& projection,
+		DirectX::SpriteBatch* spriteBatch, DirectX::SpriteFont* spriteFont, int width, int height);
+
+private:
+	// 文字列を描画する
+	void RenderLabels(const DebugDrawList& list, const DirectX::SimpleMath::Matrix& viewProjection,
+		DirectX::SpriteBatch* spriteBatch, DirectX::SpriteFont* spriteFont, int width, int height);
+
+private:
+	// エフェクト
+	std::unique_ptr<DirectX::BasicEffect> m_basicEffect;
+	// インプットレイアウト
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> m_inputLayout;
+	// コモンステートへのポインタ
+	DirectX::CommonStates* m_states;
+	// 深度テストをおこなう線分
+	GeometryBuffer m_depthTestedLines;
+	// 深度テストをおこなわない線分
+	GeometryBuffer m_overlayLines;
+};
+
+#endif	// DEBUGDRAWRENDERER_DEFINED
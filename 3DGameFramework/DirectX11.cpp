@@ -210,6 +210,41 @@ void DirectX11::CreateResources()
 	// TODO: EBhETCYɈˑIuWFNg
 }
 
+// o̓TCYݒ肵ă\[X𐶐
+void DirectX11::Resize(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+	CreateResources();
+}
+
+// obNobt@NAă_[^[Qbgɐݒ肷
+void DirectX11::Clear(const float color[4])
+{
+	// _[^[Qbgr[NA
+	m_context->ClearRenderTargetView(m_renderTargetView.Get(), color);
+	// fvXXeVr[NA
+	m_context->ClearDepthStencilView(m_depthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+	// _[^[Qbgݒ肷
+	m_context->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), m_depthStencilView.Get());
+	// r[|[gݒ肷
+	CD3D11_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(m_width), static_cast<float>(m_height));
+	m_context->RSSetViewports(1, &viewport);
+}
+
+// obNobt@XN[ɑ
+void DirectX11::Present(bool vsync)
+{
+	// ҂ꍇVSync܂ŃubNA\Ȃt[̕`CPUgȂ
+	HRESULT hr = m_swapChain->Present(vsync ? 1 : 0, 0);
+
+	// foCXZbgꂽꍇ_ďKv
+	if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET)
+		OnDeviceLost();
+	else
+		DX::ThrowIfFailed(hr);
+}
+
 // foCXXgꍇɌĂяo
 void DirectX11::OnDeviceLost() 
 {
@@ -16,11 +16,12 @@
 
 #include "StepTimer.h"
 #include "NonCopyable.h"
+#include "RenderDevice.h"
 
 using namespace std;
 
 // DirectX11NX
-class DirectX11 : public NonCopyable
+class DirectX11 : public NonCopyable, public RenderDevice
 {
 public:
 	// VOg
@@ -112,11 +113,20 @@ public:
 	}
 
 	// foCX𐶐
-	void CreateDevice();
+	void CreateDevice() override;
 
 	// \[X𐶐
 	void CreateResources();
 
+	// o̓TCYݒ肵ă\[X𐶐
+	void Resize(int width, int height) override;
+
+	// obNobt@NAă_[^[Qbgɐݒ肷
+	void Clear(const float color[4]) override;
+
+	// obNobt@XN[ɑ
+	void Present(bool vsync) override;
+
 	// foCXXgꍇ
 	void OnDeviceLost();
 
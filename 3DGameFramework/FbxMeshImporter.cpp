@@ -0,0 +1,187 @@
+﻿#include "FbxMeshImporter.h"
+#include <exception>
+#include <stdexcept>
+#include "JobSystem.h"
+#include "MeshConverter.h"
+#include "MeshFile.h"
+#include "MeshSimplifier.h"
+#include "Profiler.h"
+
+// FBXファイルをインポートしてメッシュに変換する
+std::vector<MeshData> FbxMeshImporter::Import(const char* filename, const MeshImportOptions& options,
+	std::vector<MeshOptimizerReport>* reports)
+{
+	PROFILE_SCOPE("FbxMeshImporter::Import");
+	// FbxManagerとFbxSceneオブジェクトを作成する
+	FbxManager* manager = FbxManager::Create();
+	FbxIOSettings* ios = FbxIOSettings::Create(manager, IOSROOT);
+	manager->SetIOSettings(ios);
+	FbxScene* scene = FbxScene::Create(manager, "");
+
+	// データをインポートする
+	FbxImporter* importer = FbxImporter::Create(manager, "");
+	if (!importer->Initialize(filename, -1, manager->GetIOSettings()) || !importer->Import(scene))
+	{
+		std::string message = std::string("FbxMeshImporter: ") + importer->GetStatus().GetErrorString();
+		manager->Destroy();
+		throw std::runtime_error(message);
+	}
+	importer->Destroy();
+
+	// 三角ポリゴン化する(シーンを書き換えるので逐次でおこなう)
+	FbxGeometryConverter geometryConverter(manager);
+	geometryConverter.Triangulate(scene, true);
+
+	// シーンを一度だけ辿り変換タスクの一覧を作成する
+	std::vector<FbxMeshTask> tasks;
+	FbxNode* root = scene->GetRootNode();
+	if (root)
+	{
+		for (int i = 0; i < root->GetChildCount(); i++)
+		{
+			CollectMeshes(root->GetChild(i), tasks);
+		}
+	}
+
+	// 独立したメッシュを並列に変換し、結果は走査順の位置に格納して順序を決定的にする
+	std::vector<MeshData> meshes(tasks.size());
+	std::vector<MeshOptimizerReport> taskReports(tasks.size());
+	std::vector<std::exception_ptr> errors(tasks.size());
+	auto convert = [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			PROFILE_SCOPE("ConvertMesh");
+			try
+			{
+				ConvertMesh(tasks[i], options.optimize, meshes[i], taskReports[i]);
+			}
+			catch (...)
+			{
+				errors[i] = std::current_exception();
+			}
+		}
+	};
+	if (options.jobSystem)
+	{
+		options.jobSystem->ParallelFor(tasks.size(), 1, convert);
+	}
+	else
+	{
+		convert(0, tasks.size());
+	}
+
+	// 変換後はFBX SDKのオブジェクトは不要なので解放する
+	manager->Destroy();
+
+	for (const std::exception_ptr& error : errors)
+	{
+		if (error)
+			std::rethrow_exception(error);
+	}
+	// 変換したメッシュから詳細度を生成する(メッシュごとに並列)
+	if (options.lodLevels > 0)
+	{
+		PROFILE_SCOPE("GenerateLods");
+		MeshSimplifier::GenerateLods(meshes, options.lodLevels, options.jobSystem);
+	}
+	if (reports && options.optimize)
+	{
+		reports->insert(reports->end(), taskReports.begin(), taskReports.end());
+	}
+	return meshes;
+}
+
+// FBXファイルをバイナリメッシュファイルにベイクする
+void FbxMeshImporter::Bake(const char* filename, const char* meshFilename, const MeshImportOptions& options,
+	std::vector<MeshOptimizerReport>* reports)
+{
+	std::vector<MeshData> meshes = Import(filename, options, reports);
+	PROFILE_SCOPE("MeshFile::Write");
+	MeshFile::Write(meshFilename, meshes, options.quantizeVertices ? MeshFile::VERTEX_FORMAT_QUANTIZED : MeshFile::VERTEX_FORMAT_FLOAT);
+}
+
+// ノードを辿って変換タスクを集める
+void FbxMeshImporter::CollectMeshes(FbxNode* node, std::vector<FbxMeshTask>& tasks)
+{
+	FbxNodeAttribute* attribute = node->GetNodeAttribute();
+	if (attribute && attribute->GetAttributeType() == FbxNodeAttribute::eMesh)
+	{
+		FbxMesh* mesh = static_cast<FbxMesh*>(attribute);
+		if (mesh->IsTriangleMesh())
+		{
+			FbxMeshTask task;
+			task.name = node->GetName();
+			task.mesh = mesh;
+
+			// ノードのグローバル行列とジオメトリック変換を合成する(評価はキャッシュを書き換えるので走査中におこなう)
+			FbxAMatrix geometry(node->GetGeometricTranslation(FbxNode::eSourcePivot),
+				node->GetGeometricRotation(FbxNode::eSourcePivot),
+				node->GetGeometricScaling(FbxNode::eSourcePivot));
+			task.world = node->EvaluateGlobalTransform() * geometry;
+
+			// マテリアル名を取得する
+			for (int i = 0; i < node->GetMaterialCount(); i++)
+			{
+				task.materialNames.push_back(node->GetMaterial(i)->GetName());
+			}
+
+			// ポリゴンごとのマテリアル番号を取得する
+			FbxGeometryElementMaterial* element = mesh->GetElementMaterial();
+			if (element && !task.materialNames.empty())
+			{
+				const FbxLayerElementArrayTemplate<int>& indexArray = element->GetIndexArray();
+				bool allSame = element->GetMappingMode() == FbxGeometryElement::eAllSame;
+				task.polygonMaterials.resize(mesh->GetPolygonCount());
+				for (int p = 0; p < mesh->GetPolygonCount(); p++)
+				{
+					int index = allSame ? 0 : p;
+					int material = index < indexArray.GetCount() ? indexArray.GetAt(index) : 0;
+					task.polygonMaterials[p] = (material >= 0 && material < int(task.materialNames.size())) ? material : 0;
+				}
+			}
+
+			tasks.push_back(std::move(task));
+		}
+	}
+
+	for (int i = 0; i < node->GetChildCount(); i++)
+	{
+		CollectMeshes(node->GetChild(i), tasks);
+	}
+}
+
+// 変換タスクを実行する
+void FbxMeshImporter::ConvertMesh(const FbxMeshTask& task, bool optimize, MeshData& mesh, MeshOptimizerReport& report)
+{
+	std::vector<const char*> materialNames;
+	for (const std::string& name : task.materialNames)
+	{
+		materialNames.push_back(name.c_str());
+	}
+
+	MeshSource source;
+	source.name = task.name.c_str();
+	source.controlPoints = reinterpret_cast<const double*>(task.mesh->GetControlPoints());
+	source.controlPointCount = task.mesh->GetControlPointsCount();
+	source.polygonVertices = task.mesh->GetPolygonVertices();
+	source.polygonVertexCount = task.mesh->GetPolygonVertexCount();
+	source.polygonMaterials = task.polygonMaterials.empty() ? nullptr : task.polygonMaterials.data();
+	source.materialNames = materialNames.data();
+	source.materialCount = int(materialNames.size());
+	for (int row = 0; row < 4; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			source.worldMatrix[row * 4 + column] = task.world.Get(row, column);
+		}
+	}
+
+	MeshConverter::Convert(source, mesh);
+
+	// GPUのキャッシュ効率が上がるように並べ替える
+	if (optimize)
+	{
+		report = MeshOptimizer::Optimize(mesh);
+	}
+}
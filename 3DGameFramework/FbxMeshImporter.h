@@ -0,0 +1,63 @@
+﻿#pragma once
+#ifndef FBXMESHIMPORTER_DEFINED
+#define FBXMESHIMPORTER_DEFINED
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fbxsdk.h>
+#include "MeshData.h"
+#include "MeshOptimizer.h"
+
+class JobSystem;
+
+// インポートオプション
+struct MeshImportOptions
+{
+	// ベイクで生成する詳細度の数
+	static const uint32_t DEFAULT_LOD_LEVELS = 3;
+
+	// 頂点キャッシュ・オーバードロー・頂点フェッチの最適化をおこなう
+	bool optimize;
+	// メッシュを並列に変換するジョブシステム(nullptrの場合は逐次変換する)
+	JobSystem* jobSystem;
+	// メッシュごとに生成する詳細度の最大数(0の場合は生成しない)
+	uint32_t lodLevels;
+	// ベイクするファイルの頂点を量子化する(位置は境界ボックスに対する16ビット、色はRGBA8)
+	bool quantizeVertices;
+};
+
+// シーン走査で集めたメッシュごとの変換タスク
+struct FbxMeshTask
+{
+	// ノード名
+	std::string name;
+	// メッシュ
+	FbxMesh* mesh;
+	// ワールド行列
+	FbxAMatrix world;
+	// マテリアル名
+	std::vector<std::string> materialNames;
+	// ポリゴンごとのマテリアル番号
+	std::vector<int> polygonMaterials;
+};
+
+// FBXファイルを読み込みMeshDataの配列に変換するクラス
+class FbxMeshImporter
+{
+public:
+	// FBXファイルをインポートしてメッシュに変換する(最適化した場合はメッシュごとの統計を返す)
+	static std::vector<MeshData> Import(const char* filename, const MeshImportOptions& options = MeshImportOptions(),
+		std::vector<MeshOptimizerReport>* reports = nullptr);
+	// FBXファイルをバイナリメッシュファイルにベイクする
+	static void Bake(const char* filename, const char* meshFilename, const MeshImportOptions& options = MeshImportOptions(),
+		std::vector<MeshOptimizerReport>* reports = nullptr);
+
+private:
+	// ノードを辿って変換タスクを集める
+	static void CollectMeshes(FbxNode* node, std::vector<FbxMeshTask>& tasks);
+	// 変換タスクを実行する
+	static void ConvertMesh(const FbxMeshTask& task, bool optimize, MeshData& mesh, MeshOptimizerReport& report);
+};
+
+#endif	// FBXMESHIMPORTER_DEFINED
@@ -0,0 +1,163 @@
+﻿// FrameClock.h - タイマーが使用する時刻の取得と待機をおこなうクロックソース
+
+#pragma once
+#ifndef DX_FRAMECLOCK_DEFINED
+#define DX_FRAMECLOCK_DEFINED
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <chrono>
+#include <stdexcept>
+#include <stdint.h>
+#include <thread>
+
+namespace DX
+{
+    // 単調増加するカウンタと待機を提供するクロックソース
+    class ClockSource
+    {
+    public:
+        ClockSource() :
+            m_sleepEstimate(0),
+            m_spinMargin(0)
+        {
+        }
+
+        virtual ~ClockSource() {}
+
+        // 現在のカウンタ値を取得する
+        virtual uint64_t GetCounter() = 0;
+
+        // 1秒あたりのカウンタ値を取得する
+        virtual uint64_t GetFrequency() const = 0;
+
+        // 指定されたカウンタ値になるまで待機する
+        // OSのスリープは精度が低いので、観測したスリープ時間より残りが短くなったらスピンで待つ
+        virtual void WaitUntil(uint64_t counter)
+        {
+            if (m_spinMargin == 0)
+            {
+                // 最初のスリープ時間の見積もりを1ミリ秒、スピンの余裕を0.5ミリ秒とする
+                m_sleepEstimate = GetFrequency() / 1000;
+                m_spinMargin = GetFrequency() / 2000;
+            }
+
+            for (;;)
+            {
+                uint64_t now = GetCounter();
+                if (now >= counter)
+                {
+                    return;
+                }
+
+                if (counter - now > m_sleepEstimate + m_spinMargin)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+                    // 実際にスリープした時間の移動平均で見積もりを更新する(大きくなる方向にはすぐ追従する)
+                    uint64_t slept = GetCounter() - now;
+                    m_sleepEstimate = slept > m_sleepEstimate ? slept : (m_sleepEstimate * 7 + slept) / 8;
+                }
+            }
+        }
+
+    private:
+        // 1回のスリープにかかる時間の見積もり
+        uint64_t m_sleepEstimate;
+        // スピンで待機する余裕
+        uint64_t m_spinMargin;
+    };
+
+    // std::chrono::steady_clockを使用するクロックソース(Linuxではclock_gettime(CLOCK_MONOTONIC)になる)
+    class SteadyClock : public ClockSource
+    {
+    public:
+        uint64_t GetCounter() override
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        uint64_t GetFrequency() const override				{ return 1000000000; }
+    };
+
+#ifdef _WIN32
+    // QueryPerformanceCounterを使用するクロックソース
+    class QpcClock : public ClockSource
+    {
+    public:
+        QpcClock()
+        {
+            LARGE_INTEGER frequency;
+            if (!QueryPerformanceFrequency(&frequency))
+            {
+                throw std::runtime_error("QueryPerformanceFrequency");
+            }
+            m_frequency = frequency.QuadPart;
+        }
+
+        uint64_t GetCounter() override
+        {
+            LARGE_INTEGER counter;
+            if (!QueryPerformanceCounter(&counter))
+            {
+                throw std::runtime_error("QueryPerformanceCounter");
+            }
+            return counter.QuadPart;
+        }
+
+        uint64_t GetFrequency() const override				{ return m_frequency; }
+
+    private:
+        // 1秒あたりのカウンタ値
+        uint64_t m_frequency;
+    };
+#endif
+
+    // 明示的に進めたときだけ時刻が変わる決定的なクロックソース(テストや記録の再生に使用する)
+    class VirtualClock : public ClockSource
+    {
+    public:
+        explicit VirtualClock(uint64_t frequency = 10000000) :
+            m_counter(0),
+            m_frequency(frequency)
+        {
+        }
+
+        uint64_t GetCounter() override						{ return m_counter; }
+        uint64_t GetFrequency() const override				{ return m_frequency; }
+
+        // 待機せずにカウンタを指定された値まで進める
+        void WaitUntil(uint64_t counter) override
+        {
+            if (counter > m_counter)
+            {
+                m_counter = counter;
+            }
+        }
+
+        // カウンタを進める
+        void Advance(uint64_t counts)						{ m_counter += counts; }
+        void AdvanceSeconds(double seconds)					{ m_counter += static_cast<uint64_t>(seconds * m_frequency); }
+
+    private:
+        // 現在のカウンタ値
+        uint64_t m_counter;
+        // 1秒あたりのカウンタ値
+        uint64_t m_frequency;
+    };
+
+    // プラットフォームの既定のクロックソースを取得する
+    inline ClockSource& GetDefaultClock()
+    {
+#ifdef _WIN32
+        static QpcClock clock;
+#else
+        static SteadyClock clock;
+#endif
+        return clock;
+    }
+}
+
+#endif	// DX_FRAMECLOCK_DEFINED
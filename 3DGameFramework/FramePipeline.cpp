@@ -0,0 +1,112 @@
+﻿#include "FramePipeline.h"
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+#include "Profiler.h"
+
+// コンストラクタ
+FramePipeline::FramePipeline()
+	: m_stopping(false), m_frameLatency(1), m_snapshotCount(2), m_published(0), m_acquired(0)
+{
+}
+
+// デストラクタ
+FramePipeline::~FramePipeline()
+{
+	Stop();
+}
+
+// 更新スレッドを開始する
+void FramePipeline::Start(int frameLatency, Producer producer)
+{
+	if (frameLatency < 1 || frameLatency > MAX_FRAME_LATENCY)
+	{
+		throw std::out_of_range("FramePipeline: frame latency must be 1-3");
+	}
+	Stop();
+
+	m_producer = std::move(producer);
+	m_stopping = false;
+	m_frameLatency = frameLatency;
+	m_snapshotCount = frameLatency + 1;
+	m_published = m_acquired = 0;
+	m_thread = std::thread(&FramePipeline::ProducerMain, this);
+}
+
+// 更新スレッドを停止する
+void FramePipeline::Stop()
+{
+	if (!m_thread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_condition.notify_all();
+	m_thread.join();
+}
+
+// 描画を待っている最も古いスナップショットを取得する
+int FramePipeline::Acquire(uint32_t timeoutMilliseconds)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (!m_condition.wait_for(lock, std::chrono::milliseconds(timeoutMilliseconds), [this]() { return m_published > m_acquired; }))
+		return -1;
+
+	// 描画を終えたスナップショットを手放し、次のフレームのスナップショットを描画側のものにする
+	int readIndex = int(m_acquired % uint64_t(m_snapshotCount));
+	m_acquired++;
+	lock.unlock();
+
+	// 先行数の上限で待っている更新スレッドを起こす
+	m_condition.notify_all();
+	return readIndex;
+}
+
+// 公開されたフレーム数を取得する
+uint64_t FramePipeline::GetPublishedFrames() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_published;
+}
+
+// 描画に取得されたフレーム数を取得する
+uint64_t FramePipeline::GetAcquiredFrames() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_acquired;
+}
+
+// 更新スレッドの処理
+void FramePipeline::ProducerMain()
+{
+	Profiler::Get().SetThreadName("Update");
+	for (;;)
+	{
+		int writeIndex;
+		{
+			// 描画が始まっていないフレームが上限に達している間は更新しない
+			// (上限未満なら書き込み先は描画中のスナップショットとも描画待ちのスナップショットとも重ならない)
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stopping || m_published - m_acquired < uint64_t(m_frameLatency); });
+			if (m_stopping)
+				return;
+			writeIndex = int(m_published % uint64_t(m_snapshotCount));
+		}
+
+		// 書き込み中のスナップショットは更新側だけが触れるのでロックせずに書き込む
+		if (!m_producer(writeIndex))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		{
+			// 書き込んだスナップショットを描画を待つ列の最後に公開する
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_published++;
+		}
+		m_condition.notify_all();
+	}
+}
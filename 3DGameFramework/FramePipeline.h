@@ -0,0 +1,75 @@
+﻿#pragma once
+#ifndef FRAMEPIPELINE_DEFINED
+#define FRAMEPIPELINE_DEFINED
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include "NonCopyable.h"
+
+// 更新スレッドでフレームN+1を更新しながら、呼び出し元のスレッドでフレームNを描画する2段のパイプライン
+// スナップショットは先行できるフレーム数+1個を順に使うリングで受け渡す(描画中の1つと、公開済みで描画を待つ最大frameLatency個)
+// 先行できるフレーム数が2以上の場合は公開したフレームが描画を待つ列に並び、上書きせずに公開した順にすべて描画される
+class FramePipeline : public NonCopyable
+{
+public:
+	// 描画が始まっていないフレームを更新が先行できる最大数
+	static const int MAX_FRAME_LATENCY = 3;
+	// スナップショットの数(書き込み先は描画中と描画待ちのものと重ならない)
+	static const int SNAPSHOT_COUNT = MAX_FRAME_LATENCY + 1;
+
+	// 更新してスナップショットを書き込む関数(公開しない場合はfalseを返す)
+	typedef std::function<bool(int snapshot)> Producer;
+
+	// コンストラクタ
+	FramePipeline();
+	// デストラクタ
+	~FramePipeline();
+
+	// 更新スレッドを開始する(frameLatencyは1～MAX_FRAME_LATENCY)
+	void Start(int frameLatency, Producer producer);
+	// 更新スレッドを停止する(実行中の更新が終わるまで待つ)
+	void Stop();
+	// 更新スレッドが実行中かどうか
+	bool IsRunning() const
+	{
+		return m_thread.joinable();
+	}
+
+	// 描画を待っている最も古いスナップショットを取得する(無い場合は公開されるまで待ち、タイムアウトした場合は-1を返す)
+	// 取得したスナップショットは次に取得するまで描画側が所有する
+	int Acquire(uint32_t timeoutMilliseconds);
+
+	// 公開されたフレーム数を取得する
+	uint64_t GetPublishedFrames() const;
+	// 描画に取得されたフレーム数を取得する
+	uint64_t GetAcquiredFrames() const;
+
+private:
+	// 更新スレッドの処理
+	void ProducerMain();
+
+private:
+	// 更新スレッド
+	std::thread m_thread;
+	// 更新関数
+	Producer m_producer;
+	// 状態を保護するミューテックス
+	mutable std::mutex m_mutex;
+	// 公開または取得を通知する条件変数
+	std::condition_variable m_condition;
+	// 停止を要求されたかどうか
+	bool m_stopping;
+	// 描画が始まっていないフレームを更新が先行できる数
+	int m_frameLatency;
+	// 使うスナップショットの数(フレームnはスナップショットn % m_snapshotCountに書き込む)
+	int m_snapshotCount;
+	// 公開されたフレーム数
+	uint64_t m_published;
+	// 描画に取得されたフレーム数
+	uint64_t m_acquired;
+};
+
+#endif	// FRAMEPIPELINE_DEFINED
@@ -0,0 +1,185 @@
+﻿#include "FrameStatistics.h"
+#include <algorithm>
+#include <stdexcept>
+
+// コンストラクタ
+FrameStatistics::FrameStatistics()
+	: m_stageCount(0), m_counterCount(0)
+{
+	Clear();
+}
+
+// 処理段階を登録して番号を返す
+int FrameStatistics::AddStage(const char* name)
+{
+	if (m_stageCount == MAX_STAGES)
+		throw std::out_of_range("FrameStatistics: too many stages");
+
+	Stage& stage = m_stages[m_stageCount];
+	stage.name = name;
+	stage.current = 0.0;
+	std::fill(stage.history, stage.history + WINDOW_SIZE, 0.0f);
+	stage.sum = 0.0;
+	return m_stageCount++;
+}
+
+// カウンタを登録して番号を返す
+int FrameStatistics::AddCounter(const char* name)
+{
+	if (m_counterCount == MAX_COUNTERS)
+		throw std::out_of_range("FrameStatistics: too many counters");
+
+	m_counters[m_counterCount] = { name, 0, 0 };
+	return m_counterCount++;
+}
+
+// 現在のフレームの処理段階に時間を加える
+void FrameStatistics::AddStageTime(int stage, double seconds)
+{
+	CheckStage(stage);
+	m_stages[stage].current += seconds;
+}
+
+// 現在のフレームのカウンタの値を設定する
+void FrameStatistics::SetCounter(int counter, uint64_t value)
+{
+	CheckCounter(counter);
+	m_counters[counter].current = value;
+}
+
+// 現在のフレームをフレーム時間とともに確定する
+void FrameStatistics::EndFrame(double frameSeconds)
+{
+	// 窓から外れるフレームを合計から除いてから書き込む(合計は保存した精度の値で増減させる)
+	bool full = m_count == WINDOW_SIZE;
+	if (full)
+		m_frameTimeSum -= m_frameTimes[m_next];
+	else
+		m_count++;
+	m_frameTimes[m_next] = float(frameSeconds);
+	m_frameTimeSum += m_frameTimes[m_next];
+	m_histogram.Add(frameSeconds);
+
+	for (int i = 0; i < m_stageCount; i++)
+	{
+		Stage& stage = m_stages[i];
+		if (full)
+			stage.sum -= stage.history[m_next];
+		stage.history[m_next] = float(stage.current);
+		stage.sum += stage.history[m_next];
+		stage.current = 0.0;
+	}
+	for (int i = 0; i < m_counterCount; i++)
+	{
+		m_counters[i].last = m_counters[i].current;
+		m_counters[i].current = 0;
+	}
+	m_next = (m_next + 1) % WINDOW_SIZE;
+}
+
+// 集計したフレームを除く
+void FrameStatistics::Clear()
+{
+	std::fill(m_frameTimes, m_frameTimes + WINDOW_SIZE, 0.0f);
+	m_frameTimeSum = 0.0;
+	m_next = 0;
+	m_count = 0;
+	m_histogram.Clear();
+	for (int i = 0; i < m_stageCount; i++)
+	{
+		m_stages[i].current = 0.0;
+		std::fill(m_stages[i].history, m_stages[i].history + WINDOW_SIZE, 0.0f);
+		m_stages[i].sum = 0.0;
+	}
+	for (int i = 0; i < m_counterCount; i++)
+	{
+		m_counters[i].current = 0;
+		m_counters[i].last = 0;
+	}
+}
+
+// フレーム時間を取得する
+double FrameStatistics::GetFrameTime(size_t age) const
+{
+	if (age >= m_count)
+		throw std::out_of_range("FrameStatistics: frame age out of range");
+	return m_frameTimes[(m_next + WINDOW_SIZE - 1 - age) % WINDOW_SIZE];
+}
+
+// 最小のフレーム時間を取得する
+double FrameStatistics::GetMinimum() const
+{
+	if (m_count == 0)
+		return 0.0;
+	return *std::min_element(m_frameTimes, m_frameTimes + m_count);
+}
+
+// 平均のフレーム時間を取得する
+double FrameStatistics::GetAverage() const
+{
+	return m_count != 0 ? m_frameTimeSum / m_count : 0.0;
+}
+
+// 最大のフレーム時間を取得する
+double FrameStatistics::GetMaximum() const
+{
+	if (m_count == 0)
+		return 0.0;
+	return *std::max_element(m_frameTimes, m_frameTimes + m_count);
+}
+
+// 指定された時間を超えたフレームの数を取得する
+size_t FrameStatistics::CountFramesOver(double seconds) const
+{
+	return size_t(std::count_if(m_frameTimes, m_frameTimes + m_count, [seconds](float time) { return time > seconds; }));
+}
+
+// 処理段階の名前を取得する
+const char* FrameStatistics::GetStageName(int stage) const
+{
+	CheckStage(stage);
+	return m_stages[stage].name;
+}
+
+// 処理段階の平均時間を取得する
+double FrameStatistics::GetStageAverage(int stage) const
+{
+	CheckStage(stage);
+	return m_count != 0 ? m_stages[stage].sum / m_count : 0.0;
+}
+
+// 処理段階の最大時間を取得する
+double FrameStatistics::GetStageMaximum(int stage) const
+{
+	CheckStage(stage);
+	const float* history = m_stages[stage].history;
+	return m_count != 0 ? *std::max_element(history, history + m_count) : 0.0;
+}
+
+// カウンタの名前を取得する
+const char* FrameStatistics::GetCounterName(int counter) const
+{
+	CheckCounter(counter);
+	return m_counters[counter].name;
+}
+
+// 最新のフレームのカウンタの値を取得する
+uint64_t FrameStatistics::GetCounter(int counter) const
+{
+	CheckCounter(counter);
+	return m_counters[counter].last;
+}
+
+// 処理段階の番号を確認する
+void FrameStatistics::CheckStage(int stage) const
+{
+	if (stage < 0 || stage >= m_stageCount)
+		throw std::out_of_range("FrameStatistics: stage out of range");
+}
+
+// カウンタの番号を確認する
+void FrameStatistics::CheckCounter(int counter) const
+{
+	if (counter < 0 || counter >= m_counterCount)
+		throw std::out_of_range("FrameStatistics: counter out of range");
+}
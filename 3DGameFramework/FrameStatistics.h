@@ -0,0 +1,129 @@
+﻿#pragma once
+#ifndef FRAMESTATISTICS_DEFINED
+#define FRAMESTATISTICS_DEFINED
+
+#include <stdint.h>
+#include "Profiler.h"
+
+// フレーム時間、処理段階ごとの時間、カウンタを直近のフレームにわたって集計する(描画APIに依存しない)
+// 1フレームの間にAddStageTimeとSetCounterで値を集め、EndFrameで確定する
+class FrameStatistics
+{
+public:
+	// 集計する直近のフレーム数
+	static const size_t WINDOW_SIZE = FrameTimeHistogram::WINDOW_SIZE;
+	// 処理段階の最大数
+	static const int MAX_STAGES = 8;
+	// カウンタの最大数
+	static const int MAX_COUNTERS = 8;
+
+	// コンストラクタ
+	FrameStatistics();
+
+	// 処理段階を登録して番号を返す(名前は集計が終わるまで有効な文字列であること)
+	int AddStage(const char* name);
+	// カウンタを登録して番号を返す(名前は集計が終わるまで有効な文字列であること)
+	int AddCounter(const char* name);
+	// 現在のフレームの処理段階に時間(秒)を加える
+	void AddStageTime(int stage, double seconds);
+	// 現在のフレームのカウンタの値を設定する
+	void SetCounter(int counter, uint64_t value);
+	// 現在のフレームをフレーム時間(秒)とともに確定する
+	void EndFrame(double frameSeconds);
+	// 集計したフレームを除く(登録した処理段階とカウンタは残す)
+	void Clear();
+
+	// 集計しているフレーム数を取得する
+	size_t GetFrameCount() const
+	{
+		return m_count;
+	}
+	// フレーム時間(秒)を取得する(0が最新のフレーム)
+	double GetFrameTime(size_t age) const;
+	// 最小のフレーム時間(秒)を取得する
+	double GetMinimum() const;
+	// 平均のフレーム時間(秒)を取得する
+	double GetAverage() const;
+	// 最大のフレーム時間(秒)を取得する
+	double GetMaximum() const;
+	// 百分位数(0～100)のフレーム時間(秒)を取得する
+	double GetPercentile(double percentile) const
+	{
+		return m_histogram.GetPercentile(percentile);
+	}
+	// 指定された時間(秒)を超えたフレームの数を取得する
+	size_t CountFramesOver(double seconds) const;
+
+	// 処理段階の数を取得する
+	int GetStageCount() const
+	{
+		return m_stageCount;
+	}
+	// 処理段階の名前を取得する
+	const char* GetStageName(int stage) const;
+	// 処理段階の平均時間(秒)を取得する
+	double GetStageAverage(int stage) const;
+	// 処理段階の最大時間(秒)を取得する
+	double GetStageMaximum(int stage) const;
+
+	// カウンタの数を取得する
+	int GetCounterCount() const
+	{
+		return m_counterCount;
+	}
+	// カウンタの名前を取得する
+	const char* GetCounterName(int counter) const;
+	// 最新のフレームのカウンタの値を取得する
+	uint64_t GetCounter(int counter) const;
+
+private:
+	// 処理段階
+	struct Stage
+	{
+		// 名前
+		const char* name;
+		// 現在のフレームの時間
+		double current;
+		// 直近のフレームの時間
+		float history[WINDOW_SIZE];
+		// 直近のフレームの時間の合計
+		double sum;
+	};
+	// カウンタ
+	struct Counter
+	{
+		// 名前
+		const char* name;
+		// 現在のフレームの値
+		uint64_t current;
+		// 最新のフレームの値
+		uint64_t last;
+	};
+
+	// 処理段階の番号を確認する(範囲外の場合は例外を投げる)
+	void CheckStage(int stage) const;
+	// カウンタの番号を確認する(範囲外の場合は例外を投げる)
+	void CheckCounter(int counter) const;
+
+private:
+	// 直近のフレーム時間
+	float m_frameTimes[WINDOW_SIZE];
+	// 直近のフレーム時間の合計
+	double m_frameTimeSum;
+	// 次に書き込む位置
+	size_t m_next;
+	// 集計しているフレーム数
+	size_t m_count;
+	// フレーム時間の分布
+	FrameTimeHistogram m_histogram;
+	// 処理段階
+	Stage m_stages[MAX_STAGES];
+	// 処理段階の数
+	int m_stageCount;
+	// カウンタ
+	Counter m_counters[MAX_COUNTERS];
+	// カウンタの数
+	int m_counterCount;
+};
+
+#endif	// FRAMESTATISTICS_DEFINED
@@ -0,0 +1,207 @@
+﻿#include "FrustumCuller.h"
+#include <math.h>
+#include "TransformKernel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FRUSTUMCULLER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define FRUSTUMCULLER_AVX2_TARGET
+#else
+#define FRUSTUMCULLER_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	// 境界ボックスの中心と半径
+	inline void GetCenterExtent(const MeshBounds& bounds, float center[3], float extent[3])
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			center[axis] = (bounds.maximum[axis] + bounds.minimum[axis]) * 0.5f;
+			extent[axis] = (bounds.maximum[axis] - bounds.minimum[axis]) * 0.5f;
+		}
+	}
+
+	// 境界ボックスの配列を判定する(スカラー)
+	size_t CullScalar(const float (*planes)[4], const MeshBounds* bounds, size_t count, uint8_t* visible)
+	{
+		size_t visibleCount = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			float center[3], extent[3];
+			GetCenterExtent(bounds[i], center, extent);
+			bool inside = true;
+			for (int p = 0; p < FrustumCuller::PLANE_COUNT && inside; p++)
+			{
+				const float* plane = planes[p];
+				float distance = plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3];
+				float radius = fabsf(plane[0]) * extent[0] + fabsf(plane[1]) * extent[1] + fabsf(plane[2]) * extent[2];
+				inside = distance + radius >= 0.0f;
+			}
+			visible[i] = inside ? 1 : 0;
+			visibleCount += visible[i];
+		}
+		return visibleCount;
+	}
+
+#ifdef FRUSTUMCULLER_X86
+	// 境界ボックスの配列を判定する(SSE2、4平面を同時に判定する)
+	size_t CullSSE2(const float* planeX, const float* planeY, const float* planeZ, const float* planeW,
+		const MeshBounds* bounds, size_t count, uint8_t* visible)
+	{
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		__m128 x[2], y[2], z[2], w[2], absX[2], absY[2], absZ[2];
+		for (int n = 0; n < 2; n++)
+		{
+			x[n] = _mm_load_ps(planeX + n * 4);
+			y[n] = _mm_load_ps(planeY + n * 4);
+			z[n] = _mm_load_ps(planeZ + n * 4);
+			w[n] = _mm_load_ps(planeW + n * 4);
+			absX[n] = _mm_andnot_ps(signMask, x[n]);
+			absY[n] = _mm_andnot_ps(signMask, y[n]);
+			absZ[n] = _mm_andnot_ps(signMask, z[n]);
+		}
+
+		size_t visibleCount = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			const MeshBounds& box = bounds[i];
+			__m128 minimum = _mm_setr_ps(box.minimum[0], box.minimum[1], box.minimum[2], 0.0f);
+			__m128 maximum = _mm_setr_ps(box.maximum[0], box.maximum[1], box.maximum[2], 0.0f);
+			__m128 center = _mm_mul_ps(_mm_add_ps(maximum, minimum), half);
+			__m128 extent = _mm_mul_ps(_mm_sub_ps(maximum, minimum), half);
+			__m128 cx = _mm_shuffle_ps(center, center, _MM_SHUFFLE(0, 0, 0, 0));
+			__m128 cy = _mm_shuffle_ps(center, center, _MM_SHUFFLE(1, 1, 1, 1));
+			__m128 cz = _mm_shuffle_ps(center, center, _MM_SHUFFLE(2, 2, 2, 2));
+			__m128 ex = _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(0, 0, 0, 0));
+			__m128 ey = _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(1, 1, 1, 1));
+			__m128 ez = _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(2, 2, 2, 2));
+
+			int outside = 0;
+			for (int n = 0; n < 2; n++)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x[n], cx), _mm_mul_ps(y[n], cy)), _mm_mul_ps(z[n], cz)), w[n]);
+				__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[n], ex), _mm_mul_ps(absY[n], ey)), _mm_mul_ps(absZ[n], ez));
+				outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+			}
+			visible[i] = outside ? 0 : 1;
+			visibleCount += visible[i];
+		}
+		return visibleCount;
+	}
+
+	// 境界ボックスの配列を判定する(AVX2、6平面を同時に判定する)
+	FRUSTUMCULLER_AVX2_TARGET size_t CullAVX2(const float* planeX, const float* planeY, const float* planeZ, const float* planeW,
+		const MeshBounds* bounds, size_t count, uint8_t* visible)
+	{
+		const __m256 signMask = _mm256_set1_ps(-0.0f);
+		__m256 x = _mm256_load_ps(planeX);
+		__m256 y = _mm256_load_ps(planeY);
+		__m256 z = _mm256_load_ps(planeZ);
+		__m256 w = _mm256_load_ps(planeW);
+		__m256 absX = _mm256_andnot_ps(signMask, x);
+		__m256 absY = _mm256_andnot_ps(signMask, y);
+		__m256 absZ = _mm256_andnot_ps(signMask, z);
+
+		size_t visibleCount = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			const MeshBounds& box = bounds[i];
+			__m256 cx = _mm256_set1_ps((box.maximum[0] + box.minimum[0]) * 0.5f);
+			__m256 cy = _mm256_set1_ps((box.maximum[1] + box.minimum[1]) * 0.5f);
+			__m256 cz = _mm256_set1_ps((box.maximum[2] + box.minimum[2]) * 0.5f);
+			__m256 ex = _mm256_set1_ps((box.maximum[0] - box.minimum[0]) * 0.5f);
+			__m256 ey = _mm256_set1_ps((box.maximum[1] - box.minimum[1]) * 0.5f);
+			__m256 ez = _mm256_set1_ps((box.maximum[2] - box.minimum[2]) * 0.5f);
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, cx), _mm256_mul_ps(y, cy)), _mm256_mul_ps(z, cz)), w);
+			__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX, ex), _mm256_mul_ps(absY, ey)), _mm256_mul_ps(absZ, ez));
+			int outside = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+			visible[i] = outside ? 0 : 1;
+			visibleCount += visible[i];
+		}
+		return visibleCount;
+	}
+#endif
+}
+
+// コンストラクタ
+FrustumCuller::FrustumCuller(const float* m)
+{
+	// 行ベクトル規約ではクリップ座標の各成分が行列の列との内積になる(Gribb-Hartmann)
+	for (int p = 0; p < PLANE_COUNT; p++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			const float* r = m + row * 4;
+			float value = 0.0f;
+			switch (p)
+			{
+			case 0: value = r[3] + r[0]; break;	// 左
+			case 1: value = r[3] - r[0]; break;	// 右
+			case 2: value = r[3] + r[1]; break;	// 下
+			case 3: value = r[3] - r[1]; break;	// 上
+			case 4: value = r[2]; break;		// 近
+			case 5: value = r[3] - r[2]; break;	// 遠
+			}
+			m_planes[p][row] = value;
+		}
+
+		float length = sqrtf(m_planes[p][0] * m_planes[p][0] + m_planes[p][1] * m_planes[p][1] + m_planes[p][2] * m_planes[p][2]);
+		if (length > 0.0f)
+		{
+			for (int n = 0; n < 4; n++)
+				m_planes[p][n] /= length;
+		}
+	}
+
+	for (int p = 0; p < 8; p++)
+	{
+		bool padding = p >= PLANE_COUNT;
+		m_planeX[p] = padding ? 0.0f : m_planes[p][0];
+		m_planeY[p] = padding ? 0.0f : m_planes[p][1];
+		m_planeZ[p] = padding ? 0.0f : m_planes[p][2];
+		m_planeW[p] = padding ? 1.0f : m_planes[p][3];
+	}
+}
+
+// 境界ボックスが視錐台と交差するかどうか
+bool FrustumCuller::IsVisible(const MeshBounds& bounds) const
+{
+	uint8_t visible;
+	return CullScalar(m_planes, &bounds, 1, &visible) != 0;
+}
+
+// 境界ボックスの配列を判定する
+size_t FrustumCuller::Cull(const MeshBounds* bounds, size_t count, uint8_t* visible) const
+{
+#ifdef FRUSTUMCULLER_X86
+	switch (TransformKernel::GetInstructionSet())
+	{
+	case TransformKernel::AVX2: return CullAVX2(m_planeX, m_planeY, m_planeZ, m_planeW, bounds, count, visible);
+	case TransformKernel::SSE2: return CullSSE2(m_planeX, m_planeY, m_planeZ, m_planeW, bounds, count, visible);
+	default: break;
+	}
+#endif
+	return CullScalar(m_planes, bounds, count, visible);
+}
+
+// 境界ボックスを行列で変換する(Arvo)
+MeshBounds FrustumCuller::TransformBounds(const MeshBounds& bounds, const float* m)
+{
+	MeshBounds result;
+	for (int column = 0; column < 3; column++)
+	{
+		result.minimum[column] = result.maximum[column] = m[12 + column];
+		for (int row = 0; row < 3; row++)
+		{
+			float a = m[row * 4 + column] * bounds.minimum[row];
+			float b = m[row * 4 + column] * bounds.maximum[row];
+			result.minimum[column] += a < b ? a : b;
+			result.maximum[column] += a < b ? b : a;
+		}
+	}
+	return result;
+}
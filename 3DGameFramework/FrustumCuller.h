@@ -0,0 +1,45 @@
+﻿#pragma once
+#ifndef FRUSTUMCULLER_DEFINED
+#define FRUSTUMCULLER_DEFINED
+
+#include <stddef.h>
+#include <stdint.h>
+#include "MeshData.h"
+
+// ビュー射影行列から視錐台の6平面を作成し、境界ボックスが見えるかどうかを判定するクラス
+// 行列は行優先、行ベクトル規約、クリップ空間のzは0～wとする(Direct3D)
+class FrustumCuller
+{
+public:
+	// 平面数
+	static const int PLANE_COUNT = 6;
+
+	// コンストラクタ
+	explicit FrustumCuller(const float* viewProjection);
+
+	// 境界ボックスが視錐台と交差するかどうか
+	bool IsVisible(const MeshBounds& bounds) const;
+	// 境界ボックスの配列を判定し、見えるものは1、見えないものは0を書き込む(見える数を返す)
+	// 判定にはTransformKernelで選択された命令セットを使用する
+	size_t Cull(const MeshBounds* bounds, size_t count, uint8_t* visible) const;
+
+	// 平面(a, b, c, d)を取得する(法線は視錐台の内側を向き、正規化されている)
+	const float* GetPlane(int index) const
+	{
+		return m_planes[index];
+	}
+
+	// 境界ボックスを行列で変換し、変換後の境界ボックスを求める
+	static MeshBounds TransformBounds(const MeshBounds& bounds, const float* matrix);
+
+private:
+	// 平面
+	float m_planes[PLANE_COUNT][4];
+	// SIMD用に平面の各成分を並べた配列(余った2要素は常に内側と判定される平面)
+	alignas(32) float m_planeX[8];
+	alignas(32) float m_planeY[8];
+	alignas(32) float m_planeZ[8];
+	alignas(32) float m_planeW[8];
+};
+
+#endif	// FRUSTUMCULLER_DEFINED
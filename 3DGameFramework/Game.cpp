@@ -1,12 +1,53 @@
 // Game.cpp
 #include "Game.h"
+#include "AllocationCounter.h"
 
 void ExitGame();
 
+// pCvCŃXibvVbǧJ҂(̊ԊuŃbZ[W)
+static const uint32_t PIPELINE_WAIT_MILLISECONDS = 4;
+// t[̓vɓo^鏈iKƃJE^̔ԍ(RXgN^ł̏ɓo^)
+static const int UPDATE_STAGE = 0;
+static const int RENDER_STAGE = 1;
+static const int PRESENT_STAGE = 2;
+static const int ALLOCATION_COUNTER = 0;
+static const int ARENA_COUNTER = 1;
+
+// w肳ꂽ̌oߎ(b)擾
+static double SecondsSince(uint64_t start)
+{
+	DX::ClockSource& clock = DX::GetDefaultClock();
+	return double(clock.GetCounter() - start) / clock.GetFrequency();
+}
+
+// }EXƃL[{[ȟ݂̏Ԃǂ
+static void ReadDevices(InputFrame& frame)
+{
+	DirectX::Mouse::State mouse = DirectX::Mouse::Get().GetState();
+	frame.mouseX = mouse.x;
+	frame.mouseY = mouse.y;
+	frame.scrollWheel = mouse.scrollWheelValue;
+	frame.mouseButtons = (mouse.leftButton ? InputState::MOUSE_LEFT : 0) | (mouse.middleButton ? InputState::MOUSE_MIDDLE : 0) | (mouse.rightButton ? InputState::MOUSE_RIGHT : 0);
+
+	// L[{[h̏Ԃ͉zL[R[hԍƂ256rbg̗ɂȂĂ
+	DirectX::Keyboard::State keyboard = DirectX::Keyboard::Get().GetState();
+	static_assert(sizeof(keyboard) == sizeof(frame.keys), "Keyboard::State must be a 256-bit key set");
+	memcpy(frame.keys, &keyboard, sizeof(frame.keys));
+}
+
 // RXgN^
 Game::Game(int width, int height)
-	: m_hWnd(0), m_width(width), m_height(height), m_featureLevel(D3D_FEATURE_LEVEL_9_1) 
+	: m_hWnd(0), m_width(width), m_height(height), m_featureLevel(D3D_FEATURE_LEVEL_9_1), m_vsync(true), m_skipUnchangedFrames(false), m_pipelined(false), m_frameLatency(1), m_traceKeyDown(false),
+	m_updateSeconds(0.0), m_snapshotUpdateSeconds{}, m_presentSeconds(0.0), m_lastAllocationCount(0),
+	m_headlessFrames(0), m_renderDevice(&m_directX)
 {
+	// GWv鏈iKƃJE^o^
+	m_frameStatistics.AddStage("Update");
+	m_frameStatistics.AddStage("Render");
+	m_frameStatistics.AddStage("Present");
+	m_frameStatistics.AddCounter("allocations");
+	m_frameStatistics.AddCounter("arena bytes");
+
 	// X^[gAbv
 	STARTUPINFO si{};
 	// CX^Xnh擾
@@ -15,40 +56,47 @@ Game::Game(int width, int height)
 	// STARTUPINFO\̂擾
 	::GetStartupInfo(&si);
 	m_nCmdShow = si.dwFlags & STARTF_USESHOWWINDOW ? si.wShowWindow : SW_SHOWDEFAULT;
-	// WindowIuWFNg𐶐
-	m_window = make_unique<Window>(m_hInstance, m_nCmdShow);
 }
 
 // Q[\[X
 void Game::Initialize(int width, int height)
 {
-	// WindowIuWFNg
-	m_window->Initialize(m_width, m_height);
-	// WindowIuWFNg̐ɃEBhEnh擾
-	m_hWnd = m_window->GetHWnd();
-
-	// DirectX̏̂߃EBhEnhݒ肷
-	m_directX.SetHWnd(m_hWnd);
-	// DirectX̏̂߃EBhEݒ肷
-	m_directX.SetWidth(m_width);
-	// DirectX̏̂߃EBhEݒ肷
-	m_directX.SetHeight(m_height);
+	// WuVXe𐶐(n[hEFAXbh-1̃[J[)
+	m_jobSystem = std::make_unique<JobSystem>();
+	// wbhXł̓EBhE𐶐Ȃ
+	if (!IsHeadless())
+	{
+		// WindowIuWFNg𐶐
+		m_window = make_unique<Window>(m_hInstance, m_nCmdShow);
+		// WindowIuWFNg
+		m_window->Initialize(m_width, m_height);
+		// WindowIuWFNg̐ɃEBhEnh擾
+		m_hWnd = m_window->GetHWnd();
+		// DirectX̏̂߃EBhEnhݒ肷
+		m_directX.SetHWnd(m_hWnd);
+	}
 
 	// foCX𐶐
-	m_directX.CreateDevice();
-	// \[X𐶐
-	m_directX.CreateResources();
+	m_renderDevice->CreateDevice();
+	// EBhETCỸ\[X𐶐
+	m_renderDevice->Resize(m_width, m_height);
 
     // TODO: ftHgϐtimestep[hȊÔ̂Kvȏꍇ^C}[ݒύX
 	// : 60FPSŒ^CXebvXVWbNɑ΂Ă͈ȉĂяo
     
-    m_timer.SetFixedTimeStep(true);
-    m_timer.SetTargetElapsedSeconds(1.0 / 60.0);
+    GetTimer().SetFixedTimeStep(true);
+    GetTimer().SetTargetElapsedSeconds(1.0 / 60.0);
+	// XVdԂɒǂȂꍇɍXVȂ悤ɂ
+	GetTimer().SetMaxUpdatesPerTick(4);
 
-	// SpriteBatchIuWFNg𐶐
-	m_spriteBatch = std::make_unique<DirectX::SpriteBatch>(m_directX.GetContext().Get());
-	// SpriteFontIuWFNg𐶐
-	m_spriteFont = std::make_unique<DirectX::SpriteFont>(m_directX.GetDevice().Get(), L"Arial.spritefont");
+	// wbhXłGPŨ\[X𐶐Ȃ
+	if (!IsHeadless())
+	{
+		// SpriteBatchIuWFNg𐶐
+		m_spriteBatch = std::make_unique<DirectX::SpriteBatch>(m_directX.GetContext().Get());
+		// SpriteFontIuWFNg𐶐
+		m_spriteFont = std::make_unique<DirectX::SpriteFont>(m_directX.GetDevice().Get(), L"Arial.spritefont");
+	}
 
 	// L[{[h𐶐
 	m_keyboard = std::make_unique<DirectX::Keyboard>();
@@ -68,14 +116,50 @@ MSG Game::Run()
 	// bZ[W
 	MSG msg = {};
 
+	// g[Xۑꍇ͎̓ǂݍ݂L^
+	Profiler& profiler = Profiler::Get();
+	profiler.SetThreadName("Main");
+	if (!m_traceFile.empty())
+		profiler.SetEnabled(true);
+
 	// GameIuWFNg
 	Initialize(m_width, m_height);
 	// EBhE\
-	m_window->ShowWindow();
+	if (!IsHeadless())
+		m_window->ShowWindow();
 	// \[X𐶐
 	CreateResources();
+	// ͂̋L^ƍĐJn
+	m_stepper.StartInput(m_inputRecordFile);
+
+	// pCvC̏ꍇ͍XVXbhJn
+	if (m_pipelined)
+		m_pipeline.Start(m_frameLatency, [this](int snapshot) { return Step(snapshot); });
 
 	// Q[[v
+	if (IsHeadless())
+		RunHeadless();
+	else
+		msg = RunWindowed();
+	// XVXbh~
+	m_pipeline.Stop();
+	// ͂̋L^
+	m_stepper.FinishInput();
+	// g[Xۑ
+	if (!m_traceFile.empty())
+	{
+		profiler.SetEnabled(false);
+		profiler.SaveChromeTrace(m_traceFile);
+	}
+	// GameIuWFNǧn
+	Finalize();
+	return msg;
+}
+
+// bZ[WȂEBhE܂Ńt[JԂ
+MSG Game::RunWindowed()
+{
+	MSG msg = {};
 	while (WM_QUIT != msg.message)
 	{
 		if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
@@ -83,24 +167,154 @@ MSG Game::Run()
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 		}
+		else if (m_pipelined)
+		{
+			// foCX̓͂ǂōXVXbh֓n
+			SampleInput();
+			// XVXbhJŐṼXibvVbg`悷
+			int snapshot;
+			{
+				PROFILE_SCOPE("Acquire");
+				snapshot = m_pipeline.Acquire(PIPELINE_WAIT_MILLISECONDS);
+			}
+			if (snapshot < 0)
+				continue;
+			RenderSnapshot(snapshot);
+		}
 		else
 		{
+			// foCX̓͂ǂ
+			SampleInput();
 			// Q[XV
-			m_timer.Tick([&]() { Update(m_timer); });
+			if (!Step(0))
+				continue;
 			// Q[V[`悷
-			Render(m_timer);
+			RenderSnapshot(0);
 		}
 	}
-	// GameIuWFNǧn
-	Finalize();
 	return msg;
 }
 
+// w肳ꂽt[bZ[WɃt[JԂ
+void Game::RunHeadless()
+{
+	int frame = 0;
+	while (frame < m_headlessFrames)
+	{
+		int snapshot = 0;
+		if (m_pipelined)
+		{
+			PROFILE_SCOPE("Acquire");
+			snapshot = m_pipeline.Acquire(PIPELINE_WAIT_MILLISECONDS);
+		}
+		else if (!Step(0))
+		{
+			snapshot = -1;
+		}
+		if (snapshot < 0)
+			continue;
+		RenderSnapshot(snapshot);
+		frame++;
+	}
+}
+
+// EBhEGPUg킸AzNbNŎw肳ꂽt[s悤ɐݒ肷
+void Game::SetHeadless(int frameCount)
+{
+	if (frameCount <= 0)
+		throw std::invalid_argument("Game: headless frame count must be positive");
+
+	m_headlessFrames = frameCount;
+	m_nullDevice = std::make_unique<NullRenderDevice>();
+	m_renderDevice = m_nullDevice.get();
+	// \҂A^C}[͉zNbNŐi߂
+	m_vsync = false;
+	m_stepper.SetHeadless();
+}
+
+// ^C}[i߂čXVAXibvVbg
+bool Game::Step(int snapshot)
+{
+	// Q[XV(f̕ǍoߎԂ̃ZbgƁAwbhXŉzNbNi߂邱Ƃm_stepperȂ)
+	// ŒXebvƂɒȌԂۑA͂ǂݍłXV
+	bool updated = m_stepper.Tick([&](const DX::StepTimer& timer)
+	{
+		PROFILE_SCOPE("Update");
+		uint64_t start = DX::GetDefaultClock().GetCounter();
+		Update(timer);
+		m_updateSeconds += SecondsSince(start);
+	});
+	// ҂Ȃꍇ͐VԂt[`悵Ȃ
+	if (!updated && !m_vsync && m_skipUnchangedFrames)
+		return false;
+
+	// `悷Ԃƃ^C}[XibvVbgɏ(ԂԂ͂̎_̕ԌWŏ)
+	PROFILE_SCOPE("WriteSnapshot");
+	WriteSnapshot(snapshot);
+	m_snapshotTimers[snapshot] = GetTimer();
+	// XVɂԂ̓XibvVbgƂƂɕ`Xbh֓n
+	m_snapshotUpdateSeconds[snapshot] = m_updateSeconds;
+	m_updateSeconds = 0.0;
+	return true;
+}
+
+// EBhẼbZ[WXbhŃfoCX͂ǂ݁AXV֓n
+void Game::SampleInput()
+{
+	InputFrame frame = {};
+	ReadDevices(frame);
+	m_stepper.PostInput(frame);
+}
+
+// XibvVbg`悵ăt[I
+void Game::RenderSnapshot(int snapshot)
+{
+	uint64_t start = DX::GetDefaultClock().GetCounter();
+	m_presentSeconds = 0.0;
+	{
+		PROFILE_SCOPE("Render");
+		ReadSnapshot(snapshot);
+		Render(m_snapshotTimers[snapshot]);
+	}
+	double renderSeconds = SecondsSince(start);
+
+	// t[̓vm肷(`̎ԂɂPresent̎Ԃ܂߂Ȃ)
+	uint64_t allocationCount = AllocationCounter::GetCount();
+	m_frameStatistics.AddStageTime(UPDATE_STAGE, m_snapshotUpdateSeconds[snapshot]);
+	m_frameStatistics.AddStageTime(RENDER_STAGE, renderSeconds - m_presentSeconds);
+	m_frameStatistics.AddStageTime(PRESENT_STAGE, m_presentSeconds);
+	m_frameStatistics.SetCounter(ALLOCATION_COUNTER, allocationCount - m_lastAllocationCount);
+	m_frameStatistics.SetCounter(ARENA_COUNTER, m_frameArena.GetUsed());
+	m_lastAllocationCount = allocationCount;
+	m_frameArena.Reset();
+
+	// t[ԂL^Ag[X̕ۑL[ꂽ璼߂̋L^ۑ(ŏ̃t[͕`̎Ԃőウ)
+	double frameSeconds = Profiler::Get().MarkFrame();
+	m_frameStatistics.EndFrame(frameSeconds > 0.0 ? frameSeconds : renderSeconds);
+	if (!m_traceFile.empty())
+	{
+		bool keyDown = DirectX::Keyboard::Get().GetState().F12;
+		if (keyDown && !m_traceKeyDown)
+			Profiler::Get().SaveChromeTrace(m_traceFile);
+		m_traceKeyDown = keyDown;
+	}
+}
+
 // Q[XV
 void Game::Update(const DX::StepTimer& timer)
 {
 }
 
+// `ɕKvȏԂXibvVbgɏ
+void Game::WriteSnapshot(int snapshot)
+{
+}
+
+// `悷XibvVbg󂯎
+void Game::ReadSnapshot(int snapshot)
+{
+}
+
 // n
 void Game::Finalize() 
 {
@@ -108,6 +322,8 @@ void Game::Finalize()
 	m_spriteFont.reset();
 	// SpriteBatchIuWFNg
 	m_spriteBatch.reset();
+	// WuVXe
+	m_jobSystem.reset();
 
 	// DirectX11 GraphicsIuWFNg
 	DirectX11::Dispose();
@@ -123,15 +339,9 @@ void Game::Render(const DX::StepTimer& timer)
 // obNobt@NA
 void Game::Clear()
 {
-	// _[^[Qbgr[NA
-	m_directX.GetContext()->ClearRenderTargetView(m_directX.GetRenderTargetView().Get(), DirectX::Colors::CornflowerBlue);
-	// fvXXeVr[NA
-	m_directX.GetContext()->ClearDepthStencilView(m_directX.GetDepthStencilView().Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
-	// _[^bQ[gݒ肷
-	m_directX.GetContext()->OMSetRenderTargets(1, m_directX.GetRenderTargetView().GetAddressOf(), m_directX.GetDepthStencilView().Get());
-    // r[|[gݒ肷
-    CD3D11_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(m_width), static_cast<float>(m_height));
-	m_directX.GetContext()->RSSetViewports(1, &viewport);
+	PROFILE_SCOPE("Clear");
+	// obNobt@ƃfvXXeVobt@NAA_[^[Qbgƃr[|[gݒ肷
+	m_renderDevice->Clear(DirectX::Colors::CornflowerBlue);
 }
 
 // obNobt@XN[ɑ 
@@ -141,15 +351,10 @@ void Game::Present()
     // to sleep until the next VSync. This ensures we don't waste any cycles rendering
     // frames that will never be displayed to the screen.
 
-	// DirectX11NX̃CX^X擾
-	DirectX11& directX = DirectX11::Get();
-	HRESULT hr = directX.GetSwapChain()->Present(1, 0);
-
-    // foCXZbgꂽꍇ_ďKv 
-    if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET) 
-		directX.OnDeviceLost();
-    else 
-        DX::ThrowIfFailed(hr);
+	PROFILE_SCOPE("Present");
+	uint64_t start = DX::GetDefaultClock().GetCounter();
+	m_renderDevice->Present(m_vsync);
+	m_presentSeconds += SecondsSince(start);
 }
 
 // bZ[Wnh
@@ -170,7 +375,8 @@ void Game::OnSuspending()
 
 void Game::OnResuming()
 {
-	m_timer.ResetElapsedTime();
+	// pCvCł̓^C}[XVXbhgĂ̂ŁA̍XV̑OɃZbg
+	m_stepper.RequestResetElapsedTime();
 
     // TODO: Q[p[W[ɂȂꍇ
 }
@@ -180,7 +386,7 @@ void Game::OnWindowSizeChanged(int width, int height)
     m_width = max(width, 1);
     m_height = max(height, 1);
 	
-	DirectX11::Get().CreateResources();
+	m_renderDevice->Resize(m_width, m_height);
     // TODO: Q[EBhẼTCYĕύXꂽꍇ
 }
 
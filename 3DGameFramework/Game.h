@@ -5,6 +5,13 @@
 #define GAME_DEFINED
 
 #include "StepTimer.h"
+#include "GameStepper.h"
+#include "FramePipeline.h"
+#include "JobSystem.h"
+#include "LinearArena.h"
+#include "Profiler.h"
+#include "FrameStatistics.h"
+#include "NullRenderDevice.h"
 #include "Window.h"
 #include "DirectX11.h"
 
@@ -56,6 +63,102 @@ public:
     // vpeB 
     void GetDefaultSize(int& width, int& height) const;
 
+	// ҂ăobNobt@𑗂邩ǂݒ肷
+	void SetVSync(bool vsync)
+	{
+		m_vsync = vsync;
+	}
+	// ȏꍇɁAXVȂȂt[̕`Ȃǂݒ肷
+	void SetSkipUnchangedFrames(bool skip)
+	{
+		m_skipUnchangedFrames = skip;
+	}
+	// XVXbhŎ̃t[XVȂ`悷邩ǂƁAXVsłt[(1`3)ݒ肷(Run̑OɌĂяo)
+	void SetPipelined(bool pipelined, int frameLatency = 1)
+	{
+		m_pipelined = pipelined;
+		m_frameLatency = frameLatency;
+	}
+	// vt@C̃g[Xۑt@Cݒ肷(Run̑OɌĂяo)
+	// ݒ肷ƃvt@CLɂAF12L[ƂƏIɒ߂̋L^Chromẽg[X`ŕۑ
+	void SetTraceFile(const std::string& filename)
+	{
+		m_traceFile = filename;
+	}
+	// EBhEGPUg킸AzNbNŎw肳ꂽt[s悤ɐݒ肷(Run̑OɌĂяo)
+	// `foCX̓kfoCXɒuA1t[ƂɌŒXebv1񕪂Ԃi
+	void SetHeadless(int frameCount);
+	// wbhX̃kfoCX擾(wbhXłȂꍇnullptr)
+	const NullRenderDevice* GetNullRenderDevice() const
+	{
+		return m_nullDevice.get();
+	}
+	// XVƂ̓͂L^t@Cݒ肷(Run̑OɌĂяo)
+	// XV̑Oɓǂ񂾓͂XV̎ƂƂɏoASetInputReplayœ͂Đł
+	void SetInputRecordFile(const std::string& filename)
+	{
+		m_inputRecordFile = filename;
+	}
+	// foCXǂޑɓ̓OĐ悤ɐݒ肷(Run̑OɌĂяo)
+	// wbhXƑgݍ킹ƁAsƂɓ͂œ񐔂XV
+	void SetInputReplay(std::unique_ptr<InputPlayer> player)
+	{
+		m_stepper.SetInputReplay(std::move(player));
+	}
+	// ߂̃t[̓v擾(`XbhŎgpBhNX̓JE^o^RenderŒlݒł)
+	FrameStatistics& GetFrameStatistics()
+	{
+		return m_frameStatistics;
+	}
+
+protected:
+	// GWŜŋLWuVXe擾(Initializěォgpł)
+	JobSystem& GetJobSystem()
+	{
+		return *m_jobSystem;
+	}
+	// t[Pʂ̈ꎞf[^p̃A[i擾(`XbhŎgAmۂRendeřɉ)
+	LinearArena& GetFrameArena()
+	{
+		return m_frameArena;
+	}
+	// ^C}[擾(InitializeŃ^CXebvύXꍇɎgp)
+	DX::StepTimer& GetTimer()
+	{
+		return m_stepper.GetTimer();
+	}
+	// ݂̍XVŎg͂擾(UpdateŎgpBfoCX𒼐ړǂ܂ɂgƓ͂L^EĐł)
+	const InputState& GetInput() const
+	{
+		return m_stepper.GetInput();
+	}
+	// wbhX삩ǂ擾(wbhXłGPŨ\[X𐶐Ȃ)
+	bool IsHeadless() const
+	{
+		return m_headlessFrames > 0;
+	}
+	// ŒXebvƂɒȌԂۑA`掞ɕԂԂo^
+	void AddInterpolatedState(InterpolatedStateBase* state)
+	{
+		m_stepper.AddInterpolatedState(state);
+	}
+	// XV̌ɕ`ɕKvȏԂXibvVbg(0`2)ɏ(pCvCł͍XVXbhŌĂ΂)
+	virtual void WriteSnapshot(int snapshot);
+	// `̑Oɕ`悷XibvVbg󂯎(WriteSnapshotŏ܂ꂽ̂`Ɏg)
+	virtual void ReadSnapshot(int snapshot);
+
+private:
+	// ^C}[i߂čXVAXibvVbg(`悵ȂꍇfalseԂ)
+	bool Step(int snapshot);
+	// EBhẼbZ[WXbhŃfoCX͂ǂ݁AXV֓n
+	void SampleInput();
+	// XibvVbg`悵ăt[I
+	void RenderSnapshot(int snapshot);
+	// bZ[WȂEBhE܂Ńt[JԂ
+	MSG RunWindowed();
+	// w肳ꂽt[bZ[WɃt[JԂ
+	void RunHeadless();
+
 private:
 	// o͕
 	int m_width;
@@ -68,8 +171,8 @@ private:
 	// CX^Xnh
 	HINSTANCE m_hInstance;
 
-	// ^C}[
-    DX::StepTimer m_timer;
+	// ^C}[i߂ČŒXebvƂɍXV镔
+	GameStepper m_stepper;
 	// @\x
     D3D_FEATURE_LEVEL m_featureLevel;
 	// EBhE
@@ -86,6 +189,49 @@ private:
 	std::unique_ptr<DirectX::Keyboard> m_keyboard;
 	// }EX
 	std::unique_ptr<DirectX::Mouse> m_mouse;
+
+	// ҂ǂ
+	bool m_vsync;
+	// XVȂȂt[̕`Ȃǂ
+	bool m_skipUnchangedFrames;
+
+	// GWŜŋLWuVXe
+	std::unique_ptr<JobSystem> m_jobSystem;
+	// XVƕ`̃pCvC
+	FramePipeline m_pipeline;
+	// pCvC삷邩ǂ
+	bool m_pipelined;
+	// XVsłt[
+	int m_frameLatency;
+	// XibvVbg񂾎_̃^C}[
+	DX::StepTimer m_snapshotTimers[FramePipeline::SNAPSHOT_COUNT];
+	// t[Pʂ̈ꎞf[^p̃A[i
+	LinearArena m_frameArena;
+	// g[Xۑt@C(̏ꍇ̓vt@CLɂȂ)
+	std::string m_traceFile;
+	// Õt[Ńg[X̕ۑL[Ăǂ
+	bool m_traceKeyDown;
+
+	// ߂̃t[̓v
+	FrameStatistics m_frameStatistics;
+	// XibvVbgނ܂łɍXVɂ(XVXbhŎgp)
+	double m_updateSeconds;
+	// XibvVbgɊ܂܂XVɂ
+	double m_snapshotUpdateSeconds[FramePipeline::SNAPSHOT_COUNT];
+	// ݂̃t[Presentɂ
+	double m_presentSeconds;
+	// Õt[I_̃q[vmۂ̉
+	uint64_t m_lastAllocationCount;
+
+	// wbhXŎst[(0̓EBhEŎs)
+	int m_headlessFrames;
+	// wbhX̃kfoCX
+	std::unique_ptr<NullRenderDevice> m_nullDevice;
+	// `foCX(DirectX11NX̃CX^XkfoCX)
+	RenderDevice* m_renderDevice;
+
+	// ͂L^t@C(̏ꍇ͋L^Ȃ)
+	std::string m_inputRecordFile;
 };
 
 #endif	// GAME_DEFINED
@@ -0,0 +1,51 @@
+﻿#include "GameStepper.h"
+#include <stdexcept>
+
+// コンストラクタ
+GameStepper::GameStepper()
+	: m_headless(false), m_resetElapsedTime(false)
+{
+}
+
+// タイマーを仮想クロックで進めるように設定する
+void GameStepper::SetHeadless()
+{
+	m_headless = true;
+	m_timer = DX::StepTimer(m_headlessClock);
+}
+
+// 入力の記録と再生を開始する
+void GameStepper::StartInput(const std::string& recordFile)
+{
+	// 入力の記録と再生は同じ固定ステップの間隔で更新する(時刻を更新の回数に対応させる)
+	if (m_inputPlayer && m_inputPlayer->GetStepTicks() != m_timer.GetTargetElapsedTicks())
+		throw std::runtime_error("GameStepper: input log was recorded with a different time step");
+	if (!recordFile.empty())
+		m_inputRecorder = std::make_unique<InputRecorder>(recordFile, m_timer.GetTargetElapsedTicks());
+}
+
+// 入力の記録を閉じる
+void GameStepper::FinishInput()
+{
+	if (m_inputRecorder)
+		m_inputRecorder->Close(m_timer.GetTotalTicks());
+	m_inputRecorder.reset();
+}
+
+// 更新で使う入力を読み込む
+void GameStepper::ReadInput()
+{
+	InputFrame frame = {};
+	uint64_t ticks = m_timer.GetTotalTicks();
+	if (m_inputPlayer)
+	{
+		m_inputPlayer->Read(ticks, frame);
+	}
+	else
+	{
+		frame = m_sampledInput.Read();
+		if (m_inputRecorder)
+			m_inputRecorder->Add(ticks, frame);
+	}
+	m_input.Advance(frame);
+}
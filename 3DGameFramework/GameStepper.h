@@ -0,0 +1,118 @@
+﻿#pragma once
+#ifndef GAMESTEPPER_DEFINED
+#define GAMESTEPPER_DEFINED
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "StepTimer.h"
+#include "FrameClock.h"
+#include "InterpolatedState.h"
+#include "InputState.h"
+#include "InputLog.h"
+#include "NonCopyable.h"
+
+// ゲームループのうちタイマーを進めて固定ステップごとに更新する部分(ウィンドウと描画APIに依存しない)
+// 更新の前に補間する状態を保存し、入力を読み込む。入力はデバイスから受け取ったもの、または入力ログを再生したものを使い、記録することもできる
+class GameStepper : public NonCopyable
+{
+public:
+	// コンストラクタ
+	GameStepper();
+
+	// タイマーを取得する(タイムステップを変更する場合に使用する)
+	DX::StepTimer& GetTimer()
+	{
+		return m_timer;
+	}
+	// 現在の更新で使う入力を取得する
+	const InputState& GetInput() const
+	{
+		return m_input;
+	}
+	// 固定ステップごとに直前の状態を保存し、描画時に補間する状態を登録する
+	void AddInterpolatedState(InterpolatedStateBase* state)
+	{
+		m_interpolatedStates.push_back(state);
+	}
+	// タイマーを仮想クロックで進め、1回のTickにつき固定ステップ1回分だけ時間を進めるように設定する
+	void SetHeadless();
+	// 仮想クロックで進めるかどうかを取得する
+	bool IsHeadless() const
+	{
+		return m_headless;
+	}
+	// デバイスを読む代わりに入力ログを再生するように設定する(StartInputの前に呼び出す)
+	void SetInputReplay(std::unique_ptr<InputPlayer> player)
+	{
+		m_inputPlayer = std::move(player);
+	}
+	// 再生する入力ログの更新の回数を取得する(再生しない場合は0)
+	uint32_t GetReplayUpdateCount() const
+	{
+		return m_inputPlayer ? m_inputPlayer->GetUpdateCount() : 0;
+	}
+
+	// 入力の記録と再生を開始する(タイムステップを設定した後に呼び出す。recordFileが空の場合は記録しない)
+	void StartInput(const std::string& recordFile);
+	// 入力の記録を閉じる
+	void FinishInput();
+	// デバイスから読んだ最新の入力を渡す(メッセージを処理するスレッドから呼び出せる)
+	void PostInput(const InputFrame& frame)
+	{
+		m_sampledInput.Post(frame);
+	}
+	// 次の更新の前にタイマーの経過時間をリセットする(どのスレッドからも呼び出せる)
+	void RequestResetElapsedTime()
+	{
+		m_resetElapsedTime = true;
+	}
+
+	// タイマーを進め、固定ステップごとに補間する状態を保存して入力を読み込んでから更新する(更新した場合はtrueを返す)
+	template<typename TUpdate>
+	bool Tick(const TUpdate& update)
+	{
+		// 経過時間のリセットはタイマーを進めるスレッドでおこなう
+		if (m_resetElapsedTime.exchange(false))
+			m_timer.ResetElapsedTime();
+		// 仮想クロックは実時間によらず固定ステップ1回分だけ進める(決定的に更新する)
+		if (m_headless)
+			m_headlessClock.Advance(m_timer.GetTargetElapsedTicks());
+
+		return m_timer.Tick([&]()
+		{
+			for (InterpolatedStateBase* state : m_interpolatedStates)
+				state->BeginStep();
+			ReadInput();
+			update(m_timer);
+		});
+	}
+
+private:
+	// 更新で使う入力を読み込む(再生中はログから読み、それ以外はPostInputで渡された最新の入力を使って記録中はログに書き出す)
+	void ReadInput();
+
+private:
+	// タイマー
+	DX::StepTimer m_timer;
+	// 仮想クロックで進めるかどうか
+	bool m_headless;
+	// 仮想クロックで進める場合にタイマーが使うクロック
+	DX::VirtualClock m_headlessClock;
+	// 次の更新の前にタイマーの経過時間をリセットするかどうか
+	std::atomic<bool> m_resetElapsedTime;
+	// 固定ステップごとに直前の状態を保存する補間状態
+	std::vector<InterpolatedStateBase*> m_interpolatedStates;
+
+	// 現在の更新で使う入力
+	InputState m_input;
+	// デバイスから読んだ最新の入力(メッセージを処理するスレッドで書き込み、更新で読む)
+	InputMailbox m_sampledInput;
+	// 入力の記録
+	std::unique_ptr<InputRecorder> m_inputRecorder;
+	// 入力の再生
+	std::unique_ptr<InputPlayer> m_inputPlayer;
+};
+
+#endif	// GAMESTEPPER_DEFINED
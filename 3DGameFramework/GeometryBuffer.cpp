@@ -0,0 +1,68 @@
+﻿#include "GeometryBuffer.h"
+#include <algorithm>
+#include <string.h>
+
+// コンストラクタ
+GeometryBuffer::GeometryBuffer(Usage usage, UINT vertexStride, D3D11_PRIMITIVE_TOPOLOGY topology)
+	: m_usage(usage), m_vertexStride(vertexStride), m_topology(topology), m_capacity(0), m_vertexCount(0), m_rebuildCount(0)
+{
+}
+
+// 頂点を設定する
+void GeometryBuffer::SetVertices(ID3D11DeviceContext* context, const void* vertices, UINT vertexCount)
+{
+	m_vertexCount = vertexCount;
+	if (vertexCount == 0)
+		return;
+
+	// 書き換え不可のバッファは初期データを与えて作り直す
+	if (m_usage == STATIC)
+	{
+		CreateBuffer(context, vertices, vertexCount);
+		return;
+	}
+
+	// 動的バッファは容量が足りなければ作り直し、前の内容を破棄して書き込む(GPUが使用中のバッファを待たずに済む)
+	if (vertexCount > m_capacity)
+		CreateBuffer(context, nullptr, vertexCount);
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	DX::ThrowIfFailed(context->Map(m_vertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+	memcpy(mapped.pData, vertices, size_t(vertexCount) * m_vertexStride);
+	context->Unmap(m_vertexBuffer.Get(), 0);
+}
+
+// 描画する
+void GeometryBuffer::Draw(ID3D11DeviceContext* context) const
+{
+	if (m_vertexCount == 0)
+		return;
+
+	UINT offset = 0;
+	context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &m_vertexStride, &offset);
+	context->IASetPrimitiveTopology(m_topology);
+	context->Draw(m_vertexCount, 0);
+}
+
+// バッファを生成する
+void GeometryBuffer::CreateBuffer(ID3D11DeviceContext* context, const void* vertices, UINT vertexCount)
+{
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	context->GetDevice(device.GetAddressOf());
+
+	if (m_usage == STATIC)
+	{
+		CD3D11_BUFFER_DESC desc(vertexCount * m_vertexStride, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+		D3D11_SUBRESOURCE_DATA data = { vertices, 0, 0 };
+		DX::ThrowIfFailed(device->CreateBuffer(&desc, &data, m_vertexBuffer.ReleaseAndGetAddressOf()));
+		m_capacity = vertexCount;
+	}
+	else
+	{
+		// 作り直す回数を減らすため容量を倍々に増やす
+		UINT capacity = std::max(vertexCount, m_capacity * 2);
+		CD3D11_BUFFER_DESC desc(capacity * m_vertexStride, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+		DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, m_vertexBuffer.ReleaseAndGetAddressOf()));
+		m_capacity = capacity;
+	}
+	m_rebuildCount++;
+}
@@ -0,0 +1,57 @@
+﻿#pragma once
+#ifndef GEOMETRYBUFFER_DEFINED
+#define GEOMETRYBUFFER_DEFINED
+
+// 頂点バッファとプリミティブの種類をまとめ、1回のDrawで描画するジオメトリ
+// 変更されないジオメトリは書き換え不可のバッファ、毎フレーム変わるジオメトリは動的バッファに置く
+class GeometryBuffer
+{
+public:
+	// バッファの使い方
+	enum Usage
+	{
+		// 生成後は変更しない(頂点を設定し直すとバッファを作り直す)
+		STATIC,
+		// 頻繁に書き換える(容量が足りる間は同じバッファに書き込む)
+		DYNAMIC,
+	};
+
+	// コンストラクタ
+	GeometryBuffer(Usage usage, UINT vertexStride, D3D11_PRIMITIVE_TOPOLOGY topology);
+	// 頂点を設定する
+	void SetVertices(ID3D11DeviceContext* context, const void* vertices, UINT vertexCount);
+	// 描画する
+	void Draw(ID3D11DeviceContext* context) const;
+	// 頂点数を取得する
+	UINT GetVertexCount() const
+	{
+		return m_vertexCount;
+	}
+	// バッファを作り直した回数を取得する
+	uint32_t GetRebuildCount() const
+	{
+		return m_rebuildCount;
+	}
+
+private:
+	// バッファを生成する
+	void CreateBuffer(ID3D11DeviceContext* context, const void* vertices, UINT vertexCount);
+
+private:
+	// 使い方
+	Usage m_usage;
+	// 頂点の大きさ
+	UINT m_vertexStride;
+	// プリミティブの種類
+	D3D11_PRIMITIVE_TOPOLOGY m_topology;
+	// 頂点バッファ
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_vertexBuffer;
+	// 頂点バッファの容量(頂点数)
+	UINT m_capacity;
+	// 頂点数
+	UINT m_vertexCount;
+	// バッファを作り直した回数
+	uint32_t m_rebuildCount;
+};
+
+#endif	// GEOMETRYBUFFER_DEFINED
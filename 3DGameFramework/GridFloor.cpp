@@ -1,15 +1,15 @@
-﻿#include <algorithm>
-#include "GridFloor.h"
+﻿#include "GridFloor.h"
+#include "LineGeometry.h"
 
 // コンストラクタ
-GridFloor::GridFloor(ID3D11Device* device, ID3D11DeviceContext* context, DirectX::CommonStates* states, float size, int divs) : m_size(size), m_divs(divs), m_states(states)
+GridFloor::GridFloor(ID3D11Device* device, ID3D11DeviceContext* context, DirectX::CommonStates* states, float size, int divs)
+	: m_geometry(GeometryBuffer::STATIC, sizeof(DirectX::VertexPositionColor), D3D11_PRIMITIVE_TOPOLOGY_LINELIST),
+	m_states(states), m_size(size), m_divs(divs), m_geometryDirty(true)
 {
 	// ベイシックエフェクトを生成する
 	m_basicEffect = std::make_unique<DirectX::BasicEffect>(device);
-	// 頂点カラーを有効にする
+	// 頂点カラーを有効にする(頂点は白にして、線の色はディフューズ色で指定する)
 	m_basicEffect->SetVertexColorEnabled(true);
-	// プリミティブバッチを生成する
-	m_primitiveBatch = std::make_unique<DirectX::PrimitiveBatch<DirectX::VertexPositionColor>>(context);
 	
 	void const* shaderByteCode;
 	size_t byteCodeLength;
@@ -19,6 +19,9 @@ GridFloor::GridFloor(ID3D11Device* device, ID3D11DeviceContext* context, DirectX
 		DirectX::VertexPositionColor::InputElementCount,
 		shaderByteCode, byteCodeLength,
 		m_pInputLayout.GetAddressOf());
+
+	// 格子の線分を生成する
+	UpdateGeometry(context);
 }
 
 // デストラクタ
@@ -30,9 +33,32 @@ GridFloor::~GridFloor()
 	m_pInputLayout.Reset();
 }
 
+// 床の一辺のサイズを設定する
+void GridFloor::SetSize(float size)
+{
+	if (size != m_size)
+	{
+		m_size = size;
+		m_geometryDirty = true;
+	}
+}
+
+// 分割数を設定する
+void GridFloor::SetDivisions(int divs)
+{
+	if (divs != m_divs)
+	{
+		m_divs = divs;
+		m_geometryDirty = true;
+	}
+}
+
 // 描画する
 void GridFloor::Render(ID3D11DeviceContext* context, DirectX::SimpleMath::Matrix view, DirectX::SimpleMath::Matrix projection, DirectX::GXMVECTOR color)
 {
+	// 大きさか分割数が変わっていれば格子の線分を作り直す
+	UpdateGeometry(context);
+
 	DirectX::SimpleMath::Matrix world;
 
 	context->OMSetBlendState(m_states->Opaque(), nullptr, 0xFFFFFFFF);
@@ -43,50 +69,27 @@ void GridFloor::Render(ID3D11DeviceContext* context, DirectX::SimpleMath::Matrix
 	m_basicEffect->SetView(view);
 	// プロジェクション行列を設定する
 	m_basicEffect->SetProjection(projection);
+	// 線の色を設定する
+	m_basicEffect->SetDiffuseColor(color);
+	m_basicEffect->SetAlpha(DirectX::XMVectorGetW(color));
 	// デバイスコンテキストを適用する
 	m_basicEffect->Apply(context);
 
 	context->IASetInputLayout(m_pInputLayout.Get());
 
-	m_primitiveBatch->Begin();
-
-	const DirectX::XMVECTORF32 xAxis = { m_size, 0.0f, 0.0f };
-	const DirectX::XMVECTORF32 yAxis = { 0.0f, 0.0f, m_size };
-
-	size_t divs = std::max<size_t>(1, m_divs);
-	DirectX::FXMVECTOR origin {};
-	for (size_t i = 0; i <= divs; ++i)
-	{
-		float fPercent = float(i) / float(divs);
-		fPercent = (fPercent * 1.0f) - 0.5f;
-		// スケールを設定する
-		DirectX::XMVECTOR vScale = XMVectorScale(xAxis, fPercent);
-		// 原点にスケールを加算する
-		vScale = DirectX::XMVectorAdd(vScale, origin);
-		// 起点を設定する
-		DirectX::VertexPositionColor v1(DirectX::XMVectorSubtract(vScale, yAxis * 0.5f), color);
-		// 終点を設定する
-		DirectX::VertexPositionColor v2(DirectX::XMVectorAdd(vScale, yAxis * 0.5f), color);
-		// 直線を描画する
-		m_primitiveBatch->DrawLine(v1, v2);
-	}
+	// 全ての線分を1回で描画する
+	m_geometry.Draw(context);
+}
 
-	for (size_t i = 0; i <= divs; i++)
-	{
-		FLOAT fPercent = float(i) / float(divs);
-		fPercent = (fPercent * 1.0f) - 0.5f;
-		// スケールを設定する
-		DirectX::XMVECTOR vScale = XMVectorScale(yAxis, fPercent);
-		// 原点にスケールを加算する
-		vScale = DirectX::XMVectorAdd(vScale, origin);
-		// 起点を設定する
-		DirectX::VertexPositionColor v1(DirectX::XMVectorSubtract(vScale, xAxis * 0.5f), color);
-		// 終点を設定する
-		DirectX::VertexPositionColor v2(DirectX::XMVectorAdd(vScale, xAxis * 0.5f), color);
-		// 直線を描画する
-		m_primitiveBatch->DrawLine(v1, v2);
-	}
+// 格子の線分を作り直す
+void GridFloor::UpdateGeometry(ID3D11DeviceContext* context)
+{
+	if (!m_geometryDirty)
+		return;
 
-	m_primitiveBatch->End();
+	const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	std::vector<MeshVertex> vertices;
+	LineGeometry::AppendGrid(m_size, m_divs, white, vertices);
+	m_geometry.SetVertices(context, vertices.data(), UINT(vertices.size()));
+	m_geometryDirty = false;
 }
-
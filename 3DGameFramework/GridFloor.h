@@ -1,12 +1,15 @@
 ﻿#ifndef GRIDFLOOR_DEFINED
 #define GRIDFLOOR_DEFINED
 
+#include "GeometryBuffer.h"
+
+// 格子の床(線分は書き換え不可の頂点バッファに置き、大きさか分割数が変わったときだけ作り直す)
 class GridFloor
 {
 	// エフェクト
 	std::unique_ptr<DirectX::BasicEffect> m_basicEffect;
-	// プリミティブバッチ
-	std::unique_ptr<DirectX::PrimitiveBatch<DirectX::VertexPositionColor>> m_primitiveBatch;
+	// 格子の線分
+	GeometryBuffer m_geometry;
 	// インプットレイアウト
 	Microsoft::WRL::ComPtr<ID3D11InputLayout> m_pInputLayout;
 	// コモンステートへのポインタ
@@ -15,14 +18,34 @@ class GridFloor
 	float m_size;
 	// 分割数
 	int m_divs;
+	// 格子の線分を作り直す必要があるか
+	bool m_geometryDirty;
 
 public:
 	// コンストラクタ
 	GridFloor(ID3D11Device* device, ID3D11DeviceContext* context, DirectX::CommonStates* states, float size, int divs);
 	// デストラクタ
 	~GridFloor();
+	// 床の一辺のサイズを設定する
+	void SetSize(float size);
+	// 分割数を設定する
+	void SetDivisions(int divs);
+	// 床の一辺のサイズを取得する
+	float GetSize() const
+	{
+		return m_size;
+	}
+	// 分割数を取得する
+	int GetDivisions() const
+	{
+		return m_divs;
+	}
 	// 描画する
 	void Render(ID3D11DeviceContext* context, DirectX::SimpleMath::Matrix view, DirectX::SimpleMath::Matrix proj, DirectX::GXMVECTOR color = DirectX::Colors::Gray);
+
+private:
+	// 格子の線分を作り直す
+	void UpdateGeometry(ID3D11DeviceContext* context);
 };
 
 #endif	// GRIDFLOOR_DEFINED
@@ -0,0 +1,185 @@
+﻿#include "InputLog.h"
+#include <iterator>
+#include <stdexcept>
+#include <string.h>
+
+static_assert(sizeof(InputLogHeader) == 16, "InputLogHeader layout must be stable");
+
+namespace
+{
+	// 値をストリームに書き込む
+	template<typename T>
+	void WriteValue(std::ofstream& stream, const T& value)
+	{
+		stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	// 値をバッファから読み込む
+	template<typename T>
+	void ReadValue(const std::vector<char>& data, size_t& offset, T& value, const std::string& filename)
+	{
+		if (data.size() - offset < sizeof(T))
+		{
+			throw std::runtime_error("InputPlayer: truncated log " + filename);
+		}
+		memcpy(&value, data.data() + offset, sizeof(T));
+		offset += sizeof(T);
+	}
+}
+
+// ファイルを作成してヘッダを書き込む
+InputRecorder::InputRecorder(const std::string& filename, uint64_t stepTicks)
+	: m_filename(filename), m_stream(filename, std::ios::binary | std::ios::trunc), m_last{}, m_lastTicks(0), m_started(false)
+{
+	if (stepTicks == 0)
+	{
+		throw std::invalid_argument("InputRecorder: step ticks must be positive");
+	}
+	InputLogHeader header = { MAGIC, VERSION, stepTicks };
+	WriteValue(m_stream, header);
+	if (!m_stream)
+	{
+		throw std::runtime_error("InputRecorder: cannot write " + m_filename);
+	}
+}
+
+// デストラクタ
+InputRecorder::~InputRecorder()
+{
+	if (m_stream.is_open())
+	{
+		WriteRecord(m_lastTicks, END, m_last);
+	}
+}
+
+// 指定された時刻の更新で使う入力を追加する
+void InputRecorder::Add(uint64_t ticks, const InputFrame& frame)
+{
+	if (!m_stream.is_open())
+	{
+		throw std::runtime_error("InputRecorder: log is closed " + m_filename);
+	}
+	if (m_started && ticks < m_lastTicks)
+	{
+		throw std::invalid_argument("InputRecorder: ticks must not go backwards");
+	}
+
+	// 最初の入力はすべての項目を書き込み、以降は変化した項目だけを書き込む
+	uint8_t fields = MOUSE_POSITION | SCROLL_WHEEL | MOUSE_BUTTONS | KEYS;
+	if (m_started)
+	{
+		fields = 0;
+		if (frame.mouseX != m_last.mouseX || frame.mouseY != m_last.mouseY)
+			fields |= MOUSE_POSITION;
+		if (frame.scrollWheel != m_last.scrollWheel)
+			fields |= SCROLL_WHEEL;
+		if (frame.mouseButtons != m_last.mouseButtons)
+			fields |= MOUSE_BUTTONS;
+		if (memcmp(frame.keys, m_last.keys, sizeof(frame.keys)) != 0)
+			fields |= KEYS;
+	}
+	if (fields != 0)
+	{
+		WriteRecord(ticks, fields, frame);
+	}
+	m_last = frame;
+	m_lastTicks = ticks;
+	m_started = true;
+}
+
+// 最後に更新した時刻で終わりを書き込んでファイルを閉じる
+void InputRecorder::Close(uint64_t ticks)
+{
+	if (!m_stream.is_open())
+	{
+		return;
+	}
+	WriteRecord(ticks < m_lastTicks ? m_lastTicks : ticks, END, m_last);
+	m_stream.close();
+	if (m_stream.fail())
+	{
+		throw std::runtime_error("InputRecorder: cannot write " + m_filename);
+	}
+}
+
+// 記録を書き込む
+void InputRecorder::WriteRecord(uint64_t ticks, uint8_t fields, const InputFrame& frame)
+{
+	WriteValue(m_stream, ticks);
+	WriteValue(m_stream, fields);
+	if (fields & MOUSE_POSITION)
+	{
+		WriteValue(m_stream, frame.mouseX);
+		WriteValue(m_stream, frame.mouseY);
+	}
+	if (fields & SCROLL_WHEEL)
+		WriteValue(m_stream, frame.scrollWheel);
+	if (fields & MOUSE_BUTTONS)
+		WriteValue(m_stream, frame.mouseButtons);
+	if (fields & KEYS)
+		WriteValue(m_stream, frame.keys);
+}
+
+// 入力ログを読み込む
+InputPlayer::InputPlayer(const std::string& filename)
+	: m_stepTicks(0), m_endTicks(0), m_next(0), m_current{}
+{
+	std::ifstream stream(filename, std::ios::binary);
+	if (!stream)
+	{
+		throw std::runtime_error("InputPlayer: cannot open " + filename);
+	}
+	std::vector<char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+	size_t offset = 0;
+	InputLogHeader header;
+	ReadValue(data, offset, header, filename);
+	if (header.magic != InputRecorder::MAGIC || header.version != InputRecorder::VERSION || header.stepTicks == 0)
+	{
+		throw std::runtime_error("InputPlayer: unsupported file " + filename);
+	}
+	m_stepTicks = header.stepTicks;
+
+	// 変化した項目を直前の入力に適用して、記録ごとの入力を復元する
+	InputFrame frame = {};
+	for (;;)
+	{
+		uint64_t ticks;
+		uint8_t fields;
+		ReadValue(data, offset, ticks, filename);
+		ReadValue(data, offset, fields, filename);
+		if (!m_records.empty() && ticks < m_records.back().ticks)
+		{
+			throw std::runtime_error("InputPlayer: corrupt record " + filename);
+		}
+		if (fields & InputRecorder::END)
+		{
+			m_endTicks = ticks;
+			break;
+		}
+		if (fields & InputRecorder::MOUSE_POSITION)
+		{
+			ReadValue(data, offset, frame.mouseX, filename);
+			ReadValue(data, offset, frame.mouseY, filename);
+		}
+		if (fields & InputRecorder::SCROLL_WHEEL)
+			ReadValue(data, offset, frame.scrollWheel, filename);
+		if (fields & InputRecorder::MOUSE_BUTTONS)
+			ReadValue(data, offset, frame.mouseButtons, filename);
+		if (fields & InputRecorder::KEYS)
+			ReadValue(data, offset, frame.keys, filename);
+		m_records.push_back({ ticks, frame });
+	}
+}
+
+// 指定された時刻の更新で使う入力を取得する
+void InputPlayer::Read(uint64_t ticks, InputFrame& frame)
+{
+	// 時刻までの記録を順に適用する(記録の後は最後の入力が続く)
+	while (m_next < m_records.size() && m_records[m_next].ticks <= ticks)
+	{
+		m_current = m_records[m_next].frame;
+		m_next++;
+	}
+	frame = m_current;
+}
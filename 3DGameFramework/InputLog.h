@@ -0,0 +1,107 @@
+﻿#pragma once
+#ifndef INPUTLOG_DEFINED
+#define INPUTLOG_DEFINED
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "InputState.h"
+#include "NonCopyable.h"
+
+// 入力ログのヘッダ
+// ヘッダの後に記録が続く。記録は更新の時刻(StepTimerのティック)と変化した項目のビット、変化した項目の値からなる
+struct InputLogHeader
+{
+	// 識別子
+	uint32_t magic;
+	// バージョン
+	uint32_t version;
+	// 記録したときの固定ステップの間隔(ティック)
+	uint64_t stepTicks;
+};
+
+// 更新ごとの入力を、前回から変化した項目だけの記録としてバイナリファイルに書き出すクラス
+class InputRecorder : public NonCopyable
+{
+public:
+	// 識別子("INPT")
+	static const uint32_t MAGIC = 0x54504E49;
+	// 現在のバージョン
+	static const uint32_t VERSION = 1;
+	// 記録の項目のビット
+	static const uint8_t MOUSE_POSITION = 1;
+	static const uint8_t SCROLL_WHEEL = 2;
+	static const uint8_t MOUSE_BUTTONS = 4;
+	static const uint8_t KEYS = 8;
+	// 記録の終わり(最後に更新した時刻を持つ)
+	static const uint8_t END = 0x80;
+
+	// ファイルを作成してヘッダを書き込む
+	InputRecorder(const std::string& filename, uint64_t stepTicks);
+	// デストラクタ(閉じていない場合は最後に追加した時刻で終わりを書き込む)
+	~InputRecorder();
+
+	// 指定された時刻の更新で使う入力を追加する(前回から変化した項目だけを書き込む)
+	void Add(uint64_t ticks, const InputFrame& frame);
+	// 最後に更新した時刻で終わりを書き込んでファイルを閉じる
+	void Close(uint64_t ticks);
+
+private:
+	// 記録を書き込む
+	void WriteRecord(uint64_t ticks, uint8_t fields, const InputFrame& frame);
+
+private:
+	// ファイル名
+	std::string m_filename;
+	// 出力ストリーム
+	std::ofstream m_stream;
+	// 前回追加した入力
+	InputFrame m_last;
+	// 前回追加した時刻
+	uint64_t m_lastTicks;
+	// 入力を追加したかどうか
+	bool m_started;
+};
+
+// 入力ログを読み込み、更新の時刻に対応する入力を再生するクラス
+class InputPlayer : public NonCopyable
+{
+public:
+	// 入力ログを読み込む
+	explicit InputPlayer(const std::string& filename);
+
+	// 記録したときの固定ステップの間隔(ティック)を取得する
+	uint64_t GetStepTicks() const
+	{
+		return m_stepTicks;
+	}
+	// 記録した更新の回数を取得する
+	uint32_t GetUpdateCount() const
+	{
+		return uint32_t(m_endTicks / m_stepTicks);
+	}
+	// 指定された時刻の更新で使う入力を取得する(時刻は前回以上でなければならない)
+	void Read(uint64_t ticks, InputFrame& frame);
+
+private:
+	// 時刻と入力の記録
+	struct Record
+	{
+		uint64_t ticks;
+		InputFrame frame;
+	};
+
+	// 記録
+	std::vector<Record> m_records;
+	// 固定ステップの間隔
+	uint64_t m_stepTicks;
+	// 最後に更新した時刻
+	uint64_t m_endTicks;
+	// 次に適用する記録
+	size_t m_next;
+	// 現在の入力
+	InputFrame m_current;
+};
+
+#endif	// INPUTLOG_DEFINED
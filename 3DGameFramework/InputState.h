@@ -0,0 +1,134 @@
+﻿#pragma once
+#ifndef INPUTSTATE_DEFINED
+#define INPUTSTATE_DEFINED
+
+#include <mutex>
+#include <stdint.h>
+
+// 1回の更新で使う入力(マウスとキーボードの状態)
+struct InputFrame
+{
+	// マウスの位置(クライアント座標)
+	int32_t mouseX;
+	int32_t mouseY;
+	// マウスホイールの累積値
+	int32_t scrollWheel;
+	// 押されているマウスボタン(InputState::MOUSE_LEFTなどの組み合わせ)
+	uint8_t mouseButtons;
+	// 押されているキー(仮想キーコードを番号とするビット列)
+	uint8_t keys[32];
+};
+
+// 更新ごとの入力を受け取り、直前の更新からの変化を判定する
+// Gameが更新の前に入力を設定するので、更新ではデバイスを直接読まずにこのクラスを使う(入力の記録と再生で同じ結果になる)
+class InputState
+{
+public:
+	// マウスボタン
+	static const uint8_t MOUSE_LEFT = 1;
+	static const uint8_t MOUSE_MIDDLE = 2;
+	static const uint8_t MOUSE_RIGHT = 4;
+
+	// コンストラクタ
+	InputState() : m_current{}, m_previous{}
+	{
+	}
+
+	// 次の更新の入力を設定する(現在の入力は直前の入力になる)
+	void Advance(const InputFrame& frame)
+	{
+		m_previous = m_current;
+		m_current = frame;
+	}
+	// 現在の入力を取得する
+	const InputFrame& GetFrame() const
+	{
+		return m_current;
+	}
+
+	// マウスのX座標を取得する
+	int GetMouseX() const
+	{
+		return m_current.mouseX;
+	}
+	// マウスのY座標を取得する
+	int GetMouseY() const
+	{
+		return m_current.mouseY;
+	}
+	// マウスホイールの累積値を取得する
+	int GetScrollWheel() const
+	{
+		return m_current.scrollWheel;
+	}
+	// マウスボタンが押されているかどうかを取得する
+	bool IsMouseDown(uint8_t button) const
+	{
+		return (m_current.mouseButtons & button) != 0;
+	}
+	// マウスボタンがこの更新で押されたかどうかを取得する
+	bool IsMousePressed(uint8_t button) const
+	{
+		return (m_current.mouseButtons & button) != 0 && (m_previous.mouseButtons & button) == 0;
+	}
+	// マウスボタンがこの更新で離されたかどうかを取得する
+	bool IsMouseReleased(uint8_t button) const
+	{
+		return (m_current.mouseButtons & button) == 0 && (m_previous.mouseButtons & button) != 0;
+	}
+	// キーが押されているかどうかを取得する
+	bool IsKeyDown(uint8_t key) const
+	{
+		return IsKeyDown(m_current, key);
+	}
+	// キーがこの更新で押されたかどうかを取得する
+	bool IsKeyPressed(uint8_t key) const
+	{
+		return IsKeyDown(m_current, key) && !IsKeyDown(m_previous, key);
+	}
+
+private:
+	// 入力でキーが押されているかどうかを取得する
+	static bool IsKeyDown(const InputFrame& frame, uint8_t key)
+	{
+		return (frame.keys[key >> 3] & (1 << (key & 7))) != 0;
+	}
+
+private:
+	// 現在の入力
+	InputFrame m_current;
+	// 直前の更新の入力
+	InputFrame m_previous;
+};
+
+// デバイスから読んだ最新の入力を、更新するスレッドへ受け渡す
+// デバイスはウィンドウのメッセージを処理するスレッドで読み、パイプライン動作の更新スレッドはこのクラスから最新の入力を受け取る
+class InputMailbox
+{
+public:
+	// コンストラクタ
+	InputMailbox() : m_frame{}
+	{
+	}
+
+	// 最新の入力を書き込む
+	void Post(const InputFrame& frame)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_frame = frame;
+	}
+	// 最新の入力を取得する
+	InputFrame Read() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_frame;
+	}
+
+private:
+	// 入力を保護するミューテックス
+	mutable std::mutex m_mutex;
+	// 最新の入力
+	InputFrame m_frame;
+};
+
+#endif	// INPUTSTATE_DEFINED
@@ -0,0 +1,36 @@
+﻿#include "InstanceRingBuffer.h"
+#include <stdexcept>
+#include <string.h>
+
+// コンストラクタ
+InstanceRingBuffer::InstanceRingBuffer(ID3D11Device* device, UINT capacity)
+	: m_capacity(capacity), m_position(capacity), m_wrapCount(0)
+{
+	CD3D11_BUFFER_DESC desc(capacity * UINT(sizeof(InstanceData)), D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+	DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, m_buffer.ReleaseAndGetAddressOf()));
+}
+
+// インスタンスデータを書き込み、書き込んだ位置を頂点バッファのスロットに設定する
+void InstanceRingBuffer::Append(ID3D11DeviceContext* context, UINT slot, const InstanceData* instances, UINT count)
+{
+	if (count > m_capacity)
+		throw std::invalid_argument("InstanceRingBuffer: too many instances");
+
+	// 残りに収まれば追記し、収まらなければ内容を破棄して先頭から書く(最初の書き込みも破棄から始める)
+	D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+	if (m_position + count > m_capacity)
+	{
+		mapType = D3D11_MAP_WRITE_DISCARD;
+		m_position = 0;
+		m_wrapCount++;
+	}
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	DX::ThrowIfFailed(context->Map(m_buffer.Get(), 0, mapType, 0, &mapped));
+	memcpy(static_cast<InstanceData*>(mapped.pData) + m_position, instances, sizeof(InstanceData) * count);
+	context->Unmap(m_buffer.Get(), 0);
+
+	UINT stride = UINT(sizeof(InstanceData));
+	UINT offset = m_position * stride;
+	context->IASetVertexBuffers(slot, 1, m_buffer.GetAddressOf(), &stride, &offset);
+	m_position += count;
+}
@@ -0,0 +1,41 @@
+﻿#pragma once
+#ifndef INSTANCERINGBUFFER_DEFINED
+#define INSTANCERINGBUFFER_DEFINED
+
+#include "RenderQueue.h"
+
+// インスタンスデータを毎フレーム流し込む動的頂点バッファ
+// 前回の書き込みの後ろに追記し(GPUが使用中の領域を上書きしないので待たずに済む)、末尾に達したら内容を破棄して先頭から書き直す
+class InstanceRingBuffer
+{
+public:
+	// 既定の容量(インスタンス数)
+	static const UINT DEFAULT_CAPACITY = 16384;
+
+	// コンストラクタ
+	InstanceRingBuffer(ID3D11Device* device, UINT capacity = DEFAULT_CAPACITY);
+	// インスタンスデータを書き込み、書き込んだ位置を頂点バッファのスロットに設定する(容量を超える場合は例外を投げる)
+	void Append(ID3D11DeviceContext* context, UINT slot, const InstanceData* instances, UINT count);
+	// 容量(インスタンス数)を取得する
+	UINT GetCapacity() const
+	{
+		return m_capacity;
+	}
+	// 内容を破棄して先頭に戻った回数を取得する
+	uint32_t GetWrapCount() const
+	{
+		return m_wrapCount;
+	}
+
+private:
+	// 頂点バッファ
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_buffer;
+	// 容量(インスタンス数)
+	UINT m_capacity;
+	// 次に書き込む位置(インスタンス数)
+	UINT m_position;
+	// 先頭に戻った回数
+	uint32_t m_wrapCount;
+};
+
+#endif	// INSTANCERINGBUFFER_DEFINED
@@ -0,0 +1,99 @@
+﻿#include "InstancedEffect.h"
+#include <string.h>
+#include "RenderQueue.h"
+
+namespace
+{
+	// コンパイル済みのシェーダ(ビルド時にHLSLから生成される)
+	#include "InstancedVS.inc"
+	#include "InstancedPS.inc"
+
+	// 頂点とインスタンスデータの入力要素
+	const D3D11_INPUT_ELEMENT_DESC INPUT_ELEMENTS[] =
+	{
+		{ "SV_Position", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, InstancedEffect::INSTANCE_SLOT, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, InstancedEffect::INSTANCE_SLOT, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, InstancedEffect::INSTANCE_SLOT, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "COLOR", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, InstancedEffect::INSTANCE_SLOT, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	};
+	// 量子化した頂点とインスタンスデータの入力要素(頂点シェーダには正規化した値が渡る)
+	const D3D11_INPUT_ELEMENT_DESC QUANTIZED_INPUT_ELEMENTS[] =
+	{
+		{ "SV_Position", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, InstancedEffect::INSTANCE_SLOT, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, InstancedEffect::INSTANCE_SLOT, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, InstancedEffect::INSTANCE_SLOT, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "COLOR", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, InstancedEffect::INSTANCE_SLOT, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	};
+}
+
+// コンストラクタ
+InstancedEffect::InstancedEffect(ID3D11Device* device)
+	: m_view(DirectX::SimpleMath::Matrix::Identity), m_projection(DirectX::SimpleMath::Matrix::Identity), m_dirty(true)
+{
+	static_assert(sizeof(InstanceData) == 64, "InstanceData must match the instance input elements");
+	DX::ThrowIfFailed(device->CreateVertexShader(g_InstancedVS, sizeof(g_InstancedVS), nullptr, m_vertexShader.ReleaseAndGetAddressOf()));
+	DX::ThrowIfFailed(device->CreatePixelShader(g_InstancedPS, sizeof(g_InstancedPS), nullptr, m_pixelShader.ReleaseAndGetAddressOf()));
+	CD3D11_BUFFER_DESC desc(sizeof(DirectX::SimpleMath::Matrix), D3D11_BIND_CONSTANT_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+	DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, m_constantBuffer.ReleaseAndGetAddressOf()));
+}
+
+// シェーダと定数バッファを設定する
+void InstancedEffect::Apply(ID3D11DeviceContext* context)
+{
+	// 行列が変わったときだけ定数バッファを書き換える(HLSLは列優先なので転置して渡す)
+	if (m_dirty)
+	{
+		DirectX::SimpleMath::Matrix viewProjection = (m_view * m_projection).Transpose();
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		DX::ThrowIfFailed(context->Map(m_constantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+		memcpy(mapped.pData, &viewProjection, sizeof(viewProjection));
+		context->Unmap(m_constantBuffer.Get(), 0);
+		m_dirty = false;
+	}
+	context->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+	context->VSSetConstantBuffers(0, 1, m_constantBuffer.GetAddressOf());
+	context->PSSetShader(m_pixelShader.Get(), nullptr, 0);
+}
+
+// 頂点シェーダのバイトコードを取得する
+void InstancedEffect::GetVertexShaderBytecode(void const** shaderByteCode, size_t* byteCodeLength)
+{
+	*shaderByteCode = g_InstancedVS;
+	*byteCodeLength = sizeof(g_InstancedVS);
+}
+
+// ワールド行列を設定する
+void XM_CALLCONV InstancedEffect::SetWorld(DirectX::FXMMATRIX)
+{
+}
+
+// ビュー行列を設定する
+void XM_CALLCONV InstancedEffect::SetView(DirectX::FXMMATRIX value)
+{
+	m_view = value;
+	m_dirty = true;
+}
+
+// 射影行列を設定する
+void XM_CALLCONV InstancedEffect::SetProjection(DirectX::FXMMATRIX value)
+{
+	m_projection = value;
+	m_dirty = true;
+}
+
+// インスタンス描画用のインプットレイアウトを生成する
+void InstancedEffect::CreateInputLayout(ID3D11Device* device, ID3D11InputLayout** inputLayout, bool quantized)
+{
+	if (quantized)
+	{
+		DX::ThrowIfFailed(device->CreateInputLayout(QUANTIZED_INPUT_ELEMENTS, UINT(_countof(QUANTIZED_INPUT_ELEMENTS)),
+			g_InstancedVS, sizeof(g_InstancedVS), inputLayout));
+		return;
+	}
+	DX::ThrowIfFailed(device->CreateInputLayout(INPUT_ELEMENTS, UINT(_countof(INPUT_ELEMENTS)),
+		g_InstancedVS, sizeof(g_InstancedVS), inputLayout));
+}
@@ -0,0 +1,44 @@
+﻿#pragma once
+#ifndef INSTANCEDEFFECT_DEFINED
+#define INSTANCEDEFFECT_DEFINED
+
+// 頂点の色にインスタンスの色を掛け、インスタンスごとのワールド行列で変換して描画するエフェクト
+// 頂点はスロット0(VertexPositionColorかQuantizedVertex)、インスタンスデータはスロット1(InstanceData)から読む
+class InstancedEffect : public DirectX::IEffect, public DirectX::IEffectMatrices
+{
+public:
+	// インスタンスデータを読むスロット
+	static const UINT INSTANCE_SLOT = 1;
+
+	// コンストラクタ
+	InstancedEffect(ID3D11Device* device);
+
+	// シェーダと定数バッファを設定する
+	void Apply(ID3D11DeviceContext* context) override;
+	// 頂点シェーダのバイトコードを取得する
+	void GetVertexShaderBytecode(void const** shaderByteCode, size_t* byteCodeLength) override;
+	// ワールド行列を設定する(インスタンスデータから読むので使わない)
+	void XM_CALLCONV SetWorld(DirectX::FXMMATRIX value) override;
+	// ビュー行列を設定する
+	void XM_CALLCONV SetView(DirectX::FXMMATRIX value) override;
+	// 射影行列を設定する
+	void XM_CALLCONV SetProjection(DirectX::FXMMATRIX value) override;
+	// インスタンス描画用のインプットレイアウトを生成する(quantizedの場合は量子化した頂点を読む)
+	void CreateInputLayout(ID3D11Device* device, ID3D11InputLayout** inputLayout, bool quantized = false);
+
+private:
+	// 頂点シェーダ
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> m_vertexShader;
+	// ピクセルシェーダ
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> m_pixelShader;
+	// ビュー行列と射影行列を掛けた行列の定数バッファ
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_constantBuffer;
+	// ビュー行列
+	DirectX::SimpleMath::Matrix m_view;
+	// 射影行列
+	DirectX::SimpleMath::Matrix m_projection;
+	// 定数バッファを更新する必要があるかどうか
+	bool m_dirty;
+};
+
+#endif	// INSTANCEDEFFECT_DEFINED
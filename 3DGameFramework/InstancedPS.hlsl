@@ -0,0 +1,11 @@
+// 頂点シェーダで求めた色をそのまま出力するピクセルシェーダ
+
+struct PSInput
+{
+	float4 Color : COLOR0;
+};
+
+float4 main(PSInput input) : SV_Target0
+{
+	return input.Color;
+}
@@ -0,0 +1,35 @@
+// インスタンスごとのワールド行列で頂点を変換し、頂点の色にインスタンスの色を掛ける頂点シェーダ
+
+cbuffer Parameters : register(b0)
+{
+	// ビュー行列と射影行列を掛けた行列
+	float4x4 ViewProjection;
+};
+
+struct VSInput
+{
+	// 頂点(スロット0)
+	float3 Position : SV_Position;
+	float4 Color : COLOR0;
+	// インスタンス(スロット1、ワールド行列を転置した上3行と色)
+	float4 World0 : WORLD0;
+	float4 World1 : WORLD1;
+	float4 World2 : WORLD2;
+	float4 InstanceColor : COLOR1;
+};
+
+struct VSOutput
+{
+	float4 Color : COLOR0;
+	float4 PositionPS : SV_Position;
+};
+
+VSOutput main(VSInput input)
+{
+	float4 position = float4(input.Position, 1.0f);
+	float3 world = float3(dot(input.World0, position), dot(input.World1, position), dot(input.World2, position));
+	VSOutput output;
+	output.PositionPS = mul(float4(world, 1.0f), ViewProjection);
+	output.Color = input.Color * input.InstanceColor;
+	return output;
+}
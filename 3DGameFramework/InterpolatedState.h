@@ -0,0 +1,77 @@
+﻿#pragma once
+#ifndef INTERPOLATEDSTATE_DEFINED
+#define INTERPOLATEDSTATE_DEFINED
+
+// 2つの値を補間する(SimpleMathの型など静的なLerp関数を持つ型)
+template<typename T>
+inline T InterpolateValue(const T& previous, const T& current, float alpha)
+{
+	return T::Lerp(previous, current, alpha);
+}
+
+// 2つの値を補間する(float)
+inline float InterpolateValue(float previous, float current, float alpha)
+{
+	return previous + (current - previous) * alpha;
+}
+
+// 固定ステップの開始を受け取る補間状態のインターフェース
+class InterpolatedStateBase
+{
+public:
+	// デストラクタ
+	virtual ~InterpolatedStateBase() {}
+	// 固定ステップの開始時に現在の状態を直前の状態として保存する
+	virtual void BeginStep() = 0;
+};
+
+// 直前と現在の2つの固定ステップの状態を保持し、描画時に補間するシミュレーション状態
+template<typename T>
+class InterpolatedState : public InterpolatedStateBase
+{
+public:
+	// コンストラクタ
+	InterpolatedState(const T& value = T()) : m_previous(value), m_current(value)
+	{
+	}
+
+	// 固定ステップの開始時に現在の状態を直前の状態として保存する
+	void BeginStep() override
+	{
+		m_previous = m_current;
+	}
+	// 直前と現在の状態を同じ値にする(ワープなど補間したくない場合)
+	void Reset(const T& value)
+	{
+		m_previous = m_current = value;
+	}
+
+	// 更新で書き換える現在の状態を取得する
+	T& GetCurrent()
+	{
+		return m_current;
+	}
+	// 現在の状態を取得する
+	const T& GetCurrent() const
+	{
+		return m_current;
+	}
+	// 直前の状態を取得する
+	const T& GetPrevious() const
+	{
+		return m_previous;
+	}
+	// 直前の状態から現在の状態へalpha(0～1)で補間した状態を取得する
+	T Interpolate(float alpha) const
+	{
+		return InterpolateValue(m_previous, m_current, alpha);
+	}
+
+private:
+	// 直前の固定ステップの状態
+	T m_previous;
+	// 現在の固定ステップの状態
+	T m_current;
+};
+
+#endif	// INTERPOLATEDSTATE_DEFINED
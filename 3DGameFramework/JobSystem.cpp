@@ -0,0 +1,262 @@
+﻿#include "JobSystem.h"
+#include <algorithm>
+#include <string>
+#include "Profiler.h"
+
+namespace
+{
+	// 現在のスレッドのキュー番号(ワーカー以外は0)
+	thread_local unsigned t_queueIndex = 0;
+	// 現在のスレッドが属するジョブシステム
+	thread_local const JobSystem* t_owner = nullptr;
+	// 盗み取りを始めるキューをずらすための値
+	thread_local unsigned t_stealSeed = 0;
+}
+
+// コンストラクタ
+JobSystem::JobSystem(unsigned workerCount)
+	: m_injectedHead(nullptr), m_injectedTail(nullptr), m_pending(0), m_sleeping(0), m_injectedCount(0), m_quit(false)
+{
+	if (workerCount == 0)
+	{
+		unsigned hardware = std::thread::hardware_concurrency();
+		workerCount = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	for (unsigned i = 0; i < workerCount; i++)
+	{
+		m_deques.push_back(std::make_unique<WorkStealingDeque<JobRecord*>>());
+	}
+	// 記録のプールは最初のチャンクを先に確保しておく(ワーカーが初めてジョブを積んだフレームでヒープを確保しない)
+	for (unsigned i = 0; i <= workerCount; i++)
+	{
+		m_recordPools.push_back(std::make_unique<ObjectPool<JobRecord>>());
+		m_recordPools.back()->Reserve(FixedPool::DEFAULT_BLOCKS_PER_CHUNK);
+	}
+	for (unsigned i = 1; i <= workerCount; i++)
+	{
+		m_workers.emplace_back(&JobSystem::WorkerMain, this, i);
+	}
+}
+
+// デストラクタ
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+// 現在のスレッドのキュー番号を取得する
+unsigned JobSystem::GetQueueIndex() const
+{
+	return t_owner == this ? t_queueIndex : 0;
+}
+
+// 記録をキュー番号のプールから確保する
+JobSystem::JobRecord* JobSystem::AllocateRecord(unsigned queueIndex)
+{
+	JobRecord* record;
+	if (queueIndex != 0)
+	{
+		record = m_recordPools[queueIndex]->Create();
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_externalPoolMutex);
+		record = m_recordPools[0]->Create();
+	}
+	record->owner = queueIndex;
+	return record;
+}
+
+// 記録を確保したプールに返す
+void JobSystem::FreeRecord(unsigned queueIndex, JobRecord* record)
+{
+	if (record->owner == 0)
+	{
+		std::lock_guard<std::mutex> lock(m_externalPoolMutex);
+		m_recordPools[0]->Destroy(record);
+	}
+	else if (record->owner == queueIndex)
+	{
+		m_recordPools[queueIndex]->Destroy(record);
+	}
+	else
+	{
+		// 他のワーカーのプールにはロックなしで返却する
+		m_recordPools[record->owner]->DestroyRemote(record);
+	}
+}
+
+// 記録をキューに積んでワーカーを起こす
+void JobSystem::Submit(unsigned queueIndex, JobRecord* record, JobCounter& counter)
+{
+	counter.m_count.fetch_add(1, std::memory_order_relaxed);
+	record->counter = &counter;
+	record->next = nullptr;
+
+	// ワーカーから投入された場合は自分のキューに積む
+	if (queueIndex != 0)
+	{
+		m_deques[queueIndex - 1]->Push(record);
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_injectedMutex);
+		if (m_injectedTail != nullptr)
+			m_injectedTail->next = record;
+		else
+			m_injectedHead = record;
+		m_injectedTail = record;
+		m_injectedCount.fetch_add(1, std::memory_order_release);
+	}
+
+	// 眠っているワーカーがいる場合だけ起こす
+	// (m_pendingとm_sleepingはどちらも逐次一貫で更新するので、ワーカーが眠る直前の確認と行き違うことはない)
+	m_pending.fetch_add(1, std::memory_order_seq_cst);
+	if (m_sleeping.load(std::memory_order_seq_cst) != 0)
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_wake.notify_one();
+	}
+}
+
+// カウンタが0になるまで他のジョブを手伝いながら待つ
+void JobSystem::Wait(JobCounter& counter)
+{
+	unsigned queueIndex = GetQueueIndex();
+	while (counter.IsBusy())
+	{
+		if (!ExecuteOne(queueIndex))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// ジョブが例外を投げていた場合は待っていたスレッドで投げ直す
+	std::exception_ptr exception = counter.TakeException();
+	if (exception)
+		std::rethrow_exception(exception);
+}
+
+// 範囲を分割して並列に実行する
+void JobSystem::ParallelForRange(size_t count, size_t grainSize, const RangeBody& body)
+{
+	if (count == 0)
+		return;
+
+	grainSize = std::max<size_t>(grainSize, 1);
+	JobCounter counter;
+	// 呼び出し元で処理する範囲が例外を投げても、投入したジョブがcounterとbodyを参照しているので終わるまで待つ
+	try
+	{
+		Split(0, count, grainSize, body, counter);
+	}
+	catch (...)
+	{
+		counter.SetException(std::current_exception());
+	}
+	Wait(counter);
+}
+
+// 範囲を半分ずつ分割して後半をジョブとして投入し、残りを呼び出し元で処理する
+void JobSystem::Split(size_t begin, size_t end, size_t grainSize, const RangeBody& body, JobCounter& counter)
+{
+	while (end - begin > grainSize)
+	{
+		// 分割位置を粒度の倍数にそろえる
+		size_t chunks = (end - begin + grainSize - 1) / grainSize;
+		size_t middle = begin + chunks / 2 * grainSize;
+		Run([this, middle, end, grainSize, &body, &counter]() { Split(middle, end, grainSize, body, counter); }, counter);
+		end = middle;
+	}
+	body.invoke(body.body, begin, end);
+}
+
+// ワーカースレッドの処理
+void JobSystem::WorkerMain(unsigned index)
+{
+	t_queueIndex = index;
+	t_owner = this;
+	Profiler::Get().SetThreadName("Worker " + std::to_string(index));
+
+	while (true)
+	{
+		if (ExecuteOne(index))
+			continue;
+
+		// ジョブが無い場合は投入されるまで眠る
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+		m_wake.wait(lock, [this]() { return m_quit || m_pending.load(std::memory_order_seq_cst) != 0; });
+		m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+		if (m_quit)
+			return;
+	}
+}
+
+// ジョブを1つ取り出して実行する
+bool JobSystem::ExecuteOne(unsigned queueIndex)
+{
+	JobRecord* record;
+	if (!Pop(queueIndex, record))
+		return false;
+
+	m_pending.fetch_sub(1, std::memory_order_acq_rel);
+	JobCounter* counter = record->counter;
+	// 例外はワーカーの外へ出さずにカウンタへ保存し、完了は必ず通知する
+	try
+	{
+		record->invoke(*record);
+	}
+	catch (...)
+	{
+		counter->SetException(std::current_exception());
+	}
+	FreeRecord(queueIndex, record);
+	counter->m_count.fetch_sub(1, std::memory_order_acq_rel);
+	return true;
+}
+
+// 自分のキューの末尾、外部スレッドのキュー、他のワーカーのキューの先頭の順にジョブを取り出す
+bool JobSystem::Pop(unsigned queueIndex, JobRecord*& record)
+{
+	// 自分のキューは新しいものから取る(キャッシュに残っているデータを使う)
+	if (queueIndex != 0 && m_deques[queueIndex - 1]->Pop(record))
+		return true;
+
+	if (m_pending.load(std::memory_order_acquire) == 0)
+		return false;
+
+	if (m_injectedCount.load(std::memory_order_acquire) != 0)
+	{
+		std::lock_guard<std::mutex> lock(m_injectedMutex);
+		if (m_injectedHead != nullptr)
+		{
+			record = m_injectedHead;
+			m_injectedHead = record->next;
+			if (m_injectedHead == nullptr)
+				m_injectedTail = nullptr;
+			m_injectedCount.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	// 他のワーカーのキューからは古いものから盗み取る(盗み取る相手が偏らないよう開始位置をずらす)
+	unsigned dequeCount = unsigned(m_deques.size());
+	unsigned start = t_stealSeed++;
+	for (unsigned i = 0; i < dequeCount; i++)
+	{
+		unsigned victim = (start + i) % dequeCount;
+		if (victim + 1 != queueIndex && m_deques[victim]->Steal(record))
+			return true;
+	}
+	return false;
+}
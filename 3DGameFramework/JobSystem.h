@@ -0,0 +1,226 @@
+﻿#pragma once
+#ifndef JOBSYSTEM_DEFINED
+#define JOBSYSTEM_DEFINED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "NonCopyable.h"
+#include "PoolAllocator.h"
+#include "WorkStealingDeque.h"
+
+// ジョブの完了を待つためのカウンタ
+// ジョブが例外を投げた場合もカウンタは減り、最初の例外をWaitが投げ直す
+class JobCounter : public NonCopyable
+{
+public:
+	// コンストラクタ
+	JobCounter() : m_count(0)
+	{
+	}
+	// 未完了のジョブがあるかどうか
+	bool IsBusy() const
+	{
+		return m_count.load(std::memory_order_acquire) != 0;
+	}
+
+private:
+	friend class JobSystem;
+
+	// ジョブが投げた例外を保存する(最初の例外だけを残す)
+	void SetException(std::exception_ptr exception)
+	{
+		std::lock_guard<std::mutex> lock(m_exceptionMutex);
+		if (!m_exception)
+			m_exception = exception;
+	}
+	// 保存した例外を取り出す(無い場合はnullptr)
+	std::exception_ptr TakeException()
+	{
+		std::lock_guard<std::mutex> lock(m_exceptionMutex);
+		std::exception_ptr exception = m_exception;
+		m_exception = nullptr;
+		return exception;
+	}
+
+private:
+	// 未完了のジョブ数
+	std::atomic<uint32_t> m_count;
+	// ジョブが投げた最初の例外
+	std::exception_ptr m_exception;
+	// 例外を保護するミューテックス(例外が投げられたときだけ使う)
+	std::mutex m_exceptionMutex;
+};
+
+// ワーカーごとのロックフリーのキューと盗み取り(ワークスティーリング)でジョブを実行するスレッドプール
+// ジョブの記録はスレッドごとのプールから確保し、小さな関数オブジェクトは記録の中に直接格納するので、定常状態ではヒープを使わない
+class JobSystem : public NonCopyable
+{
+public:
+	// ジョブ
+	typedef std::function<void()> Job;
+	// 記録の中に直接格納できる関数オブジェクトの最大サイズ(これを超えるものはヒープに確保する)
+	static const size_t INLINE_JOB_SIZE = 64;
+
+	// コンストラクタ(0の場合はハードウェアスレッド数-1のワーカーを生成する)
+	explicit JobSystem(unsigned workerCount = 0);
+	// デストラクタ
+	~JobSystem();
+
+	// ジョブを投入する(引数なしで呼び出せる関数オブジェクト)
+	template<typename Function>
+	void Run(Function&& function, JobCounter& counter)
+	{
+		typedef typename std::decay<Function>::type Callable;
+		typedef std::integral_constant<bool, sizeof(Callable) <= INLINE_JOB_SIZE && alignof(Callable) <= alignof(std::max_align_t)> IsInline;
+
+		unsigned queueIndex = GetQueueIndex();
+		JobRecord* record = AllocateRecord(queueIndex);
+		try
+		{
+			Store<Callable>(*record, std::forward<Function>(function), IsInline());
+		}
+		catch (...)
+		{
+			FreeRecord(queueIndex, record);
+			throw;
+		}
+		Submit(queueIndex, record, counter);
+	}
+	// カウンタが0になるまで他のジョブを手伝いながら待つ(ジョブが例外を投げていた場合は最初の例外を投げ直す)
+	void Wait(JobCounter& counter);
+	// 範囲を分割して並列に実行する(呼び出し元のスレッドも実行に加わる。bodyは(size_t begin, size_t end)で呼び出せること)
+	// bodyが例外を投げた場合も、投入済みの範囲がすべて終わってから最初の例外を投げ直す
+	// 範囲は半分ずつ再帰的に分割してワーカーに盗み取らせる。各範囲の開始位置はgrainSizeの倍数で、長さはgrainSize以下になる
+	template<typename Body>
+	void ParallelFor(size_t count, size_t grainSize, const Body& body)
+	{
+		RangeBody range = { &InvokeRange<Body>, &body };
+		ParallelForRange(count, grainSize, range);
+	}
+
+	// ワーカースレッド数を取得する
+	unsigned GetWorkerCount() const
+	{
+		return unsigned(m_workers.size());
+	}
+
+private:
+	// 投入されたジョブ
+	struct JobRecord
+	{
+		// 格納した関数オブジェクトを呼び出して破棄する関数
+		void (*invoke)(JobRecord& record);
+		// 完了を通知するカウンタ
+		JobCounter* counter;
+		// 外部スレッドのキューでの次のジョブ
+		JobRecord* next;
+		// 確保したプールのキュー番号
+		unsigned owner;
+		// 関数オブジェクト(大きいものはヒープに確保したオブジェクトへのポインタ)
+		alignas(std::max_align_t) unsigned char storage[INLINE_JOB_SIZE];
+	};
+	// 範囲を処理する関数への参照(ParallelForの間だけ有効なので、コピーせずにジョブへ渡せる)
+	struct RangeBody
+	{
+		// 呼び出す関数
+		void (*invoke)(const void* body, size_t begin, size_t end);
+		// 関数オブジェクト
+		const void* body;
+	};
+
+	// 記録の中に関数オブジェクトを格納する
+	template<typename Callable, typename Function>
+	static void Store(JobRecord& record, Function&& function, std::true_type)
+	{
+		new (record.storage) Callable(std::forward<Function>(function));
+		record.invoke = [](JobRecord& record)
+		{
+			// 関数オブジェクトが例外を投げても破棄する
+			struct Destroy
+			{
+				Callable& callable;
+				~Destroy()
+				{
+					callable.~Callable();
+				}
+			} destroy = { *reinterpret_cast<Callable*>(record.storage) };
+			destroy.callable();
+		};
+	}
+	// ヒープに関数オブジェクトを確保して記録にはポインタを格納する
+	template<typename Callable, typename Function>
+	static void Store(JobRecord& record, Function&& function, std::false_type)
+	{
+		Callable* callable = new Callable(std::forward<Function>(function));
+		new (record.storage) Callable*(callable);
+		record.invoke = [](JobRecord& record)
+		{
+			std::unique_ptr<Callable> callable(*reinterpret_cast<Callable**>(record.storage));
+			(*callable)();
+		};
+	}
+	// 範囲を処理する関数を呼び出す
+	template<typename Body>
+	static void InvokeRange(const void* body, size_t begin, size_t end)
+	{
+		(*static_cast<const Body*>(body))(begin, end);
+	}
+
+	// 現在のスレッドのキュー番号を取得する(このジョブシステムのワーカー以外は0)
+	unsigned GetQueueIndex() const;
+	// 記録をキュー番号のプールから確保する
+	JobRecord* AllocateRecord(unsigned queueIndex);
+	// 記録を確保したプールに返す
+	void FreeRecord(unsigned queueIndex, JobRecord* record);
+	// 記録をキューに積んでワーカーを起こす
+	void Submit(unsigned queueIndex, JobRecord* record, JobCounter& counter);
+	// 範囲を分割して並列に実行する
+	void ParallelForRange(size_t count, size_t grainSize, const RangeBody& body);
+	// ワーカースレッドの処理
+	void WorkerMain(unsigned index);
+	// ジョブを1つ取り出して実行する(実行した場合はtrueを返す)
+	bool ExecuteOne(unsigned queueIndex);
+	// 自分のキューの末尾、外部スレッドのキュー、他のワーカーのキューの先頭の順にジョブを取り出す
+	bool Pop(unsigned queueIndex, JobRecord*& record);
+	// 範囲を半分ずつ分割して後半をジョブとして投入し、残りを呼び出し元で処理する
+	void Split(size_t begin, size_t end, size_t grainSize, const RangeBody& body, JobCounter& counter);
+
+private:
+	// ワーカーごとのキュー(ワーカーのキュー番号-1で参照する)
+	std::vector<std::unique_ptr<WorkStealingDeque<JobRecord*>>> m_deques;
+	// ワーカー以外のスレッドから投入されたジョブのキューの先頭と末尾(複数のスレッドが積むのでロックで保護する)
+	JobRecord* m_injectedHead;
+	JobRecord* m_injectedTail;
+	// 外部スレッドのキューを保護するミューテックス
+	std::mutex m_injectedMutex;
+	// キュー番号ごとの記録のプール(0は外部スレッド用で、複数のスレッドが使うのでロックで保護する)
+	std::vector<std::unique_ptr<ObjectPool<JobRecord>>> m_recordPools;
+	// 外部スレッド用のプールを保護するミューテックス
+	std::mutex m_externalPoolMutex;
+	// ワーカースレッド
+	std::vector<std::thread> m_workers;
+	// 待機中のワーカーを起こすための条件変数
+	std::condition_variable m_wake;
+	// 条件変数用のミューテックス
+	std::mutex m_wakeMutex;
+	// 投入済みで未取得のジョブ数
+	std::atomic<uint32_t> m_pending;
+	// 眠っているワーカー数(0の間はジョブの投入でロックを取らない)
+	std::atomic<uint32_t> m_sleeping;
+	// 外部スレッドのキューのジョブ数(0の間は取り出しでロックを取らない)
+	std::atomic<uint32_t> m_injectedCount;
+	// 終了要求
+	std::atomic<bool> m_quit;
+};
+
+#endif	// JOBSYSTEM_DEFINED
@@ -0,0 +1,31 @@
+﻿#include "LineGeometry.h"
+#include <algorithm>
+
+// XZ平面上の一辺sizeの正方形をdivs分割する格子の線分を追加する(原点が中心)
+void LineGeometry::AppendGrid(float size, int divs, const float color[4], std::vector<MeshVertex>& vertices)
+{
+	int count = std::max(1, divs);
+	float half = size * 0.5f;
+	vertices.reserve(vertices.size() + GetGridVertexCount(divs));
+
+	// Z軸に平行な線分
+	for (int i = 0; i <= count; i++)
+	{
+		float x = size * (float(i) / float(count) - 0.5f);
+		vertices.push_back({ { x, 0.0f, -half }, { color[0], color[1], color[2], color[3] } });
+		vertices.push_back({ { x, 0.0f, half }, { color[0], color[1], color[2], color[3] } });
+	}
+	// X軸に平行な線分
+	for (int i = 0; i <= count; i++)
+	{
+		float z = size * (float(i) / float(count) - 0.5f);
+		vertices.push_back({ { -half, 0.0f, z }, { color[0], color[1], color[2], color[3] } });
+		vertices.push_back({ { half, 0.0f, z }, { color[0], color[1], color[2], color[3] } });
+	}
+}
+
+// 格子の頂点数を取得する
+size_t LineGeometry::GetGridVertexCount(int divs)
+{
+	return size_t(std::max(1, divs) + 1) * 4;
+}
@@ -0,0 +1,18 @@
+﻿#pragma once
+#ifndef LINEGEOMETRY_DEFINED
+#define LINEGEOMETRY_DEFINED
+
+#include <vector>
+#include "MeshData.h"
+
+// 線分リストの頂点を生成する(2頂点で1本の線分)
+class LineGeometry
+{
+public:
+	// XZ平面上の一辺sizeの正方形をdivs分割する格子の線分を追加する(原点が中心)
+	static void AppendGrid(float size, int divs, const float color[4], std::vector<MeshVertex>& vertices);
+	// 格子の頂点数を取得する
+	static size_t GetGridVertexCount(int divs);
+};
+
+#endif	// LINEGEOMETRY_DEFINED
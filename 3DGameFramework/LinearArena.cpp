@@ -0,0 +1,74 @@
+﻿#include "LinearArena.h"
+#include <algorithm>
+
+// コンストラクタ
+LinearArena::LinearArena(size_t blockSize)
+	: m_block(0), m_offset(0), m_blockSize(std::max<size_t>(blockSize, 1))
+{
+}
+
+// 指定されたサイズとアラインメントの領域を確保する
+void* LinearArena::Allocate(size_t size, size_t alignment)
+{
+	// 現在のブロックから順に、収まるブロックを探す
+	for (; m_block < m_blocks.size(); m_block++, m_offset = 0)
+	{
+		Block& block = m_blocks[m_block];
+		uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+		uintptr_t aligned = (base + m_offset + alignment - 1) & ~uintptr_t(alignment - 1);
+		if (aligned + size <= base + block.size)
+		{
+			m_offset = size_t(aligned - base) + size;
+			return reinterpret_cast<void*>(aligned);
+		}
+	}
+
+	// 収まるブロックが無ければ追加する
+	size_t blockSize = std::max(m_blockSize, size + alignment);
+	m_blocks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[blockSize]), blockSize });
+	m_block = m_blocks.size() - 1;
+	m_offset = 0;
+	return Allocate(size, alignment);
+}
+
+// すべて解放する
+void LinearArena::Reset()
+{
+	if (m_blocks.size() > 1)
+	{
+		size_t capacity = GetCapacity();
+		m_blocks.clear();
+		m_blocks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[capacity]), capacity });
+	}
+	m_block = 0;
+	m_offset = 0;
+}
+
+// 使用中のバイト数を取得する
+size_t LinearArena::GetUsed() const
+{
+	size_t used = m_offset;
+	for (size_t i = 0; i < m_block && i < m_blocks.size(); i++)
+	{
+		used += m_blocks[i].size;
+	}
+	return used;
+}
+
+// 確保済みのバイト数を取得する
+size_t LinearArena::GetCapacity() const
+{
+	size_t capacity = 0;
+	for (const Block& block : m_blocks)
+	{
+		capacity += block.size;
+	}
+	return capacity;
+}
+
+// 現在のスレッドの作業用アリーナを取得する
+LinearArena& LinearArena::GetThreadArena()
+{
+	thread_local LinearArena arena;
+	return arena;
+}
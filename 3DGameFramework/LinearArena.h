@@ -0,0 +1,107 @@
+﻿#pragma once
+#ifndef LINEARARENA_DEFINED
+#define LINEARARENA_DEFINED
+
+#include <cstddef>
+#include <memory>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+#include "NonCopyable.h"
+
+// ポインタを進めるだけで確保し、まとめて解放する線形アリーナ
+// フレーム単位の一時データに使う。確保したメモリのデストラクタは呼ばれない
+class LinearArena : public NonCopyable
+{
+public:
+	// 既定のブロックサイズ
+	static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+	// 巻き戻し位置
+	struct Marker
+	{
+		// ブロック番号
+		size_t block;
+		// ブロック内の位置
+		size_t offset;
+	};
+
+	// コンストラクタ
+	explicit LinearArena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+	// 指定されたサイズとアラインメントの領域を確保する(ブロックが足りない場合だけヒープから確保する)
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+	// 配列を確保する(破棄が不要な型のみ。値は初期化しない)
+	template<typename T>
+	T* AllocateArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "LinearArena does not run destructors");
+		return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// 現在の位置を取得する
+	Marker GetMarker() const
+	{
+		return { m_block, m_offset };
+	}
+	// 取得した位置まで巻き戻して、それ以降に確保した領域を解放する
+	void Rewind(const Marker& marker)
+	{
+		m_block = marker.block;
+		m_offset = marker.offset;
+	}
+	// すべて解放する
+	// 複数のブロックにあふれていた場合は合計サイズの1つのブロックにまとめ、次からは同じ量をヒープ確保なしで扱えるようにする
+	void Reset();
+
+	// 使用中のバイト数を取得する
+	size_t GetUsed() const;
+	// 確保済みのバイト数を取得する
+	size_t GetCapacity() const;
+
+	// 現在のスレッドの作業用アリーナを取得する(ジョブ内の一時データにArenaScopeと組み合わせて使う)
+	static LinearArena& GetThreadArena();
+
+private:
+	// ブロック
+	struct Block
+	{
+		// メモリ
+		std::unique_ptr<unsigned char[]> memory;
+		// サイズ
+		size_t size;
+	};
+
+private:
+	// ブロック
+	std::vector<Block> m_blocks;
+	// 使用中のブロック番号
+	size_t m_block;
+	// 使用中のブロック内の位置
+	size_t m_offset;
+	// 新しく確保するブロックの最小サイズ
+	size_t m_blockSize;
+};
+
+// スコープを抜けるときにアリーナを入ったときの位置まで巻き戻す
+class ArenaScope : public NonCopyable
+{
+public:
+	// コンストラクタ
+	explicit ArenaScope(LinearArena& arena) : m_arena(arena), m_marker(arena.GetMarker())
+	{
+	}
+	// デストラクタ
+	~ArenaScope()
+	{
+		m_arena.Rewind(m_marker);
+	}
+
+private:
+	// アリーナ
+	LinearArena& m_arena;
+	// 入ったときの位置
+	LinearArena::Marker m_marker;
+};
+
+#endif	// LINEARARENA_DEFINED
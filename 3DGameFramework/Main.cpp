@@ -1,19 +1,111 @@
 #include "MyGame.h"
-#include <io.h>
-#include <Fcntl.h>
+#include "FbxMeshImporter.h"
+#include "MeshFile.h"
+#include "JobSystem.h"
+#include "FrameStatistics.h"
+#include <chrono>
+#include <shellapi.h>
 
+// R}hvvgNꂽꍇ͐ẽR\[ɏo͂(ReleasełxCNwbhXšʂ)
+// Debugł͐ẽR\[ΐVJB_CNgꂽWo͂͂̂܂܎g
 static void CreateConsoleWindow() {
+	bool attached = AttachConsole(ATTACH_PARENT_PROCESS) != FALSE;
 #ifdef _DEBUG
-	AllocConsole();
-	SetConsoleTitleA("ConsoleTitle");
-	typedef struct { char* _ptr; int _cnt; char* _base; int _flag; int _file; int _charbuf; int _bufsiz; char* _tmpfname; } FILE_COMPLETE;
-	*(FILE_COMPLETE*)stdout = *(FILE_COMPLETE*)_fdopen(_open_osfhandle((intptr_t)GetStdHandle(STD_OUTPUT_HANDLE), _O_TEXT), "w");
-	*(FILE_COMPLETE*)stderr = *(FILE_COMPLETE*)_fdopen(_open_osfhandle((intptr_t)GetStdHandle(STD_ERROR_HANDLE), _O_TEXT), "w");
-	*(FILE_COMPLETE*)stdin = *(FILE_COMPLETE*)_fdopen(_open_osfhandle((intptr_t)GetStdHandle(STD_INPUT_HANDLE), _O_TEXT), "r");
+	if (!attached && AllocConsole())
+	{
+		attached = true;
+		SetConsoleTitleA("ConsoleTitle");
+	}
+#endif
+	if (!attached)
+		return;
+	FILE* file = nullptr;
+	if (_fileno(stdout) < 0)
+		freopen_s(&file, "CONOUT$", "w", stdout);
+	if (_fileno(stderr) < 0)
+		freopen_s(&file, "CONOUT$", "w", stderr);
+	if (_fileno(stdin) < 0)
+		freopen_s(&file, "CONIN$", "r", stdin);
 	setvbuf(stdout, NULL, _IONBF, 0);
 	setvbuf(stderr, NULL, _IONBF, 0);
-	setvbuf(stdin, NULL, _IONBF, 0);
-#endif
+	std::cout.clear();
+	std::cerr.clear();
+}
+
+// Ch}`oCgɕϊ
+static std::string ToMultiByte(const wchar_t* text)
+{
+	int length = WideCharToMultiByte(CP_ACP, 0, text, -1, nullptr, 0, nullptr, nullptr);
+	std::string result(length > 0 ? length - 1 : 0, '\0');
+	if (length > 0)
+		WideCharToMultiByte(CP_ACP, 0, text, -1, &result[0], length, nullptr, nullptr);
+	return result;
+}
+
+// œK̓vo͂
+static void PrintStatistics(const char* name, const MeshCacheStatistics& statistics)
+{
+	std::cout << std::setw(14) << std::left << name << std::fixed << std::setprecision(3)
+		<< " ACMR " << statistics.acmr << "  ATVR " << statistics.atvr << "  overfetch " << statistics.overfetch << std::endl;
+}
+
+// R}hCu-bake .fbx o.mesh [-nooptimize] [-quantize]vw肳ꂽꍇ̓bVxCN
+static bool BakeFromCommandLine(int& exitCode)
+{
+	int argc = 0;
+	LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+	bool bake = argv && argc >= 4 && argc <= 6 && wcscmp(argv[1], L"-bake") == 0;
+	if (bake)
+	{
+		try
+		{
+			JobSystem jobSystem;
+			MeshImportOptions options;
+			options.optimize = true;
+			options.jobSystem = &jobSystem;
+			options.lodLevels = MeshImportOptions::DEFAULT_LOD_LEVELS;
+			options.quantizeVertices = false;
+			for (int i = 4; i < argc; i++)
+			{
+				if (wcscmp(argv[i], L"-nooptimize") == 0)
+					options.optimize = false;
+				else if (wcscmp(argv[i], L"-quantize") == 0)
+					options.quantizeVertices = true;
+			}
+			std::vector<MeshOptimizerReport> reports;
+			FbxMeshImporter::Bake(ToMultiByte(argv[2]).c_str(), ToMultiByte(argv[3]).c_str(), options, &reports);
+			// ot@C̃CfbNX؂(sɊJ̓CfbNXǂ܂Ȃ)
+			MeshFile(ToMultiByte(argv[3]).c_str()).Validate();
+			for (size_t i = 0; i < reports.size(); i++)
+			{
+				std::cout << "mesh " << i << std::endl;
+				PrintStatistics("original", reports[i].original);
+				PrintStatistics("vertex cache", reports[i].vertexCache);
+				PrintStatistics("overdraw", reports[i].overdraw);
+				PrintStatistics("vertex fetch", reports[i].vertexFetch);
+			}
+			exitCode = 0;
+		}
+		catch (const std::exception& exception)
+		{
+			std::cerr << exception.what() << std::endl;
+			exitCode = 1;
+		}
+	}
+	LocalFree(argv);
+	return bake;
+}
+
+// R}hCuIvV t@Cvw肳ꂽꍇ̓t@CԂ(w肳Ȃꍇ͋)
+static std::string FileFromCommandLine(const wchar_t* option)
+{
+	int argc = 0;
+	LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+	std::string filename;
+	if (argv && argc == 3 && wcscmp(argv[1], option) == 0)
+		filename = ToMultiByte(argv[2]);
+	LocalFree(argv);
+	return filename;
 }
 
 // EBhE
@@ -21,6 +113,103 @@ const int width = 1024;
 // EBhE
 const int height = 768;
 
+// wbhXɐݒ肵Q[[vsA1b̃t[ƃt[̓vA`̃`FbNTo͂
+// (ׂẴt[\܂Ői܂Ȃꍇ͏IR[h1Ԃ)
+static int RunHeadless(MyGame& myGame, int frameCount, bool pipelined)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	myGame.SetPipelined(pipelined);
+	auto start = Clock::now();
+	myGame.Run();
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	FrameStatistics& statistics = myGame.GetFrameStatistics();
+	std::cout << "frames " << frameCount << (pipelined ? "  pipelined" : "") << std::fixed << std::setprecision(1)
+		<< "  " << frameCount / seconds << " frames/s" << std::setprecision(3)
+		<< "  avg " << statistics.GetAverage() * 1000.0 << " ms  p99 " << statistics.GetPercentile(99.0) * 1000.0
+		<< " ms  max " << statistics.GetMaximum() * 1000.0 << " ms" << std::endl;
+	for (int stage = 0; stage < statistics.GetStageCount(); stage++)
+	{
+		std::cout << std::setw(12) << statistics.GetStageName(stage) << "  avg " << statistics.GetStageAverage(stage) * 1000.0
+			<< " ms  max " << statistics.GetStageMaximum(stage) * 1000.0 << " ms" << std::endl;
+	}
+	for (int counter = 0; counter < statistics.GetCounterCount(); counter++)
+	{
+		std::cout << std::setw(12) << statistics.GetCounterName(counter) << "  " << statistics.GetCounter(counter) << std::endl;
+	}
+
+	const NullDeviceStatistics& device = myGame.GetNullRenderDevice()->GetStatistics();
+	const NullRenderBackend& backend = *myGame.GetNullRenderBackend();
+	std::cout << "device   clears " << device.clears << "  presents " << device.presents << "  resizes " << device.resizes << std::endl;
+	std::cout << "backend  shaders " << backend.GetShaderCount() << "  materials " << backend.GetMaterialCount()
+		<< "  meshes " << backend.GetMeshCount() << "  last frame: state changes " << backend.GetStatistics().shaderChanges + backend.GetStatistics().materialChanges
+		+ backend.GetStatistics().meshChanges << "  draws " << backend.GetStatistics().draws << std::endl;
+	// ͂Ŏsꍇ́AsƂɓ`FbNTɂȂ
+	std::cout << "checksum " << std::hex << std::setw(16) << std::setfill('0') << backend.GetChecksum() << std::dec << std::setfill(' ') << std::endl;
+	return device.presents == uint64_t(frameCount) ? 0 : 1;
+}
+
+// R}hCu-headless [t[] [-pipelined]vw肳ꂽꍇ
+// EBhEGPUg킸A̖͂Q[[vzNbNŎsČv
+static bool HeadlessFromCommandLine(int& exitCode)
+{
+	int argc = 0;
+	LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+	bool headless = argv && argc >= 2 && argc <= 4 && wcscmp(argv[1], L"-headless") == 0;
+	if (headless)
+	{
+		int frameCount = argc >= 3 ? std::max(_wtoi(argv[2]), 1) : 10000;
+		bool pipelined = argc == 4 && wcscmp(argv[3], L"-pipelined") == 0;
+
+		MyGame myGame(width, height);
+		myGame.SetHeadless(frameCount);
+		exitCode = RunHeadless(myGame, frameCount, pipelined);
+	}
+	LocalFree(argv);
+	return headless;
+}
+
+// R}hCu-replay ̓O [-pipelined]vw肳ꂽꍇ
+// u-record ̓OvŋL^͂wbhXōĐAL^XV̉񐔂sČv
+// (1t[ɂ1XV̂ŁAsƂɓJ̓ƕ`ɂȂA`FbNTŔrł)
+static bool ReplayFromCommandLine(int& exitCode)
+{
+	int argc = 0;
+	LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+	bool replay = argv && (argc == 3 || argc == 4) && wcscmp(argv[1], L"-replay") == 0;
+	if (replay)
+	{
+		std::string logFile = ToMultiByte(argv[2]);
+		bool pipelined = argc == 4 && wcscmp(argv[3], L"-pipelined") == 0;
+
+		try
+		{
+			auto player = std::make_unique<InputPlayer>(logFile);
+			int frameCount = int(player->GetUpdateCount());
+			std::cout << "replay " << logFile << "  updates " << frameCount << std::endl;
+			if (frameCount == 0)
+			{
+				exitCode = 1;
+			}
+			else
+			{
+				MyGame myGame(width, height);
+				myGame.SetHeadless(frameCount);
+				myGame.SetInputReplay(std::move(player));
+				exitCode = RunHeadless(myGame, frameCount, pipelined);
+			}
+		}
+		catch (const std::exception& exception)
+		{
+			std::cerr << exception.what() << std::endl;
+			exitCode = 1;
+		}
+	}
+	LocalFree(argv);
+	return replay;
+}
+
 // Gg|Cg
 int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPWSTR lpCmdLine, _In_ int nCmdShow)
 {
@@ -29,6 +218,17 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 
 	CreateConsoleWindow();
 
+	// ItCŃbVxCN
+	int exitCode = 0;
+	if (BakeFromCommandLine(exitCode))
+		return exitCode;
+	// EBhEGPUg킸ɃQ[[vs
+	if (HeadlessFromCommandLine(exitCode))
+		return exitCode;
+	// L^͂ĐăQ[[vs
+	if (ReplayFromCommandLine(exitCode))
+		return exitCode;
+
     if (!DirectX::XMVerifyCPUSupport())
         return 1;
 	// COMCu
@@ -37,6 +237,14 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 
 	// MyGameIuWFNg𐶐
 	MyGame myGame(width, height);
+	// w肳ꂽꍇ̓vt@C̃g[Xۑ
+	std::string traceFile = FileFromCommandLine(L"-trace");
+	if (!traceFile.empty())
+		myGame.SetTraceFile(traceFile);
+	// w肳ꂽꍇ͍XVƂ̓͂L^
+	std::string inputFile = FileFromCommandLine(L"-record");
+	if (!inputFile.empty())
+		myGame.SetInputRecordFile(inputFile);
 	// Q[s
 	MSG msg = myGame.Run();
 
@@ -0,0 +1,103 @@
+﻿#include "MeshConverter.h"
+#include <algorithm>
+#include <stdexcept>
+#include "TransformKernel.h"
+
+// メッシュを変換する
+void MeshConverter::Convert(const MeshSource& source, MeshData& mesh)
+{
+	if (source.controlPointCount < 0 || source.polygonVertexCount < 0 || source.polygonVertexCount % 3 != 0)
+	{
+		throw std::runtime_error("MeshConverter: invalid mesh source");
+	}
+
+	mesh.name = source.name ? source.name : "";
+	mesh.vertices.resize(source.controlPointCount);
+	// ワールド行列を掛けて頂点に焼き込む
+	if (source.controlPointCount > 0)
+	{
+		TransformKernel::ConvertControlPoints(mesh.vertices[0].position, sizeof(MeshVertex),
+			source.controlPoints, size_t(source.controlPointCount), source.worldMatrix);
+	}
+	for (MeshVertex& vertex : mesh.vertices)
+	{
+		// 頂点カラーは白とする
+		vertex.color[0] = vertex.color[1] = vertex.color[2] = vertex.color[3] = 1.0f;
+	}
+	mesh.bounds = ComputeBounds(mesh.vertices.data(), mesh.vertices.size());
+
+	// マテリアル名を設定する
+	int materialCount = std::max(source.materialCount, 1);
+	mesh.materials.clear();
+	for (int i = 0; i < source.materialCount; i++)
+	{
+		mesh.materials.push_back(source.materialNames && source.materialNames[i] ? source.materialNames[i] : "");
+	}
+
+	// 三角形をマテリアル順に並べサブメッシュにまとめる
+	int triangleCount = source.polygonVertexCount / 3;
+	std::vector<int> triangleCounts(materialCount, 0);
+	for (int t = 0; t < triangleCount; t++)
+	{
+		int material = source.polygonMaterials ? source.polygonMaterials[t] : 0;
+		if (material < 0 || material >= materialCount)
+		{
+			throw std::out_of_range("MeshConverter: polygon material index out of range");
+		}
+		triangleCounts[material]++;
+	}
+
+	mesh.subMeshes.clear();
+	std::vector<uint32_t> cursors(materialCount, 0);
+	uint32_t start = 0;
+	for (int material = 0; material < materialCount; material++)
+	{
+		cursors[material] = start;
+		if (triangleCounts[material] > 0)
+		{
+			mesh.subMeshes.push_back({ start, uint32_t(triangleCounts[material] * 3), uint32_t(material) });
+		}
+		start += uint32_t(triangleCounts[material] * 3);
+	}
+
+	mesh.indices.resize(source.polygonVertexCount);
+	for (int t = 0; t < triangleCount; t++)
+	{
+		int material = source.polygonMaterials ? source.polygonMaterials[t] : 0;
+		uint32_t& cursor = cursors[material];
+		for (int n = 0; n < 3; n++)
+		{
+			int index = source.polygonVertices[t * 3 + n];
+			if (index < 0 || index >= source.controlPointCount)
+			{
+				throw std::out_of_range("MeshConverter: polygon vertex index out of range");
+			}
+			mesh.indices[cursor++] = uint32_t(index);
+		}
+	}
+}
+
+// 単位行列を設定する
+void MeshConverter::SetIdentity(double matrix[16])
+{
+	for (int i = 0; i < 16; i++)
+	{
+		matrix[i] = (i % 5 == 0) ? 1.0 : 0.0;
+	}
+}
+
+// 境界ボックスを計算する
+MeshBounds MeshConverter::ComputeBounds(const MeshVertex* vertices, size_t vertexCount)
+{
+	MeshBounds bounds = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float value = vertices[i].position[axis];
+			if (i == 0 || value < bounds.minimum[axis]) bounds.minimum[axis] = value;
+			if (i == 0 || value > bounds.maximum[axis]) bounds.maximum[axis] = value;
+		}
+	}
+	return bounds;
+}
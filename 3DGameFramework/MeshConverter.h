@@ -0,0 +1,42 @@
+﻿#pragma once
+#ifndef MESHCONVERTER_DEFINED
+#define MESHCONVERTER_DEFINED
+
+#include "MeshData.h"
+
+// 変換元のメッシュ(FBX SDKに依存しない入力形式)
+struct MeshSource
+{
+	// メッシュ名
+	const char* name;
+	// コントロールポイント配列(x, y, z, wのdouble4要素)
+	const double* controlPoints;
+	// コントロールポイント数
+	int controlPointCount;
+	// 三角形化されたポリゴンの頂点インデックス配列
+	const int* polygonVertices;
+	// ポリゴン頂点インデックス数
+	int polygonVertexCount;
+	// 三角形ごとのマテリアル番号(nullptrの場合はすべて0)
+	const int* polygonMaterials;
+	// マテリアル名配列
+	const char* const* materialNames;
+	// マテリアル数
+	int materialCount;
+	// ワールド行列(行優先、行ベクトル規約)
+	double worldMatrix[16];
+};
+
+// インポートしたメッシュを連続した頂点配列とインデックス配列に変換するクラス
+class MeshConverter
+{
+public:
+	// メッシュを変換する(ワールド変換は頂点に焼き込む)
+	static void Convert(const MeshSource& source, MeshData& mesh);
+	// 単位行列を設定する
+	static void SetIdentity(double matrix[16]);
+	// 境界ボックスを計算する
+	static MeshBounds ComputeBounds(const MeshVertex* vertices, size_t vertexCount);
+};
+
+#endif	// MESHCONVERTER_DEFINED
@@ -0,0 +1,70 @@
+﻿#pragma once
+#ifndef MESHDATA_DEFINED
+#define MESHDATA_DEFINED
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// 頂点(DirectX::VertexPositionColorと同じメモリレイアウト)
+struct MeshVertex
+{
+	// 位置
+	float position[3];
+	// 色
+	float color[4];
+};
+
+// サブメッシュ(同じマテリアルで描画するインデックス範囲)
+struct SubMesh
+{
+	// 開始インデックス
+	uint32_t indexStart;
+	// インデックス数
+	uint32_t indexCount;
+	// マテリアル番号
+	uint32_t materialIndex;
+};
+
+// 軸平行境界ボックス
+struct MeshBounds
+{
+	// 最小座標
+	float minimum[3];
+	// 最大座標
+	float maximum[3];
+};
+
+// 詳細度を下げたメッシュ(元のメッシュのマテリアルを共有し、頂点は参照されるものだけを持つ)
+struct MeshLod
+{
+	// 元のメッシュの頂点から面までの距離の最大値(モデル空間の距離)
+	float error;
+	// 頂点配列
+	std::vector<MeshVertex> vertices;
+	// インデックス配列(三角形リスト)
+	std::vector<uint32_t> indices;
+	// サブメッシュ配列
+	std::vector<SubMesh> subMeshes;
+};
+
+// GPUへそのまま送ることができる変換済みメッシュ
+struct MeshData
+{
+	// メッシュ名
+	std::string name;
+	// 頂点配列
+	std::vector<MeshVertex> vertices;
+	// インデックス配列(三角形リスト)
+	std::vector<uint32_t> indices;
+	// サブメッシュ配列
+	std::vector<SubMesh> subMeshes;
+	// マテリアル名配列
+	std::vector<std::string> materials;
+	// 境界ボックス
+	MeshBounds bounds;
+	// 詳細度を下げたメッシュ(順に粗くなる。このメッシュ自身が最も詳細なレベルになる)
+	std::vector<MeshLod> lods;
+};
+
+#endif	// MESHDATA_DEFINED
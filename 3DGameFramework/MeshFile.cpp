@@ -0,0 +1,447 @@
+﻿#include "MeshFile.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(MeshFileHeader) == 64, "MeshFileHeader layout must be stable");
+static_assert(sizeof(MeshFileMesh) == 96, "MeshFileMesh layout must be stable");
+static_assert(sizeof(MeshFileLod) == 48, "MeshFileLod layout must be stable");
+static_assert(sizeof(MeshVertex) == 28, "MeshVertex layout must be stable");
+static_assert(sizeof(SubMesh) == 12, "SubMesh layout must be stable");
+
+namespace
+{
+	// オフセットを境界に揃える
+	uint64_t Align(uint64_t offset)
+	{
+		return (offset + MeshFile::ALIGNMENT - 1) & ~(MeshFile::ALIGNMENT - 1);
+	}
+
+	// 三角形リストのサブメッシュがインデックスとマテリアルの範囲内にあるか検証する(インデックス自体は読まない)
+	// マテリアルが無いメッシュのサブメッシュはマテリアル番号0を使う
+	bool ValidSubMeshes(uint32_t indexCount, const SubMesh* subMeshes, uint32_t subMeshCount, uint32_t materialCount)
+	{
+		if (indexCount % 3 != 0)
+			return false;
+		for (uint32_t i = 0; i < subMeshCount; i++)
+		{
+			const SubMesh& subMesh = subMeshes[i];
+			if (uint64_t(subMesh.indexStart) + subMesh.indexCount > indexCount || subMesh.materialIndex >= std::max(materialCount, 1u))
+				return false;
+		}
+		return true;
+	}
+
+	// すべてのインデックスが頂点数の範囲内にあるか検証する
+	bool ValidIndices(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+	{
+		uint32_t maximum = 0;
+		for (size_t i = 0; i < indexCount; i++)
+			maximum = std::max(maximum, indices[i]);
+		return indexCount == 0 || maximum < vertexCount;
+	}
+}
+
+// ファイルをメモリマップで開く
+MeshFile::MeshFile(const char* filename)
+	: m_data(nullptr), m_size(0), m_header(nullptr), m_file(-1), m_mapping(0)
+{
+#ifdef _WIN32
+	HANDLE file = ::CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error(std::string("MeshFile: cannot open ") + filename);
+	}
+	m_file = reinterpret_cast<intptr_t>(file);
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(file, &size) || uint64_t(size.QuadPart) < sizeof(MeshFileHeader))
+	{
+		Close();
+		throw std::runtime_error(std::string("MeshFile: invalid file size ") + filename);
+	}
+	m_size = uint64_t(size.QuadPart);
+
+	HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		Close();
+		throw std::runtime_error(std::string("MeshFile: cannot map ") + filename);
+	}
+	m_mapping = reinterpret_cast<intptr_t>(mapping);
+	m_data = static_cast<const uint8_t*>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	int file = ::open(filename, O_RDONLY);
+	if (file < 0)
+	{
+		throw std::runtime_error(std::string("MeshFile: cannot open ") + filename);
+	}
+	m_file = file;
+
+	struct stat status;
+	if (::fstat(file, &status) != 0 || uint64_t(status.st_size) < sizeof(MeshFileHeader))
+	{
+		Close();
+		throw std::runtime_error(std::string("MeshFile: invalid file size ") + filename);
+	}
+	m_size = uint64_t(status.st_size);
+
+	void* data = ::mmap(nullptr, size_t(m_size), PROT_READ, MAP_PRIVATE, file, 0);
+	m_data = data == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(data);
+#endif
+	if (m_data == nullptr)
+	{
+		Close();
+		throw std::runtime_error(std::string("MeshFile: cannot map ") + filename);
+	}
+
+	// ヘッダとレコード、オフセットの範囲と配置、サブメッシュの範囲を検証する(データは変換せずにそのまま使う)
+	// 開く時間がインデックスの数によらないように、インデックスの値はここでは読まない(Validateで検証する)
+	try
+	{
+		m_header = reinterpret_cast<const MeshFileHeader*>(m_data);
+		if (m_header->magic != MAGIC || m_header->version != VERSION || m_header->headerSize != sizeof(MeshFileHeader) || m_header->fileSize != m_size)
+		{
+			throw std::runtime_error(std::string("MeshFile: unsupported file ") + filename);
+		}
+		ValidateRange(m_header->meshTableOffset, uint64_t(m_header->meshCount) * sizeof(MeshFileMesh));
+		ValidateRange(m_header->stringTableOffset, m_header->stringTableSize);
+		if (m_header->stringTableSize == 0 || m_data[m_header->stringTableOffset + m_header->stringTableSize - 1] != '\0')
+		{
+			throw std::runtime_error(std::string("MeshFile: corrupt string table ") + filename);
+		}
+
+		const MeshFileMesh* meshes = reinterpret_cast<const MeshFileMesh*>(m_data + m_header->meshTableOffset);
+		for (uint32_t i = 0; i < m_header->meshCount; i++)
+		{
+			const MeshFileMesh& mesh = meshes[i];
+			if (mesh.vertexStride == 0 || mesh.vertexStride != GetVertexStride(mesh.vertexFormat) || mesh.nameOffset >= m_header->stringTableSize)
+			{
+				throw std::runtime_error(std::string("MeshFile: corrupt mesh record ") + filename);
+			}
+			ValidateRange(mesh.vertexOffset, uint64_t(mesh.vertexCount) * mesh.vertexStride);
+			ValidateRange(mesh.indexOffset, uint64_t(mesh.indexCount) * sizeof(uint32_t));
+			ValidateRange(mesh.subMeshOffset, uint64_t(mesh.subMeshCount) * sizeof(SubMesh));
+			ValidateRange(mesh.materialOffset, uint64_t(mesh.materialCount) * sizeof(uint32_t));
+			ValidateRange(mesh.lodOffset, uint64_t(mesh.lodCount) * sizeof(MeshFileLod));
+			if (!ValidSubMeshes(mesh.indexCount, reinterpret_cast<const SubMesh*>(m_data + mesh.subMeshOffset), mesh.subMeshCount, mesh.materialCount))
+			{
+				throw std::runtime_error(std::string("MeshFile: corrupt mesh geometry ") + filename);
+			}
+
+			const MeshFileLod* lods = reinterpret_cast<const MeshFileLod*>(m_data + mesh.lodOffset);
+			for (uint32_t level = 0; level < mesh.lodCount; level++)
+			{
+				const MeshFileLod& lod = lods[level];
+				ValidateRange(lod.vertexOffset, uint64_t(lod.vertexCount) * mesh.vertexStride);
+				ValidateRange(lod.indexOffset, uint64_t(lod.indexCount) * sizeof(uint32_t));
+				ValidateRange(lod.subMeshOffset, uint64_t(lod.subMeshCount) * sizeof(SubMesh));
+				if (!ValidSubMeshes(lod.indexCount, reinterpret_cast<const SubMesh*>(m_data + lod.subMeshOffset), lod.subMeshCount, mesh.materialCount))
+				{
+					throw std::runtime_error(std::string("MeshFile: corrupt lod geometry ") + filename);
+				}
+			}
+		}
+	}
+	catch (...)
+	{
+		Close();
+		throw;
+	}
+}
+
+// デストラクタ
+MeshFile::~MeshFile()
+{
+	Close();
+}
+
+// すべてのメッシュと詳細度のインデックスが頂点数の範囲内にあるか検証する
+void MeshFile::Validate() const
+{
+	const MeshFileMesh* meshes = reinterpret_cast<const MeshFileMesh*>(m_data + m_header->meshTableOffset);
+	for (uint32_t i = 0; i < m_header->meshCount; i++)
+	{
+		const MeshFileMesh& mesh = meshes[i];
+		if (!ValidIndices(reinterpret_cast<const uint32_t*>(m_data + mesh.indexOffset), mesh.indexCount, mesh.vertexCount))
+		{
+			throw std::runtime_error("MeshFile: corrupt mesh geometry");
+		}
+		const MeshFileLod* lods = reinterpret_cast<const MeshFileLod*>(m_data + mesh.lodOffset);
+		for (uint32_t level = 0; level < mesh.lodCount; level++)
+		{
+			if (!ValidIndices(reinterpret_cast<const uint32_t*>(m_data + lods[level].indexOffset), lods[level].indexCount, lods[level].vertexCount))
+			{
+				throw std::runtime_error("MeshFile: corrupt lod geometry");
+			}
+		}
+	}
+}
+
+// メッシュ数を取得する
+uint32_t MeshFile::GetMeshCount() const
+{
+	return m_header->meshCount;
+}
+
+// メッシュを取得する
+MeshView MeshFile::GetMesh(uint32_t index) const
+{
+	if (index >= m_header->meshCount)
+	{
+		throw std::out_of_range("MeshFile: mesh index out of range");
+	}
+
+	const MeshFileMesh& mesh = reinterpret_cast<const MeshFileMesh*>(m_data + m_header->meshTableOffset)[index];
+	const char* strings = reinterpret_cast<const char*>(m_data + m_header->stringTableOffset);
+
+	bool quantized = mesh.vertexFormat == VERTEX_FORMAT_QUANTIZED;
+	MeshView view;
+	view.name = strings + mesh.nameOffset;
+	view.vertexFormat = mesh.vertexFormat;
+	view.vertices = quantized ? nullptr : reinterpret_cast<const MeshVertex*>(m_data + mesh.vertexOffset);
+	view.quantizedVertices = quantized ? reinterpret_cast<const QuantizedVertex*>(m_data + mesh.vertexOffset) : nullptr;
+	view.vertexCount = mesh.vertexCount;
+	view.indices = reinterpret_cast<const uint32_t*>(m_data + mesh.indexOffset);
+	view.indexCount = mesh.indexCount;
+	view.subMeshes = reinterpret_cast<const SubMesh*>(m_data + mesh.subMeshOffset);
+	view.subMeshCount = mesh.subMeshCount;
+	view.materialNameOffsets = reinterpret_cast<const uint32_t*>(m_data + mesh.materialOffset);
+	view.materialCount = mesh.materialCount;
+	view.bounds = mesh.bounds;
+	view.lods = reinterpret_cast<const MeshFileLod*>(m_data + mesh.lodOffset);
+	view.lodCount = mesh.lodCount;
+	return view;
+}
+
+// メッシュの詳細度を取得する
+MeshLodView MeshFile::GetLod(const MeshView& mesh, uint32_t level) const
+{
+	if (level >= mesh.lodCount)
+	{
+		throw std::out_of_range("MeshFile: lod index out of range");
+	}
+
+	const MeshFileLod& lod = mesh.lods[level];
+	bool quantized = mesh.vertexFormat == VERTEX_FORMAT_QUANTIZED;
+	MeshLodView view;
+	view.vertices = quantized ? nullptr : reinterpret_cast<const MeshVertex*>(m_data + lod.vertexOffset);
+	view.quantizedVertices = quantized ? reinterpret_cast<const QuantizedVertex*>(m_data + lod.vertexOffset) : nullptr;
+	view.vertexCount = lod.vertexCount;
+	view.indices = reinterpret_cast<const uint32_t*>(m_data + lod.indexOffset);
+	view.indexCount = lod.indexCount;
+	view.subMeshes = reinterpret_cast<const SubMesh*>(m_data + lod.subMeshOffset);
+	view.subMeshCount = lod.subMeshCount;
+	view.error = lod.error;
+	return view;
+}
+
+// マテリアル名を取得する
+const char* MeshFile::GetMaterialName(const MeshView& mesh, uint32_t material) const
+{
+	if (material >= mesh.materialCount || mesh.materialNameOffsets[material] >= m_header->stringTableSize)
+	{
+		return "";
+	}
+	return reinterpret_cast<const char*>(m_data + m_header->stringTableOffset) + mesh.materialNameOffsets[material];
+}
+
+// メッシュ配列をバイナリメッシュファイルに書き出す
+void MeshFile::Write(const char* filename, const std::vector<MeshData>& meshes, VertexFormat vertexFormat)
+{
+	uint32_t vertexStride = GetVertexStride(vertexFormat);
+	if (vertexStride == 0)
+	{
+		throw std::invalid_argument("MeshFile: unknown vertex format");
+	}
+
+	// 開く時にはインデックスの値を検証しないので、書き出す前に頂点とマテリアルの範囲内にあるか確認する
+	for (const MeshData& mesh : meshes)
+	{
+		bool valid = ValidSubMeshes(uint32_t(mesh.indices.size()), mesh.subMeshes.data(), uint32_t(mesh.subMeshes.size()), uint32_t(mesh.materials.size())) &&
+			ValidIndices(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+		for (const MeshLod& lod : mesh.lods)
+		{
+			valid = valid && ValidSubMeshes(uint32_t(lod.indices.size()), lod.subMeshes.data(), uint32_t(lod.subMeshes.size()), uint32_t(mesh.materials.size())) &&
+				ValidIndices(lod.indices.data(), lod.indices.size(), lod.vertices.size());
+		}
+		if (!valid)
+		{
+			throw std::invalid_argument("MeshFile: invalid geometry in mesh " + mesh.name);
+		}
+	}
+
+	// 文字列テーブルを作成する
+	std::vector<char> strings(1, '\0');
+	auto addString = [&strings](const std::string& text)
+	{
+		uint32_t offset = uint32_t(strings.size());
+		strings.insert(strings.end(), text.begin(), text.end());
+		strings.push_back('\0');
+		return offset;
+	};
+
+	// レイアウトを決定する
+	MeshFileHeader header = {};
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.headerSize = sizeof(MeshFileHeader);
+	header.meshCount = uint32_t(meshes.size());
+	header.meshTableOffset = Align(sizeof(MeshFileHeader));
+
+	std::vector<MeshFileMesh> records(meshes.size());
+	std::vector<std::vector<uint32_t>> materialOffsets(meshes.size());
+	std::vector<std::vector<MeshFileLod>> lodRecords(meshes.size());
+	uint64_t offset = header.meshTableOffset + records.size() * sizeof(MeshFileMesh);
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		const MeshData& mesh = meshes[i];
+		MeshFileMesh& record = records[i];
+		record = {};
+		record.nameOffset = addString(mesh.name);
+		record.vertexCount = uint32_t(mesh.vertices.size());
+		record.indexCount = uint32_t(mesh.indices.size());
+		record.subMeshCount = uint32_t(mesh.subMeshes.size());
+		record.materialCount = uint32_t(mesh.materials.size());
+		record.vertexStride = vertexStride;
+		record.vertexFormat = vertexFormat;
+		record.bounds = mesh.bounds;
+		for (const std::string& material : mesh.materials)
+		{
+			materialOffsets[i].push_back(addString(material));
+		}
+
+		record.vertexOffset = Align(offset);
+		offset = record.vertexOffset + mesh.vertices.size() * vertexStride;
+		record.indexOffset = Align(offset);
+		offset = record.indexOffset + mesh.indices.size() * sizeof(uint32_t);
+		record.subMeshOffset = Align(offset);
+		offset = record.subMeshOffset + mesh.subMeshes.size() * sizeof(SubMesh);
+		record.materialOffset = Align(offset);
+		offset = record.materialOffset + mesh.materials.size() * sizeof(uint32_t);
+
+		// 詳細度はレコード配列の後に各詳細度のデータを並べる
+		record.lodCount = uint32_t(mesh.lods.size());
+		record.lodOffset = Align(offset);
+		offset = record.lodOffset + mesh.lods.size() * sizeof(MeshFileLod);
+		for (const MeshLod& lod : mesh.lods)
+		{
+			MeshFileLod lodRecord = {};
+			lodRecord.error = lod.error;
+			lodRecord.vertexCount = uint32_t(lod.vertices.size());
+			lodRecord.indexCount = uint32_t(lod.indices.size());
+			lodRecord.subMeshCount = uint32_t(lod.subMeshes.size());
+			lodRecord.vertexOffset = Align(offset);
+			offset = lodRecord.vertexOffset + lod.vertices.size() * vertexStride;
+			lodRecord.indexOffset = Align(offset);
+			offset = lodRecord.indexOffset + lod.indices.size() * sizeof(uint32_t);
+			lodRecord.subMeshOffset = Align(offset);
+			offset = lodRecord.subMeshOffset + lod.subMeshes.size() * sizeof(SubMesh);
+			lodRecords[i].push_back(lodRecord);
+		}
+	}
+	header.stringTableOffset = Align(offset);
+	header.stringTableSize = strings.size();
+	header.fileSize = header.stringTableOffset + header.stringTableSize;
+
+	// イメージを作成する
+	std::vector<uint8_t> image(size_t(header.fileSize), 0);
+	auto copy = [&image](uint64_t destination, const void* source, size_t size)
+	{
+		if (size > 0)
+		{
+			memcpy(image.data() + destination, source, size);
+		}
+	};
+	// 量子化する場合は詳細度の頂点もメッシュの境界ボックスに対して量子化する
+	std::vector<QuantizedVertex> quantized;
+	auto copyVertices = [&](uint64_t destination, const std::vector<MeshVertex>& vertices, const MeshBounds& bounds)
+	{
+		if (vertexFormat == VERTEX_FORMAT_FLOAT)
+		{
+			copy(destination, vertices.data(), vertices.size() * sizeof(MeshVertex));
+			return;
+		}
+		quantized.resize(vertices.size());
+		VertexQuantizer::Quantize(quantized.data(), vertices.data(), vertices.size(), bounds);
+		copy(destination, quantized.data(), quantized.size() * sizeof(QuantizedVertex));
+	};
+	copy(0, &header, sizeof(header));
+	copy(header.meshTableOffset, records.data(), records.size() * sizeof(MeshFileMesh));
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		const MeshData& mesh = meshes[i];
+		const MeshFileMesh& record = records[i];
+		copyVertices(record.vertexOffset, mesh.vertices, mesh.bounds);
+		copy(record.indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+		copy(record.subMeshOffset, mesh.subMeshes.data(), mesh.subMeshes.size() * sizeof(SubMesh));
+		copy(record.materialOffset, materialOffsets[i].data(), materialOffsets[i].size() * sizeof(uint32_t));
+		copy(record.lodOffset, lodRecords[i].data(), lodRecords[i].size() * sizeof(MeshFileLod));
+		for (size_t level = 0; level < mesh.lods.size(); level++)
+		{
+			const MeshLod& lod = mesh.lods[level];
+			const MeshFileLod& lodRecord = lodRecords[i][level];
+			copyVertices(lodRecord.vertexOffset, lod.vertices, mesh.bounds);
+			copy(lodRecord.indexOffset, lod.indices.data(), lod.indices.size() * sizeof(uint32_t));
+			copy(lodRecord.subMeshOffset, lod.subMeshes.data(), lod.subMeshes.size() * sizeof(SubMesh));
+		}
+	}
+	copy(header.stringTableOffset, strings.data(), strings.size());
+
+	// ファイルに書き出す
+	std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+	stream.write(reinterpret_cast<const char*>(image.data()), std::streamsize(image.size()));
+	if (!stream)
+	{
+		throw std::runtime_error(std::string("MeshFile: cannot write ") + filename);
+	}
+}
+
+// 頂点形式の頂点ストライドを取得する
+uint32_t MeshFile::GetVertexStride(uint32_t vertexFormat)
+{
+	switch (vertexFormat)
+	{
+	case VERTEX_FORMAT_FLOAT:
+		return sizeof(MeshVertex);
+	case VERTEX_FORMAT_QUANTIZED:
+		return sizeof(QuantizedVertex);
+	default:
+		return 0;
+	}
+}
+
+// 範囲を検証する
+void MeshFile::ValidateRange(uint64_t offset, uint64_t size) const
+{
+	if (offset % ALIGNMENT != 0 || offset > m_size || size > m_size - offset)
+	{
+		throw std::runtime_error("MeshFile: section out of range");
+	}
+}
+
+// マップを解除しファイルを閉じる
+void MeshFile::Close()
+{
+#ifdef _WIN32
+	if (m_data) ::UnmapViewOfFile(m_data);
+	if (m_mapping) ::CloseHandle(reinterpret_cast<HANDLE>(m_mapping));
+	if (m_file != -1) ::CloseHandle(reinterpret_cast<HANDLE>(m_file));
+#else
+	if (m_data) ::munmap(const_cast<uint8_t*>(m_data), size_t(m_size));
+	if (m_file != -1) ::close(int(m_file));
+#endif
+	m_data = nullptr;
+	m_header = nullptr;
+	m_mapping = 0;
+	m_file = -1;
+}
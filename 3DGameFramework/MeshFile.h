@@ -0,0 +1,206 @@
+﻿#pragma once
+#ifndef MESHFILE_DEFINED
+#define MESHFILE_DEFINED
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "MeshData.h"
+#include "NonCopyable.h"
+#include "VertexQuantizer.h"
+
+// バイナリメッシュファイルのヘッダ
+// すべてのデータはファイル先頭からのオフセットで参照し、16バイト境界に配置する
+struct MeshFileHeader
+{
+	// 識別子
+	uint32_t magic;
+	// バージョン
+	uint32_t version;
+	// ヘッダサイズ
+	uint32_t headerSize;
+	// メッシュ数
+	uint32_t meshCount;
+	// ファイルサイズ
+	uint64_t fileSize;
+	// メッシュテーブルのオフセット
+	uint64_t meshTableOffset;
+	// 文字列テーブルのオフセット
+	uint64_t stringTableOffset;
+	// 文字列テーブルのサイズ
+	uint64_t stringTableSize;
+	// 予約領域
+	uint32_t reserved[4];
+};
+
+// バイナリメッシュファイルのメッシュレコード
+struct MeshFileMesh
+{
+	// メッシュ名(文字列テーブル内のオフセット)
+	uint32_t nameOffset;
+	// 頂点数
+	uint32_t vertexCount;
+	// インデックス数
+	uint32_t indexCount;
+	// サブメッシュ数
+	uint32_t subMeshCount;
+	// マテリアル数
+	uint32_t materialCount;
+	// 頂点ストライド
+	uint32_t vertexStride;
+	// 頂点ストリームのオフセット
+	uint64_t vertexOffset;
+	// 32ビットインデックスバッファのオフセット
+	uint64_t indexOffset;
+	// サブメッシュ配列のオフセット
+	uint64_t subMeshOffset;
+	// マテリアル名オフセット配列のオフセット
+	uint64_t materialOffset;
+	// 境界ボックス
+	MeshBounds bounds;
+	// 詳細度の数
+	uint32_t lodCount;
+	// 頂点形式(MeshFile::VertexFormat、詳細度も同じ形式)
+	uint32_t vertexFormat;
+	// 詳細度レコード配列のオフセット
+	uint64_t lodOffset;
+};
+
+// バイナリメッシュファイルの詳細度レコード(マテリアルはメッシュのものを使う)
+struct MeshFileLod
+{
+	// 誤差(モデル空間の距離)
+	float error;
+	// 頂点数
+	uint32_t vertexCount;
+	// インデックス数
+	uint32_t indexCount;
+	// サブメッシュ数
+	uint32_t subMeshCount;
+	// 頂点ストリームのオフセット
+	uint64_t vertexOffset;
+	// 32ビットインデックスバッファのオフセット
+	uint64_t indexOffset;
+	// サブメッシュ配列のオフセット
+	uint64_t subMeshOffset;
+	// 予約領域
+	uint32_t reserved[2];
+};
+
+// ファイル内のメッシュを直接参照するビュー
+struct MeshView
+{
+	// メッシュ名
+	const char* name;
+	// 頂点形式(MeshFile::VertexFormat)
+	uint32_t vertexFormat;
+	// 頂点配列(浮動小数点数の形式でない場合はnullptr)
+	const MeshVertex* vertices;
+	// 量子化した頂点配列(量子化した形式でない場合はnullptr、位置は境界ボックスに対する値)
+	const QuantizedVertex* quantizedVertices;
+	// 頂点数
+	uint32_t vertexCount;
+	// インデックス配列
+	const uint32_t* indices;
+	// インデックス数
+	uint32_t indexCount;
+	// サブメッシュ配列
+	const SubMesh* subMeshes;
+	// サブメッシュ数
+	uint32_t subMeshCount;
+	// マテリアル名オフセット配列
+	const uint32_t* materialNameOffsets;
+	// マテリアル数
+	uint32_t materialCount;
+	// 境界ボックス
+	MeshBounds bounds;
+	// 詳細度レコード配列
+	const MeshFileLod* lods;
+	// 詳細度の数(元のメッシュは含まない)
+	uint32_t lodCount;
+};
+
+// ファイル内の詳細度を直接参照するビュー
+struct MeshLodView
+{
+	// 頂点配列(浮動小数点数の形式でない場合はnullptr)
+	const MeshVertex* vertices;
+	// 量子化した頂点配列(量子化した形式でない場合はnullptr、位置はメッシュの境界ボックスに対する値)
+	const QuantizedVertex* quantizedVertices;
+	// 頂点数
+	uint32_t vertexCount;
+	// インデックス配列
+	const uint32_t* indices;
+	// インデックス数
+	uint32_t indexCount;
+	// サブメッシュ配列
+	const SubMesh* subMeshes;
+	// サブメッシュ数
+	uint32_t subMeshCount;
+	// 誤差(モデル空間の距離)
+	float error;
+};
+
+// メモリマップしたバイナリメッシュファイルをパースせずにそのまま使うクラス
+class MeshFile : public NonCopyable
+{
+public:
+	// 頂点形式
+	enum VertexFormat
+	{
+		// MeshVertex(28バイト)
+		VERTEX_FORMAT_FLOAT,
+		// QuantizedVertex(12バイト)
+		VERTEX_FORMAT_QUANTIZED,
+	};
+
+	// 識別子("MESH")
+	static const uint32_t MAGIC = 0x4853454D;
+	// 現在のバージョン
+	static const uint32_t VERSION = 3;
+	// データの配置境界
+	static const uint64_t ALIGNMENT = 16;
+
+	// ファイルをメモリマップで開く(ヘッダとレコード、セクションの範囲と配置を検証し、範囲外を参照するファイルは例外を投げる)
+	// インデックスの値は読まないので、開く時間はメッシュの大きさによらない
+	explicit MeshFile(const char* filename);
+	// デストラクタ
+	~MeshFile();
+
+	// すべてのメッシュと詳細度のインデックスが頂点数の範囲内にあるか検証する(インデックスをすべて読む。ベイクの後やテストで使う)
+	void Validate() const;
+
+	// メッシュ数を取得する
+	uint32_t GetMeshCount() const;
+	// メッシュを取得する
+	MeshView GetMesh(uint32_t index) const;
+	// メッシュの詳細度を取得する(0が最も細かい簡略化したメッシュ)
+	MeshLodView GetLod(const MeshView& mesh, uint32_t level) const;
+	// マテリアル名を取得する
+	const char* GetMaterialName(const MeshView& mesh, uint32_t material) const;
+
+	// メッシュ配列をバイナリメッシュファイルに書き出す(量子化する場合は各メッシュの境界ボックスに対して量子化する。範囲外のインデックスは例外を投げる)
+	static void Write(const char* filename, const std::vector<MeshData>& meshes, VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT);
+	// 頂点形式の頂点ストライドを取得する(未知の形式は0)
+	static uint32_t GetVertexStride(uint32_t vertexFormat);
+
+private:
+	// 範囲を検証する
+	void ValidateRange(uint64_t offset, uint64_t size) const;
+	// マップを解除しファイルを閉じる
+	void Close();
+
+private:
+	// マップされたファイルの先頭
+	const uint8_t* m_data;
+	// ファイルサイズ
+	uint64_t m_size;
+	// ヘッダ
+	const MeshFileHeader* m_header;
+	// ファイルハンドル
+	intptr_t m_file;
+	// ファイルマッピングハンドル
+	intptr_t m_mapping;
+};
+
+#endif	// MESHFILE_DEFINED
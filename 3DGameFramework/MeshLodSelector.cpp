@@ -0,0 +1,62 @@
+﻿#include "MeshLodSelector.h"
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+const float MeshLodSelector::DEFAULT_THRESHOLD = 1.0f;
+const float MeshLodSelector::DEFAULT_HYSTERESIS = 0.25f;
+
+// コンストラクタ
+MeshLodSelector::MeshLodSelector()
+	: m_pixelsPerUnit(1.0f), m_threshold(DEFAULT_THRESHOLD), m_hysteresis(DEFAULT_HYSTERESIS)
+{
+}
+
+// 射影の縦の視野角と画面の高さを設定する
+void MeshLodSelector::SetProjection(float verticalFieldOfView, float screenHeight)
+{
+	m_pixelsPerUnit = screenHeight / (2.0f * tanf(verticalFieldOfView * 0.5f));
+}
+
+// モデル空間の誤差を指定された距離で画面に投影した大きさを計算する
+float MeshLodSelector::ProjectError(float error, float distance) const
+{
+	if (distance <= 0.0f)
+		return std::numeric_limits<float>::infinity();
+	return error / distance * m_pixelsPerUnit;
+}
+
+// 現在の詳細度から次の詳細度を選ぶ
+uint32_t MeshLodSelector::Select(const float* errors, uint32_t levelCount, float distance, uint32_t currentLevel) const
+{
+	currentLevel = std::min(currentLevel, levelCount);
+
+	// 現在の詳細度の誤差がしきい値を超えていれば、しきい値に収まる詳細度まですぐに細かくする
+	auto levelError = [errors](uint32_t level) { return level == 0 ? 0.0f : errors[level - 1]; };
+	if (ProjectError(levelError(currentLevel), distance) > m_threshold)
+	{
+		uint32_t level = currentLevel;
+		while (level > 0 && ProjectError(levelError(level), distance) > m_threshold)
+			level--;
+		return level;
+	}
+
+	// 粗くするのは下げたしきい値に収まる場合だけにする(誤差は詳細度の順に増えるので最初に超えたところで止める)
+	float threshold = m_threshold * (1.0f - m_hysteresis);
+	uint32_t level = currentLevel;
+	while (level < levelCount && ProjectError(errors[level], distance) <= threshold)
+		level++;
+	return level;
+}
+
+// 点から境界ボックスまでの距離を計算する
+float MeshLodSelector::Distance(const MeshBounds& bounds, const float point[3])
+{
+	float squared = 0.0f;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float d = std::max(std::max(bounds.minimum[axis] - point[axis], point[axis] - bounds.maximum[axis]), 0.0f);
+		squared += d * d;
+	}
+	return sqrtf(squared);
+}
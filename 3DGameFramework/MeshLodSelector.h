@@ -0,0 +1,52 @@
+﻿#pragma once
+#ifndef MESHLODSELECTOR_DEFINED
+#define MESHLODSELECTOR_DEFINED
+
+#include <stdint.h>
+#include "MeshData.h"
+
+// 詳細度の誤差を画面に投影した大きさ(ピクセル)から、描画する詳細度を選ぶクラス
+// 詳細度0は元のメッシュ、詳細度i(1以上)はerrors[i - 1]の誤差を持つ簡略化したメッシュとする
+// 粗くするときだけしきい値を下げて、境目の距離で詳細度が毎フレーム切り替わらないようにする
+class MeshLodSelector
+{
+public:
+	// 許容する投影した誤差(ピクセル)
+	static const float DEFAULT_THRESHOLD;
+	// 粗くするときにしきい値から下げる割合
+	static const float DEFAULT_HYSTERESIS;
+
+	// コンストラクタ
+	MeshLodSelector();
+
+	// 射影の縦の視野角(ラジアン)と画面の高さ(ピクセル)を設定する(設定するまでは距離1で誤差1を1ピクセルとする)
+	void SetProjection(float verticalFieldOfView, float screenHeight);
+	// 許容する投影した誤差(ピクセル)を設定する
+	void SetThreshold(float pixels)
+	{
+		m_threshold = pixels;
+	}
+	// 粗くするときにしきい値から下げる割合を設定する(0～1)
+	void SetHysteresis(float hysteresis)
+	{
+		m_hysteresis = hysteresis;
+	}
+
+	// モデル空間の誤差を指定された距離で画面に投影した大きさ(ピクセル)を計算する(距離が0以下の場合は無限大)
+	float ProjectError(float error, float distance) const;
+	// 現在の詳細度から次の詳細度を選ぶ(levelCountはerrorsの数)
+	uint32_t Select(const float* errors, uint32_t levelCount, float distance, uint32_t currentLevel) const;
+
+	// 点から境界ボックスまでの距離を計算する(中にある場合は0)
+	static float Distance(const MeshBounds& bounds, const float point[3]);
+
+private:
+	// 距離1で誤差1が画面に投影される大きさ(ピクセル)
+	float m_pixelsPerUnit;
+	// 許容する投影した誤差(ピクセル)
+	float m_threshold;
+	// 粗くするときにしきい値から下げる割合
+	float m_hysteresis;
+};
+
+#endif	// MESHLODSELECTOR_DEFINED
@@ -0,0 +1,434 @@
+﻿#include "MeshOptimizer.h"
+#include <algorithm>
+#include <math.h>
+#include <stdexcept>
+#include "MeshConverter.h"
+
+const float MeshOptimizer::OVERDRAW_THRESHOLD = 1.05f;
+
+namespace
+{
+	// Forsythアルゴリズムで使用するLRUキャッシュのサイズ
+	const int FORSYTH_CACHE_SIZE = 32;
+	// キャッシュ位置によるスコアの減衰
+	const float CACHE_DECAY_POWER = 1.5f;
+	// 直前の三角形の頂点のスコア
+	const float LAST_TRIANGLE_SCORE = 0.75f;
+	// 残りの三角形数によるスコアの倍率
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	// 残りの三角形数によるスコアの指数
+	const float VALENCE_BOOST_POWER = 0.5f;
+	// 頂点フェッチのキャッシュライン
+	const size_t CACHE_LINE_SIZE = 64;
+	// 頂点フェッチのキャッシュライン数
+	const uint32_t FETCH_CACHE_LINES = 64;
+
+	// 頂点のスコアを計算する
+	float VertexScore(int cachePosition, uint32_t remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				float scaler = 1.0f / float(FORSYTH_CACHE_SIZE - 3);
+				score = powf(1.0f - float(cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+			}
+		}
+		return score + VALENCE_BOOST_SCALE * powf(float(remainingTriangles), -VALENCE_BOOST_POWER);
+	}
+
+	// FIFOキャッシュをシミュレートする(ミスした場合はtrueを返す)
+	bool TouchCache(std::vector<uint32_t>& cacheTime, uint32_t& timestamp, uint32_t vertex, uint32_t cacheSize)
+	{
+		if (timestamp - cacheTime[vertex] > cacheSize)
+		{
+			cacheTime[vertex] = timestamp++;
+			return true;
+		}
+		return false;
+	}
+
+	// 三角形の重心と面積で重み付けした法線を計算する
+	void TriangleGeometry(const MeshVertex* vertices, const uint32_t* triangle, float centroid[3], float normal[3])
+	{
+		const float* p0 = vertices[triangle[0]].position;
+		const float* p1 = vertices[triangle[1]].position;
+		const float* p2 = vertices[triangle[2]].position;
+		float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			centroid[axis] = (p0[axis] + p1[axis] + p2[axis]) / 3.0f;
+		}
+	}
+}
+
+// 頂点キャッシュの統計を計算する
+MeshCacheStatistics MeshOptimizer::Analyze(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+	MeshCacheStatistics statistics = { 0.0f, 0.0f, 0.0f };
+	if (indexCount == 0 || vertexCount == 0)
+		return statistics;
+
+	// タイムスタンプがキャッシュサイズより古いものをミスとみなす
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+	std::vector<uint32_t> lineTime((vertexCount * sizeof(MeshVertex) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE + 1, 0);
+	uint32_t lineTimestamp = FETCH_CACHE_LINES + 1;
+
+	size_t misses = 0;
+	size_t fetchedLines = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		uint32_t vertex = indices[i];
+		if (!TouchCache(cacheTime, timestamp, vertex, cacheSize))
+			continue;
+
+		misses++;
+		// 変換する頂点が含まれるキャッシュラインを読み込む
+		size_t begin = vertex * sizeof(MeshVertex) / CACHE_LINE_SIZE;
+		size_t end = ((vertex + 1) * sizeof(MeshVertex) - 1) / CACHE_LINE_SIZE;
+		for (size_t line = begin; line <= end; line++)
+		{
+			if (TouchCache(lineTime, lineTimestamp, uint32_t(line), FETCH_CACHE_LINES))
+				fetchedLines++;
+		}
+	}
+
+	statistics.acmr = float(misses) / float(indexCount / 3);
+	statistics.atvr = float(misses) / float(vertexCount);
+	statistics.overfetch = float(fetchedLines * CACHE_LINE_SIZE) / float(vertexCount * sizeof(MeshVertex));
+	return statistics;
+}
+
+// 頂点キャッシュを考慮して三角形を並べ替える(Forsyth)
+void MeshOptimizer::OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+	if (indexCount % 3 != 0)
+	{
+		throw std::invalid_argument("MeshOptimizer: index count must be a multiple of 3");
+	}
+
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	// 頂点ごとに隣接する三角形の一覧を作成する
+	std::vector<uint32_t> triangleCounts(vertexCount, 0);
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		if (indices[i] >= vertexCount)
+		{
+			throw std::out_of_range("MeshOptimizer: index out of range");
+		}
+		triangleCounts[indices[i]]++;
+	}
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		offsets[v + 1] = offsets[v] + triangleCounts[v];
+	}
+	std::vector<uint32_t> adjacency(indexCount);
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		adjacency[fill[indices[i]]++] = uint32_t(i / 3);
+	}
+
+	// 初期スコアを計算する
+	std::vector<uint32_t> remaining(triangleCounts);
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = VertexScore(-1, remaining[v]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+	}
+
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	size_t cursor = 0;
+	std::vector<uint32_t> output;
+	output.reserve(indexCount);
+	int64_t best = -1;
+
+	for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+	{
+		// キャッシュから候補が見つからない場合は未出力の三角形を先頭から探す
+		if (best < 0)
+		{
+			while (emitted[cursor])
+				cursor++;
+			best = int64_t(cursor);
+		}
+
+		uint32_t triangle = uint32_t(best);
+		const uint32_t* corners = indices + triangle * 3;
+		output.insert(output.end(), corners, corners + 3);
+		emitted[triangle] = true;
+
+		// 出力した三角形を隣接リストから取り除く
+		for (int n = 0; n < 3; n++)
+		{
+			uint32_t v = corners[n];
+			uint32_t* begin = &adjacency[offsets[v]];
+			uint32_t* end = begin + remaining[v];
+			uint32_t* found = std::find(begin, end, triangle);
+			if (found != end)
+			{
+				std::swap(*found, *(end - 1));
+				remaining[v]--;
+			}
+		}
+
+		// LRUキャッシュを更新する
+		nextCache.assign(corners, corners + 3);
+		for (uint32_t v : cache)
+		{
+			if (v != corners[0] && v != corners[1] && v != corners[2])
+				nextCache.push_back(v);
+		}
+		for (uint32_t v : cache)
+		{
+			cachePosition[v] = -1;
+		}
+		cache.swap(nextCache);
+
+		// キャッシュ内の頂点と隣接三角形のスコアを更新し、最良の三角形を選ぶ
+		best = -1;
+		float bestScore = -1.0f;
+		for (size_t position = 0; position < cache.size(); position++)
+		{
+			uint32_t v = cache[position];
+			cachePosition[v] = position < size_t(FORSYTH_CACHE_SIZE) ? int(position) : -1;
+		}
+		for (size_t position = 0; position < cache.size(); position++)
+		{
+			uint32_t v = cache[position];
+			float score = VertexScore(cachePosition[v], remaining[v]);
+			float delta = score - vertexScores[v];
+			vertexScores[v] = score;
+			for (uint32_t a = 0; a < remaining[v]; a++)
+			{
+				uint32_t t = adjacency[offsets[v] + a];
+				triangleScores[t] += delta;
+				if (triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					best = int64_t(t);
+				}
+			}
+		}
+		// キャッシュから溢れた頂点を取り除く
+		if (cache.size() > size_t(FORSYTH_CACHE_SIZE))
+		{
+			cache.resize(FORSYTH_CACHE_SIZE);
+		}
+	}
+
+	std::copy(output.begin(), output.end(), destination);
+}
+
+// 頂点キャッシュ効率を保ったままオーバードローが減るようにクラスタを並べ替える
+void MeshOptimizer::OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+	const MeshVertex* vertices, size_t vertexCount, float threshold, uint32_t cacheSize)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	// キャッシュがすべてミスする位置をクラスタの境界とする
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+	std::vector<size_t> hardBoundaries;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		int misses = 0;
+		for (int n = 0; n < 3; n++)
+		{
+			misses += TouchCache(cacheTime, timestamp, indices[t * 3 + n], cacheSize) ? 1 : 0;
+		}
+		if (t == 0 || misses == 3)
+			hardBoundaries.push_back(t);
+	}
+	hardBoundaries.push_back(triangleCount);
+
+	// クラスタ内でACMRが許容範囲に収まる位置でさらに分割する
+	std::vector<size_t> boundaries;
+	for (size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+	{
+		size_t begin = hardBoundaries[c];
+		size_t end = hardBoundaries[c + 1];
+		float clusterAcmr = Analyze(indices + begin * 3, (end - begin) * 3, vertexCount, cacheSize).acmr;
+
+		timestamp += cacheSize + 1;
+		size_t start = begin;
+		size_t misses = 0;
+		boundaries.push_back(begin);
+		for (size_t t = begin; t < end; t++)
+		{
+			for (int n = 0; n < 3; n++)
+			{
+				misses += TouchCache(cacheTime, timestamp, indices[t * 3 + n], cacheSize) ? 1 : 0;
+			}
+			float acmr = float(misses) / float(t - start + 1);
+			if (t + 1 < end && acmr <= clusterAcmr * threshold)
+			{
+				// 次のクラスタは冷えたキャッシュから始まる
+				boundaries.push_back(t + 1);
+				start = t + 1;
+				misses = 0;
+				timestamp += cacheSize + 1;
+			}
+		}
+	}
+	boundaries.push_back(triangleCount);
+
+	// メッシュ全体の重心を計算する
+	float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+	float meshArea = 0.0f;
+	std::vector<float> centroids(triangleCount * 3);
+	std::vector<float> normals(triangleCount * 3);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		TriangleGeometry(vertices, indices + t * 3, &centroids[t * 3], &normals[t * 3]);
+		float area = sqrtf(normals[t * 3] * normals[t * 3] + normals[t * 3 + 1] * normals[t * 3 + 1] + normals[t * 3 + 2] * normals[t * 3 + 2]);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			meshCentroid[axis] += centroids[t * 3 + axis] * area;
+		}
+		meshArea += area;
+	}
+	for (int axis = 0; axis < 3; axis++)
+	{
+		meshCentroid[axis] = meshArea > 0.0f ? meshCentroid[axis] / meshArea : 0.0f;
+	}
+
+	// 外側を向いたクラスタほど先に描画されるように並べ替える
+	size_t clusterCount = boundaries.size() - 1;
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		float centroid[3] = { 0.0f, 0.0f, 0.0f };
+		float normal[3] = { 0.0f, 0.0f, 0.0f };
+		float area = 0.0f;
+		for (size_t t = boundaries[c]; t < boundaries[c + 1]; t++)
+		{
+			const float* n = &normals[t * 3];
+			float triangleArea = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				centroid[axis] += centroids[t * 3 + axis] * triangleArea;
+				normal[axis] += n[axis];
+			}
+			area += triangleArea;
+		}
+		float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float key = 0.0f;
+		if (area > 0.0f && length > 0.0f)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				key += (centroid[axis] / area - meshCentroid[axis]) * normal[axis] / length;
+			}
+		}
+		sortKeys[c] = key;
+	}
+
+	std::vector<size_t> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		order[c] = c;
+	}
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> output;
+	output.reserve(indexCount);
+	for (size_t c : order)
+	{
+		output.insert(output.end(), indices + boundaries[c] * 3, indices + boundaries[c + 1] * 3);
+	}
+	std::copy(output.begin(), output.end(), destination);
+}
+
+// 頂点を最初に参照される順に並べ替え、参照されない頂点を取り除く
+size_t MeshOptimizer::OptimizeVertexFetch(MeshVertex* destination, uint32_t* indices, size_t indexCount,
+	const MeshVertex* vertices, size_t vertexCount)
+{
+	const uint32_t unused = UINT32_MAX;
+	std::vector<uint32_t> remap(vertexCount, unused);
+	std::vector<MeshVertex> output;
+	output.reserve(vertexCount);
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		uint32_t& index = remap[indices[i]];
+		if (index == unused)
+		{
+			index = uint32_t(output.size());
+			output.push_back(vertices[indices[i]]);
+		}
+		indices[i] = index;
+	}
+
+	std::copy(output.begin(), output.end(), destination);
+	return output.size();
+}
+
+// メッシュにすべてのパスを適用する
+MeshOptimizerReport MeshOptimizer::Optimize(MeshData& mesh)
+{
+	MeshOptimizerReport report;
+	size_t vertexCount = mesh.vertices.size();
+	report.original = Analyze(mesh.indices.data(), mesh.indices.size(), vertexCount);
+
+	// 三角形の並べ替えはサブメッシュの範囲内でおこなう
+	std::vector<SubMesh> ranges = mesh.subMeshes;
+	if (ranges.empty())
+	{
+		ranges.push_back({ 0, uint32_t(mesh.indices.size()), 0 });
+	}
+
+	std::vector<uint32_t> work(mesh.indices.size());
+	for (const SubMesh& range : ranges)
+	{
+		OptimizeVertexCache(work.data() + range.indexStart, mesh.indices.data() + range.indexStart, range.indexCount, vertexCount);
+	}
+	mesh.indices.swap(work);
+	report.vertexCache = Analyze(mesh.indices.data(), mesh.indices.size(), vertexCount);
+
+	for (const SubMesh& range : ranges)
+	{
+		OptimizeOverdraw(work.data() + range.indexStart, mesh.indices.data() + range.indexStart, range.indexCount,
+			mesh.vertices.data(), vertexCount);
+	}
+	mesh.indices.swap(work);
+	report.overdraw = Analyze(mesh.indices.data(), mesh.indices.size(), vertexCount);
+
+	std::vector<MeshVertex> vertices(vertexCount);
+	vertices.resize(OptimizeVertexFetch(vertices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), vertexCount));
+	mesh.vertices.swap(vertices);
+	mesh.bounds = MeshConverter::ComputeBounds(mesh.vertices.data(), mesh.vertices.size());
+	report.vertexFetch = Analyze(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+	return report;
+}
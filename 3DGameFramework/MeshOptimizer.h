@@ -0,0 +1,57 @@
+﻿#pragma once
+#ifndef MESHOPTIMIZER_DEFINED
+#define MESHOPTIMIZER_DEFINED
+
+#include <stdint.h>
+#include <vector>
+#include "MeshData.h"
+
+// 頂点キャッシュの統計
+struct MeshCacheStatistics
+{
+	// 三角形あたりの平均キャッシュミス数(ACMR)
+	float acmr;
+	// 頂点あたりの平均変換回数(ATVR)
+	float atvr;
+	// 頂点フェッチの読み込み量/頂点バッファサイズ
+	float overfetch;
+};
+
+// 各パスの前後の統計
+struct MeshOptimizerReport
+{
+	// 最適化前
+	MeshCacheStatistics original;
+	// 頂点キャッシュ最適化後
+	MeshCacheStatistics vertexCache;
+	// オーバードロー最適化後
+	MeshCacheStatistics overdraw;
+	// 頂点フェッチ最適化後
+	MeshCacheStatistics vertexFetch;
+};
+
+// インポートしたメッシュの三角形と頂点を並べ替えてGPUのキャッシュ効率を上げるクラス
+class MeshOptimizer
+{
+public:
+	// 統計に使用するFIFO頂点キャッシュのサイズ
+	static const uint32_t CACHE_SIZE = 16;
+	// オーバードロー最適化で許容するACMRの悪化率
+	static const float OVERDRAW_THRESHOLD;
+
+	// 頂点キャッシュの統計を計算する
+	static MeshCacheStatistics Analyze(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+	// 頂点キャッシュを考慮して三角形を並べ替える(Forsyth)
+	static void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+	// 頂点キャッシュ効率を保ったままオーバードローが減るようにクラスタを並べ替える
+	static void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+		const MeshVertex* vertices, size_t vertexCount, float threshold = OVERDRAW_THRESHOLD, uint32_t cacheSize = CACHE_SIZE);
+	// 頂点を最初に参照される順に並べ替え、参照されない頂点を取り除く(新しい頂点数を返す)
+	static size_t OptimizeVertexFetch(MeshVertex* destination, uint32_t* indices, size_t indexCount,
+		const MeshVertex* vertices, size_t vertexCount);
+
+	// メッシュにすべてのパスを適用する(サブメッシュの範囲は保たれる)
+	static MeshOptimizerReport Optimize(MeshData& mesh);
+};
+
+#endif	// MESHOPTIMIZER_DEFINED
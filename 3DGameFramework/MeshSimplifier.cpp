@@ -0,0 +1,673 @@
+﻿#include "MeshSimplifier.h"
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <math.h>
+#include <queue>
+#include <stdexcept>
+#include <string.h>
+#include "JobSystem.h"
+#include "MeshOptimizer.h"
+
+const float MeshSimplifier::DEFAULT_REDUCTION = 0.5f;
+const float MeshSimplifier::DEFAULT_MAX_ERROR = 0.02f;
+
+namespace
+{
+	// 開いた縁とマテリアルの境界に加える平面の重み(縁の長さの2乗に掛ける)
+	const double BOUNDARY_WEIGHT = 10.0;
+	// 縮約の前後で周りの三角形の法線が成す角の余弦の下限(これより大きく傾く縮約は裏返りとみなす)
+	const double MIN_NORMAL_COSINE = 0.2;
+
+	// 対称な4x4行列で表した二次誤差(a2, ab, ac, ad, b2, bc, bd, c2, cd, d2)
+	struct Quadric
+	{
+		double m[10];
+	};
+
+	// 平面ax+by+cz+d=0までの距離の2乗を重みwで加える
+	void AddPlane(Quadric& q, double a, double b, double c, double d, double w)
+	{
+		q.m[0] += w * a * a; q.m[1] += w * a * b; q.m[2] += w * a * c; q.m[3] += w * a * d;
+		q.m[4] += w * b * b; q.m[5] += w * b * c; q.m[6] += w * b * d;
+		q.m[7] += w * c * c; q.m[8] += w * c * d;
+		q.m[9] += w * d * d;
+	}
+
+	// 二次誤差を加える
+	void AddQuadric(Quadric& q, const Quadric& other)
+	{
+		for (int i = 0; i < 10; i++)
+			q.m[i] += other.m[i];
+	}
+
+	// 2つの二次誤差の和を点で評価する
+	double Evaluate(const Quadric& a, const Quadric& b, const double* p)
+	{
+		double m[10];
+		for (int i = 0; i < 10; i++)
+			m[i] = a.m[i] + b.m[i];
+		double x = p[0], y = p[1], z = p[2];
+		return m[0] * x * x + 2.0 * m[1] * x * y + 2.0 * m[2] * x * z + 2.0 * m[3] * x
+			+ m[4] * y * y + 2.0 * m[5] * y * z + 2.0 * m[6] * y
+			+ m[7] * z * z + 2.0 * m[8] * z + m[9];
+	}
+
+	// 三角形の法線(長さは面積の2倍)を計算する
+	void TriangleNormal(const double* p0, const double* p1, const double* p2, double* normal)
+	{
+		double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+
+	// 3次元ベクトルの内積を計算する
+	double Dot(const double* a, const double* b)
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	// 点から三角形までの距離の2乗を計算する(三角形上の最も近い点を頂点・辺・面の領域で場合分けして求める)
+	double PointTriangleDistanceSquared(const double* p, const double* a, const double* b, const double* c)
+	{
+		double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		double ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+		// 点から線分上の点origin + direction * tまでの距離の2乗
+		auto along = [p](const double* origin, const double* direction, double t)
+		{
+			double d[3] = { p[0] - origin[0] - direction[0] * t, p[1] - origin[1] - direction[1] * t, p[2] - origin[2] - direction[2] * t };
+			return Dot(d, d);
+		};
+
+		double d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+		if (d1 <= 0.0 && d2 <= 0.0)
+			return Dot(ap, ap);
+		double bp[3] = { p[0] - b[0], p[1] - b[1], p[2] - b[2] };
+		double d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+		if (d3 >= 0.0 && d4 <= d3)
+			return Dot(bp, bp);
+		double vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+		{
+			return along(a, ab, d1 / (d1 - d3));
+		}
+		double cp[3] = { p[0] - c[0], p[1] - c[1], p[2] - c[2] };
+		double d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+		if (d6 >= 0.0 && d5 <= d6)
+			return Dot(cp, cp);
+		double vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+		{
+			return along(a, ac, d2 / (d2 - d6));
+		}
+		double va = d3 * d6 - d5 * d4;
+		if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+		{
+			double bc[3] = { c[0] - b[0], c[1] - b[1], c[2] - b[2] };
+			return along(b, bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+		}
+		// 面の内側では平面までの距離になる
+		double denominator = va + vb + vc;
+		if (denominator <= 0.0)
+			return Dot(ap, ap);
+		double v = vb / denominator, w = vc / denominator;
+		double d[3] = { ap[0] - ab[0] * v - ac[0] * w, ap[1] - ab[1] * v - ac[1] * w, ap[2] - ab[2] * v - ac[2] * w };
+		return Dot(d, d);
+	}
+
+	// 辺の縮約で三角形を減らす簡略化の作業状態
+	class QuadricSimplifier
+	{
+	public:
+		// 同じ位置の頂点をまとめ、頂点ごとの二次誤差と縮約の候補を作成する
+		QuadricSimplifier(const MeshVertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, const uint32_t* materials);
+		// 三角形が目標数以下になるまで縮約し、届いたかどうかを返す(誤差がmaxErrorを超える縮約はしない)
+		bool CollapseTo(size_t targetTriangleCount, double maxError);
+		// 元の頂点から残っている面までの距離の最大値(モデル空間の距離)を測る
+		// 縮約された頂点は縮約先の頂点の周りから近い三角形を辿って距離を測るので、実際の距離以上の値になる
+		double MeasureError() const;
+		// 残っている三角形を元の順に取り出す
+		void Extract(std::vector<uint32_t>& indices, std::vector<uint32_t>* materials) const;
+
+	private:
+		// 縮約の候補(fromをtoの位置へ移して辺を消す)
+		struct Candidate
+		{
+			// 誤差(距離の2乗)
+			double cost;
+			// 消える頂点
+			uint32_t from;
+			// 残る頂点
+			uint32_t to;
+			// 候補を作ったときの頂点の版(どちらかが変わっていれば古い候補)
+			uint32_t fromVersion;
+			uint32_t toVersion;
+
+			// 誤差の小さい順に取り出す(同じ誤差は頂点番号で決定的に並べる)
+			bool operator>(const Candidate& other) const
+			{
+				if (cost != other.cost)
+					return cost > other.cost;
+				if (from != other.from)
+					return from > other.from;
+				return to > other.to;
+			}
+		};
+
+	private:
+		// 縮約の誤差(頂点の重みで割った距離の2乗)を計算する
+		double Cost(uint32_t from, uint32_t to) const;
+		// 辺の両方向の縮約を候補に加える
+		void PushEdge(uint32_t a, uint32_t b);
+		// 縮約で三角形が裏返らず、非多様体にならないかどうか
+		bool IsValid(uint32_t from, uint32_t to) const;
+		// 縮約する
+		void Collapse(uint32_t from, uint32_t to);
+		// 生きている三角形から隣接する頂点を集める
+		void CollectNeighbors(uint32_t vertex, std::vector<uint32_t>& neighbors) const;
+		// 三角形が頂点を含むかどうか
+		bool Contains(uint32_t triangle, uint32_t vertex) const
+		{
+			const uint32_t* t = &m_triangles[triangle * 3];
+			return t[0] == vertex || t[1] == vertex || t[2] == vertex;
+		}
+
+	private:
+		// 頂点の位置
+		std::vector<double> m_positions;
+		// 三角形の頂点(まとめた頂点の番号)
+		std::vector<uint32_t> m_triangles;
+		// 三角形のマテリアル番号
+		std::vector<uint32_t> m_materials;
+		// 三角形が残っているかどうか
+		std::vector<uint8_t> m_triangleAlive;
+		// 頂点を使う三角形(消えた三角形を含むことがある)
+		std::vector<std::vector<uint32_t>> m_vertexTriangles;
+		// 頂点の二次誤差
+		std::vector<Quadric> m_quadrics;
+		// 頂点の二次誤差の重みの合計
+		std::vector<double> m_weights;
+		// 頂点の版(縮約で二次誤差が変わるたびに増やす)
+		std::vector<uint32_t> m_versions;
+		// 縮約の候補
+		std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> m_candidates;
+		// 残っている三角形の数
+		size_t m_triangleCount;
+		// 三角形に使われている頂点
+		std::vector<uint32_t> m_sources;
+		// 縮約先の頂点(縮約されていない頂点は自身)
+		std::vector<uint32_t> m_parents;
+		// 作業用の隣接頂点
+		mutable std::vector<uint32_t> m_fromNeighbors;
+		mutable std::vector<uint32_t> m_toNeighbors;
+	};
+
+	// 同じ位置の頂点をまとめ、頂点ごとの二次誤差と縮約の候補を作成する
+	QuadricSimplifier::QuadricSimplifier(const MeshVertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount,
+		const uint32_t* materials)
+		: m_positions(vertexCount * 3), m_vertexTriangles(vertexCount), m_quadrics(vertexCount, Quadric()), m_weights(vertexCount, 0.0),
+		m_versions(vertexCount, 0), m_triangleCount(0), m_parents(vertexCount)
+	{
+		// 位置で並べ替えて同じ位置の頂点を最初の頂点にまとめる
+		std::vector<uint32_t> order(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			order[i] = uint32_t(i);
+			for (int axis = 0; axis < 3; axis++)
+				m_positions[i * 3 + axis] = vertices[i].position[axis];
+		}
+		auto less = [vertices](uint32_t a, uint32_t b)
+		{
+			const float* p = vertices[a].position;
+			const float* q = vertices[b].position;
+			if (p[0] != q[0]) return p[0] < q[0];
+			if (p[1] != q[1]) return p[1] < q[1];
+			if (p[2] != q[2]) return p[2] < q[2];
+			return a < b;
+		};
+		std::sort(order.begin(), order.end(), less);
+		std::vector<uint32_t> remap(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			const float* p = vertices[order[i]].position;
+			bool same = i > 0 && memcmp(p, vertices[order[i - 1]].position, sizeof(float) * 3) == 0;
+			remap[order[i]] = same ? remap[order[i - 1]] : order[i];
+		}
+
+		// まとめた頂点で三角形を作り、面積で重み付けした平面の誤差を頂点に加える(潰れた三角形は除く)
+		for (size_t i = 0; i + 3 <= indexCount; i += 3)
+		{
+			uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+			if (a >= vertexCount || b >= vertexCount || c >= vertexCount)
+				throw std::out_of_range("MeshSimplifier: index out of range");
+			a = remap[a];
+			b = remap[b];
+			c = remap[c];
+			if (a == b || b == c || c == a)
+				continue;
+
+			uint32_t triangle = uint32_t(m_triangleCount++);
+			m_triangles.push_back(a);
+			m_triangles.push_back(b);
+			m_triangles.push_back(c);
+			m_materials.push_back(materials ? materials[i / 3] : 0);
+			m_triangleAlive.push_back(1);
+
+			double normal[3];
+			TriangleNormal(&m_positions[a * 3], &m_positions[b * 3], &m_positions[c * 3], normal);
+			double length = sqrt(Dot(normal, normal));
+			double area = length * 0.5;
+			if (length > 0.0)
+			{
+				double n[3] = { normal[0] / length, normal[1] / length, normal[2] / length };
+				double d = -Dot(n, &m_positions[a * 3]);
+				for (uint32_t vertex : { a, b, c })
+				{
+					AddPlane(m_quadrics[vertex], n[0], n[1], n[2], d, area);
+					m_weights[vertex] += area;
+				}
+			}
+			m_vertexTriangles[a].push_back(triangle);
+			m_vertexTriangles[b].push_back(triangle);
+			m_vertexTriangles[c].push_back(triangle);
+		}
+
+		// 辺を共有する三角形が1つだけの縁と、マテリアルが変わる辺には縁に垂直な平面の誤差を加える
+		struct Edge
+		{
+			uint32_t low, high, triangle;
+		};
+		std::vector<Edge> edges;
+		edges.reserve(m_triangleCount * 3);
+		for (uint32_t t = 0; t < m_triangleCount; t++)
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint32_t a = m_triangles[t * 3 + corner], b = m_triangles[t * 3 + (corner + 1) % 3];
+				edges.push_back({ std::min(a, b), std::max(a, b), t });
+			}
+		}
+		std::sort(edges.begin(), edges.end(), [](const Edge& x, const Edge& y)
+			{
+				return x.low != y.low ? x.low < y.low : x.high != y.high ? x.high < y.high : x.triangle < y.triangle;
+			});
+		for (size_t begin = 0, end = 0; begin < edges.size(); begin = end)
+		{
+			end = begin + 1;
+			while (end < edges.size() && edges[end].low == edges[begin].low && edges[end].high == edges[begin].high)
+				end++;
+			bool boundary = end - begin != 2 || m_materials[edges[begin].triangle] != m_materials[edges[begin + 1].triangle];
+			if (!boundary)
+				continue;
+			for (size_t i = begin; i < end; i++)
+			{
+				const Edge& edge = edges[i];
+				const double* p = &m_positions[edge.low * 3];
+				const double* q = &m_positions[edge.high * 3];
+				const uint32_t* t = &m_triangles[edge.triangle * 3];
+				double normal[3];
+				TriangleNormal(&m_positions[t[0] * 3], &m_positions[t[1] * 3], &m_positions[t[2] * 3], normal);
+				double e[3] = { q[0] - p[0], q[1] - p[1], q[2] - p[2] };
+				double m[3] = { e[1] * normal[2] - e[2] * normal[1], e[2] * normal[0] - e[0] * normal[2], e[0] * normal[1] - e[1] * normal[0] };
+				double length = sqrt(Dot(m, m));
+				if (length > 0.0)
+				{
+					double weight = BOUNDARY_WEIGHT * Dot(e, e);
+					double d = -(m[0] * p[0] + m[1] * p[1] + m[2] * p[2]) / length;
+					for (uint32_t vertex : { edge.low, edge.high })
+					{
+						AddPlane(m_quadrics[vertex], m[0] / length, m[1] / length, m[2] / length, d, weight);
+						m_weights[vertex] += weight;
+					}
+				}
+			}
+		}
+
+		// すべての二次誤差がそろってから、辺ごとに1回だけ縮約の候補を作る
+		for (size_t i = 0; i < edges.size(); i++)
+		{
+			if (i == 0 || edges[i].low != edges[i - 1].low || edges[i].high != edges[i - 1].high)
+				PushEdge(edges[i].low, edges[i].high);
+		}
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			m_parents[vertex] = vertex;
+			if (!m_vertexTriangles[vertex].empty())
+				m_sources.push_back(vertex);
+		}
+	}
+
+	// 三角形が目標数以下になるまで縮約し、届いたかどうかを返す
+	bool QuadricSimplifier::CollapseTo(size_t targetTriangleCount, double maxError)
+	{
+		double maxCost = maxError * maxError;
+		while (m_triangleCount > targetTriangleCount && !m_candidates.empty())
+		{
+			Candidate candidate = m_candidates.top();
+			if (candidate.fromVersion != m_versions[candidate.from] || candidate.toVersion != m_versions[candidate.to])
+			{
+				m_candidates.pop();
+				continue;
+			}
+			// 残りの候補はすべて誤差の上限を超えるので、次に上限を緩めて呼ばれるまで残しておく
+			if (candidate.cost > maxCost)
+				break;
+			m_candidates.pop();
+			if (IsValid(candidate.from, candidate.to))
+				Collapse(candidate.from, candidate.to);
+		}
+		return m_triangleCount <= targetTriangleCount;
+	}
+
+	// 残っている三角形を元の順に取り出す
+	void QuadricSimplifier::Extract(std::vector<uint32_t>& indices, std::vector<uint32_t>* materials) const
+	{
+		indices.clear();
+		if (materials)
+			materials->clear();
+		for (size_t t = 0; t < m_triangleAlive.size(); t++)
+		{
+			if (!m_triangleAlive[t])
+				continue;
+			indices.insert(indices.end(), &m_triangles[t * 3], &m_triangles[t * 3] + 3);
+			if (materials)
+				materials->push_back(m_materials[t]);
+		}
+	}
+
+	// 縮約の誤差を計算する
+	double QuadricSimplifier::Cost(uint32_t from, uint32_t to) const
+	{
+		double weight = m_weights[from] + m_weights[to];
+		if (weight <= 0.0)
+			return 0.0;
+		return std::max(Evaluate(m_quadrics[from], m_quadrics[to], &m_positions[to * 3]) / weight, 0.0);
+	}
+
+	// 辺の両方向の縮約を候補に加える
+	void QuadricSimplifier::PushEdge(uint32_t a, uint32_t b)
+	{
+		m_candidates.push({ Cost(a, b), a, b, m_versions[a], m_versions[b] });
+		m_candidates.push({ Cost(b, a), b, a, m_versions[b], m_versions[a] });
+	}
+
+	// 縮約で三角形が裏返らず、非多様体にならないかどうか
+	bool QuadricSimplifier::IsValid(uint32_t from, uint32_t to) const
+	{
+		const double* target = &m_positions[to * 3];
+		size_t shared = 0;
+		for (uint32_t triangle : m_vertexTriangles[from])
+		{
+			if (!m_triangleAlive[triangle])
+				continue;
+			if (Contains(triangle, to))
+			{
+				shared++;
+				continue;
+			}
+
+			// fromを移した後の法線が元の法線から大きく傾くか、面積が無くなる場合は縮約しない
+			const uint32_t* t = &m_triangles[triangle * 3];
+			const double* before[3] = { &m_positions[t[0] * 3], &m_positions[t[1] * 3], &m_positions[t[2] * 3] };
+			const double* after[3] = { before[0], before[1], before[2] };
+			for (int corner = 0; corner < 3; corner++)
+			{
+				if (t[corner] == from)
+					after[corner] = target;
+			}
+			double n0[3], n1[3];
+			TriangleNormal(before[0], before[1], before[2], n0);
+			TriangleNormal(after[0], after[1], after[2], n1);
+			double length0 = sqrt(Dot(n0, n0)), length1 = sqrt(Dot(n1, n1));
+			if (length1 <= 0.0 || Dot(n0, n1) < MIN_NORMAL_COSINE * length0 * length1)
+				return false;
+		}
+		// 辺が既に無い場合
+		if (shared == 0)
+			return false;
+
+		// 両端に共通する隣接頂点が辺を挟む三角形の頂点より多いと、縮約で辺が3つ以上の三角形に共有される
+		CollectNeighbors(from, m_fromNeighbors);
+		CollectNeighbors(to, m_toNeighbors);
+		size_t common = 0;
+		for (size_t i = 0, j = 0; i < m_fromNeighbors.size() && j < m_toNeighbors.size();)
+		{
+			if (m_fromNeighbors[i] < m_toNeighbors[j])
+				i++;
+			else if (m_fromNeighbors[i] > m_toNeighbors[j])
+				j++;
+			else
+			{
+				common++;
+				i++;
+				j++;
+			}
+		}
+		return common <= shared;
+	}
+
+	// 縮約する
+	void QuadricSimplifier::Collapse(uint32_t from, uint32_t to)
+	{
+		// 辺を含む三角形を消し、残りの三角形はfromをtoに付け替える
+		std::vector<uint32_t>& toTriangles = m_vertexTriangles[to];
+		for (uint32_t triangle : m_vertexTriangles[from])
+		{
+			if (!m_triangleAlive[triangle])
+				continue;
+			if (Contains(triangle, to))
+			{
+				m_triangleAlive[triangle] = 0;
+				m_triangleCount--;
+				continue;
+			}
+			uint32_t* t = &m_triangles[triangle * 3];
+			for (int corner = 0; corner < 3; corner++)
+			{
+				if (t[corner] == from)
+					t[corner] = to;
+			}
+			toTriangles.push_back(triangle);
+		}
+		m_vertexTriangles[from].clear();
+		m_vertexTriangles[from].shrink_to_fit();
+		toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(),
+			[this](uint32_t triangle) { return !m_triangleAlive[triangle]; }), toTriangles.end());
+
+		AddQuadric(m_quadrics[to], m_quadrics[from]);
+		m_weights[to] += m_weights[from];
+		m_versions[from]++;
+		m_versions[to]++;
+		m_parents[from] = to;
+
+		// toの二次誤差が変わったので、toにつながる辺の候補を作り直す
+		std::vector<uint32_t> neighbors;
+		CollectNeighbors(to, neighbors);
+		for (uint32_t neighbor : neighbors)
+			PushEdge(to, neighbor);
+	}
+
+	// 元の頂点から残っている面までの距離の最大値を測る
+	double QuadricSimplifier::MeasureError() const
+	{
+		double maxDistance = 0.0;
+		for (uint32_t source : m_sources)
+		{
+			uint32_t vertex = source;
+			while (m_parents[vertex] != vertex)
+				vertex = m_parents[vertex];
+			if (vertex == source)
+				continue;
+
+			// 縮約先の頂点を囲む三角形から始めて、近い三角形の頂点を囲む三角形へ距離が縮まらなくなるまで移る
+			// (三角形が残っていなければ測らない)
+			const double* p = &m_positions[source * 3];
+			double nearest = -1.0;
+			uint32_t closest = 0;
+			auto visit = [&](uint32_t around)
+			{
+				bool improved = false;
+				for (uint32_t triangle : m_vertexTriangles[around])
+				{
+					if (!m_triangleAlive[triangle])
+						continue;
+					const uint32_t* t = &m_triangles[triangle * 3];
+					double distance = PointTriangleDistanceSquared(p, &m_positions[t[0] * 3], &m_positions[t[1] * 3], &m_positions[t[2] * 3]);
+					if (nearest < 0.0 || distance < nearest)
+					{
+						nearest = distance;
+						closest = triangle;
+						improved = true;
+					}
+				}
+				return improved;
+			};
+			bool improved = visit(vertex);
+			while (improved && nearest > 0.0)
+			{
+				uint32_t corners[3] = { m_triangles[closest * 3], m_triangles[closest * 3 + 1], m_triangles[closest * 3 + 2] };
+				improved = false;
+				for (uint32_t corner : corners)
+					improved = visit(corner) || improved;
+			}
+			maxDistance = std::max(maxDistance, nearest);
+		}
+		return sqrt(maxDistance);
+	}
+
+	// 生きている三角形から隣接する頂点を集める
+	void QuadricSimplifier::CollectNeighbors(uint32_t vertex, std::vector<uint32_t>& neighbors) const
+	{
+		neighbors.clear();
+		for (uint32_t triangle : m_vertexTriangles[vertex])
+		{
+			if (!m_triangleAlive[triangle])
+				continue;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint32_t other = m_triangles[triangle * 3 + corner];
+				if (other != vertex)
+					neighbors.push_back(other);
+			}
+		}
+		std::sort(neighbors.begin(), neighbors.end());
+		neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+	}
+
+	// 三角形ごとのマテリアル番号からサブメッシュを作成して詳細度にする
+	void MakeLod(const MeshData& mesh, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& materials, double error, MeshLod& lod)
+	{
+		// 三角形をマテリアル順に並べ(同じマテリアルの中では元の順を保つ)サブメッシュにまとめる
+		std::vector<uint32_t> order(materials.size());
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = uint32_t(i);
+		std::stable_sort(order.begin(), order.end(), [&materials](uint32_t a, uint32_t b) { return materials[a] < materials[b]; });
+
+		MeshData work;
+		work.vertices = mesh.vertices;
+		work.indices.reserve(indices.size());
+		for (uint32_t triangle : order)
+		{
+			if (work.subMeshes.empty() || work.subMeshes.back().materialIndex != materials[triangle])
+				work.subMeshes.push_back({ uint32_t(work.indices.size()), 0, materials[triangle] });
+			work.indices.insert(work.indices.end(), &indices[triangle * 3], &indices[triangle * 3] + 3);
+			work.subMeshes.back().indexCount += 3;
+		}
+
+		// キャッシュ効率が上がるように並べ替え、参照されない頂点を取り除く
+		MeshOptimizer::Optimize(work);
+		lod.error = float(error);
+		lod.vertices.swap(work.vertices);
+		lod.indices.swap(work.indices);
+		lod.subMeshes.swap(work.subMeshes);
+	}
+}
+
+// 三角形が目標数以下になるまで縮約する
+float MeshSimplifier::Simplify(std::vector<uint32_t>& destination, const uint32_t* indices, size_t indexCount,
+	const MeshVertex* vertices, size_t vertexCount, size_t targetTriangleCount, float maxError,
+	const uint32_t* materials, std::vector<uint32_t>* destinationMaterials)
+{
+	QuadricSimplifier simplifier(vertices, vertexCount, indices, indexCount, materials);
+	simplifier.CollapseTo(targetTriangleCount, maxError);
+	simplifier.Extract(destination, destinationMaterials);
+	return float(simplifier.MeasureError());
+}
+
+// 三角形の数を前のレベルのreduction倍ずつ減らした詳細度を生成する
+void MeshSimplifier::GenerateLods(MeshData& mesh, uint32_t levelCount, float reduction, float maxError)
+{
+	mesh.lods.clear();
+	if (levelCount == 0 || mesh.indices.empty())
+		return;
+	if (!(reduction > 0.0f && reduction < 1.0f))
+		throw std::invalid_argument("MeshSimplifier: reduction must be between 0 and 1");
+
+	// サブメッシュから三角形ごとのマテリアル番号を作る
+	std::vector<uint32_t> materials(mesh.indices.size() / 3, 0);
+	for (const SubMesh& subMesh : mesh.subMeshes)
+	{
+		for (uint32_t i = subMesh.indexStart / 3; i < (subMesh.indexStart + subMesh.indexCount) / 3 && i < materials.size(); i++)
+			materials[i] = subMesh.materialIndex;
+	}
+
+	// 誤差の上限は境界ボックスの対角線の長さに対する割合で与える
+	const MeshBounds& bounds = mesh.bounds;
+	double extent[3] = { bounds.maximum[0] - bounds.minimum[0], bounds.maximum[1] - bounds.minimum[1], bounds.maximum[2] - bounds.minimum[2] };
+	double limit = double(maxError) * sqrt(Dot(extent, extent));
+
+	QuadricSimplifier simplifier(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), materials.data());
+	size_t target = mesh.indices.size() / 3;
+	double error = 0.0;
+	std::vector<uint32_t> indices, lodMaterials;
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		target = size_t(double(target) * reduction);
+		if (target == 0 || !simplifier.CollapseTo(target, limit))
+			break;
+		// 二次誤差は面の内側のずれを測らないので、詳細度の誤差は実際に測った距離にする
+		error = std::max(error, simplifier.MeasureError());
+		if (error > limit)
+			break;
+		simplifier.Extract(indices, &lodMaterials);
+		mesh.lods.emplace_back();
+		MakeLod(mesh, indices, lodMaterials, error, mesh.lods.back());
+	}
+}
+
+// 複数のメッシュの詳細度をメッシュごとに並列に生成する
+void MeshSimplifier::GenerateLods(std::vector<MeshData>& meshes, uint32_t levelCount, JobSystem* jobSystem, float reduction, float maxError)
+{
+	// メッシュごとの例外は集めておき、すべて終わってから最初のものを投げ直す
+	std::vector<std::exception_ptr> errors(meshes.size());
+	auto generate = [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			try
+			{
+				GenerateLods(meshes[i], levelCount, reduction, maxError);
+			}
+			catch (...)
+			{
+				errors[i] = std::current_exception();
+			}
+		}
+	};
+	if (jobSystem)
+	{
+		jobSystem->ParallelFor(meshes.size(), 1, generate);
+	}
+	else
+	{
+		generate(0, meshes.size());
+	}
+	for (const std::exception_ptr& error : errors)
+	{
+		if (error)
+			std::rethrow_exception(error);
+	}
+}
@@ -0,0 +1,37 @@
+﻿#pragma once
+#ifndef MESHSIMPLIFIER_DEFINED
+#define MESHSIMPLIFIER_DEFINED
+
+#include <stdint.h>
+#include <vector>
+#include "MeshData.h"
+
+class JobSystem;
+
+// 二次誤差(QEM)による辺の縮約でメッシュの三角形を減らし、詳細度の連鎖を生成するクラス
+// 縮約先は辺の端点のどちらかなので、簡略化したメッシュは元の頂点をそのまま使う
+// 同じ位置の頂点は1つにまとめて扱い、開いた縁とマテリアルの境界は縁に垂直な平面の誤差で形を保つ
+class MeshSimplifier
+{
+public:
+	// 前のレベルに対する三角形の数の割合
+	static const float DEFAULT_REDUCTION;
+	// 許容する誤差(境界ボックスの対角線の長さに対する割合)
+	static const float DEFAULT_MAX_ERROR;
+
+	// 三角形が目標数以下になるまで縮約する(誤差がmaxErrorを超える縮約はしないので、目標数に届かない場合がある)
+	// 三角形ごとのマテリアル番号は縮約後も保たれる(materialsがnullptrの場合はすべて同じマテリアル)
+	// 元の頂点から簡略化した面までの距離の最大値(モデル空間の距離、実際の距離以上の値になる)を返す
+	static float Simplify(std::vector<uint32_t>& destination, const uint32_t* indices, size_t indexCount,
+		const MeshVertex* vertices, size_t vertexCount, size_t targetTriangleCount, float maxError,
+		const uint32_t* materials = nullptr, std::vector<uint32_t>* destinationMaterials = nullptr);
+	// 三角形の数を前のレベルのreduction倍ずつ減らした詳細度をlevelCount個まで生成する
+	// 1つの縮約の列から順に取り出すので誤差は単調に増え、誤差の上限までに目標数に届かないレベルは作らない
+	// 縮約の順は二次誤差で決め、レベルの誤差は元の頂点から簡略化した面までの距離を測って求める
+	static void GenerateLods(MeshData& mesh, uint32_t levelCount, float reduction = DEFAULT_REDUCTION, float maxError = DEFAULT_MAX_ERROR);
+	// 複数のメッシュの詳細度をメッシュごとに並列に生成する(jobSystemがnullptrの場合は逐次生成する)
+	static void GenerateLods(std::vector<MeshData>& meshes, uint32_t levelCount, JobSystem* jobSystem,
+		float reduction = DEFAULT_REDUCTION, float maxError = DEFAULT_MAX_ERROR);
+};
+
+#endif	// MESHSIMPLIFIER_DEFINED
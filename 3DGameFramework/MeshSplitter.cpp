@@ -0,0 +1,69 @@
+﻿#include "MeshSplitter.h"
+#include <algorithm>
+#include <stdexcept>
+
+// 三角形の順序を保ったままメッシュを分割する
+std::vector<MeshChunk> MeshSplitter::Split(const MeshVertex* vertices, uint32_t vertexCount,
+	const uint32_t* indices, uint32_t indexCount, uint32_t maxVertices, uint32_t maxIndices)
+{
+	if (indexCount % 3 != 0 || maxVertices < 3 || maxVertices > MAX_CHUNK_VERTICES || maxIndices < 3)
+	{
+		throw std::invalid_argument("MeshSplitter: invalid split parameters");
+	}
+
+	// 元の頂点番号からチャンク内の頂点番号への対応表(世代番号で毎回のクリアを省く)
+	std::vector<uint32_t> remap(vertexCount, 0);
+	std::vector<uint32_t> generation(vertexCount, 0);
+	uint32_t currentGeneration = 0;
+
+	std::vector<MeshChunk> chunks;
+	MeshChunk* chunk = nullptr;
+
+	for (uint32_t i = 0; i < indexCount; i += 3)
+	{
+		const uint32_t* triangle = indices + i;
+		for (int n = 0; n < 3; n++)
+		{
+			if (triangle[n] >= vertexCount)
+			{
+				throw std::out_of_range("MeshSplitter: index out of range");
+			}
+		}
+
+		// この三角形で新たに必要になる頂点数を数える
+		uint32_t newVertices = 0;
+		if (chunk)
+		{
+			for (int n = 0; n < 3; n++)
+			{
+				bool duplicate = (n > 0 && triangle[n] == triangle[0]) || (n > 1 && triangle[n] == triangle[1]);
+				if (generation[triangle[n]] != currentGeneration && !duplicate)
+					newVertices++;
+			}
+		}
+
+		// 収まらない場合は新しいチャンクを開始する
+		if (chunk == nullptr || chunk->sourceVertices.size() + newVertices > maxVertices || chunk->indices.size() + 3 > maxIndices)
+		{
+			chunks.emplace_back();
+			chunk = &chunks.back();
+			currentGeneration++;
+		}
+
+		for (int n = 0; n < 3; n++)
+		{
+			uint32_t index = triangle[n];
+			if (generation[index] != currentGeneration)
+			{
+				generation[index] = currentGeneration;
+				remap[index] = uint32_t(chunk->sourceVertices.size());
+				chunk->sourceVertices.push_back(index);
+				if (vertices)
+					chunk->vertices.push_back(vertices[index]);
+			}
+			chunk->indices.push_back(uint16_t(remap[index]));
+		}
+	}
+
+	return chunks;
+}
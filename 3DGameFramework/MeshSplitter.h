@@ -0,0 +1,33 @@
+﻿#pragma once
+#ifndef MESHSPLITTER_DEFINED
+#define MESHSPLITTER_DEFINED
+
+#include <stdint.h>
+#include <vector>
+#include "MeshData.h"
+
+// 16ビットインデックスで描画できる大きさに分割したメッシュの断片
+struct MeshChunk
+{
+	// 頂点配列(頂点を渡さずに分割した場合は空)
+	std::vector<MeshVertex> vertices;
+	// チャンクの頂点ごとの元の頂点番号
+	std::vector<uint32_t> sourceVertices;
+	// 16ビットインデックス配列
+	std::vector<uint16_t> indices;
+};
+
+// 32ビットインデックスのメッシュを16ビットインデックスのチャンクに分割するクラス
+class MeshSplitter
+{
+public:
+	// チャンクあたりの最大頂点数(0xFFFFはストリップカット値なので使用しない)
+	static const uint32_t MAX_CHUNK_VERTICES = 0xFFFF;
+
+	// 三角形の順序を保ったままメッシュを分割する(verticesがnullptrの場合は元の頂点番号だけを記録する)
+	static std::vector<MeshChunk> Split(const MeshVertex* vertices, uint32_t vertexCount,
+		const uint32_t* indices, uint32_t indexCount,
+		uint32_t maxVertices = MAX_CHUNK_VERTICES, uint32_t maxIndices = UINT32_MAX);
+};
+
+#endif	// MESHSPLITTER_DEFINED
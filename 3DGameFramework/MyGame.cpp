@@ -1,13 +1,29 @@
 #define _CRT_SECURE_NO_WARNINGS
 
 #include "MyGame.h"
+#include "FbxMeshImporter.h"
+#include "JobSystem.h"
+#include "DebugDraw.h"
 
 using namespace DirectX;
 using namespace DirectX::SimpleMath;
 
+namespace
+{
+	// Nbvʂ܂ł̋
+	const float FAR_PLANE = 100.0f;
+	// CX^Xׂiq̈ӂ̐
+	const int INSTANCE_GRID_SIZE = 32;
+}
+
 // RXgN^
-MyGame::MyGame(int width, int height) : m_width(width), m_height(height), Game(width, height)
+MyGame::MyGame(int width, int height) : m_width(width), m_height(height), Game(width, height), m_pickedMesh(-1), m_snapshot(nullptr), m_writingSnapshot(nullptr), m_showBounds(false), m_showInstances(false), m_useLods(true)
 {
+	// f̉]pŒXebvԂŕԂ
+	AddInterpolatedState(&m_modelAngle);
+	// bV̕`R[ƎOp`t[̓vɉ
+	m_drawCallCounter = GetFrameStatistics().AddCounter("draw calls");
+	m_triangleCounter = GetFrameStatistics().AddCounter("triangles");
 }
 
 // MyGameIuWFNg
@@ -15,39 +31,167 @@ void MyGame::Initialize(int width, int height)
 {
 	// NXInitializeĂяo 
 	Game::Initialize(width, height);
+	// ̓ǂݍ݂v
+	PROFILE_SCOPE("LoadAssets");
 
-	// CommonStatesIuWFNg𐶐
-	m_commonStates = std::make_unique<DirectX::CommonStates>(m_directX.GetDevice().Get());
-	// EffectFactoryIuWFNg𐶐
-	m_effectFactory = std::make_unique<DirectX::EffectFactory>(m_directX.GetDevice().Get());
-	// fIuWFNg𐶐
-	m_model = DirectX::Model::CreateFromCMO(m_directX.GetDevice().Get(), L"cup.cmo", *m_effectFactory);
+	// wbhXłGPŨ\[X𐶐Ȃ(f͕`悵Ȃ)
+	if (!IsHeadless())
+	{
+		// CommonStatesIuWFNg𐶐
+		m_commonStates = std::make_unique<DirectX::CommonStates>(m_directX.GetDevice().Get());
+		// EffectFactoryIuWFNg𐶐
+		m_effectFactory = std::make_unique<DirectX::EffectFactory>(m_directX.GetDevice().Get());
+		// fIuWFNg𐶐
+		PROFILE_SCOPE("LoadModel");
+		m_model = DirectX::Model::CreateFromCMO(m_directX.GetDevice().Get(), L"cup.cmo", *m_effectFactory);
+	}
 
 	m_world = DirectX::SimpleMath::Matrix::Identity;
 
-	//FbxManagerFbxSceneIuWFNg쐬
-	FbxManager* manager = FbxManager::Create();
-	FbxIOSettings* ios = FbxIOSettings::Create(manager, IOSROOT);
-	manager->SetIOSettings(ios);
-	FbxScene* scene = FbxScene::Create(manager, "");
+	// xCNς݃bVt@C}bvœǂݍ(ÂꍇFBXxCN)
+	try
+	{
+		PROFILE_SCOPE("LoadMeshFile");
+		m_meshFile = std::make_unique<MeshFile>("star2.mesh");
+	}
+	catch (const std::exception&)
+	{
+		MeshImportOptions options;
+		options.optimize = true;
+		options.jobSystem = &GetJobSystem();
+		options.lodLevels = MeshImportOptions::DEFAULT_LOD_LEVELS;
+		options.quantizeVertices = true;
+		PROFILE_SCOPE("BakeMeshFile");
+		FbxMeshImporter::Bake("star2.FBX", "star2.mesh", options);
+		m_meshFile = std::make_unique<MeshFile>("star2.mesh");
+	}
+	// bVGPUɏ풓(32rbgCfbNXgȂꍇ̓`Nɕ)
+	// bVƂɃV[Ot̃m[h쐬([hϊ͒_ɏĂ܂Ă̂ŒPʕϊ)
+	m_sceneGraph.Clear();
+	m_sceneGraph.Reserve(m_meshFile->GetMeshCount() + 1);
+	int32_t root = m_sceneGraph.AddNode("star2");
+	for (uint32_t i = 0; i < m_meshFile->GetMeshCount(); i++)
+	{
+		PROFILE_SCOPE("UploadMesh");
+		MeshView mesh = m_meshFile->GetMesh(i);
+		if (!IsHeadless())
+		{
+			if (mesh.quantizedVertices)
+				m_staticMeshes.push_back(std::make_unique<StaticMesh>(m_directX.GetDevice().Get(),
+					mesh.quantizedVertices, mesh.vertexCount, mesh.indices, mesh.indexCount));
+			else
+				m_staticMeshes.push_back(std::make_unique<StaticMesh>(m_directX.GetDevice().Get(),
+					mesh.vertices, mesh.vertexCount, mesh.indices, mesh.indexCount));
+		}
+		m_meshNodes.push_back(m_sceneGraph.AddNode(mesh.name, root, int32_t(i)));
+		m_meshBounds.push_back(mesh.bounds);
+		// ʎqʒu͋E{bNX̒0`1ɂȂĂ̂ŁA`掞ɕsŖ߂
+		SceneMatrix decode;
+		VertexQuantizer::GetDecodeMatrix(mesh.bounds, decode.m);
+		m_meshQuantized.push_back(mesh.quantizedVertices != nullptr);
+		m_meshDecodes.push_back(decode);
+	}
+	// ڍדx͌̃bV̌ɓo^ÃbV̔ԍ͕ςȂ
+	for (uint32_t i = 0; i < m_meshFile->GetMeshCount(); i++)
+	{
+		MeshView mesh = m_meshFile->GetMesh(i);
+		m_meshLodFirst.push_back(uint32_t(m_meshLodErrors.size()));
+		m_meshLodCounts.push_back(mesh.lodCount);
+		for (uint32_t level = 0; level < mesh.lodCount; level++)
+		{
+			MeshLodView lod = m_meshFile->GetLod(mesh, level);
+			if (!IsHeadless() && lod.quantizedVertices)
+				m_staticMeshes.push_back(std::make_unique<StaticMesh>(m_directX.GetDevice().Get(),
+					lod.quantizedVertices, lod.vertexCount, lod.indices, lod.indexCount));
+			else if (!IsHeadless())
+				m_staticMeshes.push_back(std::make_unique<StaticMesh>(m_directX.GetDevice().Get(),
+					lod.vertices, lod.vertexCount, lod.indices, lod.indexCount));
+			m_meshLodErrors.push_back(lod.error);
+		}
+	}
+	// `L[̃\[gL[ɂ͌̃bVƏڍדx킹ԍ̂ŁAǂݍ񂾎_Ŏ܂邩mF
+	if (m_meshNodes.size() + m_meshLodErrors.size() > (size_t(1) << RenderQueue::MESH_BITS))
+		throw std::runtime_error("MyGame: too many meshes and levels for the render queue sort key");
+	m_meshLods.assign(m_meshFile->GetMeshCount(), 0);
+	m_lodSelector.SetProjection(DirectX::XM_PI / 4.0f, float(height));
+	// bV̋E{[Kw\z
+	{
+		PROFILE_SCOPE("BuildBvh");
+		m_sceneGraph.UpdateWorldTransforms();
+		UpdateMeshBounds();
+		m_bvh.Build(m_meshWorldBounds.data(), m_meshWorldBounds.size(), &GetJobSystem());
+	}
+	m_meshVisible.resize(m_meshWorldBounds.size());
+	// ŏ̃bṼCX^Xׂ
+	CreateInstances();
+	// XibvVbg^XNOt\z
+	CreateSnapshotTasks();
 
-	//f[^C|[g
-	const char* filename = "star2.FBX";
-	FbxImporter* importer = FbxImporter::Create(manager, "");
-	importer->Initialize(filename, -1, manager->GetIOSettings());
-	importer->Import(scene);
-	importer->Destroy();
+	// fobOJ𐶐
+	m_debugCamera = std::make_unique<DebugCamera>(width, height);
 
-	//Op|S
-	FbxGeometryConverter geometryConverter(manager);
-	geometryConverter.Triangulate(scene, true);
+	// wbhXł͕`R}h𐔂邾̃obNGhɁAŃVF[_E}eAEbVo^
+	if (IsHeadless())
+	{
+		m_nullBackend = std::make_unique<NullRenderBackend>();
+		m_meshShader = m_nullBackend->AddShader();
+		m_instancedShader = m_nullBackend->AddShader();
+		m_quantizedMeshShader = m_nullBackend->AddShader();
+		m_quantizedInstancedShader = m_nullBackend->AddShader();
+		m_meshMaterial = m_nullBackend->AddMaterial();
+		for (uint32_t i = 0; i < m_meshFile->GetMeshCount(); i++)
+		{
+			m_nullBackend->AddMesh(1, m_meshFile->GetMesh(i).indexCount / 3);
+		}
+		for (uint32_t i = 0; i < m_meshFile->GetMeshCount(); i++)
+		{
+			MeshView mesh = m_meshFile->GetMesh(i);
+			for (uint32_t level = 0; level < mesh.lodCount; level++)
+				m_nullBackend->AddMesh(1, m_meshFile->GetLod(mesh, level).indexCount / 3);
+		}
+		return;
+	}
 
-	m_primitiveBatch = std::make_unique<DirectX::PrimitiveBatch<DirectX::VertexPositionColor>>(m_directX.GetContext().Get());
+	// bV`p̃GtFNg𐶐
+	m_meshEffect = std::make_unique<DirectX::BasicEffect>(m_directX.GetDevice().Get());
+	m_meshEffect->SetVertexColorEnabled(true);
+	void const* shaderByteCode;
+	size_t byteCodeLength;
+	m_meshEffect->GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
+	// bV`p̃CvbgCAEg𐶐
+	DX::ThrowIfFailed(m_directX.GetDevice()->CreateInputLayout(DirectX::VertexPositionColor::InputElements,
+		DirectX::VertexPositionColor::InputElementCount,
+		shaderByteCode, byteCodeLength,
+		m_meshInputLayout.ReleaseAndGetAddressOf()));
+	// ʎqbV`p̃CvbgCAEg𐶐(K̓VF[_ɂ͕_œn)
+	DX::ThrowIfFailed(m_directX.GetDevice()->CreateInputLayout(StaticMesh::QUANTIZED_INPUT_ELEMENTS,
+		StaticMesh::QUANTIZED_INPUT_ELEMENT_COUNT,
+		shaderByteCode, byteCodeLength,
+		m_quantizedMeshInputLayout.ReleaseAndGetAddressOf()));
+	// CX^X`p̃GtFNgƃCvbgCAEg𐶐
+	m_instancedEffect = std::make_unique<InstancedEffect>(m_directX.GetDevice().Get());
+	m_instancedEffect->CreateInputLayout(m_directX.GetDevice().Get(), m_instancedInputLayout.ReleaseAndGetAddressOf());
+	m_instancedEffect->CreateInputLayout(m_directX.GetDevice().Get(), m_quantizedInstancedInputLayout.ReleaseAndGetAddressOf(), true);
+
+	// `R}hsobNGhɃVF[_E}eAEbVo^
+	m_renderBackend = std::make_unique<D3D11RenderBackend>(m_directX.GetContext().Get());
+	m_meshShader = m_renderBackend->AddShader(m_meshEffect.get(), m_meshInputLayout.Get());
+	m_instancedShader = m_renderBackend->AddShader(m_instancedEffect.get(), m_instancedInputLayout.Get());
+	m_quantizedMeshShader = m_renderBackend->AddShader(m_meshEffect.get(), m_quantizedMeshInputLayout.Get());
+	m_quantizedInstancedShader = m_renderBackend->AddShader(m_instancedEffect.get(), m_quantizedInstancedInputLayout.Get());
+	m_meshMaterial = m_renderBackend->AddMaterial(m_commonStates->Opaque(), m_commonStates->DepthDefault(), m_commonStates->CullNone());
+	for (const std::unique_ptr<StaticMesh>& staticMesh : m_staticMeshes)
+	{
+		m_renderBackend->AddMesh(staticMesh.get());
+	}
 
-	m_fbxmodel = scene;
+	// t[̓v\I[o[Cʂ̉Eɐ
+	m_overlay = std::make_unique<PerformanceOverlay>(m_directX.GetDevice().Get(), m_directX.GetContext().Get(), m_commonStates.get(),
+		GetSpriteBatch(), GetSpriteFont());
+	m_overlay->SetPosition(float(width - PerformanceOverlay::PANEL_WIDTH - PerformanceOverlay::MARGIN), float(PerformanceOverlay::MARGIN));
 
-	// fobOJ𐶐
-	m_debugCamera = std::make_unique<DebugCamera>(width, height);
+	// fobO\`悷郌_𐶐
+	m_debugDrawRenderer = std::make_unique<DebugDrawRenderer>(m_directX.GetDevice().Get(), m_commonStates.get());
 }
 
 // \[X𐶐
@@ -62,7 +206,10 @@ void MyGame::CreateResources()
 		DirectX::SimpleMath::Vector3::Zero, DirectX::SimpleMath::Vector3::Up);
 	// ˉeWϊs𐶐
 	m_projection = DirectX::SimpleMath::Matrix::CreatePerspectiveFieldOfView(DirectX::XM_PI / 4.0f,
-		float(m_width) / float(m_height), 0.1f, 100.0f);
+		float(m_width) / float(m_height), 0.1f, FAR_PLANE);
+	// wbhXł̓fƏ`悵Ȃ
+	if (IsHeadless())
+		return;
 	// GtFNgXV
 	m_model->UpdateEffects([](DirectX::IEffect* effect)
 		{
@@ -100,113 +247,281 @@ void MyGame::Update(const DX::StepTimer& timer)
 	// oߎԂ擾
 	float elapsedTime = float(timer.GetTotalSeconds());
 
-	// fobOJXV
-	m_debugCamera->Update();
-}
+	// f̉]pXV
+	m_modelAngle.GetCurrent() = cosf(elapsedTime) * 1.0f;
 
-void DisplayPosition(FbxMesh* mesh)
-{
-	int positionNum = mesh->GetControlPointsCount();	// _
-	FbxVector4* position = mesh->GetControlPoints();	// _Wz
+	// fobOJXV
+	const InputState& input = GetInput();
+	m_debugCamera->Update(input);
 
-	for (int i = 0; i < positionNum; ++i)
+	// ENbNʒũbVI
+	if (input.IsMousePressed(InputState::MOUSE_RIGHT))
+	{
+		PickMesh(input.GetMouseX(), input.GetMouseY());
+	}
+	// BL[łׂẴbV̋E{bNX̕\؂ւ
+	if (input.IsKeyPressed(DirectX::Keyboard::B))
+	{
+		m_showBounds = !m_showBounds;
+	}
+	// IL[ŃbṼCX^X̕\؂ւ
+	if (input.IsKeyPressed(DirectX::Keyboard::I))
 	{
-		std::cout << "position[" << i << "] : ("
-			<< position[i][0] << ","
-			<< position[i][1] << ","
-			<< position[i][2] << ","
-			<< position[i][3] << ")" << std::endl;
+		m_showInstances = !m_showInstances;
+	}
+	// LL[ŏڍדx̐؂ւLEɂ
+	if (input.IsKeyPressed(DirectX::Keyboard::L))
+	{
+		m_useLods = !m_useLods;
 	}
 }
 
-void DisplayIndex(FbxMesh* mesh)
+// bṼ[hԂ̋E{bNXXV
+void MyGame::UpdateMeshBounds()
 {
-	//|S
-	int polygonNum = mesh->GetPolygonCount();
-
-	//pڂ̃|Sւ̏
-	for (int p = 0; p < polygonNum; ++p)
+	m_meshWorldBounds.resize(m_meshNodes.size());
+	for (size_t i = 0; i < m_meshNodes.size(); i++)
 	{
-		//pڂ̃|Snڂ̒_ւ̏
-		for (int n = 0; n < 3; ++n)
-		{
-			int index = mesh->GetPolygonVertex(p, n);
-			std::cout << "index[" << p + n << "] : " << index << std::endl;
-		}
+		m_meshWorldBounds[i] = FrustumCuller::TransformBounds(m_meshBounds[i], m_sceneGraph.GetWorldMatrix(m_meshNodes[i]).m);
 	}
 }
 
-void MyGame::DisplayMesh(FbxNode* node)
+// XN[W΂CōłÕbVI
+void MyGame::PickMesh(int x, int y)
 {
-	FbxMesh* mesh = (FbxMesh*)node->GetNodeAttribute();
+	// XN[WߕʂƉʏ̃[hWɖ߂
+	DirectX::SimpleMath::Matrix inverse = (m_debugCamera->GetCameraMatrix() * m_projection).Invert();
+	float clipX = 2.0f * float(x) / float(m_width) - 1.0f;
+	float clipY = 1.0f - 2.0f * float(y) / float(m_height);
+	DirectX::SimpleMath::Vector3 nearPoint = DirectX::SimpleMath::Vector3::Transform(DirectX::SimpleMath::Vector3(clipX, clipY, 0.0f), inverse);
+	DirectX::SimpleMath::Vector3 farPoint = DirectX::SimpleMath::Vector3::Transform(DirectX::SimpleMath::Vector3(clipX, clipY, 1.0f), inverse);
+	DirectX::SimpleMath::Vector3 direction = farPoint - nearPoint;
+	float length = direction.Length();
+	direction /= length;
+
+	uint32_t mesh = m_bvh.Raycast(&nearPoint.x, &direction.x, length);
+	m_pickedMesh = mesh == BoundingVolumeHierarchy::NO_PRIMITIVE ? -1 : int32_t(mesh);
+}
 
-	//std::cout << "\n\nMesh Name: " << (char*)node->GetName() << std::endl;
+// `ɕKvȏԂXibvVbgɏ(pCvCł͍XVXbhŌĂ΂)
+void MyGame::WriteSnapshot(int snapshot)
+{
+	FrameSnapshot& frame = m_snapshots[snapshot];
+	frame.view = m_debugCamera->GetCameraMatrix();
+	// Zɑ΂ĉ]s𐶐(Oƌ݂̌ŒXebv̉]pԂ)
+	frame.world = DirectX::SimpleMath::Matrix::CreateRotationZ(m_modelAngle.Interpolate(float(GetTimer().GetInterpolationAlpha())));
+	frame.pickedMesh = m_pickedMesh;
+
+	// ϊEJOE`L[̍쐬WuVXeŎs
+	m_writingSnapshot = &frame;
+	m_snapshotTasks.Run(GetJobSystem());
+	m_writingSnapshot = nullptr;
+
+	// XVɐς܂ꂽfobO\܂Ƃ߂
+	DebugDraw::Get().Collect(frame.debugDraw);
+}
 
-	//DisplayIndex(mesh);
-	//DisplayPosition(mesh);
+// XibvVbg^XNOt\z
+void MyGame::CreateSnapshotTasks()
+{
+	m_snapshotTasks.Clear();
+	TaskGraph::TaskId transforms = m_snapshotTasks.AddTask("transforms", [this]() { UpdateTransforms(); });
+	TaskGraph::TaskId culling = m_snapshotTasks.AddTask("culling", [this]() { CullMeshes(*m_writingSnapshot); });
+	TaskGraph::TaskId submission = m_snapshotTasks.AddTask("submission", [this]() { BuildRenderQueue(*m_writingSnapshot); });
+	// f̃JO͑̃^XNɈˑȂ̂ŕsĎs
+	m_snapshotTasks.AddTask("model culling", [this]() { CullModel(*m_writingSnapshot); });
+	// E{bNX̕\̓JǑʂgA`L[̍쐬ƕsĎs
+	TaskGraph::TaskId bounds = m_snapshotTasks.AddTask("debug bounds", [this]() { DrawMeshBounds(*m_writingSnapshot); });
+	m_snapshotTasks.AddDependency(transforms, culling);
+	m_snapshotTasks.AddDependency(culling, submission);
+	m_snapshotTasks.AddDependency(culling, bounds);
+}
 
-	m_spriteBatch;
+// V[Ot̃[hsXVAύX΋E{[KwēK
+void MyGame::UpdateTransforms()
+{
+	// ύXꂽm[h̃[hs񂾂XV
+	if (m_sceneGraph.UpdateWorldTransforms() > 0)
+	{
+		UpdateMeshBounds();
+		m_bvh.Refit(m_meshWorldBounds.data());
+	}
 }
 
-void MyGame::DisplayContent(FbxScene* scene, FbxNode* node)
+// E{[KwHĎƌ郁bV𔻒肷
+void MyGame::CullMeshes(const FrameSnapshot& snapshot)
 {
-	FbxNodeAttribute::EType lAttributeType;
+	DirectX::SimpleMath::Matrix viewProjection = snapshot.view * m_projection;
+	FrustumCuller culler(&viewProjection._11);
+	m_bvh.CullFrustum(culler, m_meshVisible.data());
+}
 
-	if (node->GetNodeAttribute() == NULL)
+// bV̋E{bNXfobO\ɐς(郁bV͗΁AJOꂽbV͐ԁAIꂽbV͎OɉFŕ\)
+void MyGame::DrawMeshBounds(const FrameSnapshot& snapshot)
+{
+	DebugDraw& debugDraw = DebugDraw::Get();
+	if (snapshot.pickedMesh >= 0)
 	{
-		//std::cout << "NULL Node Attribute\n\n";
+		const float yellow[4] = { 1.0f, 1.0f, 0.0f, 1.0f };
+		const MeshBounds& bounds = m_meshWorldBounds[snapshot.pickedMesh];
+		const float top[3] = { (bounds.minimum[0] + bounds.maximum[0]) * 0.5f, bounds.maximum[1], (bounds.minimum[2] + bounds.maximum[2]) * 0.5f };
+		debugDraw.AddBox(bounds, yellow, DebugDrawList::NO_DEPTH);
+		debugDraw.AddText(top, m_sceneGraph.GetName(m_meshNodes[snapshot.pickedMesh]).c_str(), yellow);
 	}
-	else
-	{
-		lAttributeType = (node->GetNodeAttribute()->GetAttributeType());
+	if (!m_showBounds)
+		return;
 
-		switch (lAttributeType)
+	// bVꍇ̓[J[ŕSĐς
+	const float green[4] = { 0.0f, 1.0f, 0.0f, 1.0f };
+	const float red[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+	GetJobSystem().ParallelFor(m_meshNodes.size(), 256, [&](size_t begin, size_t end)
 		{
-		default:
-			break;
-
-		case FbxNodeAttribute::eMesh:
+			for (size_t i = begin; i < end; i++)
+				debugDraw.AddBox(m_meshWorldBounds[i], m_meshVisible[i] ? green : red);
+		});
+	debugDraw.AddAxes(&Matrix::Identity._11, 1.0f);
+}
 
-			FbxMesh* mesh = (FbxMesh*)node->GetNodeAttribute();
+// `悷XibvVbg󂯎
+void MyGame::ReadSnapshot(int snapshot)
+{
+	m_snapshot = &m_snapshots[snapshot];
+}
 
-			//std::cout << "\n\nMesh Name: " << (char*)node->GetName() << std::endl;
+// 郁bVXibvVbg̕`L[ɐς
+void MyGame::BuildRenderQueue(FrameSnapshot& snapshot)
+{
+	// 郁bV`L[ɐς(sȂ̂ŋE{bNX̒S̃r[Ԃ̐[xŎOׂ)
+	// `撆ɃV[OtXVĂeȂ悤A[hs̓XibvVbgɕĎQƂ
+	snapshot.renderQueue.Clear();
+	snapshot.meshWorlds.resize(m_meshNodes.size());
+	// _̈ʒu̓r[s̋ts̕sړɂȂ
+	DirectX::SimpleMath::Vector3 eye = snapshot.view.Invert().Translation();
+	for (size_t i = 0; i < m_meshNodes.size(); i++)
+	{
+		if (!m_meshVisible[i])
+			continue;
+
+		const MeshBounds& bounds = m_meshWorldBounds[i];
+		DirectX::SimpleMath::Vector3 center((bounds.minimum[0] + bounds.maximum[0]) * 0.5f,
+			(bounds.minimum[1] + bounds.maximum[1]) * 0.5f, (bounds.minimum[2] + bounds.maximum[2]) * 0.5f);
+		float depth = -DirectX::SimpleMath::Vector3::Transform(center, snapshot.view).z / FAR_PLANE;
+		const SceneMatrix& world = m_sceneGraph.GetWorldMatrix(m_meshNodes[i]);
+		if (m_meshQuantized[i])
+			SceneGraph::Multiply(m_meshDecodes[i], world, snapshot.meshWorlds[i]);
+		else
+			snapshot.meshWorlds[i] = world;
+
+		// E{bNX܂ł̋ŏڍדxI([hϊ͒_ɏĂ܂Ă̂ŁA덷͂̂܂܃[hԂ̋ɂȂ)
+		uint32_t level = m_useLods ? m_lodSelector.Select(m_meshLodErrors.data() + m_meshLodFirst[i], m_meshLodCounts[i],
+			MeshLodSelector::Distance(bounds, &eye.x), m_meshLods[i]) : 0;
+		m_meshLods[i] = level;
+		uint32_t mesh = level == 0 ? uint32_t(i) : uint32_t(m_meshNodes.size()) + m_meshLodFirst[i] + level - 1;
+		uint32_t shader = m_meshQuantized[i] ? m_quantizedMeshShader : m_meshShader;
+		snapshot.renderQueue.Submit(0, shader, m_meshMaterial, mesh, depth, snapshot.meshWorlds[i].m);
+	}
 
-			//DisplayIndex(mesh);
-			//DisplayPosition(mesh);
+	// CX^X͓bVƃ}eAȂ̂ŁA܂Ƃ߂1̃CX^X`ɂȂ
+	if (m_showInstances)
+	{
+		uint32_t shader = !m_meshQuantized.empty() && m_meshQuantized[0] ? m_quantizedInstancedShader : m_instancedShader;
+		for (size_t i = 0; i < m_instanceWorlds.size(); i++)
+		{
+			snapshot.renderQueue.SubmitInstance(0, shader, m_meshMaterial, 0, &m_instanceWorlds[i]._11, &m_instanceColors[i].x);
+		}
+	}
 
-			//m_spriteBatch->Draw(scene->GetTexture(,), mesh.getTex);
-			int vertexCount = mesh->GetControlPointsCount();
-			auto vertices = new VertexPositionColor[vertexCount];
-			for (int i = 0; i < mesh->GetControlPointsCount(); i++) {
-				auto point = mesh->GetControlPointAt(i);
-				//auto color = mesh->coloGetElementVertexColor(i);
-				vertices[i] = VertexPositionColor(Vector3((float)point[0], (float)point[1], (float)point[2]), Colors::White);
-			}
+	// VF[_E}eAEbV̏Ƀ\[g
+	snapshot.renderQueue.Sort();
+}
 
-			m_primitiveBatch->DrawIndexed(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, (uint16_t*) mesh->GetPolygonVertices(), mesh->GetPolygonCount(), vertices, vertexCount);
-			delete vertices;
+// bṼCX^Xiqɕׂ
+void MyGame::CreateInstances()
+{
+	m_instanceWorlds.clear();
+	m_instanceColors.clear();
+	if (m_meshBounds.empty())
+		return;
 
-			break;
+	// ŏ̃bVAE{bNX̒S_̎̏̏̊iq_ɗ悤ɕׂ
+	const MeshBounds& bounds = m_meshBounds[0];
+	Vector3 center((bounds.minimum[0] + bounds.maximum[0]) * 0.5f, bounds.minimum[1], (bounds.minimum[2] + bounds.maximum[2]) * 0.5f);
+	float spacing = std::max(bounds.maximum[0] - bounds.minimum[0], bounds.maximum[2] - bounds.minimum[2]) * 1.5f;
+	float offset = float(INSTANCE_GRID_SIZE - 1) * 0.5f;
+	// ʎqbV͕sɊ|Ă
+	Matrix decode = m_meshQuantized[0] ? Matrix(m_meshDecodes[0].m) : Matrix::Identity;
+	for (int z = 0; z < INSTANCE_GRID_SIZE; z++)
+	{
+		for (int x = 0; x < INSTANCE_GRID_SIZE; x++)
+		{
+			Vector3 position((float(x) - offset) * spacing, 0.0f, (float(z) - offset) * spacing);
+			m_instanceWorlds.push_back(decode * Matrix::CreateTranslation(position - center));
+			m_instanceColors.push_back(Vector4(float(x) / float(INSTANCE_GRID_SIZE), 0.5f, float(z) / float(INSTANCE_GRID_SIZE), 1.0f));
 		}
 	}
+}
 
+// ϊς݂FBXbV`悷
+void MyGame::DrawMeshes()
+{
+	static_assert(sizeof(MeshVertex) == sizeof(VertexPositionColor), "MeshVertex must match VertexPositionColor layout");
 
-	for (int i = 0; i < node->GetChildCount(); i++)
+	// XibvVbg̃\[gς݂̕`L[AԂ̐؂ւȂR}hŕ`悷
+	m_renderCommands.Clear();
+	m_snapshot->renderQueue.Record(m_renderCommands);
+	if (m_nullBackend)
 	{
-		DisplayContent(scene, node->GetChild(i));
+		m_nullBackend->SetViewProjection(&m_view._11, &m_projection._11);
+		m_nullBackend->ResetStatistics();
+		m_renderCommands.Execute(*m_nullBackend);
+		GetFrameStatistics().SetCounter(m_drawCallCounter, m_nullBackend->GetDrawCalls());
+		GetFrameStatistics().SetCounter(m_triangleCounter, m_nullBackend->GetTriangles());
+		return;
 	}
+	m_renderBackend->SetViewProjection(m_view, m_projection);
+	m_renderBackend->ResetStatistics();
+	m_renderCommands.Execute(*m_renderBackend);
+	GetFrameStatistics().SetCounter(m_drawCallCounter, m_renderBackend->GetDrawCalls());
+	GetFrameStatistics().SetCounter(m_triangleCounter, m_renderBackend->GetTriangles());
 }
 
-void MyGame::DisplayContent(FbxScene* scene)
+// ƌ郂f̃bV𔻒肷
+void MyGame::CullModel(FrameSnapshot& snapshot)
 {
-	FbxNode* node = scene->GetRootNode();
+	snapshot.visibleModelMeshes.clear();
+	// wbhXł̓fǂݍ܂Ȃ
+	if (!m_model)
+		return;
 
-	if (node)
+	DirectX::SimpleMath::Matrix viewProjection = snapshot.view * m_projection;
+	FrustumCuller culler(&viewProjection._11);
+	for (const std::shared_ptr<DirectX::ModelMesh>& mesh : m_model->meshes)
 	{
-		for (int i = 0; i < node->GetChildCount(); i++)
+		const DirectX::BoundingBox& box = mesh->boundingBox;
+		MeshBounds bounds =
 		{
-			DisplayContent(scene, node->GetChild(i));
-		}
+			{ box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z },
+			{ box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z },
+		};
+		if (culler.IsVisible(FrustumCuller::TransformBounds(bounds, &snapshot.world._11)))
+			snapshot.visibleModelMeshes.push_back(mesh.get());
+	}
+}
+
+// ƌ郂f̃bV`悷
+void MyGame::DrawModel()
+{
+	// Model::DrawƓsȕ`悵Ă甼ȕ`悷
+	ID3D11DeviceContext* context = m_directX.GetContext().Get();
+	for (DirectX::ModelMesh* mesh : m_snapshot->visibleModelMeshes)
+	{
+		mesh->PrepareForRendering(context, *m_commonStates, false);
+		mesh->Draw(context, m_world, m_view, m_projection, false);
+	}
+	for (DirectX::ModelMesh* mesh : m_snapshot->visibleModelMeshes)
+	{
+		mesh->PrepareForRendering(context, *m_commonStates, true);
+		mesh->Draw(context, m_world, m_view, m_projection, true);
 	}
 }
 
@@ -217,27 +532,30 @@ void MyGame::Render(const DX::StepTimer& timer)
 	if (timer.GetFrameCount() == 0) 
 		return;
 
-	// TODO: _OR[hǉ
-	float time = float(timer.GetTotalSeconds());
-
-	// Zɑ΂ĉ]s𐶐
-	m_world = DirectX::SimpleMath::Matrix::CreateRotationZ(cosf(time) * 1.0f);
-
-	// r[s쐬
-	m_view = m_debugCamera->GetCameraMatrix();
+	// XibvVbg烏[hsƃr[s擾
+	m_world = m_snapshot->world;
+	m_view = m_snapshot->view;
 
 	// obt@NA
 	Clear();
 
+	// wbhXł͕`L[kobNGhŎs邾ɂ
+	if (IsHeadless())
+	{
+		DrawMeshes();
+		Present();
+		return;
+	}
+
 	// Obh̏`悷
 	m_gridFloor->Render(m_directX.GetContext().Get(), m_view, m_projection);
 
 	// XvCgob`Jn
 	GetSpriteBatch()->Begin(DirectX::SpriteSortMode_Deferred, m_commonStates->NonPremultiplied());
-	// FPS`悷
-	DrawFPS(timer);
+	// IꂽbV`悷
+	DrawPickedMesh();
 	// f`悷
-	m_model->Draw(m_directX.GetContext().Get(), *m_commonStates, m_world, m_view, m_projection);
+	DrawModel();
 
 	//for (auto& mesh : m_model->meshes)
 	//{
@@ -260,10 +578,16 @@ void MyGame::Render(const DX::StepTimer& timer)
 	// XvCgob`I
 	GetSpriteBatch()->End();
 
-	m_primitiveBatch->Begin();
-	DisplayContent(m_fbxmodel);
-	m_primitiveBatch->End();
+	// ϊς݂FBXbV`悷
+	DrawMeshes();
 
+	// fobO\`悷
+	m_debugDrawRenderer->Render(m_directX.GetContext().Get(), m_snapshot->debugDraw, m_view, m_projection,
+		GetSpriteBatch(), GetSpriteFont(), m_width, m_height);
+
+	// t[̓v`悷
+	m_overlay->Draw(m_directX.GetContext().Get(), GetFrameStatistics(), m_width, m_height);
+
 	// obNobt@\
 	Present();
 }
@@ -275,11 +599,19 @@ void MyGame::Finalize()
 	Game::Finalize();
 }
 
-// FPS`悷
-void MyGame::DrawFPS(const DX::StepTimer& timer)
+// IꂽbV`悷
+void MyGame::DrawPickedMesh()
 {
-	// FPS𐶐
-	wstring fpsString = L"fps = " + std::to_wstring((unsigned int)timer.GetFramesPerSecond());
-	// FPS`悷
-	GetSpriteFont()->DrawString(GetSpriteBatch(), fpsString.c_str(), DirectX::SimpleMath::Vector2(0, 0), DirectX::Colors::White);
+	if (m_snapshot->pickedMesh < 0)
+		return;
+
+	// OChɍLt[A[iɐ
+	const std::string& name = m_sceneGraph.GetName(m_meshNodes[m_snapshot->pickedMesh]);
+	const wchar_t prefix[] = L"picked = ";
+	const size_t prefixLength = sizeof(prefix) / sizeof(prefix[0]) - 1;
+	wchar_t* pickedString = GetFrameArena().AllocateArray<wchar_t>(prefixLength + name.size() + 1);
+	std::copy(prefix, prefix + prefixLength, pickedString);
+	std::copy(name.begin(), name.end(), pickedString + prefixLength);
+	pickedString[prefixLength + name.size()] = L'\0';
+	GetSpriteFont()->DrawString(GetSpriteBatch(), pickedString, DirectX::SimpleMath::Vector2(0, 32), DirectX::Colors::White);
 }
@@ -6,7 +6,38 @@
 #include "Game.h"
 #include "DebugCamera.h"
 #include "GridFloor.h"
-#include <fbxsdk.h>
+#include "MeshFile.h"
+#include "StaticMesh.h"
+#include "SceneGraph.h"
+#include "FrustumCuller.h"
+#include "BoundingVolumeHierarchy.h"
+#include "RenderQueue.h"
+#include "D3D11RenderBackend.h"
+#include "TaskGraph.h"
+#include "PerformanceOverlay.h"
+#include "NullRenderBackend.h"
+#include "DebugDrawRenderer.h"
+#include "InstancedEffect.h"
+#include "MeshLodSelector.h"
+
+// XVXbh`Xbh֓n1t[̕`
+struct FrameSnapshot
+{
+	// r[s
+	DirectX::SimpleMath::Matrix view;
+	// f̃[hs
+	DirectX::SimpleMath::Matrix world;
+	// IꂽbVԍ(ꍇ-1)
+	int32_t pickedMesh;
+	// \[gς݂̃bV̕`L[
+	RenderQueue renderQueue;
+	// `L[QƂ郁bṼ[hs(ʎqbV͕s|)
+	std::vector<SceneMatrix> meshWorlds;
+	// ƌf̃bV
+	std::vector<DirectX::ModelMesh*> visibleModelMeshes;
+	// XVɐς܂ꂽfobO\
+	DebugDrawList debugDraw;
+};
 
 class MyGame : public Game 
 {
@@ -19,16 +50,44 @@ public:
 	void CreateResources() override;
 	// Q[XV
 	void Update(const DX::StepTimer& timer) override;
-	void DisplayMesh(FbxNode* node);
-	void DisplayContent(FbxScene* scene, FbxNode* node);
-	void DisplayContent(FbxScene* scene);
 	// Q[`悷
 	void Render(const DX::StepTimer& timer) override;
 	// IȂ
 	void Finalize() override;
+	// `ɕKvȏԂXibvVbgɏ
+	void WriteSnapshot(int snapshot) override;
+	// `悷XibvVbg󂯎
+	void ReadSnapshot(int snapshot) override;
+	// wbhXŕ`R}h󂯎obNGh擾(wbhXłȂꍇnullptr)
+	const NullRenderBackend* GetNullRenderBackend() const
+	{
+		return m_nullBackend.get();
+	}
 
-	// FPS`悷
-	void DrawFPS(const DX::StepTimer& timer);
+	// IꂽbV`悷
+	void DrawPickedMesh();
+	// bṼ[hԂ̋E{bNXXV
+	void UpdateMeshBounds();
+	// XN[W΂CōłÕbVI
+	void PickMesh(int x, int y);
+	// XibvVbg^XNOt\z
+	void CreateSnapshotTasks();
+	// V[Ot̃[hsXVAύX΋E{[KwēK
+	void UpdateTransforms();
+	// E{[KwHĎƌ郁bV𔻒肷
+	void CullMeshes(const FrameSnapshot& snapshot);
+	// 郁bVXibvVbg̕`L[ɐς
+	void BuildRenderQueue(FrameSnapshot& snapshot);
+	// bṼCX^Xiqɕׂ
+	void CreateInstances();
+	// ƌ郂f̃bV𔻒肷
+	void CullModel(FrameSnapshot& snapshot);
+	// bV̋E{bNXfobO\ɐς
+	void DrawMeshBounds(const FrameSnapshot& snapshot);
+	// ϊς݂FBXbV`悷
+	void DrawMeshes();
+	// ƌ郂f̃bV`悷
+	void DrawModel();
 
 private:
 	// 
@@ -37,13 +96,13 @@ private:
 	int m_height;
 	// [hs
 	DirectX::SimpleMath::Matrix m_world;
+	// fZ̉]p(ŒXebvԂŕԂ)
+	InterpolatedState<float> m_modelAngle;
 	// r[s
 	DirectX::SimpleMath::Matrix m_view;
 	// ˉes
 	DirectX::SimpleMath::Matrix m_projection;
 
-	// v~eBuob`
-	std::unique_ptr<DirectX::PrimitiveBatch<DirectX::VertexPositionColor>> m_primitiveBatch;
 	// XvCgob`
 	DirectX::SpriteBatch* m_spriteBatch;
 	// GtFNgt@NgC^[tF[X(m_fxFactory)
@@ -63,8 +122,89 @@ private:
 	// RXe[g
 	std::unique_ptr<DirectX::CommonStates> m_states;
 
-	// FBXV[
-	FbxScene* m_fbxmodel;
+	// xCNς݃bVt@C
+	std::unique_ptr<MeshFile> m_meshFile;
+	// GPUɏ풓bV
+	std::vector<std::unique_ptr<StaticMesh>> m_staticMeshes;
+	// bVzuV[Ot
+	SceneGraph m_sceneGraph;
+	// bVƂ̋E{bNX
+	std::vector<MeshBounds> m_meshBounds;
+	// bVzum[hԍ
+	std::vector<int32_t> m_meshNodes;
+	// bVƂ̃[hԂ̋E{bNX
+	std::vector<MeshBounds> m_meshWorldBounds;
+	// bVƂ̉茋
+	std::vector<uint8_t> m_meshVisible;
+	// bV̋E{[Kw
+	BoundingVolumeHierarchy m_bvh;
+	// IꂽbVԍ(ꍇ-1)
+	int32_t m_pickedMesh;
+	// bV`p̃GtFNg
+	std::unique_ptr<DirectX::BasicEffect> m_meshEffect;
+	// bV`p̃CvbgCAEg
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> m_meshInputLayout;
+	// XVƕ`Ŏ󂯓nXibvVbg
+	FrameSnapshot m_snapshots[FramePipeline::SNAPSHOT_COUNT];
+	// `撆̃XibvVbg
+	const FrameSnapshot* m_snapshot;
+	// ݒ̃XibvVbg
+	FrameSnapshot* m_writingSnapshot;
+	// XibvVbg^XNOt(ϊJO`L[Af̃JO͕sĎs)
+	TaskGraph m_snapshotTasks;
+	// `L[쐬`R}h
+	RenderCommandList m_renderCommands;
+	// `R}hsobNGh
+	std::unique_ptr<D3D11RenderBackend> m_renderBackend;
+	// wbhXŕ`R}h𐔂obNGh
+	std::unique_ptr<NullRenderBackend> m_nullBackend;
+	// bV`p̃VF[_ԍ
+	uint32_t m_meshShader;
+	// bV`p̃}eAԍ
+	uint32_t m_meshMaterial;
+	// t[̓v\I[o[C
+	std::unique_ptr<PerformanceOverlay> m_overlay;
+	// t[̓vɓo^`R[ƎOp`̃JE^ԍ
+	int m_drawCallCounter;
+	int m_triangleCounter;
+	// fobO\`悷郌_
+	std::unique_ptr<DebugDrawRenderer> m_debugDrawRenderer;
+	// ׂẴbV̋E{bNX\邩
+	bool m_showBounds;
+	// CX^X`p̃GtFNg
+	std::unique_ptr<InstancedEffect> m_instancedEffect;
+	// CX^X`p̃CvbgCAEg
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> m_instancedInputLayout;
+	// CX^X`p̃VF[_ԍ
+	uint32_t m_instancedShader;
+	// ׂĕ\郁bṼCX^X̃[hsƐF(͕ύXȂ)
+	std::vector<DirectX::SimpleMath::Matrix> m_instanceWorlds;
+	std::vector<DirectX::SimpleMath::Vector4> m_instanceColors;
+	// bṼCX^Xׂĕ\邩
+	bool m_showInstances;
+	// bVƂ̏ڍדx̍ŏ̒ʂԍƏڍדx̐(ڍדx̃bVԍ͌̃bV+ʂԍ)
+	std::vector<uint32_t> m_meshLodFirst;
+	std::vector<uint32_t> m_meshLodCounts;
+	// ڍדx̒ʂԍƂ̌덷
+	std::vector<float> m_meshLodErrors;
+	// bVƂɑÕt[őI񂾏ڍדx
+	std::vector<uint32_t> m_meshLods;
+	// ʏ̌덷ڍדxIԃZN^
+	MeshLodSelector m_lodSelector;
+	// ڍדx؂ւ邩
+	bool m_useLods;
+	// bV̒_ʎqĂ邩
+	std::vector<uint8_t> m_meshQuantized;
+	// ʎqbV̈ʒuE{bNXɖ߂s
+	std::vector<SceneMatrix> m_meshDecodes;
+	// ʎqbV`p̃CvbgCAEg
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> m_quantizedMeshInputLayout;
+	// ʎqbṼCX^X`p̃CvbgCAEg
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> m_quantizedInstancedInputLayout;
+	// ʎqbV`p̃VF[_ԍ
+	uint32_t m_quantizedMeshShader;
+	// ʎqbṼCX^X`p̃VF[_ԍ
+	uint32_t m_quantizedInstancedShader;
 };
 
 #endif	// MYGAME_DEFINED
\ No newline at end of file
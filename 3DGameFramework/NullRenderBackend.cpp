@@ -0,0 +1,118 @@
+﻿#include "NullRenderBackend.h"
+#include <stdexcept>
+#include <string.h>
+
+// コンストラクタ
+NullRenderBackend::NullRenderBackend()
+	: m_shaderCount(0), m_materialCount(0), m_shaderSet(false), m_mesh(nullptr), m_statistics{}, m_drawCalls(0), m_triangles(0), m_checksum(14695981039346656037ull)
+{
+}
+
+// シェーダを登録して番号を返す
+uint32_t NullRenderBackend::AddShader()
+{
+	return m_shaderCount++;
+}
+
+// マテリアルを登録して番号を返す
+uint32_t NullRenderBackend::AddMaterial()
+{
+	return m_materialCount++;
+}
+
+// メッシュを登録して番号を返す
+uint32_t NullRenderBackend::AddMesh(uint32_t drawCount, uint32_t triangleCount)
+{
+	m_meshes.push_back({ drawCount, triangleCount });
+	return uint32_t(m_meshes.size() - 1);
+}
+
+// ビュー行列と射影行列を設定する
+void NullRenderBackend::SetViewProjection(const float* view, const float* projection)
+{
+	Hash(view, sizeof(float) * 16);
+	Hash(projection, sizeof(float) * 16);
+}
+
+// パスを開始する
+void NullRenderBackend::BeginPass(uint32_t pass)
+{
+	Hash(&pass, sizeof(pass));
+	// D3D11RenderBackendと同じく、パスの間で設定中の状態を忘れる
+	m_shaderSet = false;
+	m_mesh = nullptr;
+	m_statistics.passChanges++;
+}
+
+// シェーダを設定する
+void NullRenderBackend::SetShader(uint32_t shader)
+{
+	if (shader >= m_shaderCount)
+		throw std::out_of_range("NullRenderBackend: shader out of range");
+	Hash(&shader, sizeof(shader));
+	m_shaderSet = true;
+	m_statistics.shaderChanges++;
+}
+
+// マテリアルを設定する
+void NullRenderBackend::SetMaterial(uint32_t material)
+{
+	if (material >= m_materialCount)
+		throw std::out_of_range("NullRenderBackend: material out of range");
+	Hash(&material, sizeof(material));
+	m_statistics.materialChanges++;
+}
+
+// メッシュを設定する
+void NullRenderBackend::SetMesh(uint32_t mesh)
+{
+	m_mesh = &m_meshes.at(mesh);
+	Hash(&mesh, sizeof(mesh));
+	m_statistics.meshChanges++;
+}
+
+// 設定された状態で描画する
+void NullRenderBackend::Draw(const float* world)
+{
+	if (!m_shaderSet || m_mesh == nullptr)
+		throw std::runtime_error("NullRenderBackend: draw without shader or mesh");
+	Hash(world, sizeof(float) * 16);
+	m_statistics.draws++;
+	m_drawCalls += m_mesh->drawCount;
+	m_triangles += m_mesh->triangleCount;
+}
+
+// 設定された状態でインスタンスの数だけ描画する
+void NullRenderBackend::DrawInstanced(const InstanceData* instances, uint32_t count)
+{
+	if (!m_shaderSet || m_mesh == nullptr)
+		throw std::runtime_error("NullRenderBackend: draw without shader or mesh");
+	Hash(instances, sizeof(InstanceData) * count);
+	m_statistics.draws++;
+	m_statistics.instances += count;
+	// 描画範囲ごとに1回の呼び出しで全インスタンスを描く
+	m_drawCalls += m_mesh->drawCount;
+	m_triangles += uint64_t(m_mesh->triangleCount) * count;
+}
+
+// 状態の切り替え数、描画呼び出し数、三角形の数を0に戻す
+void NullRenderBackend::ResetStatistics()
+{
+	m_statistics = {};
+	m_drawCalls = 0;
+	m_triangles = 0;
+}
+
+// データをチェックサムに加える
+void NullRenderBackend::Hash(const void* data, size_t size)
+{
+	// 描画のたびに呼ばれるので、バイトではなく32ビット単位で混ぜる(サイズは4の倍数)
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i + sizeof(uint32_t) <= size; i += sizeof(uint32_t))
+	{
+		uint32_t word;
+		memcpy(&word, bytes + i, sizeof(word));
+		m_checksum ^= word;
+		m_checksum *= 1099511628211ull;
+	}
+}
@@ -0,0 +1,112 @@
+﻿#pragma once
+#ifndef NULLRENDERBACKEND_DEFINED
+#define NULLRENDERBACKEND_DEFINED
+
+#include <vector>
+#include "RenderQueue.h"
+
+// GPUを使わず、登録されたリソースと受け取ったコマンドを数えるだけのバックエンド(ヘッドレス動作で使用する)
+// 番号の範囲はD3D11RenderBackendと同じく確認するので、GPUの無い環境でも描画キューの誤りを検出できる
+class NullRenderBackend : public RenderBackend
+{
+public:
+	// コンストラクタ
+	NullRenderBackend();
+
+	// シェーダを登録して番号を返す
+	uint32_t AddShader();
+	// マテリアルを登録して番号を返す
+	uint32_t AddMaterial();
+	// メッシュを描画範囲の数と三角形の数で登録して番号を返す
+	uint32_t AddMesh(uint32_t drawCount, uint32_t triangleCount);
+
+	// ビュー行列と射影行列を設定する(描画はしないが、チェックサムに含める)
+	void SetViewProjection(const float* view, const float* projection);
+	// パスを開始する
+	void BeginPass(uint32_t pass) override;
+	// シェーダを設定する
+	void SetShader(uint32_t shader) override;
+	// マテリアルを設定する
+	void SetMaterial(uint32_t material) override;
+	// メッシュを設定する
+	void SetMesh(uint32_t mesh) override;
+	// 設定された状態で描画する
+	void Draw(const float* world) override;
+	// 設定された状態でインスタンスの数だけ描画する
+	void DrawInstanced(const InstanceData* instances, uint32_t count) override;
+
+	// 状態の切り替え数、描画呼び出し数、三角形の数を0に戻す
+	void ResetStatistics();
+	// ResetStatisticsからの状態の切り替え数と描画数を取得する
+	const RenderStatistics& GetStatistics() const
+	{
+		return m_statistics;
+	}
+	// ResetStatisticsからの描画呼び出し数を取得する(メッシュの描画範囲ごとに数える)
+	uint32_t GetDrawCalls() const
+	{
+		return m_drawCalls;
+	}
+	// ResetStatisticsからの三角形の数を取得する
+	uint64_t GetTriangles() const
+	{
+		return m_triangles;
+	}
+	// これまでに受け取ったコマンドと行列のチェックサムを取得する(ResetStatisticsでは戻らない)
+	// 同じ入力を再生したヘッドレス動作で、実行ごとに同じ描画になっているかどうかの比較に使う
+	uint64_t GetChecksum() const
+	{
+		return m_checksum;
+	}
+	// 登録されたシェーダの数を取得する
+	uint32_t GetShaderCount() const
+	{
+		return m_shaderCount;
+	}
+	// 登録されたマテリアルの数を取得する
+	uint32_t GetMaterialCount() const
+	{
+		return m_materialCount;
+	}
+	// 登録されたメッシュの数を取得する
+	uint32_t GetMeshCount() const
+	{
+		return uint32_t(m_meshes.size());
+	}
+
+private:
+	// データをチェックサムに加える(サイズは4の倍数)
+	void Hash(const void* data, size_t size);
+
+private:
+	// メッシュ
+	struct Mesh
+	{
+		// 描画範囲の数
+		uint32_t drawCount;
+		// 三角形の数
+		uint32_t triangleCount;
+	};
+
+private:
+	// 登録されたシェーダの数
+	uint32_t m_shaderCount;
+	// 登録されたマテリアルの数
+	uint32_t m_materialCount;
+	// 登録されたメッシュ
+	std::vector<Mesh> m_meshes;
+	// 設定中のシェーダがあるかどうか
+	bool m_shaderSet;
+	// 設定中のメッシュ
+	const Mesh* m_mesh;
+	// 状態の切り替え数と描画数
+	RenderStatistics m_statistics;
+	// 描画呼び出し数
+	uint32_t m_drawCalls;
+	// 三角形の数
+	uint64_t m_triangles;
+	// 受け取ったコマンドと行列のチェックサム(32ビット単位のFNV-1a)
+	uint64_t m_checksum;
+};
+
+#endif	// NULLRENDERBACKEND_DEFINED
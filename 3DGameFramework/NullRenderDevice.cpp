@@ -0,0 +1,37 @@
+﻿#include "NullRenderDevice.h"
+#include <stdexcept>
+
+// コンストラクタ
+NullRenderDevice::NullRenderDevice()
+	: m_width(0), m_height(0), m_statistics{}
+{
+}
+
+// デバイスを生成する
+void NullRenderDevice::CreateDevice()
+{
+	m_statistics.devices++;
+}
+
+// 出力サイズを設定する
+void NullRenderDevice::Resize(int width, int height)
+{
+	if (m_statistics.devices == 0)
+		throw std::runtime_error("NullRenderDevice: Resize before CreateDevice");
+
+	m_width = width;
+	m_height = height;
+	m_statistics.resizes++;
+}
+
+// 出力をクリアする
+void NullRenderDevice::Clear(const float[4])
+{
+	m_statistics.clears++;
+}
+
+// 出力を表示する
+void NullRenderDevice::Present(bool)
+{
+	m_statistics.presents++;
+}
@@ -0,0 +1,62 @@
+﻿#pragma once
+#ifndef NULLRENDERDEVICE_DEFINED
+#define NULLRENDERDEVICE_DEFINED
+
+#include <stdint.h>
+#include "RenderDevice.h"
+
+// ヌルデバイスが受け取った呼び出しの数
+struct NullDeviceStatistics
+{
+	// デバイスの生成数
+	uint64_t devices;
+	// 出力サイズの変更数
+	uint64_t resizes;
+	// クリア数
+	uint64_t clears;
+	// 表示数
+	uint64_t presents;
+};
+
+// GPUもウィンドウも使わず、呼び出しを数えるだけの描画デバイス(ヘッドレス動作で使用する)
+class NullRenderDevice : public RenderDevice
+{
+public:
+	// コンストラクタ
+	NullRenderDevice();
+
+	// デバイスを生成する
+	void CreateDevice() override;
+	// 出力サイズを設定する
+	void Resize(int width, int height) override;
+	// 出力をクリアする
+	void Clear(const float color[4]) override;
+	// 出力を表示する
+	void Present(bool vsync) override;
+
+	// 出力幅を取得する
+	int GetWidth() const
+	{
+		return m_width;
+	}
+	// 出力高を取得する
+	int GetHeight() const
+	{
+		return m_height;
+	}
+	// 呼び出しの数を取得する
+	const NullDeviceStatistics& GetStatistics() const
+	{
+		return m_statistics;
+	}
+
+private:
+	// 出力幅
+	int m_width;
+	// 出力高
+	int m_height;
+	// 呼び出しの数
+	NullDeviceStatistics m_statistics;
+};
+
+#endif	// NULLRENDERDEVICE_DEFINED
@@ -0,0 +1,185 @@
+﻿#include "PerformanceOverlay.h"
+#include <algorithm>
+#include <stdio.h>
+
+using namespace DirectX;
+
+// 文字の拡大率
+const float PerformanceOverlay::TEXT_SCALE = 0.5f;
+
+// コンストラクタ
+PerformanceOverlay::PerformanceOverlay(ID3D11Device* device, ID3D11DeviceContext* context, CommonStates* states,
+	SpriteBatch* spriteBatch, SpriteFont* spriteFont)
+	: m_states(states), m_spriteBatch(spriteBatch), m_lineHeight(spriteFont->GetLineSpacing() * TEXT_SCALE),
+	m_x(float(MARGIN)), m_y(float(MARGIN)), m_targetFrameTime(1.0 / 60.0), m_labelStages(-1), m_labelCounters(-1)
+{
+	// グラフ描画用のエフェクトとインプットレイアウトを生成する
+	m_effect = std::make_unique<BasicEffect>(device);
+	m_effect->SetVertexColorEnabled(true);
+	m_primitiveBatch = std::make_unique<PrimitiveBatch<VertexPositionColor>>(context);
+	void const* shaderByteCode;
+	size_t byteCodeLength;
+	m_effect->GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
+	DX::ThrowIfFailed(device->CreateInputLayout(VertexPositionColor::InputElements, VertexPositionColor::InputElementCount,
+		shaderByteCode, byteCodeLength, m_inputLayout.ReleaseAndGetAddressOf()));
+
+	// ASCII文字のグリフを引いておき、毎フレームの検索を省く
+	spriteFont->GetSpriteSheet(m_fontTexture.ReleaseAndGetAddressOf());
+	for (wchar_t character = 0; character < 128; character++)
+	{
+		m_glyphs[character] = character >= L' ' && spriteFont->ContainsCharacter(character) ? spriteFont->FindGlyph(character) : nullptr;
+	}
+	m_valueQuads.reserve(VALUE_LENGTH * (FIXED_ROWS + FrameStatistics::MAX_STAGES + FrameStatistics::MAX_COUNTERS));
+}
+
+// 描画する
+void PerformanceOverlay::Draw(ID3D11DeviceContext* context, const FrameStatistics& statistics, int width, int height)
+{
+	if (m_labelStages != statistics.GetStageCount() || m_labelCounters != statistics.GetCounterCount())
+		LayoutLabels(statistics);
+	LayoutValues(statistics);
+
+	DrawGraph(context, statistics, width, height);
+
+	m_spriteBatch->Begin(SpriteSortMode_Deferred, m_states->NonPremultiplied());
+	DrawGlyphs(m_labelQuads, Colors::LightGray);
+	DrawGlyphs(m_valueQuads, Colors::White);
+	m_spriteBatch->End();
+}
+
+// 文字列のグリフを並べる(SpriteFont::DrawStringと同じ規則で並べる)
+void PerformanceOverlay::LayoutText(const char* text, float x, float y, std::vector<GlyphQuad>& quads) const
+{
+	float cursor = 0.0f;
+	for (const char* p = text; *p; p++)
+	{
+		unsigned char character = static_cast<unsigned char>(*p);
+		const SpriteFont::Glyph* glyph = character < 128 ? m_glyphs[character] : nullptr;
+		if (glyph == nullptr)
+			continue;
+
+		cursor = std::max(cursor + glyph->XOffset, 0.0f);
+		if (character != ' ')
+			quads.push_back({ glyph->Subrect, XMFLOAT2(x + cursor * TEXT_SCALE, y + glyph->YOffset * TEXT_SCALE) });
+		cursor += float(glyph->Subrect.right - glyph->Subrect.left) + glyph->XAdvance;
+	}
+}
+
+// 行の位置を取得する
+float PerformanceOverlay::GetRowY(int row) const
+{
+	return m_y + GRAPH_HEIGHT + MARGIN + row * m_lineHeight;
+}
+
+// 見出しのグリフを並べる
+void PerformanceOverlay::LayoutLabels(const FrameStatistics& statistics)
+{
+	static const char* const FIXED_LABELS[FIXED_ROWS] = { "fps", "frame avg", "min / max", "p50/p95/p99", "spikes" };
+
+	m_labelQuads.clear();
+	int row = 0;
+	for (const char* label : FIXED_LABELS)
+	{
+		LayoutText(label, m_x, GetRowY(row++), m_labelQuads);
+	}
+	for (int stage = 0; stage < statistics.GetStageCount(); stage++)
+	{
+		LayoutText(statistics.GetStageName(stage), m_x, GetRowY(row++), m_labelQuads);
+	}
+	for (int counter = 0; counter < statistics.GetCounterCount(); counter++)
+	{
+		LayoutText(statistics.GetCounterName(counter), m_x, GetRowY(row++), m_labelQuads);
+	}
+	m_labelStages = statistics.GetStageCount();
+	m_labelCounters = statistics.GetCounterCount();
+}
+
+// 値のグリフを並べる
+void PerformanceOverlay::LayoutValues(const FrameStatistics& statistics)
+{
+	m_valueQuads.clear();
+	const float x = m_x + LABEL_WIDTH;
+	double average = statistics.GetAverage();
+	char text[VALUE_LENGTH];
+	int row = 0;
+
+	snprintf(text, sizeof(text), "%.1f", average > 0.0 ? 1.0 / average : 0.0);
+	LayoutText(text, x, GetRowY(row++), m_valueQuads);
+	snprintf(text, sizeof(text), "%.2f ms", average * 1000.0);
+	LayoutText(text, x, GetRowY(row++), m_valueQuads);
+	snprintf(text, sizeof(text), "%.2f / %.2f ms", statistics.GetMinimum() * 1000.0, statistics.GetMaximum() * 1000.0);
+	LayoutText(text, x, GetRowY(row++), m_valueQuads);
+	snprintf(text, sizeof(text), "%.1f / %.1f / %.1f ms", statistics.GetPercentile(50.0) * 1000.0,
+		statistics.GetPercentile(95.0) * 1000.0, statistics.GetPercentile(99.0) * 1000.0);
+	LayoutText(text, x, GetRowY(row++), m_valueQuads);
+	snprintf(text, sizeof(text), "%u over %.1f ms", unsigned(statistics.CountFramesOver(m_targetFrameTime * 2.0)), m_targetFrameTime * 2000.0);
+	LayoutText(text, x, GetRowY(row++), m_valueQuads);
+
+	for (int stage = 0; stage < statistics.GetStageCount(); stage++)
+	{
+		snprintf(text, sizeof(text), "%.2f ms (max %.2f)", statistics.GetStageAverage(stage) * 1000.0, statistics.GetStageMaximum(stage) * 1000.0);
+		LayoutText(text, x, GetRowY(row++), m_valueQuads);
+	}
+	for (int counter = 0; counter < statistics.GetCounterCount(); counter++)
+	{
+		snprintf(text, sizeof(text), "%llu", static_cast<unsigned long long>(statistics.GetCounter(counter)));
+		LayoutText(text, x, GetRowY(row++), m_valueQuads);
+	}
+}
+
+// 背景とグラフを描画する
+void PerformanceOverlay::DrawGraph(ID3D11DeviceContext* context, const FrameStatistics& statistics, int width, int height)
+{
+	// 画面のピクセル座標で描画する
+	m_effect->SetWorld(SimpleMath::Matrix::Identity);
+	m_effect->SetView(SimpleMath::Matrix::Identity);
+	m_effect->SetProjection(SimpleMath::Matrix::CreateOrthographicOffCenter(0.0f, float(width), float(height), 0.0f, 0.0f, 1.0f));
+	m_effect->Apply(context);
+	context->OMSetBlendState(m_states->AlphaBlend(), nullptr, 0xFFFFFFFF);
+	context->OMSetDepthStencilState(m_states->DepthNone(), 0);
+	context->RSSetState(m_states->CullNone());
+	context->IASetInputLayout(m_inputLayout.Get());
+
+	// 目標の3倍までを表示し、目標以内は緑、2倍以内は黄、それ以上は赤で塗る
+	const float scale = float(GRAPH_HEIGHT / (m_targetFrameTime * 3.0));
+	const float left = m_x;
+	const float bottom = m_y + GRAPH_HEIGHT;
+	int rows = FIXED_ROWS + statistics.GetStageCount() + statistics.GetCounterCount();
+	float panelBottom = GetRowY(rows) + MARGIN;
+	auto quad = [&](float x0, float y0, float x1, float y1, FXMVECTOR color)
+	{
+		m_primitiveBatch->DrawQuad(VertexPositionColor(XMFLOAT3(x0, y0, 0.0f), color), VertexPositionColor(XMFLOAT3(x1, y0, 0.0f), color),
+			VertexPositionColor(XMFLOAT3(x1, y1, 0.0f), color), VertexPositionColor(XMFLOAT3(x0, y1, 0.0f), color));
+	};
+
+	m_primitiveBatch->Begin();
+	quad(left - MARGIN, m_y - MARGIN, left + PANEL_WIDTH + MARGIN, panelBottom, XMVectorSet(0.0f, 0.0f, 0.0f, 0.6f));
+
+	size_t count = std::min(statistics.GetFrameCount(), size_t(GRAPH_WIDTH));
+	for (size_t age = 0; age < count; age++)
+	{
+		double frameTime = statistics.GetFrameTime(age);
+		float x = left + float(GRAPH_WIDTH - 1 - age);
+		float top = bottom - std::min(float(frameTime) * scale, float(GRAPH_HEIGHT));
+		XMVECTOR color = frameTime <= m_targetFrameTime ? Colors::LimeGreen : frameTime <= m_targetFrameTime * 2.0 ? Colors::Yellow : Colors::Red;
+		quad(x, top, x + 1.0f, bottom, color);
+	}
+
+	// 目標と2倍の位置に線を引く
+	for (int multiple = 1; multiple <= 2; multiple++)
+	{
+		float y = bottom - float(m_targetFrameTime * multiple) * scale;
+		m_primitiveBatch->DrawLine(VertexPositionColor(XMFLOAT3(left, y, 0.0f), Colors::White),
+			VertexPositionColor(XMFLOAT3(left + GRAPH_WIDTH, y, 0.0f), Colors::White));
+	}
+	m_primitiveBatch->End();
+}
+
+// 並べたグリフを描画する
+void PerformanceOverlay::DrawGlyphs(const std::vector<GlyphQuad>& quads, FXMVECTOR color)
+{
+	for (const GlyphQuad& quad : quads)
+	{
+		m_spriteBatch->Draw(m_fontTexture.Get(), quad.position, &quad.source, color, 0.0f, XMFLOAT2(0.0f, 0.0f), TEXT_SCALE);
+	}
+}
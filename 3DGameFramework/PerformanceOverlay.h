@@ -0,0 +1,104 @@
+﻿#pragma once
+#ifndef PERFORMANCEOVERLAY_DEFINED
+#define PERFORMANCEOVERLAY_DEFINED
+
+#include <vector>
+#include "FrameStatistics.h"
+
+// フレーム時間のグラフと統計を画面に重ねて描画する
+// グラフはPrimitiveBatch、文字はSpriteBatchでそれぞれ1回にまとめて描画する
+// 文字はフォントのグリフを直接並べ、変わらない見出しの配置は登録された処理段階とカウンタが変わったときだけ計算する
+class PerformanceOverlay
+{
+public:
+	// グラフに表示するフレーム数(1フレームを1ピクセルで表示する)
+	static const int GRAPH_WIDTH = 240;
+	// グラフの高さ(ピクセル)
+	static const int GRAPH_HEIGHT = 80;
+	// 見出しから値までの幅(ピクセル)
+	static const int LABEL_WIDTH = 100;
+	// 背景の幅(ピクセル)
+	static const int PANEL_WIDTH = 260;
+	// 余白(ピクセル)
+	static const int MARGIN = 4;
+	// 値の文字列の最大長
+	static const int VALUE_LENGTH = 48;
+
+	// コンストラクタ
+	PerformanceOverlay(ID3D11Device* device, ID3D11DeviceContext* context, DirectX::CommonStates* states,
+		DirectX::SpriteBatch* spriteBatch, DirectX::SpriteFont* spriteFont);
+
+	// 左上の位置を設定する
+	void SetPosition(float x, float y)
+	{
+		m_x = x;
+		m_y = y;
+	}
+	// 目標のフレーム時間(秒)を設定する(グラフの目盛りと色分けに使う)
+	void SetTargetFrameTime(double seconds)
+	{
+		m_targetFrameTime = seconds;
+	}
+	// 描画する
+	void Draw(ID3D11DeviceContext* context, const FrameStatistics& statistics, int width, int height);
+
+private:
+	// 並べたグリフ
+	struct GlyphQuad
+	{
+		// フォントのテクスチャ上の矩形
+		RECT source;
+		// 画面上の位置
+		DirectX::XMFLOAT2 position;
+	};
+
+	// 文字列のグリフを並べる
+	void LayoutText(const char* text, float x, float y, std::vector<GlyphQuad>& quads) const;
+	// 見出しのグリフを並べる
+	void LayoutLabels(const FrameStatistics& statistics);
+	// 値のグリフを並べる
+	void LayoutValues(const FrameStatistics& statistics);
+	// 行の位置を取得する
+	float GetRowY(int row) const;
+	// 背景とグラフを描画する
+	void DrawGraph(ID3D11DeviceContext* context, const FrameStatistics& statistics, int width, int height);
+	// 並べたグリフを描画する
+	void DrawGlyphs(const std::vector<GlyphQuad>& quads, DirectX::FXMVECTOR color);
+
+private:
+	// 文字の拡大率
+	static const float TEXT_SCALE;
+	// 固定の行数(フレーム時間の統計)
+	static const int FIXED_ROWS = 5;
+
+	// エフェクト
+	std::unique_ptr<DirectX::BasicEffect> m_effect;
+	// プリミティブバッチ
+	std::unique_ptr<DirectX::PrimitiveBatch<DirectX::VertexPositionColor>> m_primitiveBatch;
+	// インプットレイアウト
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> m_inputLayout;
+	// コモンステート
+	DirectX::CommonStates* m_states;
+	// スプライトバッチ
+	DirectX::SpriteBatch* m_spriteBatch;
+	// フォントのテクスチャ
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_fontTexture;
+	// ASCII文字のグリフ(フォントに無い文字はnullptr)
+	const DirectX::SpriteFont::Glyph* m_glyphs[128];
+	// 行の高さ
+	float m_lineHeight;
+	// 左上の位置
+	float m_x;
+	float m_y;
+	// 目標のフレーム時間
+	double m_targetFrameTime;
+	// 見出しのグリフ
+	std::vector<GlyphQuad> m_labelQuads;
+	// 見出しを並べたときの処理段階とカウンタの数
+	int m_labelStages;
+	int m_labelCounters;
+	// 値のグリフ(毎フレーム並べ直すが、容量は保持して再確保しない)
+	std::vector<GlyphQuad> m_valueQuads;
+};
+
+#endif	// PERFORMANCEOVERLAY_DEFINED
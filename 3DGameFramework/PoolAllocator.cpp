@@ -0,0 +1,65 @@
+﻿#include "PoolAllocator.h"
+#include <algorithm>
+
+// コンストラクタ
+FixedPool::FixedPool(size_t blockSize, size_t blocksPerChunk)
+	: m_blocksPerChunk(std::max<size_t>(blocksPerChunk, 1)), m_free(nullptr), m_remoteFree(nullptr)
+{
+	// 空きリストのポインタを格納でき、どのブロックも最大アラインメントにそろうようにする
+	const size_t alignment = alignof(std::max_align_t);
+	blockSize = std::max(blockSize, sizeof(FreeBlock));
+	m_blockSize = (blockSize + alignment - 1) / alignment * alignment;
+}
+
+// ブロックを確保する
+void* FixedPool::Allocate()
+{
+	if (m_free == nullptr)
+	{
+		// 他のスレッドから返却されたブロックをまとめて引き取り、それも無ければチャンクを追加する
+		m_free = m_remoteFree.exchange(nullptr, std::memory_order_acquire);
+		if (m_free == nullptr)
+			Grow();
+	}
+
+	FreeBlock* block = m_free;
+	m_free = block->next;
+	return block;
+}
+
+// ブロックを解放する
+void FixedPool::Free(void* block)
+{
+	FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+	freeBlock->next = m_free;
+	m_free = freeBlock;
+}
+
+// ブロックを解放する(任意のスレッド)
+void FixedPool::FreeRemote(void* block)
+{
+	FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+	FreeBlock* head = m_remoteFree.load(std::memory_order_relaxed);
+	do
+	{
+		freeBlock->next = head;
+	} while (!m_remoteFree.compare_exchange_weak(head, freeBlock, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// 少なくともcount個のブロックを確保しておく
+void FixedPool::Reserve(size_t count)
+{
+	while (m_chunks.size() * m_blocksPerChunk < count)
+		Grow();
+}
+
+// チャンクを追加して空きリストにつなぐ
+void FixedPool::Grow()
+{
+	m_chunks.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[m_blockSize * m_blocksPerChunk]));
+	unsigned char* chunk = m_chunks.back().get();
+	for (size_t i = m_blocksPerChunk; i-- > 0;)
+	{
+		Free(chunk + i * m_blockSize);
+	}
+}
@@ -0,0 +1,118 @@
+﻿#pragma once
+#ifndef POOLALLOCATOR_DEFINED
+#define POOLALLOCATOR_DEFINED
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "NonCopyable.h"
+
+// 固定サイズのブロックを空きリストで再利用するプール
+// 確保と通常の解放は所有スレッドだけがおこなう。他のスレッドはFreeRemoteでロックなしに返却でき、
+// 所有スレッドは空きが無くなったときに返却されたブロックをまとめて引き取る
+class FixedPool : public NonCopyable
+{
+public:
+	// 既定の1チャンクあたりのブロック数
+	static const size_t DEFAULT_BLOCKS_PER_CHUNK = 256;
+
+	// コンストラクタ
+	explicit FixedPool(size_t blockSize, size_t blocksPerChunk = DEFAULT_BLOCKS_PER_CHUNK);
+
+	// ブロックを確保する(所有スレッドのみ)
+	void* Allocate();
+	// ブロックを解放する(所有スレッドのみ)
+	void Free(void* block);
+	// ブロックを解放する(任意のスレッド)
+	void FreeRemote(void* block);
+	// 少なくともcount個のブロックを確保しておく(所有スレッドが使い始める前に呼び出す)
+	void Reserve(size_t count);
+
+	// ブロックサイズを取得する
+	size_t GetBlockSize() const
+	{
+		return m_blockSize;
+	}
+	// 確保したチャンク数を取得する
+	size_t GetChunkCount() const
+	{
+		return m_chunks.size();
+	}
+
+private:
+	// 空きブロック
+	struct FreeBlock
+	{
+		// 次の空きブロック
+		FreeBlock* next;
+	};
+
+	// チャンクを追加して空きリストにつなぐ
+	void Grow();
+
+private:
+	// ブロックサイズ
+	size_t m_blockSize;
+	// 1チャンクあたりのブロック数
+	size_t m_blocksPerChunk;
+	// 所有スレッドの空きリスト
+	FreeBlock* m_free;
+	// 他のスレッドから返却された空きリスト(積むだけで、取り出しは所有スレッドがまとめておこなうのでABA問題は起きない)
+	std::atomic<FreeBlock*> m_remoteFree;
+	// チャンク
+	std::vector<std::unique_ptr<unsigned char[]>> m_chunks;
+};
+
+// 同じ型のオブジェクトを固定サイズのプールから生成・破棄する
+template<typename T>
+class ObjectPool : public NonCopyable
+{
+public:
+	// コンストラクタ
+	explicit ObjectPool(size_t blocksPerChunk = FixedPool::DEFAULT_BLOCKS_PER_CHUNK)
+		: m_pool(sizeof(T), blocksPerChunk)
+	{
+		static_assert(alignof(T) <= alignof(std::max_align_t), "ObjectPool does not support over-aligned types");
+	}
+
+	// オブジェクトを生成する(所有スレッドのみ)
+	template<typename... Args>
+	T* Create(Args&&... args)
+	{
+		void* block = m_pool.Allocate();
+		try
+		{
+			return new (block) T(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			m_pool.Free(block);
+			throw;
+		}
+	}
+	// オブジェクトを破棄する(所有スレッドのみ)
+	void Destroy(T* object)
+	{
+		object->~T();
+		m_pool.Free(object);
+	}
+	// オブジェクトを破棄する(任意のスレッド)
+	void DestroyRemote(T* object)
+	{
+		object->~T();
+		m_pool.FreeRemote(object);
+	}
+	// 少なくともcount個のオブジェクトの領域を確保しておく(所有スレッドが使い始める前に呼び出す)
+	void Reserve(size_t count)
+	{
+		m_pool.Reserve(count);
+	}
+
+private:
+	// プール
+	FixedPool m_pool;
+};
+
+#endif	// POOLALLOCATOR_DEFINED
@@ -0,0 +1,234 @@
+﻿#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <math.h>
+#include <stdexcept>
+
+namespace
+{
+	// 現在のスレッドの名前(リングバッファを作成するときに使う)
+	thread_local std::string t_threadName;
+
+	// 文字列をJSONの文字列として書き出す
+	void WriteJsonString(std::ostream& stream, const char* text)
+	{
+		stream << '"';
+		for (const char* p = text; *p; p++)
+		{
+			unsigned char c = static_cast<unsigned char>(*p);
+			if (c == '"' || c == '\\')
+				stream << '\\' << char(c);
+			else if (c < 0x20)
+				stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << unsigned(c) << std::dec << std::setfill(' ');
+			else
+				stream << char(c);
+		}
+		stream << '"';
+	}
+}
+
+std::atomic<bool> Profiler::s_enabled(false);
+thread_local Profiler::ThreadBuffer* Profiler::s_threadBuffer = nullptr;
+
+// コンストラクタ
+FrameTimeHistogram::FrameTimeHistogram()
+{
+	Clear();
+}
+
+// 時間を区間番号に変換する
+uint32_t FrameTimeHistogram::ToBucket(double seconds)
+{
+	double bucket = seconds * 1000000.0 / BUCKET_MICROSECONDS;
+	return bucket < double(BUCKET_COUNT - 1) ? uint32_t(std::max(bucket, 0.0)) : BUCKET_COUNT - 1;
+}
+
+// フレーム時間を追加する
+void FrameTimeHistogram::Add(double seconds)
+{
+	if (m_count == WINDOW_SIZE)
+		m_buckets[ToBucket(m_samples[m_next])]--;
+	else
+		m_count++;
+
+	// 除くときと同じ区間に数えるよう、保存する精度に丸めてから区間を求める
+	m_samples[m_next] = float(seconds);
+	m_buckets[ToBucket(m_samples[m_next])]++;
+	m_next = (m_next + 1) % WINDOW_SIZE;
+}
+
+// 百分位数のフレーム時間を取得する
+double FrameTimeHistogram::GetPercentile(double percentile) const
+{
+	if (m_count == 0)
+		return 0.0;
+
+	// 小さい方から数えてrank番目のフレームを含む区間を探す
+	size_t rank = size_t(ceil(std::min(std::max(percentile, 0.0), 100.0) / 100.0 * m_count));
+	rank = std::max<size_t>(rank, 1);
+	size_t cumulative = 0;
+	for (uint32_t bucket = 0; bucket < BUCKET_COUNT - 1; bucket++)
+	{
+		cumulative += m_buckets[bucket];
+		if (cumulative >= rank)
+			return double(bucket + 1) * BUCKET_MICROSECONDS / 1000000.0;
+	}
+
+	// 最後の区間は幅が無いので実際の最大値を返す
+	float maximum = 0.0f;
+	for (size_t i = 0; i < m_count; i++)
+	{
+		maximum = std::max(maximum, m_samples[i]);
+	}
+	return maximum;
+}
+
+// すべて除く
+void FrameTimeHistogram::Clear()
+{
+	std::fill(m_samples, m_samples + WINDOW_SIZE, 0.0f);
+	std::fill(m_buckets, m_buckets + BUCKET_COUNT, 0);
+	m_next = 0;
+	m_count = 0;
+}
+
+// プロファイラを取得する
+Profiler& Profiler::Get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+// コンストラクタ
+Profiler::Profiler()
+	: m_clock(DX::GetDefaultClock()), m_origin(m_clock.GetCounter()), m_lastFrame(0)
+{
+}
+
+// 現在のスレッドのリングバッファを取得する
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+{
+	if (s_threadBuffer == nullptr)
+	{
+		std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+		buffer->events.reset(new Event[EVENT_CAPACITY]);
+		buffer->started.store(0, std::memory_order_relaxed);
+		buffer->written.store(0, std::memory_order_relaxed);
+		buffer->cleared = 0;
+
+		// スレッドが終了してもバッファは残し、書き出せるようにする
+		std::lock_guard<std::mutex> lock(m_mutex);
+		buffer->id = uint32_t(m_buffers.size() + 1);
+		buffer->name = t_threadName.empty() ? "Thread " + std::to_string(buffer->id) : t_threadName;
+		s_threadBuffer = buffer.get();
+		m_buffers.push_back(std::move(buffer));
+	}
+	return *s_threadBuffer;
+}
+
+// 現在のスレッドの名前を設定する
+void Profiler::SetThreadName(const std::string& name)
+{
+	t_threadName = name;
+	if (s_threadBuffer != nullptr)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		s_threadBuffer->name = name;
+	}
+}
+
+// 現在のスレッドに区間を記録する
+void Profiler::Record(const char* name, uint64_t begin, uint64_t end)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	uint64_t index = buffer.written.load(std::memory_order_relaxed);
+
+	// 上書きを始めることを先に公開してから区間を書き込む(読み出し側はこれを見て上書き中の区間を除く)
+	buffer.started.store(index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	Event& event = buffer.events[index & (EVENT_CAPACITY - 1)];
+	event.name.store(name, std::memory_order_relaxed);
+	event.begin.store(begin, std::memory_order_relaxed);
+	event.end.store(end, std::memory_order_relaxed);
+	buffer.written.store(index + 1, std::memory_order_release);
+}
+
+// フレームの区切りを記録する
+double Profiler::MarkFrame()
+{
+	uint64_t now = m_clock.GetCounter();
+	double frameSeconds = 0.0;
+	if (m_lastFrame != 0)
+	{
+		frameSeconds = double(now - m_lastFrame) / m_clock.GetFrequency();
+		m_frameTimes.Add(frameSeconds);
+		if (IsEnabled())
+			Record("Frame", m_lastFrame, now);
+	}
+	m_lastFrame = now;
+	return frameSeconds;
+}
+
+// 記録済みの区間を破棄する
+void Profiler::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const std::unique_ptr<ThreadBuffer>& buffer : m_buffers)
+	{
+		buffer->cleared = buffer->written.load(std::memory_order_acquire);
+	}
+}
+
+// 記録済みの区間をChromeのトレース形式で書き出す
+void Profiler::WriteChromeTrace(std::ostream& stream)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const double microsecondsPerCount = 1000000.0 / m_clock.GetFrequency();
+
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"3DGameFramework\"}}";
+	for (const std::unique_ptr<ThreadBuffer>& buffer : m_buffers)
+	{
+		stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":";
+		WriteJsonString(stream, buffer->name.c_str());
+		stream << "}}";
+		stream << ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"sort_index\":" << buffer->id << "}}";
+
+		// 書き込みが完了した範囲のうち、リングバッファに残っているものを読む
+		uint64_t written = buffer->written.load(std::memory_order_acquire);
+		uint64_t first = std::max(buffer->cleared, written > EVENT_CAPACITY ? written - EVENT_CAPACITY : 0);
+		for (uint64_t index = first; index < written; index++)
+		{
+			const Event& event = buffer->events[index & (EVENT_CAPACITY - 1)];
+			const char* name = event.name.load(std::memory_order_relaxed);
+			uint64_t begin = event.begin.load(std::memory_order_relaxed);
+			uint64_t end = event.end.load(std::memory_order_relaxed);
+
+			// 読んでいる間に所有スレッドが上書きを始めていれば除く
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t started = buffer->started.load(std::memory_order_relaxed);
+			if (started > EVENT_CAPACITY && index < started - EVENT_CAPACITY)
+				continue;
+			if (begin < m_origin || end < begin)
+				continue;
+
+			stream << ",\n{\"name\":";
+			WriteJsonString(stream, name);
+			stream << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id << std::fixed << std::setprecision(3)
+				<< ",\"ts\":" << (begin - m_origin) * microsecondsPerCount << ",\"dur\":" << (end - begin) * microsecondsPerCount << "}";
+		}
+	}
+	stream << "\n]}\n";
+}
+
+// 記録済みの区間をChromeのトレース形式でファイルに保存する
+void Profiler::SaveChromeTrace(const std::string& filename)
+{
+	std::ofstream stream(filename, std::ios::binary);
+	if (!stream)
+		throw std::runtime_error("Profiler: cannot open " + filename);
+	WriteChromeTrace(stream);
+	if (!stream)
+		throw std::runtime_error("Profiler: cannot write " + filename);
+}
@@ -0,0 +1,191 @@
+﻿#pragma once
+#ifndef PROFILER_DEFINED
+#define PROFILER_DEFINED
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "FrameClock.h"
+#include "NonCopyable.h"
+
+// 直近のフレーム時間を一定幅の区間ごとに数え、百分位数を求める
+class FrameTimeHistogram
+{
+public:
+	// 集計する直近のフレーム数
+	static const size_t WINDOW_SIZE = 600;
+	// 区間の幅(マイクロ秒)
+	static const uint32_t BUCKET_MICROSECONDS = 100;
+	// 区間の数(これを超える時間は最後の区間にまとめて数える)
+	static const uint32_t BUCKET_COUNT = 1000;
+
+	// コンストラクタ
+	FrameTimeHistogram();
+
+	// フレーム時間(秒)を追加する(WINDOW_SIZEを超えた古いフレームは除かれる)
+	void Add(double seconds);
+	// 百分位数(0～100)のフレーム時間(秒)を取得する(区間の上端を返す。最後の区間は実際の最大値を返す)
+	double GetPercentile(double percentile) const;
+	// 集計しているフレーム数を取得する
+	size_t GetCount() const
+	{
+		return m_count;
+	}
+	// すべて除く
+	void Clear();
+
+private:
+	// 時間を区間番号に変換する
+	static uint32_t ToBucket(double seconds);
+
+private:
+	// 直近のフレーム時間(秒)
+	float m_samples[WINDOW_SIZE];
+	// 区間ごとの度数
+	uint32_t m_buckets[BUCKET_COUNT];
+	// 次に書き込む位置
+	size_t m_next;
+	// 集計しているフレーム数
+	size_t m_count;
+};
+
+// スレッドごとのロックフリーのリングバッファに計測区間を記録し、Chromeのトレース形式(Perfettoでも読める)で書き出すプロファイラ
+// 無効な間の計測区間のコストはフラグの読み込み1回だけで、DISABLE_PROFILERを定義するとPROFILE_SCOPEは何も生成しない
+class Profiler : public NonCopyable
+{
+public:
+	// スレッドごとに保持する区間の数(2のべき乗。古いものから上書きされる)
+	static const uint32_t EVENT_CAPACITY = 65536;
+
+	// プロファイラを取得する
+	static Profiler& Get();
+	// 記録するかどうか
+	static bool IsEnabled()
+	{
+		return s_enabled.load(std::memory_order_relaxed);
+	}
+
+	// 記録するかどうかを設定する
+	void SetEnabled(bool enabled)
+	{
+		s_enabled.store(enabled, std::memory_order_relaxed);
+	}
+	// 現在のスレッドの名前を設定する(トレースに表示される。リングバッファは最初に区間を記録するときに作成する)
+	void SetThreadName(const std::string& name);
+	// 現在のカウンタ値を取得する
+	uint64_t GetCounter() const
+	{
+		return m_clock.GetCounter();
+	}
+	// 現在のスレッドに区間を記録する(名前はトレースを書き出すまで有効な文字列であること)
+	void Record(const char* name, uint64_t begin, uint64_t end);
+
+	// フレームの区切りを記録してフレーム時間(秒)を返す(描画スレッドで1フレームに1回、計測区間の外で呼び出す。最初の呼び出しは0を返す)
+	double MarkFrame();
+	// 直近のフレーム時間の分布を取得する(MarkFrameと同じスレッドから使用する)
+	const FrameTimeHistogram& GetFrameTimes() const
+	{
+		return m_frameTimes;
+	}
+
+	// 記録済みの区間を破棄する
+	void Clear();
+	// 記録済みの区間をChromeのトレース形式で書き出す(記録中でも呼び出せる。書き出し中に上書きされた区間は除かれる)
+	void WriteChromeTrace(std::ostream& stream);
+	// 記録済みの区間をChromeのトレース形式でファイルに保存する
+	void SaveChromeTrace(const std::string& filename);
+
+private:
+	// 計測区間
+	struct Event
+	{
+		// 名前
+		std::atomic<const char*> name;
+		// 開始時のカウンタ値
+		std::atomic<uint64_t> begin;
+		// 終了時のカウンタ値
+		std::atomic<uint64_t> end;
+	};
+	// スレッドごとのリングバッファ
+	// 書き込むのは所有スレッドだけで、読み出し側は書き込み開始数と完了数から上書きされていない範囲を判断する
+	struct ThreadBuffer
+	{
+		// 区間
+		std::unique_ptr<Event[]> events;
+		// 書き込みを開始した区間数
+		std::atomic<uint64_t> started;
+		// 書き込みを完了した区間数
+		std::atomic<uint64_t> written;
+		// Clearした時点の書き込み完了数
+		uint64_t cleared;
+		// スレッド番号
+		uint32_t id;
+		// スレッド名
+		std::string name;
+	};
+
+	// コンストラクタ
+	Profiler();
+	// 現在のスレッドのリングバッファを取得する(初めて記録するスレッドでは作成する)
+	ThreadBuffer& GetThreadBuffer();
+
+private:
+	// 記録するかどうか
+	static std::atomic<bool> s_enabled;
+	// 現在のスレッドのリングバッファ
+	static thread_local ThreadBuffer* s_threadBuffer;
+
+	// クロックソース
+	DX::ClockSource& m_clock;
+	// 時刻の基準となるカウンタ値
+	uint64_t m_origin;
+	// スレッドごとのリングバッファ
+	std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+	// リングバッファの一覧とスレッド名を保護するミューテックス
+	std::mutex m_mutex;
+	// 前回のフレームの区切りのカウンタ値
+	uint64_t m_lastFrame;
+	// 直近のフレーム時間の分布
+	FrameTimeHistogram m_frameTimes;
+};
+
+// スコープを抜けるまでを計測区間として記録する
+class ProfileScope : public NonCopyable
+{
+public:
+	// コンストラクタ(名前はトレースを書き出すまで有効な文字列であること)
+	explicit ProfileScope(const char* name)
+		: m_name(Profiler::IsEnabled() ? name : nullptr), m_begin(m_name ? Profiler::Get().GetCounter() : 0)
+	{
+	}
+	// デストラクタ
+	~ProfileScope()
+	{
+		if (m_name)
+		{
+			Profiler& profiler = Profiler::Get();
+			profiler.Record(m_name, m_begin, profiler.GetCounter());
+		}
+	}
+
+private:
+	// 名前(記録しない場合はnullptr)
+	const char* m_name;
+	// 開始時のカウンタ値
+	uint64_t m_begin;
+};
+
+// スコープの計測区間を記録する
+#ifdef DISABLE_PROFILER
+#define PROFILE_SCOPE(name) ((void)0)
+#else
+#define PROFILE_SCOPE_CONCAT_(a, b) a##b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_SCOPE_CONCAT(profileScope, __LINE__)(name)
+#endif
+
+#endif	// PROFILER_DEFINED
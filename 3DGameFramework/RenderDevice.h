@@ -0,0 +1,22 @@
+﻿#pragma once
+#ifndef RENDERDEVICE_DEFINED
+#define RENDERDEVICE_DEFINED
+
+// ゲームループが使う描画デバイス(デバイスの生成、出力のクリアと表示)
+// グラフィックスAPIやウィンドウに依存しないので、ヌルデバイスに差し替えてGPUの無い環境で実行できる
+class RenderDevice
+{
+public:
+	// デストラクタ
+	virtual ~RenderDevice() {}
+	// デバイスを生成する
+	virtual void CreateDevice() = 0;
+	// 出力サイズを設定し、サイズに依存するリソースを生成する
+	virtual void Resize(int width, int height) = 0;
+	// 出力を指定された色(RGBA)でクリアして描画先に設定する
+	virtual void Clear(const float color[4]) = 0;
+	// 出力を表示する(垂直同期を待つ場合はtrue)
+	virtual void Present(bool vsync) = 0;
+};
+
+#endif	// RENDERDEVICE_DEFINED
@@ -0,0 +1,237 @@
+﻿#include "RenderQueue.h"
+#include <stdexcept>
+#include <string.h>
+#include "TransformKernel.h"
+
+namespace
+{
+	// 状態が未設定であることを表す番号
+	const uint32_t UNSET = UINT32_MAX;
+	// 色が指定されないインスタンスの色
+	const float WHITE[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+}
+
+// ワールド行列と色のポインタの配列からインスタンスデータを作成し、インスタンス描画コマンドを追加する
+void RenderCommandList::AddInstances(const float* const* worlds, const float* const* colors, size_t stride, size_t count)
+{
+	static_assert(sizeof(InstanceData) == sizeof(float) * 16, "InstanceData must be 16 floats");
+	size_t first = m_instances.size();
+	m_instances.resize(first + count);
+	TransformKernel::PackInstances(m_instances[first].world, worlds, colors, stride, count);
+	m_commands.push_back({ RENDER_COMMAND_DRAW_INSTANCED, uint32_t(count), nullptr });
+}
+
+// 作成済みのインスタンスデータを複製し、インスタンス描画コマンドを追加する
+void RenderCommandList::AddInstances(const InstanceData* instances, size_t count)
+{
+	m_instances.insert(m_instances.end(), instances, instances + count);
+	m_commands.push_back({ RENDER_COMMAND_DRAW_INSTANCED, uint32_t(count), nullptr });
+}
+
+// バックエンドでコマンドを実行する
+void RenderCommandList::Execute(RenderBackend& backend) const
+{
+	// インスタンスデータはインスタンス描画コマンドの順に並んでいる
+	const InstanceData* instances = m_instances.data();
+	for (const RenderCommand& command : m_commands)
+	{
+		switch (command.type)
+		{
+		case RENDER_COMMAND_PASS: backend.BeginPass(command.value); break;
+		case RENDER_COMMAND_SHADER: backend.SetShader(command.value); break;
+		case RENDER_COMMAND_MATERIAL: backend.SetMaterial(command.value); break;
+		case RENDER_COMMAND_MESH: backend.SetMesh(command.value); break;
+		case RENDER_COMMAND_DRAW: backend.Draw(command.world); break;
+		case RENDER_COMMAND_DRAW_INSTANCED:
+			backend.DrawInstanced(instances, command.value);
+			instances += command.value;
+			break;
+		}
+	}
+}
+
+// コンストラクタ
+RecordingRenderBackend::RecordingRenderBackend()
+{
+	Reset();
+}
+
+// パスを開始する
+void RecordingRenderBackend::BeginPass(uint32_t pass)
+{
+	m_statistics.passChanges++;
+	m_recorded.Add(RENDER_COMMAND_PASS, pass);
+}
+
+// シェーダを設定する
+void RecordingRenderBackend::SetShader(uint32_t shader)
+{
+	m_statistics.shaderChanges++;
+	m_recorded.Add(RENDER_COMMAND_SHADER, shader);
+}
+
+// マテリアルを設定する
+void RecordingRenderBackend::SetMaterial(uint32_t material)
+{
+	m_statistics.materialChanges++;
+	m_recorded.Add(RENDER_COMMAND_MATERIAL, material);
+}
+
+// メッシュを設定する
+void RecordingRenderBackend::SetMesh(uint32_t mesh)
+{
+	m_statistics.meshChanges++;
+	m_recorded.Add(RENDER_COMMAND_MESH, mesh);
+}
+
+// 設定された状態で描画する
+void RecordingRenderBackend::Draw(const float* world)
+{
+	m_statistics.draws++;
+	m_recorded.Add(RENDER_COMMAND_DRAW, 0, world);
+}
+
+// 設定された状態でインスタンスの数だけ描画する
+void RecordingRenderBackend::DrawInstanced(const InstanceData* instances, uint32_t count)
+{
+	m_statistics.draws++;
+	m_statistics.instances += count;
+	m_recorded.AddInstances(instances, count);
+}
+
+// 統計と記録を消去する
+void RecordingRenderBackend::Reset()
+{
+	memset(&m_statistics, 0, sizeof(m_statistics));
+	m_recorded.Clear();
+}
+
+// ソートキーを作成する
+uint64_t RenderQueue::MakeKey(uint32_t pass, uint32_t shader, uint32_t material, float depth, uint32_t mesh)
+{
+	const uint32_t maxDepth = (1u << DEPTH_BITS) - 1;
+	uint32_t quantizedDepth = !(depth > 0.0f) ? 0 : depth >= 1.0f ? maxDepth : uint32_t(depth * float(maxDepth));
+
+	uint64_t key = pass;
+	key = (key << SHADER_BITS) | shader;
+	key = (key << MATERIAL_BITS) | material;
+	key = (key << DEPTH_BITS) | quantizedDepth;
+	key = (key << MESH_BITS) | mesh;
+	return key;
+}
+
+// 描画項目を追加する
+void RenderQueue::Submit(uint32_t pass, uint32_t shader, uint32_t material, uint32_t mesh, float depth, const float* world)
+{
+	if (pass >> PASS_BITS || shader >> SHADER_BITS || material >> MATERIAL_BITS || mesh >> MESH_BITS)
+	{
+		throw std::out_of_range("RenderQueue: id does not fit in the sort key");
+	}
+	m_items.push_back({ MakeKey(pass, shader, material, depth, mesh), pass, shader, material, mesh, world, nullptr });
+}
+
+// インスタンス描画の項目を追加する
+void RenderQueue::SubmitInstance(uint32_t pass, uint32_t shader, uint32_t material, uint32_t mesh, const float* world, const float* color)
+{
+	if (pass >> PASS_BITS || shader >> SHADER_BITS || material >> MATERIAL_BITS || mesh >> MESH_BITS)
+	{
+		throw std::out_of_range("RenderQueue: id does not fit in the sort key");
+	}
+	m_items.push_back({ MakeKey(pass, shader, material, 0.0f, mesh), pass, shader, material, mesh, world, color ? color : WHITE });
+}
+
+// 描画項目をソートキーの昇順に並べる(8ビットずつの最下位桁優先基数ソート)
+void RenderQueue::Sort()
+{
+	size_t count = m_items.size();
+	if (count < 2)
+		return;
+
+	m_entries.resize(count);
+	m_scratch.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		m_entries[i].key = m_items[i].key;
+		m_entries[i].index = uint32_t(i);
+	}
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t histogram[256] = {};
+		for (const SortEntry& entry : m_entries)
+		{
+			histogram[(entry.key >> shift) & 0xFF]++;
+		}
+		// すべてのキーでこの桁が同じ場合は並べ替えを省く
+		if (histogram[(m_entries[0].key >> shift) & 0xFF] == count)
+			continue;
+
+		size_t offset = 0;
+		for (size_t& bucket : histogram)
+		{
+			size_t bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+		for (const SortEntry& entry : m_entries)
+		{
+			m_scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+		}
+		m_entries.swap(m_scratch);
+	}
+
+	m_sorted.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		m_sorted[i] = m_items[m_entries[i].index];
+	}
+	m_items.swap(m_sorted);
+}
+
+// 状態が変わる場合だけ設定コマンドを出力し、描画コマンド列を作成する
+void RenderQueue::Record(RenderCommandList& commandList) const
+{
+	uint32_t pass = UNSET, shader = UNSET, material = UNSET, mesh = UNSET;
+	size_t count = m_items.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		const RenderItem& item = m_items[i];
+		// パスの開始でバックエンドが状態を変える可能性があるので、それ以外の状態は設定し直す
+		if (item.pass != pass)
+		{
+			pass = item.pass;
+			shader = material = mesh = UNSET;
+			commandList.Add(RENDER_COMMAND_PASS, pass);
+		}
+		if (item.shader != shader)
+		{
+			shader = item.shader;
+			commandList.Add(RENDER_COMMAND_SHADER, shader);
+		}
+		if (item.material != material)
+		{
+			material = item.material;
+			commandList.Add(RENDER_COMMAND_MATERIAL, material);
+		}
+		if (item.mesh != mesh)
+		{
+			mesh = item.mesh;
+			commandList.Add(RENDER_COMMAND_MESH, mesh);
+		}
+		if (item.color == nullptr)
+		{
+			commandList.Add(RENDER_COMMAND_DRAW, 0, item.world);
+			continue;
+		}
+
+		// 同じ状態のインスタンス描画の項目が続く範囲を1回で描画する
+		size_t end = i + 1;
+		while (end < count && m_items[end].color != nullptr && m_items[end].pass == pass && m_items[end].shader == shader &&
+			m_items[end].material == material && m_items[end].mesh == mesh)
+		{
+			end++;
+		}
+		commandList.AddInstances(&item.world, &item.color, sizeof(RenderItem), end - i);
+		i = end - 1;
+	}
+}
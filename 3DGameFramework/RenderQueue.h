@@ -0,0 +1,240 @@
+﻿#pragma once
+#ifndef RENDERQUEUE_DEFINED
+#define RENDERQUEUE_DEFINED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// インスタンスごとの描画データ(インスタンス用の頂点バッファにそのまま書き込む)
+struct InstanceData
+{
+	// ワールド行列を転置した上3行(各行との内積がワールド座標のx, y, zになる)
+	float world[12];
+	// 色(RGBA、頂点の色に掛ける)
+	float color[4];
+};
+
+// 描画項目
+struct RenderItem
+{
+	// ソートキー(上位からパス・シェーダ・マテリアル・深度・メッシュ)
+	uint64_t key;
+	// パス番号
+	uint32_t pass;
+	// シェーダ番号
+	uint32_t shader;
+	// マテリアル番号
+	uint32_t material;
+	// メッシュ番号
+	uint32_t mesh;
+	// ワールド行列(行優先の16要素、描画が終わるまで有効であること)
+	const float* world;
+	// インスタンスの色(インスタンス描画の項目のみ。通常の項目はnullptr)
+	const float* color;
+};
+
+// 描画コマンドの種類
+enum RenderCommandType
+{
+	// パスを開始する
+	RENDER_COMMAND_PASS,
+	// シェーダを設定する
+	RENDER_COMMAND_SHADER,
+	// マテリアルを設定する
+	RENDER_COMMAND_MATERIAL,
+	// メッシュを設定する
+	RENDER_COMMAND_MESH,
+	// 描画する
+	RENDER_COMMAND_DRAW,
+	// インスタンス描画する
+	RENDER_COMMAND_DRAW_INSTANCED,
+};
+
+// 描画コマンド
+struct RenderCommand
+{
+	// 種類
+	RenderCommandType type;
+	// パス・シェーダ・マテリアル・メッシュの番号(インスタンス描画ではインスタンス数)
+	uint32_t value;
+	// ワールド行列(描画コマンドのみ)
+	const float* world;
+};
+
+// 描画コマンドを受け取ってグラフィックスAPIを呼び出すバックエンド
+class RenderBackend
+{
+public:
+	// デストラクタ
+	virtual ~RenderBackend() {}
+	// パスを開始する
+	virtual void BeginPass(uint32_t pass) = 0;
+	// シェーダを設定する
+	virtual void SetShader(uint32_t shader) = 0;
+	// マテリアルを設定する
+	virtual void SetMaterial(uint32_t material) = 0;
+	// メッシュを設定する
+	virtual void SetMesh(uint32_t mesh) = 0;
+	// 設定された状態で描画する
+	virtual void Draw(const float* world) = 0;
+	// 設定された状態でインスタンスの数だけ描画する(インスタンスデータは呼び出しの間だけ有効)
+	virtual void DrawInstanced(const InstanceData* instances, uint32_t count) = 0;
+};
+
+// グラフィックスAPIに依存しない描画コマンドの列
+class RenderCommandList
+{
+public:
+	// コマンドを削除する
+	void Clear()
+	{
+		m_commands.clear();
+		m_instances.clear();
+	}
+	// コマンドを追加する
+	void Add(RenderCommandType type, uint32_t value, const float* world = nullptr)
+	{
+		m_commands.push_back({ type, value, world });
+	}
+	// ワールド行列と色のポインタの配列(strideバイトごと)からインスタンスデータを作成し、インスタンス描画コマンドを追加する
+	void AddInstances(const float* const* worlds, const float* const* colors, size_t stride, size_t count);
+	// 作成済みのインスタンスデータを複製し、インスタンス描画コマンドを追加する
+	void AddInstances(const InstanceData* instances, size_t count);
+	// コマンド配列を取得する
+	const std::vector<RenderCommand>& GetCommands() const
+	{
+		return m_commands;
+	}
+	// インスタンスデータを取得する(インスタンス描画コマンドの順に並ぶ)
+	const std::vector<InstanceData>& GetInstances() const
+	{
+		return m_instances;
+	}
+	// バックエンドでコマンドを実行する
+	void Execute(RenderBackend& backend) const;
+
+private:
+	// コマンド配列
+	std::vector<RenderCommand> m_commands;
+	// インスタンスデータ
+	std::vector<InstanceData> m_instances;
+};
+
+// 描画統計
+struct RenderStatistics
+{
+	// パスの切り替え数
+	uint32_t passChanges;
+	// シェーダの切り替え数
+	uint32_t shaderChanges;
+	// マテリアルの切り替え数
+	uint32_t materialChanges;
+	// メッシュの切り替え数
+	uint32_t meshChanges;
+	// 描画数
+	uint32_t draws;
+	// インスタンス描画で描いたインスタンスの数
+	uint32_t instances;
+};
+
+// GPUを使用せず、受け取ったコマンドを記録して状態の切り替え数を数えるバックエンド
+class RecordingRenderBackend : public RenderBackend
+{
+public:
+	// コンストラクタ
+	RecordingRenderBackend();
+
+	// パスを開始する
+	void BeginPass(uint32_t pass) override;
+	// シェーダを設定する
+	void SetShader(uint32_t shader) override;
+	// マテリアルを設定する
+	void SetMaterial(uint32_t material) override;
+	// メッシュを設定する
+	void SetMesh(uint32_t mesh) override;
+	// 設定された状態で描画する
+	void Draw(const float* world) override;
+	// 設定された状態でインスタンスの数だけ描画する
+	void DrawInstanced(const InstanceData* instances, uint32_t count) override;
+
+	// 統計と記録を消去する
+	void Reset();
+	// 統計を取得する
+	const RenderStatistics& GetStatistics() const
+	{
+		return m_statistics;
+	}
+	// 記録したコマンドを取得する
+	const RenderCommandList& GetRecorded() const
+	{
+		return m_recorded;
+	}
+
+private:
+	// 統計
+	RenderStatistics m_statistics;
+	// 記録したコマンド
+	RenderCommandList m_recorded;
+};
+
+// 描画項目を集めてソートキーで基数ソートし、冗長な状態の切り替えを省いたコマンド列にする描画キュー
+// インスタンス描画の項目は同じパス・シェーダ・マテリアル・メッシュが続く範囲を1回のインスタンス描画にまとめる
+class RenderQueue
+{
+public:
+	// ソートキーの各フィールドのビット数(メッシュの番号は詳細度も含むので、深度と同じ20ビットにする)
+	static const int PASS_BITS = 4;
+	static const int SHADER_BITS = 8;
+	static const int MATERIAL_BITS = 12;
+	static const int DEPTH_BITS = 20;
+	static const int MESH_BITS = 20;
+
+	// ソートキーを作成する(depthは0～1、大きいほど後に描画する。範囲外は切り詰め、NaNは0とする)
+	static uint64_t MakeKey(uint32_t pass, uint32_t shader, uint32_t material, float depth, uint32_t mesh);
+
+	// 描画項目を削除する
+	void Clear()
+	{
+		m_items.clear();
+	}
+	// 描画項目を追加する(各番号はソートキーのビット数に収まること)
+	void Submit(uint32_t pass, uint32_t shader, uint32_t material, uint32_t mesh, float depth, const float* world);
+	// インスタンス描画の項目を追加する(色は4要素で、nullptrの場合は白。深度は0として並べるので同じメッシュが隣り合う)
+	void SubmitInstance(uint32_t pass, uint32_t shader, uint32_t material, uint32_t mesh, const float* world, const float* color = nullptr);
+	// 描画項目をソートキーの昇順に並べる(同じキーは追加順を保つ)
+	void Sort();
+	// 状態が変わる場合だけ設定コマンドを出力し、描画コマンド列を作成する
+	void Record(RenderCommandList& commandList) const;
+
+	// 描画項目数を取得する
+	size_t GetItemCount() const
+	{
+		return m_items.size();
+	}
+	// 描画項目配列を取得する
+	const RenderItem* GetItems() const
+	{
+		return m_items.data();
+	}
+
+private:
+	// キーと項目番号の組
+	struct SortEntry
+	{
+		// ソートキー
+		uint64_t key;
+		// 項目番号
+		uint32_t index;
+	};
+
+private:
+	// 描画項目
+	std::vector<RenderItem> m_items;
+	// ソート用の作業領域
+	std::vector<SortEntry> m_entries;
+	std::vector<SortEntry> m_scratch;
+	std::vector<RenderItem> m_sorted;
+};
+
+#endif	// RENDERQUEUE_DEFINED
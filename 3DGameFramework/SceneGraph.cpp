@@ -0,0 +1,150 @@
+﻿#include "SceneGraph.h"
+#include <stdexcept>
+
+// ノードを追加する
+int32_t SceneGraph::AddNode(const char* name, int32_t parent, int32_t meshIndex)
+{
+	int32_t node = int32_t(m_parents.size());
+	if (parent != NO_PARENT && (parent < 0 || parent >= node))
+	{
+		throw std::out_of_range("SceneGraph: parent must be added before its children");
+	}
+
+	m_parents.push_back(parent);
+	m_meshIndices.push_back(meshIndex);
+	m_names.push_back(name ? name : "");
+	m_localPositions.push_back({ 0.0f, 0.0f, 0.0f });
+	m_localRotations.push_back({ 0.0f, 0.0f, 0.0f, 1.0f });
+	m_localScales.push_back({ 1.0f, 1.0f, 1.0f });
+	m_worldMatrices.emplace_back();
+	m_dirty.push_back(1);
+	m_changed.push_back(0);
+	m_anyDirty = true;
+	return node;
+}
+
+// 指定したノード数の領域を確保する
+void SceneGraph::Reserve(size_t nodeCount)
+{
+	m_parents.reserve(nodeCount);
+	m_meshIndices.reserve(nodeCount);
+	m_names.reserve(nodeCount);
+	m_localPositions.reserve(nodeCount);
+	m_localRotations.reserve(nodeCount);
+	m_localScales.reserve(nodeCount);
+	m_worldMatrices.reserve(nodeCount);
+	m_dirty.reserve(nodeCount);
+	m_changed.reserve(nodeCount);
+}
+
+// すべてのノードを削除する
+void SceneGraph::Clear()
+{
+	m_parents.clear();
+	m_meshIndices.clear();
+	m_names.clear();
+	m_localPositions.clear();
+	m_localRotations.clear();
+	m_localScales.clear();
+	m_worldMatrices.clear();
+	m_dirty.clear();
+	m_changed.clear();
+	m_anyDirty = false;
+}
+
+// ローカル位置を設定する
+void SceneGraph::SetLocalPosition(int32_t node, const SceneVector3& position)
+{
+	m_localPositions[node] = position;
+	m_dirty[node] = 1;
+	m_anyDirty = true;
+}
+
+// ローカル回転を設定する
+void SceneGraph::SetLocalRotation(int32_t node, const SceneQuaternion& rotation)
+{
+	m_localRotations[node] = rotation;
+	m_dirty[node] = 1;
+	m_anyDirty = true;
+}
+
+// ローカル拡大率を設定する
+void SceneGraph::SetLocalScale(int32_t node, const SceneVector3& scale)
+{
+	m_localScales[node] = scale;
+	m_dirty[node] = 1;
+	m_anyDirty = true;
+}
+
+// 変更されたノードとその子孫のワールド行列を再計算する
+size_t SceneGraph::UpdateWorldTransforms()
+{
+	if (!m_anyDirty)
+		return 0;
+
+	// 親は必ず子より前にあるので、先頭から1回走査するだけで変更が子孫に伝搬する
+	size_t updated = 0;
+	size_t nodeCount = m_parents.size();
+	for (size_t i = 0; i < nodeCount; i++)
+	{
+		int32_t parent = m_parents[i];
+		bool changed = m_dirty[i] || (parent != NO_PARENT && m_changed[parent]);
+		m_changed[i] = changed;
+		if (!changed)
+			continue;
+
+		if (parent == NO_PARENT)
+		{
+			Compose(m_localPositions[i], m_localRotations[i], m_localScales[i], m_worldMatrices[i]);
+		}
+		else
+		{
+			SceneMatrix local;
+			Compose(m_localPositions[i], m_localRotations[i], m_localScales[i], local);
+			Multiply(local, m_worldMatrices[parent], m_worldMatrices[i]);
+		}
+		m_dirty[i] = 0;
+		updated++;
+	}
+	m_anyDirty = false;
+	return updated;
+}
+
+// 位置・回転・拡大率からローカル行列を作成する(拡大→回転→平行移動の順に適用する)
+void SceneGraph::Compose(const SceneVector3& position, const SceneQuaternion& rotation, const SceneVector3& scale, SceneMatrix& matrix)
+{
+	float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+	float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+	float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+
+	float* m = matrix.m;
+	m[0] = (1.0f - 2.0f * (yy + zz)) * scale.x;
+	m[1] = 2.0f * (xy + wz) * scale.x;
+	m[2] = 2.0f * (xz - wy) * scale.x;
+	m[3] = 0.0f;
+	m[4] = 2.0f * (xy - wz) * scale.y;
+	m[5] = (1.0f - 2.0f * (xx + zz)) * scale.y;
+	m[6] = 2.0f * (yz + wx) * scale.y;
+	m[7] = 0.0f;
+	m[8] = 2.0f * (xz + wy) * scale.z;
+	m[9] = 2.0f * (yz - wx) * scale.z;
+	m[10] = (1.0f - 2.0f * (xx + yy)) * scale.z;
+	m[11] = 0.0f;
+	m[12] = position.x;
+	m[13] = position.y;
+	m[14] = position.z;
+	m[15] = 1.0f;
+}
+
+// 行列を乗算する
+void SceneGraph::Multiply(const SceneMatrix& a, const SceneMatrix& b, SceneMatrix& result)
+{
+	for (int row = 0; row < 4; row++)
+	{
+		float a0 = a.m[row * 4 + 0], a1 = a.m[row * 4 + 1], a2 = a.m[row * 4 + 2], a3 = a.m[row * 4 + 3];
+		for (int column = 0; column < 4; column++)
+		{
+			result.m[row * 4 + column] = a0 * b.m[column] + a1 * b.m[4 + column] + a2 * b.m[8 + column] + a3 * b.m[12 + column];
+		}
+	}
+}
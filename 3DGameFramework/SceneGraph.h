@@ -0,0 +1,105 @@
+﻿#pragma once
+#ifndef SCENEGRAPH_DEFINED
+#define SCENEGRAPH_DEFINED
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// 3次元ベクトル
+struct SceneVector3
+{
+	float x, y, z;
+};
+
+// 四元数
+struct SceneQuaternion
+{
+	float x, y, z, w;
+};
+
+// 4x4行列(行優先、行ベクトル規約)
+struct SceneMatrix
+{
+	float m[16];
+};
+
+// ノードを親が子より前に来る平坦な配列で保持し、変換を構造体の配列(SoA)で管理するシーングラフ
+class SceneGraph
+{
+public:
+	// 親が無いことを表すノード番号
+	static const int32_t NO_PARENT = -1;
+	// メッシュが無いことを表すメッシュ番号
+	static const int32_t NO_MESH = -1;
+
+	// コンストラクタ
+	SceneGraph() : m_anyDirty(false)
+	{
+	}
+
+	// ノードを追加する(親は既に追加されたノードでなければならない)
+	int32_t AddNode(const char* name, int32_t parent = NO_PARENT, int32_t meshIndex = NO_MESH);
+	// 指定したノード数の領域を確保する
+	void Reserve(size_t nodeCount);
+	// すべてのノードを削除する
+	void Clear();
+
+	// ローカル位置を設定する
+	void SetLocalPosition(int32_t node, const SceneVector3& position);
+	// ローカル回転を設定する
+	void SetLocalRotation(int32_t node, const SceneQuaternion& rotation);
+	// ローカル拡大率を設定する
+	void SetLocalScale(int32_t node, const SceneVector3& scale);
+
+	// 変更されたノードとその子孫のワールド行列を再計算する(再計算したノード数を返す)
+	size_t UpdateWorldTransforms();
+
+	// ノード数を取得する
+	size_t GetNodeCount() const { return m_parents.size(); }
+	// 親のノード番号を取得する
+	int32_t GetParent(int32_t node) const { return m_parents[node]; }
+	// メッシュ番号を取得する
+	int32_t GetMeshIndex(int32_t node) const { return m_meshIndices[node]; }
+	// ノード名を取得する
+	const std::string& GetName(int32_t node) const { return m_names[node]; }
+	// ローカル位置を取得する
+	const SceneVector3& GetLocalPosition(int32_t node) const { return m_localPositions[node]; }
+	// ローカル回転を取得する
+	const SceneQuaternion& GetLocalRotation(int32_t node) const { return m_localRotations[node]; }
+	// ローカル拡大率を取得する
+	const SceneVector3& GetLocalScale(int32_t node) const { return m_localScales[node]; }
+	// ワールド行列を取得する
+	const SceneMatrix& GetWorldMatrix(int32_t node) const { return m_worldMatrices[node]; }
+	// ワールド行列の配列を取得する
+	const SceneMatrix* GetWorldMatrices() const { return m_worldMatrices.data(); }
+
+	// 位置・回転・拡大率からローカル行列を作成する
+	static void Compose(const SceneVector3& position, const SceneQuaternion& rotation, const SceneVector3& scale, SceneMatrix& matrix);
+	// 行列を乗算する(result = a * b)
+	static void Multiply(const SceneMatrix& a, const SceneMatrix& b, SceneMatrix& result);
+
+private:
+	// 親のノード番号
+	std::vector<int32_t> m_parents;
+	// メッシュ番号
+	std::vector<int32_t> m_meshIndices;
+	// ノード名
+	std::vector<std::string> m_names;
+	// ローカル位置
+	std::vector<SceneVector3> m_localPositions;
+	// ローカル回転
+	std::vector<SceneQuaternion> m_localRotations;
+	// ローカル拡大率
+	std::vector<SceneVector3> m_localScales;
+	// ワールド行列
+	std::vector<SceneMatrix> m_worldMatrices;
+	// ローカル変換が変更されたかどうか
+	std::vector<uint8_t> m_dirty;
+	// 今回の更新でワールド行列が変わったかどうか(子への伝搬に使用する)
+	std::vector<uint8_t> m_changed;
+	// 変更されたノードがあるかどうか
+	bool m_anyDirty;
+};
+
+#endif	// SCENEGRAPH_DEFINED
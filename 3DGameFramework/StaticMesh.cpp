@@ -0,0 +1,111 @@
+﻿#include "StaticMesh.h"
+#include "MeshSplitter.h"
+
+// 量子化した頂点の入力要素
+const D3D11_INPUT_ELEMENT_DESC StaticMesh::QUANTIZED_INPUT_ELEMENTS[QUANTIZED_INPUT_ELEMENT_COUNT] =
+{
+	{ "SV_Position", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+// コンストラクタ
+StaticMesh::StaticMesh(ID3D11Device* device, const MeshVertex* vertices, uint32_t vertexCount,
+	const uint32_t* indices, uint32_t indexCount, bool allow32BitIndices)
+	: m_vertexStride(sizeof(MeshVertex)), m_indexFormat(DXGI_FORMAT_R16_UINT), m_triangleCount(indexCount / 3)
+{
+	Create(device, vertices, vertexCount, indices, indexCount, allow32BitIndices);
+}
+
+// コンストラクタ(量子化した頂点)
+StaticMesh::StaticMesh(ID3D11Device* device, const QuantizedVertex* vertices, uint32_t vertexCount,
+	const uint32_t* indices, uint32_t indexCount, bool allow32BitIndices)
+	: m_vertexStride(sizeof(QuantizedVertex)), m_indexFormat(DXGI_FORMAT_R16_UINT), m_triangleCount(indexCount / 3)
+{
+	Create(device, vertices, vertexCount, indices, indexCount, allow32BitIndices);
+}
+
+// 頂点とインデックスからバッファと描画範囲を作成する
+void StaticMesh::Create(ID3D11Device* device, const void* vertices, uint32_t vertexCount,
+	const uint32_t* indices, uint32_t indexCount, bool allow32BitIndices)
+{
+	if (indexCount == 0)
+		return;
+
+	// 機能レベル9_1は16ビットインデックスしか扱えない
+	bool supports32BitIndices = allow32BitIndices && device->GetFeatureLevel() >= D3D_FEATURE_LEVEL_9_2;
+
+	if (supports32BitIndices && vertexCount > MeshSplitter::MAX_CHUNK_VERTICES)
+	{
+		// 32ビットインデックスで1回で描画する
+		m_indexFormat = DXGI_FORMAT_R32_UINT;
+		CreateBuffers(device, vertices, vertexCount * m_vertexStride, indices, indexCount * sizeof(uint32_t));
+		m_ranges.push_back({ 0, indexCount, 0 });
+		return;
+	}
+
+	// 16ビットインデックスのチャンクに分割し、1つのバッファにまとめてベース頂点で描き分ける
+	// 頂点の形式によらないよう、チャンクの頂点は元の頂点番号からバイト列として集める
+	std::vector<MeshChunk> chunks = MeshSplitter::Split(nullptr, vertexCount, indices, indexCount);
+	const uint8_t* source = static_cast<const uint8_t*>(vertices);
+	std::vector<uint8_t> chunkVertices;
+	std::vector<uint16_t> chunkIndices;
+	for (const MeshChunk& chunk : chunks)
+	{
+		m_ranges.push_back({ UINT(chunkIndices.size()), UINT(chunk.indices.size()), INT(chunkVertices.size() / m_vertexStride) });
+		for (uint32_t vertex : chunk.sourceVertices)
+			chunkVertices.insert(chunkVertices.end(), source + size_t(vertex) * m_vertexStride, source + size_t(vertex + 1) * m_vertexStride);
+		chunkIndices.insert(chunkIndices.end(), chunk.indices.begin(), chunk.indices.end());
+	}
+	CreateBuffers(device, chunkVertices.data(), UINT(chunkVertices.size()),
+		chunkIndices.data(), UINT(chunkIndices.size() * sizeof(uint16_t)));
+}
+
+// 描画する
+void StaticMesh::Draw(ID3D11DeviceContext* context) const
+{
+	Bind(context);
+	DrawRanges(context);
+}
+
+// 頂点バッファとインデックスバッファを設定する
+void StaticMesh::Bind(ID3D11DeviceContext* context) const
+{
+	if (m_ranges.empty())
+		return;
+
+	UINT offset = 0;
+	context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &m_vertexStride, &offset);
+	context->IASetIndexBuffer(m_indexBuffer.Get(), m_indexFormat, 0);
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
+
+// 設定済みのバッファで全範囲を描画する
+void StaticMesh::DrawRanges(ID3D11DeviceContext* context) const
+{
+	for (const StaticMeshRange& range : m_ranges)
+	{
+		context->DrawIndexed(range.indexCount, range.indexStart, range.baseVertex);
+	}
+}
+
+// 設定済みのバッファで全範囲をインスタンスの数だけ描画する
+void StaticMesh::DrawRangesInstanced(ID3D11DeviceContext* context, UINT instanceCount) const
+{
+	for (const StaticMeshRange& range : m_ranges)
+	{
+		context->DrawIndexedInstanced(range.indexCount, instanceCount, range.indexStart, range.baseVertex, 0);
+	}
+}
+
+// バッファを生成する
+void StaticMesh::CreateBuffers(ID3D11Device* device, const void* vertices, UINT vertexBytes, const void* indices, UINT indexBytes)
+{
+	// 変更されないので書き換え不可のバッファとして生成する
+	CD3D11_BUFFER_DESC vertexDesc(vertexBytes, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+	D3D11_SUBRESOURCE_DATA vertexData = { vertices, 0, 0 };
+	DX::ThrowIfFailed(device->CreateBuffer(&vertexDesc, &vertexData, m_vertexBuffer.ReleaseAndGetAddressOf()));
+
+	CD3D11_BUFFER_DESC indexDesc(indexBytes, D3D11_BIND_INDEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+	D3D11_SUBRESOURCE_DATA indexData = { indices, 0, 0 };
+	DX::ThrowIfFailed(device->CreateBuffer(&indexDesc, &indexData, m_indexBuffer.ReleaseAndGetAddressOf()));
+}
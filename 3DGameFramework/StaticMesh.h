@@ -0,0 +1,81 @@
+﻿#pragma once
+#ifndef STATICMESH_DEFINED
+#define STATICMESH_DEFINED
+
+#include <vector>
+#include "MeshData.h"
+#include "VertexQuantizer.h"
+
+// 1回のDrawIndexedで描画する範囲
+struct StaticMeshRange
+{
+	// 開始インデックス
+	UINT indexStart;
+	// インデックス数
+	UINT indexCount;
+	// ベース頂点
+	INT baseVertex;
+};
+
+// 頂点とインデックスをGPUに常駐させて描画するメッシュ
+class StaticMesh
+{
+public:
+	// 量子化した頂点の入力要素の数
+	static const UINT QUANTIZED_INPUT_ELEMENT_COUNT = 2;
+	// 量子化した頂点の入力要素(位置はR16G16B16A16_UNORM、色はR8G8B8A8_UNORMとして読む)
+	static const D3D11_INPUT_ELEMENT_DESC QUANTIZED_INPUT_ELEMENTS[QUANTIZED_INPUT_ELEMENT_COUNT];
+
+	// コンストラクタ(16ビットインデックスしか扱えない場合は自動的にチャンクに分割する)
+	StaticMesh(ID3D11Device* device, const MeshVertex* vertices, uint32_t vertexCount,
+		const uint32_t* indices, uint32_t indexCount, bool allow32BitIndices = true);
+	// コンストラクタ(量子化した頂点、位置は描画時に復号行列をワールド行列の前に掛けて戻す)
+	StaticMesh(ID3D11Device* device, const QuantizedVertex* vertices, uint32_t vertexCount,
+		const uint32_t* indices, uint32_t indexCount, bool allow32BitIndices = true);
+	// 描画する
+	void Draw(ID3D11DeviceContext* context) const;
+	// 頂点バッファとインデックスバッファを設定する
+	void Bind(ID3D11DeviceContext* context) const;
+	// 設定済みのバッファで全範囲を描画する
+	void DrawRanges(ID3D11DeviceContext* context) const;
+	// 設定済みのバッファで全範囲をインスタンスの数だけ描画する
+	void DrawRangesInstanced(ID3D11DeviceContext* context, UINT instanceCount) const;
+	// 描画呼び出し数を取得する
+	size_t GetDrawCount() const
+	{
+		return m_ranges.size();
+	}
+	// 三角形の数を取得する
+	uint32_t GetTriangleCount() const
+	{
+		return m_triangleCount;
+	}
+	// インデックス形式を取得する
+	DXGI_FORMAT GetIndexFormat() const
+	{
+		return m_indexFormat;
+	}
+
+private:
+	// 頂点(m_vertexStrideバイトずつ)とインデックスからバッファと描画範囲を作成する
+	void Create(ID3D11Device* device, const void* vertices, uint32_t vertexCount,
+		const uint32_t* indices, uint32_t indexCount, bool allow32BitIndices);
+	// バッファを生成する
+	void CreateBuffers(ID3D11Device* device, const void* vertices, UINT vertexBytes, const void* indices, UINT indexBytes);
+
+private:
+	// 頂点バッファ
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_vertexBuffer;
+	// インデックスバッファ
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_indexBuffer;
+	// 頂点ストライド
+	UINT m_vertexStride;
+	// インデックス形式
+	DXGI_FORMAT m_indexFormat;
+	// 描画範囲
+	std::vector<StaticMeshRange> m_ranges;
+	// 三角形の数
+	uint32_t m_triangleCount;
+};
+
+#endif	// STATICMESH_DEFINED
@@ -4,10 +4,11 @@
 #ifndef DX_HELPER_DEFINED
 #define DX_HELPER_DEFINED
 
-#include <windows.h>
 #include <stdexcept>
 #include <exception>
 #include <stdint.h>
+#include <cstdlib>
+#include "FrameClock.h"
 
 namespace DX
 {
@@ -15,29 +16,34 @@ namespace DX
     class StepTimer
     {
     public:
-        StepTimer() : 
+        // 時刻の取得に使用するクロックソースを指定する(既定はWindowsではQPC、それ以外ではsteady_clock)
+        explicit StepTimer(ClockSource& clock = GetDefaultClock()) :
+            m_clock(&clock),
             m_elapsedTicks(0),
             m_totalTicks(0),
             m_leftOverTicks(0),
             m_frameCount(0),
             m_framesPerSecond(0),
             m_framesThisSecond(0),
-            m_qpcSecondCounter(0),
+            m_secondCounter(0),
             m_isFixedTimeStep(false),
-            m_targetElapsedTicks(TicksPerSecond / 60)
+            m_targetElapsedTicks(TicksPerSecond / 60),
+            m_frameInterval(0),
+            m_nextFrameCounter(0),
+            m_maxUpdatesPerTick(0),
+            m_catchUpLimit(0),
+            m_droppedUpdates(0)
         {
-            if (!QueryPerformanceFrequency(&m_qpcFrequency))
+            m_frequency = m_clock->GetFrequency();
+            if (m_frequency == 0)
             {
-                throw std::exception( "QueryPerformanceFrequency" );
+                throw std::runtime_error("StepTimer: clock frequency is zero");
             }
 
-            if (!QueryPerformanceCounter(&m_qpcLastTime))
-            {
-                throw std::exception( "QueryPerformanceCounter" );
-            }
+            m_lastCounter = m_clock->GetCounter();
 
             // 1/10秒への最大デルタを初期化する
-            m_qpcMaxDelta = m_qpcFrequency.QuadPart / 10;
+            m_maxDelta = m_frequency / 10;
         }
 
         // 直前のUpdateの呼び出し後経過時間を取得する
@@ -54,6 +60,13 @@ namespace DX
         // 現在のフレームレイトを取得する
         uint32_t GetFramesPerSecond() const					{ return m_framesPerSecond; }
 
+        // 直前の固定ステップから次の固定ステップまでの補間係数(0～1)を取得する
+        // 固定時間ステップモードでは次のステップに満たない端数の割合、変動ステップモードでは常に1
+        double GetInterpolationAlpha() const
+        {
+            return m_isFixedTimeStep ? static_cast<double>(m_leftOverTicks) / m_targetElapsedTicks : 1.0;
+        }
+
         // 固定または変動ステップモードを使用するかどうかを設定する
         void SetFixedTimeStep(bool isFixedTimestep)			{ m_isFixedTimeStep = isFixedTimestep; }
 
@@ -61,54 +74,85 @@ namespace DX
         void SetTargetElapsedTicks(uint64_t targetElapsed)	{ m_targetElapsedTicks = targetElapsed; }
         void SetTargetElapsedSeconds(double targetElapsed)	{ m_targetElapsedTicks = SecondsToTicks(targetElapsed); }
 
+        // 固定時間ステップモード時のUpdateの間隔を取得する
+        uint64_t GetTargetElapsedTicks() const				{ return m_targetElapsedTicks; }
+        double GetTargetElapsedSeconds() const				{ return TicksToSeconds(m_targetElapsedTicks); }
+
+        // Tickの呼び出し頻度の上限を設定する(0は無制限)
+        // 残りが長い間はスリープし、直前はスピンして待つので、スリープの精度より細かく刻める
+        void SetFrameRateLimit(double framesPerSecond)
+        {
+            m_frameInterval = framesPerSecond > 0.0 ? static_cast<uint64_t>(m_frequency / framesPerSecond) : 0;
+            m_nextFrameCounter = 0;
+        }
+
+        // 固定時間ステップモードで1回のTickが呼び出すUpdateの上限を設定する(0は無制限)
+        // 更新が実時間に追いつかない間は上限を半分ずつ下げ、追いついたら1ずつ戻す
+        void SetMaxUpdatesPerTick(uint32_t maxUpdates)		{ m_maxUpdatesPerTick = maxUpdates; m_catchUpLimit = maxUpdates; }
+
+        // 現在の1回のTickが呼び出すUpdateの上限を取得する(0は無制限)
+        uint32_t GetCatchUpLimit() const					{ return m_catchUpLimit; }
+
+        // 上限を超えたため捨てたUpdateの数を取得する
+        uint64_t GetDroppedUpdates() const					{ return m_droppedUpdates; }
+
         // 整数形式は1秒に対する10,000,000テックを使用する時間を示す
         static const uint64_t TicksPerSecond = 10000000;
 
         static double TicksToSeconds(uint64_t ticks)		{ return static_cast<double>(ticks) / TicksPerSecond; }
         static uint64_t SecondsToTicks(double seconds)		{ return static_cast<uint64_t>(seconds * TicksPerSecond); }
 
+        // クロックソースのカウンタ値を標準的なテック形式に変換する(大きな値でもオーバーフローしない)
+        uint64_t CounterToTicks(uint64_t counter) const
+        {
+            return counter / m_frequency * TicksPerSecond + counter % m_frequency * TicksPerSecond / m_frequency;
+        }
+
         // ブロッキングIO操作など不連続なタイミングの後、キャッチアップ用のUpdate呼び出しを
 		// おこない固定タイムステップロジックの保持を避けるためこの関数を呼び出す
         void ResetElapsedTime()
         {
-            if (!QueryPerformanceCounter(&m_qpcLastTime))
-            {
-                throw std::exception("QueryPerformanceCounter");
-            }
+            m_lastCounter = m_clock->GetCounter();
 
             m_leftOverTicks = 0;
             m_framesPerSecond = 0;
             m_framesThisSecond = 0;
-            m_qpcSecondCounter = 0;
+            m_secondCounter = 0;
+            m_nextFrameCounter = 0;
         }
 
-        // 指定された更新関数を呼び出すタイマーの状態を更新する
+        // 指定された更新関数を呼び出すタイマーの状態を更新する(更新関数を呼び出した場合はtrueを返す)
         template<typename TUpdate>
-        void Tick(const TUpdate& update) 
+        bool Tick(const TUpdate& update) 
 		{
-            // 現在の時間を問い合わせる
-            LARGE_INTEGER currentTime;
+            // フレームレイトの上限が設定されていれば次のフレームの時刻まで待機する
+            if (m_frameInterval != 0)
+            {
+                m_clock->WaitUntil(m_nextFrameCounter);
+                uint64_t now = m_clock->GetCounter();
 
-            if (!QueryPerformanceCounter(&currentTime)) 
-			{
-                throw std::exception( "QueryPerformanceCounter" );
+                // 1フレーム以上遅れた場合は取り戻そうとせず、現在の時間から次のフレームを数える
+                m_nextFrameCounter = now - m_nextFrameCounter > m_frameInterval ? now + m_frameInterval : m_nextFrameCounter + m_frameInterval;
             }
 
-            uint64_t timeDelta = currentTime.QuadPart - m_qpcLastTime.QuadPart;
+            // 現在の時間を問い合わせる
+            uint64_t currentTime = m_clock->GetCounter();
+
+            uint64_t timeDelta = currentTime - m_lastCounter;
 
-            m_qpcLastTime = currentTime;
-            m_qpcSecondCounter += timeDelta;
+            m_lastCounter = currentTime;
+            m_secondCounter += timeDelta;
 
             // 大きなデルタタイムをクランプする(例:デバッグのポーズ後)
-            if (timeDelta > m_qpcMaxDelta) 
+            if (timeDelta > m_maxDelta) 
 			{
-                timeDelta = m_qpcMaxDelta;
+                timeDelta = m_maxDelta;
             }
 
-            // QPCユニットを標準的なテック形式に変換する
+            // クロックソースのユニットを標準的なテック形式に変換する
 			// 直前のクランプのためオーバーフローはできない
             timeDelta *= TicksPerSecond;
-            timeDelta /= m_qpcFrequency.QuadPart;
+            timeDelta /= m_frequency;
 
             uint32_t lastFrameCount = m_frameCount;
 
@@ -123,22 +167,49 @@ namespace DX
                 // accumulate enough tiny errors that it would drop a frame. It is better to just round 
                 // small deviations down to zero to leave things running smoothly.
 
-                if (abs(static_cast<int64_t>(timeDelta - m_targetElapsedTicks)) < TicksPerSecond / 4000) 
+                if (std::llabs(static_cast<int64_t>(timeDelta - m_targetElapsedTicks)) < static_cast<int64_t>(TicksPerSecond / 4000)) 
 				{
                     timeDelta = m_targetElapsedTicks;
                 }
 
                 m_leftOverTicks += timeDelta;
 
+                uint32_t updates = 0;
+                uint64_t updateStart = m_clock->GetCounter();
+
                 while (m_leftOverTicks >= m_targetElapsedTicks) 
 				{
+                    // 上限に達したら残りの更新は捨てる(1ステップ未満の端数は残して位相を保つ)
+                    if (m_catchUpLimit != 0 && updates == m_catchUpLimit)
+                    {
+                        uint64_t dropped = m_leftOverTicks / m_targetElapsedTicks;
+                        m_droppedUpdates += dropped;
+                        m_leftOverTicks -= dropped * m_targetElapsedTicks;
+                        break;
+                    }
+
                     m_elapsedTicks = m_targetElapsedTicks;
                     m_totalTicks += m_targetElapsedTicks;
                     m_leftOverTicks -= m_targetElapsedTicks;
                     m_frameCount++;
+                    updates++;
 
                     update();
                 }
+
+                // 更新にかかった時間が更新で進めた時間を超えていれば、追いつこうとするほど遅れるので上限を下げる
+                if (m_maxUpdatesPerTick != 0 && updates != 0)
+                {
+                    uint64_t updateTicks = CounterToTicks(m_clock->GetCounter() - updateStart);
+                    if (updateTicks > updates * m_targetElapsedTicks)
+                    {
+                        m_catchUpLimit = m_catchUpLimit > 1 ? m_catchUpLimit / 2 : 1;
+                    }
+                    else if (m_catchUpLimit < m_maxUpdatesPerTick)
+                    {
+                        m_catchUpLimit++;
+                    }
+                }
             }
             else 
 			{
@@ -157,19 +228,22 @@ namespace DX
                 m_framesThisSecond++;
             }
 
-            if (m_qpcSecondCounter >= static_cast<uint64_t>(m_qpcFrequency.QuadPart)) 
+            if (m_secondCounter >= m_frequency) 
 			{
                 m_framesPerSecond = m_framesThisSecond;
                 m_framesThisSecond = 0;
-                m_qpcSecondCounter %= m_qpcFrequency.QuadPart;
+                m_secondCounter %= m_frequency;
             }
+
+            return m_frameCount != lastFrameCount;
         }
 
     private:
-        // QPCユニットを使用するためのソースタイミングデータ
-        LARGE_INTEGER m_qpcFrequency;
-        LARGE_INTEGER m_qpcLastTime;
-        uint64_t m_qpcMaxDelta;
+        // クロックソースのユニットを使用するためのソースタイミングデータ
+        ClockSource* m_clock;
+        uint64_t m_frequency;
+        uint64_t m_lastCounter;
+        uint64_t m_maxDelta;
 
         // 標準的なテック形式を使用するための派生タイミングデータ
 		uint64_t m_elapsedTicks;
@@ -180,11 +254,20 @@ namespace DX
         uint32_t m_frameCount;
         uint32_t m_framesPerSecond;
         uint32_t m_framesThisSecond;
-        uint64_t m_qpcSecondCounter;
+        uint64_t m_secondCounter;
 
         // 固定タイムステップモードを構成するための変数
         bool m_isFixedTimeStep;
         uint64_t m_targetElapsedTicks;
+
+        // フレームレイトの上限を構成するための変数(クロックソースのユニット)
+        uint64_t m_frameInterval;
+        uint64_t m_nextFrameCounter;
+
+        // 固定タイムステップモードの追いつき処理を制限するための変数
+        uint32_t m_maxUpdatesPerTick;
+        uint32_t m_catchUpLimit;
+        uint64_t m_droppedUpdates;
     };
 }
 
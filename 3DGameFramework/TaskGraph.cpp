@@ -0,0 +1,128 @@
+﻿#include "TaskGraph.h"
+#include <stdexcept>
+#include "Profiler.h"
+
+// タスクを追加して番号を返す
+TaskGraph::TaskId TaskGraph::AddTask(const std::string& name, JobSystem::Job job)
+{
+	m_tasks.emplace_back(name, std::move(job));
+	m_validated = false;
+	return TaskId(m_tasks.size() - 1);
+}
+
+// beforeが完了してからafterを開始するように依存関係を追加する
+void TaskGraph::AddDependency(TaskId before, TaskId after)
+{
+	if (before >= m_tasks.size() || after >= m_tasks.size())
+	{
+		throw std::out_of_range("TaskGraph: invalid task id");
+	}
+	m_tasks[before].successors.push_back(after);
+	m_tasks[after].dependencyCount++;
+	m_validated = false;
+}
+
+// タスクと依存関係を削除する
+void TaskGraph::Clear()
+{
+	m_tasks.clear();
+	m_order.clear();
+	m_validated = false;
+}
+
+// 依存関係に従ってすべてのタスクを並列に実行し、完了するまで待つ
+void TaskGraph::Run(JobSystem& jobSystem)
+{
+	Validate();
+	for (Task& task : m_tasks)
+	{
+		task.remaining.store(task.dependencyCount, std::memory_order_relaxed);
+	}
+
+	// 先行タスクの無いタスクから投入する(後続は先行タスクを実行したワーカーが投入する)
+	// タスクが投げた例外はジョブシステムがカウンタに保存し、実行中のタスクがすべて終わってからWaitが投げ直す
+	JobCounter counter;
+	try
+	{
+		for (TaskId id = 0; id < m_tasks.size(); id++)
+		{
+			if (m_tasks[id].dependencyCount == 0)
+			{
+				jobSystem.Run([this, &jobSystem, id, &counter]() { Execute(jobSystem, id, counter); }, counter);
+			}
+		}
+	}
+	catch (...)
+	{
+		// 投入済みのタスクがcounterを参照しているので、終わるまで待ってから投げ直す
+		try
+		{
+			jobSystem.Wait(counter);
+		}
+		catch (...)
+		{
+		}
+		throw;
+	}
+	jobSystem.Wait(counter);
+}
+
+// 依存関係に従ってすべてのタスクを呼び出し元のスレッドで順に実行する
+void TaskGraph::RunSerial()
+{
+	Validate();
+	for (TaskId id : m_order)
+	{
+		m_tasks[id].job();
+	}
+}
+
+// 循環が無いことを確かめ、先行タスクの無いタスクの順に並べた実行順を作る
+void TaskGraph::Validate()
+{
+	if (m_validated)
+		return;
+
+	// Kahnの方法でトポロジカルソートする
+	std::vector<uint32_t> remaining(m_tasks.size());
+	m_order.clear();
+	for (TaskId id = 0; id < m_tasks.size(); id++)
+	{
+		remaining[id] = m_tasks[id].dependencyCount;
+		if (remaining[id] == 0)
+			m_order.push_back(id);
+	}
+	for (size_t i = 0; i < m_order.size(); i++)
+	{
+		for (TaskId successor : m_tasks[m_order[i]].successors)
+		{
+			if (--remaining[successor] == 0)
+				m_order.push_back(successor);
+		}
+	}
+	if (m_order.size() != m_tasks.size())
+	{
+		throw std::runtime_error("TaskGraph: dependency cycle");
+	}
+	m_validated = true;
+}
+
+// タスクを実行し、先行タスクがすべて完了した後続のタスクを投入する
+void TaskGraph::Execute(JobSystem& jobSystem, TaskId id, JobCounter& counter)
+{
+	// タスクが例外を投げた場合は後続を投入しない(例外はジョブシステムがカウンタに保存する)
+	Task& task = m_tasks[id];
+	{
+		PROFILE_SCOPE(task.name.c_str());
+		task.job();
+	}
+
+	// 後続を投入してからこのジョブが完了するので、カウンタが途中で0になることはない
+	for (TaskId successor : task.successors)
+	{
+		if (m_tasks[successor].remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			jobSystem.Run([this, &jobSystem, successor, &counter]() { Execute(jobSystem, successor, counter); }, counter);
+		}
+	}
+}
@@ -0,0 +1,84 @@
+﻿#pragma once
+#ifndef TASKGRAPH_DEFINED
+#define TASKGRAPH_DEFINED
+
+#include <atomic>
+#include <deque>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "JobSystem.h"
+
+// 依存関係を持つタスクのグラフ
+// 一度構築すれば毎フレーム同じ構造で繰り返し実行できる(例: アニメーション→変換→カリング→描画の投入)
+class TaskGraph : public NonCopyable
+{
+public:
+	// タスク番号
+	typedef uint32_t TaskId;
+
+	// コンストラクタ
+	TaskGraph() : m_validated(false)
+	{
+	}
+
+	// タスクを追加して番号を返す
+	TaskId AddTask(const std::string& name, JobSystem::Job job);
+	// beforeが完了してからafterを開始するように依存関係を追加する
+	void AddDependency(TaskId before, TaskId after);
+	// タスクと依存関係を削除する
+	void Clear();
+
+	// 依存関係に従ってすべてのタスクを並列に実行し、完了するまで待つ(循環がある場合は例外を投げる)
+	// タスクが例外を投げた場合はその後続を実行せず、実行中のタスクが終わってから最初の例外を投げ直す
+	void Run(JobSystem& jobSystem);
+	// 依存関係に従ってすべてのタスクを呼び出し元のスレッドで順に実行する(循環がある場合は例外を投げる)
+	void RunSerial();
+
+	// タスク数を取得する
+	size_t GetTaskCount() const
+	{
+		return m_tasks.size();
+	}
+	// タスク名を取得する
+	const std::string& GetName(TaskId task) const
+	{
+		return m_tasks[task].name;
+	}
+
+private:
+	// タスク
+	struct Task
+	{
+		// コンストラクタ
+		Task(const std::string& name, JobSystem::Job job) : name(name), job(std::move(job)), dependencyCount(0), remaining(0)
+		{
+		}
+
+		// 名前
+		std::string name;
+		// 処理
+		JobSystem::Job job;
+		// 後続のタスク
+		std::vector<TaskId> successors;
+		// 先行するタスク数
+		uint32_t dependencyCount;
+		// 実行中に未完了の先行タスク数
+		std::atomic<uint32_t> remaining;
+	};
+
+	// 循環が無いことを確かめ、先行タスクの無いタスクの順に並べた実行順を作る
+	void Validate();
+	// タスクを実行し、先行タスクがすべて完了した後続のタスクを投入する
+	void Execute(JobSystem& jobSystem, TaskId task, JobCounter& counter);
+
+private:
+	// タスク(要素のアドレスが変わらないようdequeで保持する)
+	std::deque<Task> m_tasks;
+	// 依存関係に矛盾しない実行順
+	std::vector<TaskId> m_order;
+	// 実行順が構造の変更後に作り直されているかどうか
+	bool m_validated;
+};
+
+#endif	// TASKGRAPH_DEFINED
@@ -0,0 +1,431 @@
+﻿#include "TransformKernel.h"
+#include <stdint.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TRANSFORMKERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVCはコンパイルオプションに関わらずAVX2の組み込み関数を使用できる
+#define TRANSFORMKERNEL_AVX2_TARGET
+#else
+#include <cpuid.h>
+#define TRANSFORMKERNEL_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	// ストライド分進めたポインタを取得する
+	inline float* Advance(float* pointer, size_t stride, size_t count)
+	{
+		return reinterpret_cast<float*>(reinterpret_cast<char*>(pointer) + stride * count);
+	}
+	inline const float* Advance(const float* pointer, size_t stride, size_t count)
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const char*>(pointer) + stride * count);
+	}
+	inline const float* const* Advance(const float* const* pointer, size_t stride, size_t count)
+	{
+		return reinterpret_cast<const float* const*>(reinterpret_cast<const char*>(pointer) + stride * count);
+	}
+	// ストライドごとに並んだポインタを取得する
+	inline const float* PointerAt(const float* const* pointers, size_t stride, size_t index)
+	{
+		return *Advance(pointers, stride, index);
+	}
+
+	// 行列の配列にそれぞれ同じ行列を右から掛ける(スカラー)
+	void MultiplyMatricesScalar(float* result, const float* matrices, const float* matrix, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const float* a = matrices + i * 16;
+			float* r = result + i * 16;
+			for (int row = 0; row < 4; row++)
+			{
+				float a0 = a[row * 4 + 0], a1 = a[row * 4 + 1], a2 = a[row * 4 + 2], a3 = a[row * 4 + 3];
+				for (int column = 0; column < 4; column++)
+				{
+					r[row * 4 + column] = a0 * matrix[column] + a1 * matrix[4 + column] + a2 * matrix[8 + column] + a3 * matrix[12 + column];
+				}
+			}
+		}
+	}
+
+	// 点の配列をアフィン変換する(スカラー)
+	void TransformPointsScalar(float* destination, size_t destinationStride,
+		const float* points, size_t pointStride, size_t count, const float* m)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const float* p = Advance(points, pointStride, i);
+			float* d = Advance(destination, destinationStride, i);
+			float x = p[0], y = p[1], z = p[2];
+			d[0] = x * m[0] + y * m[4] + z * m[8] + m[12];
+			d[1] = x * m[1] + y * m[5] + z * m[9] + m[13];
+			d[2] = x * m[2] + y * m[6] + z * m[10] + m[14];
+		}
+	}
+
+	// コントロールポイントを変換する(スカラー)
+	void ConvertControlPointsScalar(float* destination, size_t destinationStride,
+		const double* controlPoints, size_t count, const double* m)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const double* p = controlPoints + i * 4;
+			float* d = Advance(destination, destinationStride, i);
+			d[0] = float(p[0] * m[0] + p[1] * m[4] + p[2] * m[8] + m[12]);
+			d[1] = float(p[0] * m[1] + p[1] * m[5] + p[2] * m[9] + m[13]);
+			d[2] = float(p[0] * m[2] + p[1] * m[6] + p[2] * m[10] + m[14]);
+		}
+	}
+
+	// インスタンスデータを作成する(スカラー)
+	void PackInstancesScalar(float* destination, const float* const* worlds, const float* const* colors, size_t stride, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const float* w = PointerAt(worlds, stride, i);
+			const float* c = PointerAt(colors, stride, i);
+			float* d = destination + i * 16;
+			for (int row = 0; row < 3; row++)
+			{
+				d[row * 4 + 0] = w[row + 0];
+				d[row * 4 + 1] = w[row + 4];
+				d[row * 4 + 2] = w[row + 8];
+				d[row * 4 + 3] = w[row + 12];
+			}
+			d[12] = c[0];
+			d[13] = c[1];
+			d[14] = c[2];
+			d[15] = c[3];
+		}
+	}
+
+#ifdef TRANSFORMKERNEL_X86
+	// 4要素のうちx, y, zの3要素を書き込む
+	inline void StoreFloat3(float* destination, __m128 value)
+	{
+		_mm_storel_pi(reinterpret_cast<__m64*>(destination), value);
+		_mm_store_ss(destination + 2, _mm_movehl_ps(value, value));
+	}
+
+	// 行列の配列にそれぞれ同じ行列を右から掛ける(SSE2)
+	void MultiplyMatricesSSE2(float* result, const float* matrices, const float* matrix, size_t count)
+	{
+		__m128 b0 = _mm_loadu_ps(matrix + 0);
+		__m128 b1 = _mm_loadu_ps(matrix + 4);
+		__m128 b2 = _mm_loadu_ps(matrix + 8);
+		__m128 b3 = _mm_loadu_ps(matrix + 12);
+		for (size_t i = 0; i < count * 4; i++)
+		{
+			__m128 a = _mm_loadu_ps(matrices + i * 4);
+			__m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+			_mm_storeu_ps(result + i * 4, r);
+		}
+	}
+
+	// 点の配列をアフィン変換する(SSE2)
+	void TransformPointsSSE2(float* destination, size_t destinationStride,
+		const float* points, size_t pointStride, size_t count, const float* matrix)
+	{
+		__m128 m0 = _mm_loadu_ps(matrix + 0);
+		__m128 m1 = _mm_loadu_ps(matrix + 4);
+		__m128 m2 = _mm_loadu_ps(matrix + 8);
+		__m128 m3 = _mm_loadu_ps(matrix + 12);
+		for (size_t i = 0; i < count; i++)
+		{
+			const float* p = Advance(points, pointStride, i);
+			__m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p[0]), m0), _mm_mul_ps(_mm_set1_ps(p[1]), m1));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(p[2]), m2));
+			r = _mm_add_ps(r, m3);
+			StoreFloat3(Advance(destination, destinationStride, i), r);
+		}
+	}
+
+	// コントロールポイントを変換する(SSE2)
+	void ConvertControlPointsSSE2(float* destination, size_t destinationStride,
+		const double* controlPoints, size_t count, const double* m)
+	{
+		__m128d m0xy = _mm_loadu_pd(m + 0), m0zw = _mm_loadu_pd(m + 2);
+		__m128d m1xy = _mm_loadu_pd(m + 4), m1zw = _mm_loadu_pd(m + 6);
+		__m128d m2xy = _mm_loadu_pd(m + 8), m2zw = _mm_loadu_pd(m + 10);
+		__m128d m3xy = _mm_loadu_pd(m + 12), m3zw = _mm_loadu_pd(m + 14);
+		for (size_t i = 0; i < count; i++)
+		{
+			const double* p = controlPoints + i * 4;
+			__m128d x = _mm_set1_pd(p[0]), y = _mm_set1_pd(p[1]), z = _mm_set1_pd(p[2]);
+			__m128d xy = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(x, m0xy), _mm_mul_pd(y, m1xy)), _mm_mul_pd(z, m2xy)), m3xy);
+			__m128d zw = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(x, m0zw), _mm_mul_pd(y, m1zw)), _mm_mul_pd(z, m2zw)), m3zw);
+			StoreFloat3(Advance(destination, destinationStride, i), _mm_movelh_ps(_mm_cvtpd_ps(xy), _mm_cvtpd_ps(zw)));
+		}
+	}
+
+	// インスタンスデータを作成する(SSE2)
+	void PackInstancesSSE2(float* destination, const float* const* worlds, const float* const* colors, size_t stride, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const float* w = PointerAt(worlds, stride, i);
+			__m128 r0 = _mm_loadu_ps(w + 0);
+			__m128 r1 = _mm_loadu_ps(w + 4);
+			__m128 r2 = _mm_loadu_ps(w + 8);
+			__m128 r3 = _mm_loadu_ps(w + 12);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			float* d = destination + i * 16;
+			_mm_storeu_ps(d + 0, r0);
+			_mm_storeu_ps(d + 4, r1);
+			_mm_storeu_ps(d + 8, r2);
+			_mm_storeu_ps(d + 12, _mm_loadu_ps(PointerAt(colors, stride, i)));
+		}
+	}
+
+	// 行列の配列にそれぞれ同じ行列を右から掛ける(AVX2、2行ずつ処理する)
+	TRANSFORMKERNEL_AVX2_TARGET void MultiplyMatricesAVX2(float* result, const float* matrices, const float* matrix, size_t count)
+	{
+		__m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(matrix + 0));
+		__m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(matrix + 4));
+		__m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(matrix + 8));
+		__m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(matrix + 12));
+		for (size_t i = 0; i < count * 2; i++)
+		{
+			__m256 a = _mm256_loadu_ps(matrices + i * 8);
+			__m256 r = _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+			r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+			_mm256_storeu_ps(result + i * 8, r);
+		}
+	}
+
+	// 点の配列をアフィン変換する(AVX2、2点を上下の128ビットに載せて処理する)
+	TRANSFORMKERNEL_AVX2_TARGET void TransformPointsAVX2(float* destination, size_t destinationStride,
+		const float* points, size_t pointStride, size_t count, const float* matrix)
+	{
+		__m256 m0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(matrix + 0));
+		__m256 m1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(matrix + 4));
+		__m256 m2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(matrix + 8));
+		__m256 m3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(matrix + 12));
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2)
+		{
+			const float* p0 = Advance(points, pointStride, i);
+			const float* p1 = Advance(points, pointStride, i + 1);
+			__m256 x = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(p0[0])), _mm_set1_ps(p1[0]), 1);
+			__m256 y = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(p0[1])), _mm_set1_ps(p1[1]), 1);
+			__m256 z = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(p0[2])), _mm_set1_ps(p1[2]), 1);
+			__m256 r = _mm256_add_ps(_mm256_mul_ps(x, m0), _mm256_mul_ps(y, m1));
+			r = _mm256_add_ps(r, _mm256_mul_ps(z, m2));
+			r = _mm256_add_ps(r, m3);
+			StoreFloat3(Advance(destination, destinationStride, i), _mm256_castps256_ps128(r));
+			StoreFloat3(Advance(destination, destinationStride, i + 1), _mm256_extractf128_ps(r, 1));
+		}
+		TransformPointsSSE2(Advance(destination, destinationStride, i), destinationStride,
+			Advance(points, pointStride, i), pointStride, count - i, matrix);
+	}
+
+	// インスタンスデータを作成する(AVX2、2つのインスタンスを上下の128ビットに載せて転置する)
+	TRANSFORMKERNEL_AVX2_TARGET void PackInstancesAVX2(float* destination, const float* const* worlds, const float* const* colors, size_t stride, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2)
+		{
+			const float* w0 = PointerAt(worlds, stride, i);
+			const float* w1 = PointerAt(worlds, stride, i + 1);
+			__m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(w0 + 0)), _mm_loadu_ps(w1 + 0), 1);
+			__m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(w0 + 4)), _mm_loadu_ps(w1 + 4), 1);
+			__m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(w0 + 8)), _mm_loadu_ps(w1 + 8), 1);
+			__m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(w0 + 12)), _mm_loadu_ps(w1 + 12), 1);
+			__m256 color = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(PointerAt(colors, stride, i))),
+				_mm_loadu_ps(PointerAt(colors, stride, i + 1)), 1);
+
+			// 128ビットごとに転置して上3行を取り出す
+			__m256 t0 = _mm256_unpacklo_ps(r0, r1);
+			__m256 t1 = _mm256_unpacklo_ps(r2, r3);
+			__m256 t2 = _mm256_unpackhi_ps(r0, r1);
+			__m256 t3 = _mm256_unpackhi_ps(r2, r3);
+			__m256 c0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 c1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+			__m256 c2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+
+			float* d = destination + i * 16;
+			_mm256_storeu_ps(d + 0, _mm256_permute2f128_ps(c0, c1, 0x20));
+			_mm256_storeu_ps(d + 8, _mm256_permute2f128_ps(c2, color, 0x20));
+			_mm256_storeu_ps(d + 16, _mm256_permute2f128_ps(c0, c1, 0x31));
+			_mm256_storeu_ps(d + 24, _mm256_permute2f128_ps(c2, color, 0x31));
+		}
+		PackInstancesSSE2(destination + i * 16, Advance(worlds, stride, i), Advance(colors, stride, i), stride, count - i);
+	}
+
+	// コントロールポイントを変換する(AVX2、1点を4要素まとめて処理する)
+	TRANSFORMKERNEL_AVX2_TARGET void ConvertControlPointsAVX2(float* destination, size_t destinationStride,
+		const double* controlPoints, size_t count, const double* m)
+	{
+		__m256d m0 = _mm256_loadu_pd(m + 0);
+		__m256d m1 = _mm256_loadu_pd(m + 4);
+		__m256d m2 = _mm256_loadu_pd(m + 8);
+		__m256d m3 = _mm256_loadu_pd(m + 12);
+		for (size_t i = 0; i < count; i++)
+		{
+			const double* p = controlPoints + i * 4;
+			__m256d r = _mm256_add_pd(_mm256_mul_pd(_mm256_broadcast_sd(p + 0), m0), _mm256_mul_pd(_mm256_broadcast_sd(p + 1), m1));
+			r = _mm256_add_pd(r, _mm256_mul_pd(_mm256_broadcast_sd(p + 2), m2));
+			r = _mm256_add_pd(r, m3);
+			StoreFloat3(Advance(destination, destinationStride, i), _mm256_cvtpd_ps(r));
+		}
+	}
+
+	// CPUIDを実行する
+	void CpuId(int leaf, int subLeaf, uint32_t registers[4])
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuidex(info, leaf, subLeaf);
+		for (int i = 0; i < 4; i++)
+			registers[i] = uint32_t(info[i]);
+#else
+		__cpuid_count(leaf, subLeaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+	}
+
+	// OSが保存するレジスタの状態を取得する
+	uint64_t GetExtendedControlRegister()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		uint32_t eax, edx;
+		__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (uint64_t(edx) << 32) | eax;
+#endif
+	}
+#endif
+
+	// CPUが対応している最上位の命令セットを判定する
+	TransformKernel::InstructionSet DetectInstructionSet()
+	{
+#ifdef TRANSFORMKERNEL_X86
+		uint32_t registers[4];
+		CpuId(0, 0, registers);
+		uint32_t maxLeaf = registers[0];
+		CpuId(1, 0, registers);
+		bool sse2 = (registers[3] & (1u << 26)) != 0;
+		bool osxsave = (registers[2] & (1u << 27)) != 0;
+		bool avx = (registers[2] & (1u << 28)) != 0;
+		if (!sse2)
+			return TransformKernel::SCALAR;
+
+		// AVXの256ビットレジスタをOSが保存する場合だけAVX2を使用する
+		if (maxLeaf >= 7 && osxsave && avx && (GetExtendedControlRegister() & 0x6) == 0x6)
+		{
+			CpuId(7, 0, registers);
+			if (registers[1] & (1u << 5))
+				return TransformKernel::AVX2;
+		}
+		return TransformKernel::SSE2;
+#else
+		return TransformKernel::SCALAR;
+#endif
+	}
+
+	// 使用中の命令セット
+	TransformKernel::InstructionSet& CurrentInstructionSet()
+	{
+		static TransformKernel::InstructionSet instructionSet = TransformKernel::GetSupportedInstructionSet();
+		return instructionSet;
+	}
+}
+
+// CPUが対応している最上位の命令セットを取得する
+TransformKernel::InstructionSet TransformKernel::GetSupportedInstructionSet()
+{
+	static const InstructionSet supported = DetectInstructionSet();
+	return supported;
+}
+
+// 使用中の命令セットを取得する
+TransformKernel::InstructionSet TransformKernel::GetInstructionSet()
+{
+	return CurrentInstructionSet();
+}
+
+// 使用する命令セットを設定する
+void TransformKernel::SetInstructionSet(InstructionSet instructionSet)
+{
+	InstructionSet supported = GetSupportedInstructionSet();
+	CurrentInstructionSet() = instructionSet < supported ? instructionSet : supported;
+}
+
+// 命令セットの名前を取得する
+const char* TransformKernel::GetInstructionSetName(InstructionSet instructionSet)
+{
+	switch (instructionSet)
+	{
+	case SSE2: return "SSE2";
+	case AVX2: return "AVX2";
+	default: return "Scalar";
+	}
+}
+
+// 行列の配列にそれぞれ同じ行列を右から掛ける
+void TransformKernel::MultiplyMatrices(float* result, const float* matrices, const float* matrix, size_t count)
+{
+#ifdef TRANSFORMKERNEL_X86
+	switch (CurrentInstructionSet())
+	{
+	case AVX2: MultiplyMatricesAVX2(result, matrices, matrix, count); return;
+	case SSE2: MultiplyMatricesSSE2(result, matrices, matrix, count); return;
+	default: break;
+	}
+#endif
+	MultiplyMatricesScalar(result, matrices, matrix, count);
+}
+
+// 点の配列をアフィン変換する
+void TransformKernel::TransformPoints(float* destination, size_t destinationStride,
+	const float* points, size_t pointStride, size_t count, const float* matrix)
+{
+#ifdef TRANSFORMKERNEL_X86
+	switch (CurrentInstructionSet())
+	{
+	case AVX2: TransformPointsAVX2(destination, destinationStride, points, pointStride, count, matrix); return;
+	case SSE2: TransformPointsSSE2(destination, destinationStride, points, pointStride, count, matrix); return;
+	default: break;
+	}
+#endif
+	TransformPointsScalar(destination, destinationStride, points, pointStride, count, matrix);
+}
+
+// FBXのコントロールポイントを単精度の位置に変換する
+void TransformKernel::ConvertControlPoints(float* destination, size_t destinationStride,
+	const double* controlPoints, size_t count, const double* matrix)
+{
+#ifdef TRANSFORMKERNEL_X86
+	switch (CurrentInstructionSet())
+	{
+	case AVX2: ConvertControlPointsAVX2(destination, destinationStride, controlPoints, count, matrix); return;
+	case SSE2: ConvertControlPointsSSE2(destination, destinationStride, controlPoints, count, matrix); return;
+	default: break;
+	}
+#endif
+	ConvertControlPointsScalar(destination, destinationStride, controlPoints, count, matrix);
+}
+
+// ワールド行列と色のポインタの配列からインスタンスデータを作成する
+void TransformKernel::PackInstances(float* destination, const float* const* worlds, const float* const* colors, size_t stride, size_t count)
+{
+#ifdef TRANSFORMKERNEL_X86
+	switch (CurrentInstructionSet())
+	{
+	case AVX2: PackInstancesAVX2(destination, worlds, colors, stride, count); return;
+	case SSE2: PackInstancesSSE2(destination, worlds, colors, stride, count); return;
+	default: break;
+	}
+#endif
+	PackInstancesScalar(destination, worlds, colors, stride, count);
+}
@@ -0,0 +1,47 @@
+﻿#pragma once
+#ifndef TRANSFORMKERNEL_DEFINED
+#define TRANSFORMKERNEL_DEFINED
+
+#include <stddef.h>
+
+// 行列と頂点の配列をまとめて変換するSIMDカーネル(CPUの対応命令を実行時に判定して切り替える)
+// 行列はすべて行優先、行ベクトル規約の16要素の配列とする
+class TransformKernel
+{
+public:
+	// 命令セット
+	enum InstructionSet
+	{
+		// スカラー(SIMDを使用しない)
+		SCALAR,
+		// SSE2
+		SSE2,
+		// AVX2
+		AVX2,
+	};
+
+	// CPUが対応している最上位の命令セットを取得する
+	static InstructionSet GetSupportedInstructionSet();
+	// 使用中の命令セットを取得する
+	static InstructionSet GetInstructionSet();
+	// 使用する命令セットを設定する(CPUが対応していない場合は対応している最上位のものになる)
+	// 他のスレッドがカーネルを使用していない時に呼び出すこと
+	static void SetInstructionSet(InstructionSet instructionSet);
+	// 命令セットの名前を取得する
+	static const char* GetInstructionSetName(InstructionSet instructionSet);
+
+	// 行列の配列にそれぞれ同じ行列を右から掛ける(result[i] = matrices[i] * matrix)
+	static void MultiplyMatrices(float* result, const float* matrices, const float* matrix, size_t count);
+	// 点の配列をアフィン変換する(ストライドはバイト単位、出力はx, y, zの3要素)
+	static void TransformPoints(float* destination, size_t destinationStride,
+		const float* points, size_t pointStride, size_t count, const float* matrix);
+	// ワールド行列(16要素)と色(4要素)のポインタの配列から、行列を転置した上3行と色を並べた16要素ずつのインスタンスデータを書き込む
+	// ポインタはどちらもstrideバイトごとに並んでいること(構造体の配列の2つのメンバーを直接渡せる)
+	static void PackInstances(float* destination, const float* const* worlds, const float* const* colors, size_t stride, size_t count);
+	// FBXのコントロールポイント(x, y, z, wのdouble4要素)を倍精度で変換し単精度の位置に変換する
+	// 演算順序はスカラー版と同じなので、どの命令セットでも結果は一致する
+	static void ConvertControlPoints(float* destination, size_t destinationStride,
+		const double* controlPoints, size_t count, const double* matrix);
+};
+
+#endif	// TRANSFORMKERNEL_DEFINED
@@ -0,0 +1,176 @@
+﻿#include "VertexQuantizer.h"
+#include <math.h>
+#include <string.h>
+
+static_assert(sizeof(QuantizedVertex) == 12, "QuantizedVertex layout must be stable");
+
+namespace
+{
+	// 0～1の値を段階数stepsの整数に丸める
+	uint32_t QuantizeUnorm(float value, uint32_t steps)
+	{
+		value = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+		return uint32_t(value * float(steps) + 0.5f);
+	}
+
+	// 符号を取得する(0は正とする)
+	float Sign(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+}
+
+// 頂点を境界ボックスに対して量子化する
+void VertexQuantizer::Quantize(QuantizedVertex* destination, const MeshVertex* vertices, size_t count, const MeshBounds& bounds)
+{
+	// 厚みの無い軸はすべて0にする
+	float scale[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = bounds.maximum[axis] - bounds.minimum[axis];
+		scale[axis] = extent > 0.0f ? 1.0f / extent : 0.0f;
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		const MeshVertex& vertex = vertices[i];
+		QuantizedVertex& quantized = destination[i];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			quantized.position[axis] = uint16_t(QuantizeUnorm((vertex.position[axis] - bounds.minimum[axis]) * scale[axis], POSITION_STEPS));
+		}
+		quantized.position[3] = uint16_t(POSITION_STEPS);
+		for (int channel = 0; channel < 4; channel++)
+		{
+			quantized.color[channel] = uint8_t(QuantizeUnorm(vertex.color[channel], COLOR_STEPS));
+		}
+	}
+}
+
+// 量子化した頂点を復号する(GPUと同じく正規化してから復号行列と同じ計算で戻す)
+void VertexQuantizer::Dequantize(MeshVertex* destination, const QuantizedVertex* vertices, size_t count, const MeshBounds& bounds)
+{
+	float extent[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		extent[axis] = bounds.maximum[axis] - bounds.minimum[axis];
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		const QuantizedVertex& quantized = vertices[i];
+		MeshVertex& vertex = destination[i];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			vertex.position[axis] = float(quantized.position[axis]) / float(POSITION_STEPS) * extent[axis] + bounds.minimum[axis];
+		}
+		for (int channel = 0; channel < 4; channel++)
+		{
+			vertex.color[channel] = float(quantized.color[channel]) / float(COLOR_STEPS);
+		}
+	}
+}
+
+// 正規化した位置を境界ボックス内の位置に戻す行列を作成する
+void VertexQuantizer::GetDecodeMatrix(const MeshBounds& bounds, float matrix[16])
+{
+	memset(matrix, 0, sizeof(float) * 16);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		matrix[axis * 5] = bounds.maximum[axis] - bounds.minimum[axis];
+		matrix[12 + axis] = bounds.minimum[axis];
+	}
+	matrix[15] = 1.0f;
+}
+
+// 単位ベクトルを八面体に投影し、2つの16ビット符号付き正規化整数にする
+void VertexQuantizer::EncodeOctahedral(const float normal[3], int16_t encoded[2])
+{
+	// L1ノルムで正規化して八面体の面に投影し、下半分は対角線で折り返して上半分に重ねる
+	float length = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+	float x = length > 0.0f ? normal[0] / length : 0.0f;
+	float y = length > 0.0f ? normal[1] / length : 0.0f;
+	if (length > 0.0f && normal[2] < 0.0f)
+	{
+		float folded = (1.0f - fabsf(y)) * Sign(x);
+		y = (1.0f - fabsf(x)) * Sign(y);
+		x = folded;
+	}
+	encoded[0] = int16_t(lroundf(fmaxf(fminf(x, 1.0f), -1.0f) * float(NORMAL_STEPS)));
+	encoded[1] = int16_t(lroundf(fmaxf(fminf(y, 1.0f), -1.0f) * float(NORMAL_STEPS)));
+}
+
+// 八面体符号化した単位ベクトルを復号する
+void VertexQuantizer::DecodeOctahedral(const int16_t encoded[2], float normal[3])
+{
+	float x = fmaxf(float(encoded[0]) / float(NORMAL_STEPS), -1.0f);
+	float y = fmaxf(float(encoded[1]) / float(NORMAL_STEPS), -1.0f);
+	float z = 1.0f - fabsf(x) - fabsf(y);
+	if (z < 0.0f)
+	{
+		float unfolded = (1.0f - fabsf(y)) * Sign(x);
+		y = (1.0f - fabsf(x)) * Sign(y);
+		x = unfolded;
+	}
+	float length = sqrtf(x * x + y * y + z * z);
+	normal[0] = x / length;
+	normal[1] = y / length;
+	normal[2] = z / length;
+}
+
+// 半精度浮動小数点数に変換する
+uint16_t VertexQuantizer::FloatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t magnitude = bits & 0x7FFFFFFF;
+
+	// 無限大とNaN(NaNは仮数の最上位ビットを立てて保つ)
+	if (magnitude >= 0x7F800000)
+		return uint16_t(sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x0200 : 0));
+	// 65520以上は最大値65504を超えて丸められるので無限大
+	if (magnitude >= 0x477FF000)
+		return uint16_t(sign | 0x7C00);
+	// 2^-14未満は非正規化数(2^-25以下は0)
+	if (magnitude < 0x38800000)
+	{
+		if (magnitude <= 0x33000000)
+			return uint16_t(sign);
+		uint32_t mantissa = (magnitude & 0x007FFFFF) | 0x00800000;
+		uint32_t shift = 126 - (magnitude >> 23);
+		uint32_t half = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t midpoint = 1u << (shift - 1);
+		if (remainder > midpoint || (remainder == midpoint && (half & 1)))
+			half++;
+		return uint16_t(sign | half);
+	}
+
+	// 指数のバイアスを127から15に付け替え、仮数の下位13ビットを最近接偶数に丸める(繰り上がりは指数に伝わる)
+	uint32_t half = (magnitude - 0x38000000) >> 13;
+	uint32_t remainder = magnitude & 0x1FFF;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+		half++;
+	return uint16_t(sign | half);
+}
+
+// 半精度浮動小数点数を単精度に戻す
+float VertexQuantizer::HalfToFloat(uint16_t value)
+{
+	uint32_t sign = uint32_t(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1F;
+	uint32_t mantissa = value & 0x03FF;
+	uint32_t bits;
+	if (exponent == 0)
+	{
+		// 0と非正規化数
+		float magnitude = ldexpf(float(mantissa), -24);
+		return sign ? -magnitude : magnitude;
+	}
+	if (exponent == 0x1F)
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	else
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
@@ -0,0 +1,49 @@
+﻿#pragma once
+#ifndef VERTEXQUANTIZER_DEFINED
+#define VERTEXQUANTIZER_DEFINED
+
+#include <stddef.h>
+#include <stdint.h>
+#include "MeshData.h"
+
+// 量子化した頂点(MeshVertexの28バイトを12バイトにする)
+// GPUはR16G16B16A16_UNORMとR8G8B8A8_UNORMとして読み、位置は復号行列をワールド行列の前に掛けて戻す
+struct QuantizedVertex
+{
+	// 境界ボックスに対する位置(16ビットの正規化整数、wは1になるよう常に最大値)
+	uint16_t position[4];
+	// 色(RGBA8)
+	uint8_t color[4];
+};
+
+// 頂点属性を量子化・復号するクラス
+// 位置は境界ボックスに対する16ビット、色はRGBA8にする
+// 法線の八面体符号化とUVの半精度浮動小数点数は、頂点に法線とUVを持たせたときのために単独の関数として用意する
+class VertexQuantizer
+{
+public:
+	// 位置の量子化の段階数
+	static const uint32_t POSITION_STEPS = 0xFFFF;
+	// 色の量子化の段階数
+	static const uint32_t COLOR_STEPS = 0xFF;
+	// 八面体符号化の成分の段階数
+	static const int32_t NORMAL_STEPS = 0x7FFF;
+
+	// 頂点を境界ボックスに対して量子化する(境界ボックスの外の位置は境界に丸める)
+	static void Quantize(QuantizedVertex* destination, const MeshVertex* vertices, size_t count, const MeshBounds& bounds);
+	// 量子化した頂点を復号する
+	static void Dequantize(MeshVertex* destination, const QuantizedVertex* vertices, size_t count, const MeshBounds& bounds);
+	// 正規化した位置(0～1)を境界ボックス内の位置に戻す行列(行ベクトル形式)を作成する
+	static void GetDecodeMatrix(const MeshBounds& bounds, float matrix[16]);
+
+	// 単位ベクトルを八面体に投影し、2つの16ビット符号付き正規化整数にする
+	static void EncodeOctahedral(const float normal[3], int16_t encoded[2]);
+	// 八面体符号化した単位ベクトルを復号する
+	static void DecodeOctahedral(const int16_t encoded[2], float normal[3]);
+	// 半精度浮動小数点数に変換する(最近接偶数丸め、範囲外は無限大)
+	static uint16_t FloatToHalf(float value);
+	// 半精度浮動小数点数を単精度に戻す
+	static float HalfToFloat(uint16_t value);
+};
+
+#endif	// VERTEXQUANTIZER_DEFINED
@@ -0,0 +1,141 @@
+﻿#pragma once
+#ifndef WORKSTEALINGDEQUE_DEFINED
+#define WORKSTEALINGDEQUE_DEFINED
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+#include "NonCopyable.h"
+
+// 所有スレッドが末尾に積んで末尾から取り出し、他のスレッドが先頭から盗み取るロックフリーの両端キュー
+// (Chase-Levのデック。メモリ順序はLe, Pop, Cohen, Nardelli "Correct and Efficient Work-Stealing for Weak Memory Models"に従う)
+// Tはアトミックに読み書きできる型(ポインタなど)であること
+template<typename T>
+class WorkStealingDeque : public NonCopyable
+{
+public:
+	// 最初の容量(2のべき乗)
+	static const int64_t INITIAL_CAPACITY = 256;
+
+	// コンストラクタ
+	WorkStealingDeque() : m_top(0), m_bottom(0)
+	{
+		m_arrays.push_back(std::make_unique<Array>(int64_t(INITIAL_CAPACITY)));
+		m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+	}
+
+	// 末尾に積む(所有スレッドのみ)
+	void Push(T item)
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		int64_t top = m_top.load(std::memory_order_acquire);
+		Array* array = m_array.load(std::memory_order_relaxed);
+		if (bottom - top > array->capacity - 1)
+		{
+			array = Grow(array, top, bottom);
+		}
+		array->Put(bottom, item);
+		// 論文の解放フェンスと緩和ストアの組の代わりに解放ストアを使う(x86では同じ命令になり、スレッドサニタイザも解釈できる)
+		m_bottom.store(bottom + 1, std::memory_order_release);
+	}
+
+	// 末尾から取り出す(所有スレッドのみ。空の場合はfalseを返す)
+	bool Pop(T& item)
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		Array* array = m_array.load(std::memory_order_relaxed);
+		m_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+
+		if (top > bottom)
+		{
+			// 空だった
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		item = array->Get(bottom);
+		if (top == bottom)
+		{
+			// 最後の1つは盗み取りと競合するので先頭を進めて確保する
+			bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return won;
+		}
+		return true;
+	}
+
+	// 先頭から盗み取る(任意のスレッド。空または他のスレッドと競合した場合はfalseを返す)
+	bool Steal(T& item)
+	{
+		int64_t top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = m_bottom.load(std::memory_order_acquire);
+		if (top >= bottom)
+			return false;
+
+		Array* array = m_array.load(std::memory_order_acquire);
+		item = array->Get(top);
+		return m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+	// 要素数の概算を取得する
+	int64_t GetSize() const
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+		return bottom > top ? bottom - top : 0;
+	}
+
+private:
+	// 循環配列
+	struct Array
+	{
+		// コンストラクタ
+		explicit Array(int64_t capacity) : capacity(capacity), items(new std::atomic<T>[size_t(capacity)])
+		{
+		}
+		// 要素を取得する
+		T Get(int64_t index) const
+		{
+			return items[size_t(index & (capacity - 1))].load(std::memory_order_relaxed);
+		}
+		// 要素を設定する
+		void Put(int64_t index, T item)
+		{
+			items[size_t(index & (capacity - 1))].store(item, std::memory_order_relaxed);
+		}
+
+		// 容量
+		int64_t capacity;
+		// 要素
+		std::unique_ptr<std::atomic<T>[]> items;
+	};
+
+	// 容量を2倍にした配列に移す(盗み取り中のスレッドが古い配列を読む可能性があるので古い配列は破棄しない)
+	Array* Grow(Array* array, int64_t top, int64_t bottom)
+	{
+		m_arrays.push_back(std::make_unique<Array>(array->capacity * 2));
+		Array* grown = m_arrays.back().get();
+		for (int64_t i = top; i < bottom; i++)
+		{
+			grown->Put(i, array->Get(i));
+		}
+		m_array.store(grown, std::memory_order_release);
+		return grown;
+	}
+
+private:
+	// 盗み取る位置
+	std::atomic<int64_t> m_top;
+	// 積む位置
+	std::atomic<int64_t> m_bottom;
+	// 現在の配列
+	std::atomic<Array*> m_array;
+	// 確保した配列(所有スレッドのみが追加する)
+	std::vector<std::unique_ptr<Array>> m_arrays;
+};
+
+#endif	// WORKSTEALINGDEQUE_DEFINED
@@ -0,0 +1,32 @@
+﻿#pragma once
+#ifndef BENCHMARKCAMERA_DEFINED
+#define BENCHMARKCAMERA_DEFINED
+
+#include <math.h>
+
+// 原点から+x方向を見る右手系のビュー行列と透視射影行列の積を作成する(行優先、行ベクトル規約)
+// 視野角45度、アスペクト比4:3、近平面0.1、遠平面100
+inline void CreateBenchmarkViewProjection(float* result)
+{
+	const float fieldOfView = 3.14159265f / 4.0f, aspect = 4.0f / 3.0f, nearZ = 0.1f, farZ = 100.0f;
+	const float view[16] = { 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+	float height = 1.0f / tanf(fieldOfView / 2.0f);
+	float projection[16] = {};
+	projection[0] = height / aspect;
+	projection[5] = height;
+	projection[10] = farZ / (nearZ - farZ);
+	projection[11] = -1.0f;
+	projection[14] = nearZ * farZ / (nearZ - farZ);
+	for (int row = 0; row < 4; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			float sum = 0.0f;
+			for (int k = 0; k < 4; k++)
+				sum += view[row * 4 + k] * projection[k * 4 + column];
+			result[row * 4 + column] = sum;
+		}
+	}
+}
+
+#endif	// BENCHMARKCAMERA_DEFINED
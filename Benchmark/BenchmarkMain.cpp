@@ -0,0 +1,426 @@
+﻿// BenchmarkMain.cpp - 生成したシーンでフレームのCPU側の処理を計測し、結果をJSONで出力・比較する
+//
+// FrameBenchmark [-frames N] [-repeat N] [-warmup N] [-scene 名前] [-isa scalar|sse2|avx2] [-label ラベル] [-output ファイル]
+//     標準のシーン(または指定したシーン)を計測し、要約を表示してJSON形式のレポートを書き出す
+//     シーンを順に切り替えながら計測を繰り返すので、計測中の負荷の変化はすべてのシーンに均等に表れる
+// FrameBenchmark -compare 基準のレポート 現在のレポート [-threshold 0.05] [-confidence 0.99]
+//     2つのレポートを比較し、有意に遅くなった処理段階があれば終了コード1を返す
+// FrameBenchmark -list
+//     標準のシーンの一覧を表示する
+// FrameBenchmark -vertices [-repeat N] [-scene 名前]
+//     シーンの形状の頂点を量子化したときのメモリ量と、量子化・復号・頂点の読み出しと変換の速度、復号の誤差を表示する
+
+#include <algorithm>
+#include <ctype.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+#include "BenchmarkReport.h"
+#include "BenchmarkTimer.h"
+#include "FrameBenchmark.h"
+#include "FrameClock.h"
+#include "TransformKernel.h"
+#include "VertexQuantizer.h"
+
+namespace
+{
+	// シーンの乱数の種(同じ種なら毎回同じシーンになる)
+	const uint32_t SCENE_SEED = 12345;
+	// 頂点の速度の計測で、キャッシュに収まらないよう形状を繰り返して並べる頂点数
+	const size_t STREAM_VERTICES = size_t(1) << 22;
+
+	// 使い方を表示する
+	void PrintUsage()
+	{
+		std::cerr << "usage: FrameBenchmark [-frames N] [-repeat N] [-warmup N] [-scene name] [-isa scalar|sse2|avx2] [-label text] [-output file]\n"
+			<< "       FrameBenchmark -compare baseline.json current.json [-threshold 0.05] [-confidence 0.99]\n"
+			<< "       FrameBenchmark -list\n"
+			<< "       FrameBenchmark -vertices [-repeat N] [-scene name]" << std::endl;
+	}
+
+	// オプションの値を取得する(無い場合は例外を投げる)
+	const char* OptionValue(int argc, char* argv[], int& index)
+	{
+		if (index + 1 >= argc)
+			throw std::invalid_argument(std::string("missing value for ") + argv[index]);
+		return argv[++index];
+	}
+
+	// 名前から命令セットを取得する
+	TransformKernel::InstructionSet ParseInstructionSet(const std::string& name)
+	{
+		const TransformKernel::InstructionSet sets[] = { TransformKernel::SCALAR, TransformKernel::SSE2, TransformKernel::AVX2 };
+		for (TransformKernel::InstructionSet set : sets)
+		{
+			std::string setName = TransformKernel::GetInstructionSetName(set);
+			if (setName.size() == name.size() && std::equal(setName.begin(), setName.end(), name.begin(),
+				[](char a, char b) { return tolower(a) == tolower(b); }))
+			{
+				return set;
+			}
+		}
+		throw std::invalid_argument("unknown instruction set " + name);
+	}
+
+	// 計測中のシーン
+	struct SceneRun
+	{
+		// 設定
+		const SceneDescription* description;
+		// 生成したシーン
+		GeneratedScene scene;
+		// 計測
+		std::unique_ptr<FrameBenchmark> benchmark;
+		// 処理段階(最後はフレーム全体)ごと、繰り返しごとのフレームの時間
+		std::vector<std::vector<std::vector<double>>> samples;
+	};
+
+	// 1回分のフレームを計測する(繰り返しごとに同じフレーム番号を使うので、どの繰り返しも同じ処理になる)
+	void MeasureRepetition(SceneRun& run, uint32_t warmupFrames, uint32_t frames)
+	{
+		// 最初のフレームはキャッシュと作業領域の確保の影響を受けるので計測から除く
+		double stageSeconds[FrameBenchmark::STAGE_COUNT];
+		for (uint32_t frame = 0; frame < warmupFrames; frame++)
+			run.benchmark->RunFrame(frame, stageSeconds);
+
+		for (std::vector<std::vector<double>>& stage : run.samples)
+			stage.emplace_back();
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			run.benchmark->RunFrame(warmupFrames + frame, stageSeconds);
+			double total = 0.0;
+			for (int stage = 0; stage < FrameBenchmark::STAGE_COUNT; stage++)
+			{
+				run.samples[stage].back().push_back(stageSeconds[stage]);
+				total += stageSeconds[stage];
+			}
+			run.samples[FrameBenchmark::STAGE_COUNT].back().push_back(total);
+		}
+	}
+
+	// 計測したシーンのレポートを作成する
+	SceneReport MakeSceneReport(const SceneRun& run)
+	{
+		const SceneDescription& description = *run.description;
+		const GeneratedScene& scene = run.scene;
+		const FrameBenchmark& benchmark = *run.benchmark;
+		SceneReport report;
+		report.name = description.name;
+		report.nodes = scene.sceneGraph.GetNodeCount();
+		report.meshes = scene.meshNodes.size();
+		report.triangles = scene.triangleCount;
+		report.materials = description.materialCount;
+		report.depth = description.hierarchyDepth;
+		report.visible = benchmark.GetVisibleCount();
+		const RenderStatistics& statistics = benchmark.GetRenderStatistics();
+		report.draws = statistics.draws;
+		report.stateChanges = statistics.shaderChanges + statistics.materialChanges + statistics.meshChanges;
+		std::ostringstream checksum;
+		checksum << std::hex << std::setw(16) << std::setfill('0') << benchmark.GetChecksum();
+		report.checksum = checksum.str();
+		for (int stage = 0; stage < FrameBenchmark::STAGE_COUNT; stage++)
+			report.stages.push_back(StageSummary::Summarize(FrameBenchmark::GetStageName(stage), run.samples[stage]));
+		report.stages.push_back(StageSummary::Summarize("frame", run.samples[FrameBenchmark::STAGE_COUNT]));
+		return report;
+	}
+
+	// シーンの計測結果を表示する
+	void PrintScene(const SceneReport& scene)
+	{
+		std::cout << "scene " << scene.name << "  nodes " << scene.nodes << "  meshes " << scene.meshes << "  triangles " << scene.triangles
+			<< "  materials " << scene.materials << "  depth " << scene.depth << std::endl;
+		std::cout << "  visible " << scene.visible << "  draws " << scene.draws << "  state changes " << scene.stateChanges
+			<< "  checksum " << scene.checksum << std::endl;
+		for (const StageSummary& stage : scene.stages)
+		{
+			std::cout << "  " << std::left << std::setw(12) << stage.name << std::right << std::fixed << std::setprecision(4)
+				<< "mean " << std::setw(9) << stage.mean << " ms  median " << std::setw(9) << stage.median << " ms  p95 "
+				<< std::setw(9) << stage.p95 << " ms  stddev " << std::setw(9) << stage.deviation << " ms" << std::endl;
+		}
+	}
+
+	// 計測してレポートを書き出す
+	int Run(int argc, char* argv[])
+	{
+		uint32_t frames = 100;
+		uint32_t repetitions = 5;
+		uint32_t warmupFrames = 10;
+		std::string sceneName;
+		std::string label;
+		std::string output = "benchmark.json";
+		for (int i = 1; i < argc; i++)
+		{
+			if (strcmp(argv[i], "-frames") == 0)
+				frames = uint32_t(std::max(atoi(OptionValue(argc, argv, i)), 1));
+			else if (strcmp(argv[i], "-repeat") == 0)
+				repetitions = uint32_t(std::max(atoi(OptionValue(argc, argv, i)), 1));
+			else if (strcmp(argv[i], "-warmup") == 0)
+				warmupFrames = uint32_t(std::max(atoi(OptionValue(argc, argv, i)), 0));
+			else if (strcmp(argv[i], "-scene") == 0)
+				sceneName = OptionValue(argc, argv, i);
+			else if (strcmp(argv[i], "-isa") == 0)
+				TransformKernel::SetInstructionSet(ParseInstructionSet(OptionValue(argc, argv, i)));
+			else if (strcmp(argv[i], "-label") == 0)
+				label = OptionValue(argc, argv, i);
+			else if (strcmp(argv[i], "-output") == 0)
+				output = OptionValue(argc, argv, i);
+			else
+				throw std::invalid_argument(std::string("unknown option ") + argv[i]);
+		}
+
+		BenchmarkReport report;
+		report.label = label;
+		report.instructionSet = TransformKernel::GetInstructionSetName(TransformKernel::GetInstructionSet());
+		report.frames = frames;
+		report.repetitions = repetitions;
+
+		// シーンを生成する
+		std::vector<std::unique_ptr<SceneRun>> runs;
+		for (int i = 0; i < SceneGenerator::STANDARD_SCENE_COUNT; i++)
+		{
+			const SceneDescription& description = SceneGenerator::GetStandardScene(i);
+			if (!sceneName.empty() && sceneName != description.name)
+				continue;
+			runs.push_back(std::make_unique<SceneRun>());
+			SceneRun& run = *runs.back();
+			run.description = &description;
+			SceneGenerator::Generate(description, SCENE_SEED, run.scene);
+			run.benchmark = std::make_unique<FrameBenchmark>(run.scene, description.instanced);
+			run.samples.resize(FrameBenchmark::STAGE_COUNT + 1);
+		}
+		if (runs.empty())
+			throw std::invalid_argument("unknown scene " + sceneName);
+
+		// シーンを順に切り替えながら計測を繰り返す
+		for (uint32_t repetition = 0; repetition < repetitions; repetition++)
+		{
+			for (std::unique_ptr<SceneRun>& run : runs)
+				MeasureRepetition(*run, warmupFrames, frames);
+		}
+		for (const std::unique_ptr<SceneRun>& run : runs)
+		{
+			report.scenes.push_back(MakeSceneReport(*run));
+			PrintScene(report.scenes.back());
+		}
+
+		std::ofstream stream(output, std::ios::binary | std::ios::trunc);
+		report.WriteJson(stream);
+		if (!stream)
+			throw std::runtime_error("cannot write " + output);
+		std::cout << "report " << output << std::endl;
+		return 0;
+	}
+
+	// 2つのレポートを比較する
+	int Compare(int argc, char* argv[])
+	{
+		if (argc < 4)
+			throw std::invalid_argument("-compare needs two reports");
+		double threshold = 0.05;
+		double confidence = 0.99;
+		for (int i = 4; i < argc; i++)
+		{
+			if (strcmp(argv[i], "-threshold") == 0)
+				threshold = atof(OptionValue(argc, argv, i));
+			else if (strcmp(argv[i], "-confidence") == 0)
+				confidence = atof(OptionValue(argc, argv, i));
+			else
+				throw std::invalid_argument(std::string("unknown option ") + argv[i]);
+		}
+		BenchmarkReport baseline = BenchmarkReport::ReadJson(argv[2]);
+		BenchmarkReport current = BenchmarkReport::ReadJson(argv[3]);
+		return CompareReports(baseline, current, threshold, confidence, std::cout) > 0 ? 1 : 0;
+	}
+
+	// 頂点を量子化したときのメモリ量と速度を計測する
+	int Vertices(int argc, char* argv[])
+	{
+		uint32_t repetitions = 5;
+		std::string sceneName;
+		for (int i = 2; i < argc; i++)
+		{
+			if (strcmp(argv[i], "-repeat") == 0)
+				repetitions = uint32_t(std::max(atoi(OptionValue(argc, argv, i)), 1));
+			else if (strcmp(argv[i], "-scene") == 0)
+				sceneName = OptionValue(argc, argv, i);
+			else
+				throw std::invalid_argument(std::string("unknown option ") + argv[i]);
+		}
+
+		// 形状に掛けるワールド行列(Y軸回りの回転と平行移動)
+		const SceneMatrix world = { {
+			0.8f, 0.0f, -0.6f, 0.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			0.6f, 0.0f, 0.8f, 0.0f,
+			10.0f, -2.0f, 5.0f, 1.0f,
+		} };
+		bool found = false;
+		for (int i = 0; i < SceneGenerator::STANDARD_SCENE_COUNT; i++)
+		{
+			const SceneDescription& description = SceneGenerator::GetStandardScene(i);
+			if (!sceneName.empty() && sceneName != description.name)
+				continue;
+			found = true;
+			GeneratedScene scene;
+			SceneGenerator::Generate(description, SCENE_SEED, scene);
+
+			// 形状を頂点数がSTREAM_VERTICESを超えるまで繰り返して並べる
+			// 量子化したメッシュは描画時に復号行列をワールド行列の前に掛けるので、正規化の1/65535も含めて行列を1つにまとめておく
+			size_t residentVertices = 0;
+			for (const MeshData& shape : scene.shapes)
+				residentVertices += shape.vertices.size();
+			std::vector<MeshVertex> vertices;
+			std::vector<uint32_t> rangeShapes;
+			std::vector<size_t> rangeStarts;
+			vertices.reserve(STREAM_VERTICES + residentVertices);
+			while (vertices.size() < STREAM_VERTICES)
+			{
+				for (uint32_t shape = 0; shape < scene.shapes.size(); shape++)
+				{
+					rangeShapes.push_back(shape);
+					rangeStarts.push_back(vertices.size());
+					vertices.insert(vertices.end(), scene.shapes[shape].vertices.begin(), scene.shapes[shape].vertices.end());
+				}
+			}
+			rangeStarts.push_back(vertices.size());
+			std::vector<SceneMatrix> decodeWorlds(scene.shapes.size());
+			for (size_t shape = 0; shape < scene.shapes.size(); shape++)
+			{
+				SceneMatrix decode;
+				VertexQuantizer::GetDecodeMatrix(scene.shapes[shape].bounds, decode.m);
+				for (int element = 0; element < 12; element++)
+					decode.m[element] /= float(VertexQuantizer::POSITION_STEPS);
+				SceneGraph::Multiply(decode, world, decodeWorlds[shape]);
+			}
+
+			std::vector<QuantizedVertex> quantized(vertices.size());
+			std::vector<MeshVertex> decoded(vertices.size());
+			double encodeSeconds = MeasureFastest(repetitions, [&]()
+			{
+				for (size_t range = 0; range < rangeShapes.size(); range++)
+				{
+					VertexQuantizer::Quantize(&quantized[rangeStarts[range]], &vertices[rangeStarts[range]],
+						rangeStarts[range + 1] - rangeStarts[range], scene.shapes[rangeShapes[range]].bounds);
+				}
+			});
+			double decodeSeconds = MeasureFastest(repetitions, [&]()
+			{
+				for (size_t range = 0; range < rangeShapes.size(); range++)
+				{
+					VertexQuantizer::Dequantize(&decoded[rangeStarts[range]], &quantized[rangeStarts[range]],
+						rangeStarts[range + 1] - rangeStarts[range], scene.shapes[rangeShapes[range]].bounds);
+				}
+			});
+
+			// 頂点シェーダと同じく頂点を読み出して位置をワールド空間に変換する
+			std::vector<float> floatWorld(vertices.size() * 3), quantizedWorld(vertices.size() * 3);
+			double floatSeconds = MeasureFastest(repetitions, [&]()
+			{
+				const float* m = world.m;
+				for (size_t index = 0; index < vertices.size(); index++)
+				{
+					const float* p = vertices[index].position;
+					float* result = &floatWorld[index * 3];
+					result[0] = p[0] * m[0] + p[1] * m[4] + p[2] * m[8] + m[12];
+					result[1] = p[0] * m[1] + p[1] * m[5] + p[2] * m[9] + m[13];
+					result[2] = p[0] * m[2] + p[1] * m[6] + p[2] * m[10] + m[14];
+				}
+			});
+			double quantizedSeconds = MeasureFastest(repetitions, [&]()
+			{
+				for (size_t range = 0; range < rangeShapes.size(); range++)
+				{
+					const float* m = decodeWorlds[rangeShapes[range]].m;
+					for (size_t index = rangeStarts[range]; index < rangeStarts[range + 1]; index++)
+					{
+						const uint16_t* q = quantized[index].position;
+						float x = float(q[0]), y = float(q[1]), z = float(q[2]);
+						float* result = &quantizedWorld[index * 3];
+						result[0] = x * m[0] + y * m[4] + z * m[8] + m[12];
+						result[1] = x * m[1] + y * m[5] + z * m[9] + m[13];
+						result[2] = x * m[2] + y * m[6] + z * m[10] + m[14];
+					}
+				}
+			});
+			float worldError = 0.0f;
+			for (size_t element = 0; element < floatWorld.size(); element++)
+				worldError = std::max(worldError, fabsf(floatWorld[element] - quantizedWorld[element]));
+
+			// 復号した位置の誤差を境界ボックスの大きさに対する量子化の段階数で表す
+			double maxError = 0.0;
+			for (size_t range = 0; range < rangeShapes.size(); range++)
+			{
+				const MeshBounds& bounds = scene.shapes[rangeShapes[range]].bounds;
+				for (size_t index = rangeStarts[range]; index < rangeStarts[range + 1]; index++)
+				{
+					for (int axis = 0; axis < 3; axis++)
+					{
+						double extent = double(bounds.maximum[axis]) - double(bounds.minimum[axis]);
+						double error = fabs(double(decoded[index].position[axis]) - double(vertices[index].position[axis]));
+						if (extent > 0.0)
+							maxError = std::max(maxError, error / extent * double(VertexQuantizer::POSITION_STEPS));
+					}
+				}
+			}
+
+			double count = double(vertices.size());
+			double megabyte = 1024.0 * 1024.0;
+			std::cout << std::fixed << std::setprecision(2) << "scene " << description.name << "  shapes " << scene.shapes.size()
+				<< "  resident vertices " << residentVertices << "  streamed vertices " << vertices.size() << std::endl;
+			std::cout << "  bytes/vertex  float " << sizeof(MeshVertex) << "  quantized " << sizeof(QuantizedVertex)
+				<< "  resident MB  float " << double(residentVertices * sizeof(MeshVertex)) / megabyte
+				<< "  quantized " << double(residentVertices * sizeof(QuantizedVertex)) / megabyte << std::endl;
+			std::cout << "  encode " << count / encodeSeconds * 1.0e-6 << " Mvertices/s  decode " << count / decodeSeconds * 1.0e-6 << " Mvertices/s" << std::endl;
+			std::cout << "  fetch+transform  float " << count / floatSeconds * 1.0e-6 << " Mvertices/s ("
+				<< count * sizeof(MeshVertex) / floatSeconds / 1.0e9 << " GB/s)  quantized " << count / quantizedSeconds * 1.0e-6 << " Mvertices/s ("
+				<< count * sizeof(QuantizedVertex) / quantizedSeconds / 1.0e9 << " GB/s)  speedup " << floatSeconds / quantizedSeconds << "x" << std::endl;
+			std::cout << "  max position error " << std::setprecision(3) << maxError << " steps  max world position difference "
+				<< std::scientific << worldError << std::defaultfloat << std::endl;
+		}
+		if (!found)
+			throw std::invalid_argument("unknown scene " + sceneName);
+		return 0;
+	}
+
+	// 標準のシーンの一覧を表示する
+	int List()
+	{
+		for (int i = 0; i < SceneGenerator::STANDARD_SCENE_COUNT; i++)
+		{
+			const SceneDescription& description = SceneGenerator::GetStandardScene(i);
+			std::cout << std::left << std::setw(16) << description.name << std::right << "meshes " << std::setw(6) << description.meshCount
+				<< "  shapes " << std::setw(4) << description.shapeCount << "  triangles/shape " << std::setw(6) << description.trianglesPerShape
+				<< "  depth " << std::setw(4) << description.hierarchyDepth << "  materials " << std::setw(5) << description.materialCount
+				<< "  shaders " << std::setw(4) << description.shaderCount << "  animated " << description.animatedFraction * 100.0f << "%"
+				<< (description.instanced ? "  instanced" : "") << std::endl;
+		}
+		return 0;
+	}
+}
+
+// エントリポイント(計測は0、回帰があれば1、引数やファイルの誤りは2を返す)
+int main(int argc, char* argv[])
+{
+	try
+	{
+		if (argc >= 2 && strcmp(argv[1], "-compare") == 0)
+			return Compare(argc, argv);
+		if (argc == 2 && strcmp(argv[1], "-list") == 0)
+			return List();
+		if (argc >= 2 && strcmp(argv[1], "-vertices") == 0)
+			return Vertices(argc, argv);
+		return Run(argc, argv);
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << "error: " << exception.what() << std::endl;
+		PrintUsage();
+		return 2;
+	}
+}
@@ -0,0 +1,519 @@
+﻿#include "BenchmarkReport.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <math.h>
+#include <stdexcept>
+#include <stdlib.h>
+
+namespace
+{
+	// 読み込んだJSONの値
+	struct JsonValue
+	{
+		// 種類
+		enum Type { JSON_NULL, JSON_BOOLEAN, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+		Type type = JSON_NULL;
+		bool boolean = false;
+		double number = 0.0;
+		std::string string;
+		std::vector<JsonValue> elements;
+		std::vector<std::pair<std::string, JsonValue>> members;
+
+		// オブジェクトのメンバを取得する(無い場合は例外を投げる)
+		const JsonValue& Get(const char* key) const
+		{
+			for (const auto& member : members)
+			{
+				if (member.first == key)
+					return member.second;
+			}
+			throw std::runtime_error(std::string("BenchmarkReport: missing member ") + key);
+		}
+		// 数値のメンバを取得する
+		double GetNumber(const char* key) const
+		{
+			const JsonValue& value = Get(key);
+			if (value.type != JSON_NUMBER)
+				throw std::runtime_error(std::string("BenchmarkReport: member is not a number ") + key);
+			return value.number;
+		}
+		// 文字列のメンバを取得する
+		const std::string& GetString(const char* key) const
+		{
+			const JsonValue& value = Get(key);
+			if (value.type != JSON_STRING)
+				throw std::runtime_error(std::string("BenchmarkReport: member is not a string ") + key);
+			return value.string;
+		}
+		// 配列のメンバを取得する
+		const std::vector<JsonValue>& GetArray(const char* key) const
+		{
+			const JsonValue& value = Get(key);
+			if (value.type != JSON_ARRAY)
+				throw std::runtime_error(std::string("BenchmarkReport: member is not an array ") + key);
+			return value.elements;
+		}
+	};
+
+	// ベンチマークのレポートを読むのに十分な、最小限のJSONパーサ
+	class JsonParser
+	{
+	public:
+		// コンストラクタ
+		explicit JsonParser(const std::string& text) : m_text(text), m_position(0)
+		{
+		}
+
+		// 文書全体を読み込む
+		JsonValue ParseDocument()
+		{
+			JsonValue value = ParseValue();
+			SkipSpace();
+			if (m_position != m_text.size())
+				Fail("trailing characters");
+			return value;
+		}
+
+	private:
+		// 値を読み込む
+		JsonValue ParseValue()
+		{
+			SkipSpace();
+			JsonValue value;
+			char c = Peek();
+			if (c == '{')
+			{
+				value.type = JsonValue::JSON_OBJECT;
+				m_position++;
+				if (!Consume('}'))
+				{
+					do
+					{
+						SkipSpace();
+						std::string key = ParseString();
+						SkipSpace();
+						Expect(':');
+						value.members.emplace_back(key, ParseValue());
+						SkipSpace();
+					} while (Consume(','));
+					Expect('}');
+				}
+			}
+			else if (c == '[')
+			{
+				value.type = JsonValue::JSON_ARRAY;
+				m_position++;
+				if (!Consume(']'))
+				{
+					do
+					{
+						value.elements.push_back(ParseValue());
+						SkipSpace();
+					} while (Consume(','));
+					Expect(']');
+				}
+			}
+			else if (c == '"')
+			{
+				value.type = JsonValue::JSON_STRING;
+				value.string = ParseString();
+			}
+			else if (m_text.compare(m_position, 4, "true") == 0 || m_text.compare(m_position, 5, "false") == 0)
+			{
+				value.type = JsonValue::JSON_BOOLEAN;
+				value.boolean = c == 't';
+				m_position += value.boolean ? 4 : 5;
+			}
+			else if (m_text.compare(m_position, 4, "null") == 0)
+			{
+				m_position += 4;
+			}
+			else
+			{
+				const char* begin = m_text.c_str() + m_position;
+				char* end = nullptr;
+				value.type = JsonValue::JSON_NUMBER;
+				value.number = strtod(begin, &end);
+				if (end == begin)
+					Fail("unexpected character");
+				m_position += size_t(end - begin);
+			}
+			return value;
+		}
+
+		// 文字列を読み込む(\uのエスケープはASCIIの範囲だけ扱う)
+		std::string ParseString()
+		{
+			Expect('"');
+			std::string result;
+			for (;;)
+			{
+				if (m_position >= m_text.size())
+					Fail("unterminated string");
+				char c = m_text[m_position++];
+				if (c == '"')
+					return result;
+				if (c != '\\')
+				{
+					result += c;
+					continue;
+				}
+				if (m_position >= m_text.size())
+					Fail("unterminated string");
+				char escape = m_text[m_position++];
+				switch (escape)
+				{
+				case 'n': result += '\n'; break;
+				case 't': result += '\t'; break;
+				case 'r': result += '\r'; break;
+				case 'b': result += '\b'; break;
+				case 'f': result += '\f'; break;
+				case 'u':
+					if (m_position + 4 > m_text.size())
+						Fail("invalid escape");
+					result += char(strtol(m_text.substr(m_position, 4).c_str(), nullptr, 16) & 0x7F);
+					m_position += 4;
+					break;
+				default: result += escape; break;
+				}
+			}
+		}
+
+		// 空白を読み飛ばす
+		void SkipSpace()
+		{
+			while (m_position < m_text.size() && (m_text[m_position] == ' ' || m_text[m_position] == '\t' ||
+				m_text[m_position] == '\r' || m_text[m_position] == '\n'))
+			{
+				m_position++;
+			}
+		}
+		// 次の文字を取得する
+		char Peek() const
+		{
+			return m_position < m_text.size() ? m_text[m_position] : '\0';
+		}
+		// 次の文字が指定された文字なら読み進める
+		bool Consume(char c)
+		{
+			SkipSpace();
+			if (Peek() != c)
+				return false;
+			m_position++;
+			return true;
+		}
+		// 指定された文字を読み進める(無い場合は例外を投げる)
+		void Expect(char c)
+		{
+			if (!Consume(c))
+				Fail(std::string("expected '") + c + "'");
+		}
+		// 読み込みに失敗した位置を例外で投げる
+		void Fail(const std::string& message) const
+		{
+			throw std::runtime_error("BenchmarkReport: " + message + " at offset " + std::to_string(m_position));
+		}
+
+	private:
+		// 文書
+		const std::string& m_text;
+		// 読み込み位置
+		size_t m_position;
+	};
+
+	// 文字列をJSONの文字列として書き出す
+	void WriteString(std::ostream& stream, const std::string& text)
+	{
+		stream << '"';
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				stream << '\\' << c;
+			else if (static_cast<unsigned char>(c) < 0x20)
+				stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+			else
+				stream << c;
+		}
+		stream << '"';
+	}
+
+	// 正則化不完全ベータ関数の連分数を計算する(修正Lentz法)
+	double BetaContinuedFraction(double a, double b, double x)
+	{
+		const double TINY = 1e-300;
+		double c = 1.0;
+		double d = 1.0 - (a + b) * x / (a + 1.0);
+		d = 1.0 / (fabs(d) < TINY ? TINY : d);
+		double result = d;
+		for (int m = 1; m <= 200; m++)
+		{
+			// 偶数項と奇数項を順に適用する
+			for (int step = 0; step < 2; step++)
+			{
+				double numerator = step == 0 ? m * (b - m) * x / ((a + 2.0 * m - 1.0) * (a + 2.0 * m))
+					: -(a + m) * (a + b + m) * x / ((a + 2.0 * m) * (a + 2.0 * m + 1.0));
+				d = 1.0 + numerator * d;
+				d = 1.0 / (fabs(d) < TINY ? TINY : d);
+				c = 1.0 + numerator / c;
+				c = fabs(c) < TINY ? TINY : c;
+				result *= d * c;
+			}
+			if (fabs(d * c - 1.0) < 1e-12)
+				break;
+		}
+		return result;
+	}
+
+	// 正則化不完全ベータ関数I_x(a, b)を計算する
+	double RegularizedBeta(double a, double b, double x)
+	{
+		if (x <= 0.0)
+			return 0.0;
+		if (x >= 1.0)
+			return 1.0;
+		double front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1.0 - x));
+		if (x < (a + 1.0) / (a + b + 2.0))
+			return front * BetaContinuedFraction(a, b, x) / a;
+		return 1.0 - front * BetaContinuedFraction(b, a, 1.0 - x) / b;
+	}
+
+	// 自由度dfのt分布で、統計量tの両側p値を求める
+	double TwoSidedPValue(double t, double df)
+	{
+		return RegularizedBeta(df * 0.5, 0.5, df / (df + t * t));
+	}
+
+	// 平均と不偏分散を計算する
+	void MeanAndVariance(const std::vector<double>& values, double& mean, double& variance)
+	{
+		mean = 0.0;
+		for (double value : values)
+			mean += value;
+		mean /= double(values.size());
+		variance = 0.0;
+		for (double value : values)
+			variance += (value - mean) * (value - mean);
+		variance = values.size() > 1 ? variance / double(values.size() - 1) : 0.0;
+	}
+
+	// 並べ替えた値の中央値を求める
+	double SortedMedian(const std::vector<double>& sorted)
+	{
+		size_t count = sorted.size();
+		return count % 2 != 0 ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) * 0.5;
+	}
+
+	// 名前でシーンを探す
+	const SceneReport* FindScene(const BenchmarkReport& report, const std::string& name)
+	{
+		for (const SceneReport& scene : report.scenes)
+		{
+			if (scene.name == name)
+				return &scene;
+		}
+		return nullptr;
+	}
+
+	// 名前で処理段階を探す
+	const StageSummary* FindStage(const SceneReport& scene, const std::string& name)
+	{
+		for (const StageSummary& stage : scene.stages)
+		{
+			if (stage.name == name)
+				return &stage;
+		}
+		return nullptr;
+	}
+}
+
+// 繰り返しごとのフレームの時間(秒)から要約を作成する
+StageSummary StageSummary::Summarize(const std::string& name, const std::vector<std::vector<double>>& seconds)
+{
+	StageSummary summary;
+	summary.name = name;
+	std::vector<double> all;
+	for (const std::vector<double>& run : seconds)
+	{
+		if (run.empty())
+			throw std::invalid_argument("StageSummary: no samples");
+		std::vector<double> sorted = run;
+		std::sort(sorted.begin(), sorted.end());
+		summary.runs.push_back(SortedMedian(sorted) * 1000.0);
+		all.insert(all.end(), sorted.begin(), sorted.end());
+	}
+	if (all.empty())
+		throw std::invalid_argument("StageSummary: no samples");
+
+	// すべてのフレームをまとめて要約する
+	std::sort(all.begin(), all.end());
+	double mean, variance;
+	MeanAndVariance(all, mean, variance);
+	size_t count = all.size();
+	summary.samples = uint32_t(count);
+	summary.mean = mean * 1000.0;
+	summary.median = SortedMedian(all) * 1000.0;
+	summary.deviation = sqrt(variance) * 1000.0;
+	summary.p95 = all[std::min(count - 1, size_t(ceil(double(count) * 0.95)) - 1)] * 1000.0;
+	summary.minimum = all.front() * 1000.0;
+	summary.maximum = all.back() * 1000.0;
+	return summary;
+}
+
+// JSON形式で書き出す
+void BenchmarkReport::WriteJson(std::ostream& stream) const
+{
+	stream << std::setprecision(6) << "{\n  \"version\": 1,\n  \"label\": ";
+	WriteString(stream, label);
+	stream << ",\n  \"instructionSet\": ";
+	WriteString(stream, instructionSet);
+	stream << ",\n  \"frames\": " << frames << ",\n  \"repetitions\": " << repetitions << ",\n  \"scenes\": [";
+	for (size_t i = 0; i < scenes.size(); i++)
+	{
+		const SceneReport& scene = scenes[i];
+		stream << (i == 0 ? "\n" : ",\n") << "    {\n      \"name\": ";
+		WriteString(stream, scene.name);
+		stream << ",\n      \"nodes\": " << scene.nodes << ", \"meshes\": " << scene.meshes << ", \"triangles\": " << scene.triangles
+			<< ", \"materials\": " << scene.materials << ", \"depth\": " << scene.depth
+			<< ",\n      \"visible\": " << scene.visible << ", \"draws\": " << scene.draws << ", \"stateChanges\": " << scene.stateChanges
+			<< ", \"checksum\": ";
+		WriteString(stream, scene.checksum);
+		stream << ",\n      \"stages\": [";
+		for (size_t j = 0; j < scene.stages.size(); j++)
+		{
+			const StageSummary& stage = scene.stages[j];
+			stream << (j == 0 ? "\n" : ",\n") << "        { \"name\": ";
+			WriteString(stream, stage.name);
+			stream << ", \"mean\": " << stage.mean << ", \"median\": " << stage.median << ", \"deviation\": " << stage.deviation
+				<< ", \"p95\": " << stage.p95 << ", \"min\": " << stage.minimum << ", \"max\": " << stage.maximum
+				<< ", \"samples\": " << stage.samples << ", \"runs\": [";
+			for (size_t k = 0; k < stage.runs.size(); k++)
+				stream << (k == 0 ? "" : ", ") << stage.runs[k];
+			stream << "] }";
+		}
+		stream << "\n      ]\n    }";
+	}
+	stream << "\n  ]\n}\n";
+}
+
+// JSON形式のファイルから読み込む
+BenchmarkReport BenchmarkReport::ReadJson(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file)
+		throw std::runtime_error("BenchmarkReport: cannot open " + filename);
+	std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	JsonValue document = JsonParser(text).ParseDocument();
+	if (document.GetNumber("version") != 1.0)
+		throw std::runtime_error("BenchmarkReport: unsupported version " + filename);
+
+	BenchmarkReport report;
+	report.label = document.GetString("label");
+	report.instructionSet = document.GetString("instructionSet");
+	report.frames = uint32_t(document.GetNumber("frames"));
+	report.repetitions = uint32_t(document.GetNumber("repetitions"));
+	for (const JsonValue& sceneValue : document.GetArray("scenes"))
+	{
+		SceneReport scene;
+		scene.name = sceneValue.GetString("name");
+		scene.nodes = uint64_t(sceneValue.GetNumber("nodes"));
+		scene.meshes = uint64_t(sceneValue.GetNumber("meshes"));
+		scene.triangles = uint64_t(sceneValue.GetNumber("triangles"));
+		scene.materials = uint64_t(sceneValue.GetNumber("materials"));
+		scene.depth = uint64_t(sceneValue.GetNumber("depth"));
+		scene.visible = uint64_t(sceneValue.GetNumber("visible"));
+		scene.draws = uint64_t(sceneValue.GetNumber("draws"));
+		scene.stateChanges = uint64_t(sceneValue.GetNumber("stateChanges"));
+		scene.checksum = sceneValue.GetString("checksum");
+		for (const JsonValue& stageValue : sceneValue.GetArray("stages"))
+		{
+			StageSummary stage;
+			stage.name = stageValue.GetString("name");
+			stage.mean = stageValue.GetNumber("mean");
+			stage.median = stageValue.GetNumber("median");
+			stage.deviation = stageValue.GetNumber("deviation");
+			stage.p95 = stageValue.GetNumber("p95");
+			stage.minimum = stageValue.GetNumber("min");
+			stage.maximum = stageValue.GetNumber("max");
+			stage.samples = uint32_t(stageValue.GetNumber("samples"));
+			for (const JsonValue& run : stageValue.GetArray("runs"))
+			{
+				if (run.type != JsonValue::JSON_NUMBER)
+					throw std::runtime_error("BenchmarkReport: run is not a number " + filename);
+				stage.runs.push_back(run.number);
+			}
+			scene.stages.push_back(stage);
+		}
+		report.scenes.push_back(scene);
+	}
+	return report;
+}
+
+// 2つの計測結果を比較し、有意に遅くなった処理段階を回帰として数える
+int CompareReports(const BenchmarkReport& baseline, const BenchmarkReport& current, double threshold, double confidence, std::ostream& stream)
+{
+	if (threshold < 0.0 || confidence <= 0.0 || confidence >= 1.0)
+		throw std::invalid_argument("CompareReports: threshold must be non-negative and confidence in (0, 1)");
+
+	stream << "baseline " << (baseline.label.empty() ? "(no label)" : baseline.label) << " [" << baseline.instructionSet << "]  current "
+		<< (current.label.empty() ? "(no label)" : current.label) << " [" << current.instructionSet << "]" << std::endl;
+	stream << "threshold " << threshold * 100.0 << "%  confidence " << confidence * 100.0 << "%" << std::endl;
+	stream << std::left << std::setw(16) << "scene" << std::setw(12) << "stage" << std::right << std::setw(12) << "base ms"
+		<< std::setw(12) << "current ms" << std::setw(10) << "change" << std::setw(9) << "p" << "  result" << std::endl;
+
+	int regressions = 0;
+	for (const SceneReport& scene : current.scenes)
+	{
+		const SceneReport* baseScene = FindScene(baseline, scene.name);
+		if (baseScene == nullptr)
+		{
+			stream << std::left << std::setw(16) << scene.name << std::right << "not in baseline" << std::endl;
+			continue;
+		}
+		for (const StageSummary& stage : scene.stages)
+		{
+			const StageSummary* baseStage = FindStage(*baseScene, stage.name);
+			if (baseStage == nullptr || baseStage->runs.size() < 2 || stage.runs.size() < 2)
+				continue;
+
+			// 繰り返しごとの中央値でウェルチのt検定をおこなう(自由度はウェルチ・サタスウェイトの近似)
+			double baseMean, baseVariance, mean, variance;
+			MeanAndVariance(baseStage->runs, baseMean, baseVariance);
+			MeanAndVariance(stage.runs, mean, variance);
+			if (baseMean <= 0.0)
+				continue;
+			double change = (mean - baseMean) / baseMean;
+			double baseError = baseVariance / double(baseStage->runs.size());
+			double error = variance / double(stage.runs.size());
+			double p = mean == baseMean ? 1.0 : 0.0;
+			if (baseError + error > 0.0)
+			{
+				double t = (mean - baseMean) / sqrt(baseError + error);
+				double df = (baseError + error) * (baseError + error) /
+					(baseError * baseError / double(baseStage->runs.size() - 1) + error * error / double(stage.runs.size() - 1));
+				p = TwoSidedPValue(t, df);
+			}
+			bool significant = p < 1.0 - confidence && fabs(change) > threshold;
+			const char* result = "";
+			if (significant && change > 0.0)
+			{
+				result = "REGRESSION";
+				regressions++;
+			}
+			else if (significant)
+			{
+				result = "improvement";
+			}
+			stream << std::left << std::setw(16) << scene.name << std::setw(12) << stage.name << std::right << std::fixed << std::setprecision(4)
+				<< std::setw(12) << baseMean << std::setw(12) << mean << std::setprecision(1) << std::setw(9)
+				<< change * 100.0 << "%" << std::setprecision(4) << std::setw(9) << p << "  " << result << std::endl;
+		}
+		// チェックサムが異なる場合は描画する内容が変わっているので、時間の比較は参考にとどめる
+		if (scene.checksum != baseScene->checksum)
+			stream << std::left << std::setw(16) << scene.name << std::right << "note: rendered output differs from baseline (checksum)" << std::endl;
+	}
+	stream << regressions << " regression(s)" << std::endl;
+	return regressions;
+}
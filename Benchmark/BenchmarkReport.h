@@ -0,0 +1,88 @@
+﻿#pragma once
+#ifndef BENCHMARKREPORT_DEFINED
+#define BENCHMARKREPORT_DEFINED
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// 処理段階の計測結果の要約(時間はミリ秒)
+struct StageSummary
+{
+	// 処理段階の名前
+	std::string name;
+	// 平均
+	double mean;
+	// 中央値
+	double median;
+	// 標準偏差
+	double deviation;
+	// 95パーセンタイル
+	double p95;
+	// 最小
+	double minimum;
+	// 最大
+	double maximum;
+	// 計測したフレーム数
+	uint32_t samples;
+	// 繰り返しごとの中央値(比較の検定に使う)
+	std::vector<double> runs;
+
+	// 繰り返しごとのフレームの時間(秒)から要約を作成する
+	static StageSummary Summarize(const std::string& name, const std::vector<std::vector<double>>& seconds);
+};
+
+// シーンの計測結果
+struct SceneReport
+{
+	// シーン名
+	std::string name;
+	// ノード数
+	uint64_t nodes;
+	// メッシュ数
+	uint64_t meshes;
+	// 三角形の数
+	uint64_t triangles;
+	// マテリアル数
+	uint64_t materials;
+	// 階層の深さ
+	uint64_t depth;
+	// 最後のフレームで見えたメッシュの数
+	uint64_t visible;
+	// 最後のフレームの描画数
+	uint64_t draws;
+	// 最後のフレームの状態の切り替え数
+	uint64_t stateChanges;
+	// 全フレームの描画のチェックサム(16進数の文字列)
+	std::string checksum;
+	// 処理段階ごとの要約(最後はフレーム全体)
+	std::vector<StageSummary> stages;
+};
+
+// ベンチマーク全体の計測結果
+struct BenchmarkReport
+{
+	// 計測した版を区別するラベル(コミットなど)
+	std::string label;
+	// 変換カーネルの命令セット
+	std::string instructionSet;
+	// 繰り返しごとの計測フレーム数
+	uint32_t frames;
+	// 繰り返しの数
+	uint32_t repetitions;
+	// シーンごとの計測結果
+	std::vector<SceneReport> scenes;
+
+	// JSON形式で書き出す
+	void WriteJson(std::ostream& stream) const;
+	// JSON形式のファイルから読み込む
+	static BenchmarkReport ReadJson(const std::string& filename);
+};
+
+// 2つの計測結果を比較し、有意に遅くなった処理段階を回帰として数える
+// 繰り返しごとの中央値の平均の差の相対値がthresholdを超え、かつウェルチのt検定で信頼度confidenceで有意な場合に変化とみなす
+// (フレームごとの時間は互いに独立ではないので、検定には繰り返しごとの中央値を使う)
+int CompareReports(const BenchmarkReport& baseline, const BenchmarkReport& current, double threshold, double confidence, std::ostream& stream);
+
+#endif	// BENCHMARKREPORT_DEFINED
@@ -0,0 +1,25 @@
+﻿#pragma once
+#ifndef BENCHMARKTIMER_DEFINED
+#define BENCHMARKTIMER_DEFINED
+
+#include <algorithm>
+#include <stdint.h>
+#include "FrameClock.h"
+
+// 処理を繰り返し、最も速かった時間(秒)を返す
+template <typename Function>
+double MeasureFastest(uint32_t repetitions, Function function)
+{
+	DX::ClockSource& clock = DX::GetDefaultClock();
+	double fastest = 0.0;
+	for (uint32_t repetition = 0; repetition < repetitions; repetition++)
+	{
+		uint64_t start = clock.GetCounter();
+		function();
+		double seconds = double(clock.GetCounter() - start) / double(clock.GetFrequency());
+		fastest = repetition == 0 ? seconds : std::min(fastest, seconds);
+	}
+	return fastest;
+}
+
+#endif	// BENCHMARKTIMER_DEFINED
@@ -0,0 +1,118 @@
+﻿// BvhBenchmark.cpp - 境界ボリューム階層の構築・再適合・問い合わせの速度を計測する
+//
+// BvhBenchmark [境界ボックス数]
+//     大きさの異なる境界ボックスを一様に配置し、単一スレッドと並列の構築、再適合、
+//     平坦な判定と比較した視錐台カリング、レイ、重なりの問い合わせを計測する(既定は100万個)
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <random>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+#include "BenchmarkCamera.h"
+#include "BoundingVolumeHierarchy.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "MeshData.h"
+
+namespace
+{
+	// レイと重なりの問い合わせ回数
+	const int QUERY_COUNT = 100000;
+
+	// 計測して秒を返す
+	double Measure(const std::function<void()>& body)
+	{
+		auto start = std::chrono::steady_clock::now();
+		body();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	size_t count = argc >= 2 ? size_t(std::max(atoi(argv[1]), 1)) : 1000000;
+
+	// 大きさの異なる境界ボックスを一様に配置する
+	std::mt19937 random(0);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> size(0.1f, 1.0f);
+	std::vector<MeshBounds> bounds(count);
+	for (MeshBounds& box : bounds)
+	{
+		float x = position(random), y = position(random), z = position(random), half = size(random);
+		box = { { x - half, y - half, z - half }, { x + half, y + half, z + half } };
+	}
+
+	// 構築
+	BoundingVolumeHierarchy bvh;
+	double seconds = Measure([&]() { bvh.Build(bounds.data(), count); });
+	std::cout << "build    1 thread   " << std::fixed << std::setprecision(3) << seconds * 1000.0 << " ms  nodes " << bvh.GetNodeCount() << std::endl;
+	{
+		JobSystem jobSystem;
+		seconds = Measure([&]() { bvh.Build(bounds.data(), count, &jobSystem); });
+		std::cout << "build    " << jobSystem.GetWorkerCount() + 1 << " threads  " << seconds * 1000.0 << " ms  nodes " << bvh.GetNodeCount() << std::endl;
+	}
+
+	// 再適合
+	for (MeshBounds& box : bounds)
+	{
+		box.minimum[1] += 1.0f;
+		box.maximum[1] += 1.0f;
+	}
+	seconds = Measure([&]() { bvh.Refit(bounds.data()); });
+	std::cout << "refit    " << seconds * 1000.0 << " ms" << std::endl;
+
+	// 視錐台カリング(平坦な判定と比較する)
+	float viewProjection[16];
+	CreateBenchmarkViewProjection(viewProjection);
+	FrustumCuller culler(viewProjection);
+	std::vector<uint8_t> visible(count);
+	size_t visibleCount = 0;
+	seconds = Measure([&]() { visibleCount = culler.Cull(bounds.data(), count, visible.data()); });
+	std::cout << "cull     flat " << seconds * 1000.0 << " ms  visible " << visibleCount << std::endl;
+	seconds = Measure([&]() { visibleCount = bvh.CullFrustum(culler, visible.data()); });
+	std::cout << "cull     bvh  " << seconds * 1000.0 << " ms  visible " << visibleCount << std::endl;
+
+	// レイ(原点から一様な方向へ飛ばす)
+	std::vector<float> directions(QUERY_COUNT * 3);
+	for (int n = 0; n < QUERY_COUNT; n++)
+	{
+		float* direction = &directions[n * 3];
+		float x = position(random), y = position(random), z = position(random);
+		float length = std::max(sqrtf(x * x + y * y + z * z), 1e-6f);
+		direction[0] = x / length;
+		direction[1] = y / length;
+		direction[2] = z / length;
+	}
+	const float origin[3] = { 0.0f, 0.0f, 0.0f };
+	size_t hits = 0;
+	seconds = Measure([&]()
+	{
+		for (int n = 0; n < QUERY_COUNT; n++)
+		{
+			if (bvh.Raycast(origin, &directions[n * 3], 1000.0f) != BoundingVolumeHierarchy::NO_PRIMITIVE)
+				hits++;
+		}
+	});
+	std::cout << "raycast  " << QUERY_COUNT / seconds / 1000000.0 << " Mrays/s  hits " << hits << std::endl;
+
+	// 重なり
+	std::vector<uint32_t> results;
+	seconds = Measure([&]()
+	{
+		for (int n = 0; n < QUERY_COUNT; n++)
+		{
+			const MeshBounds& box = bounds[n % count];
+			results.clear();
+			bvh.QueryOverlap(box, results);
+		}
+	});
+	std::cout << "overlap  " << QUERY_COUNT / seconds / 1000000.0 << " Mqueries/s" << std::endl;
+	return 0;
+}
@@ -0,0 +1,59 @@
+﻿// CullBenchmark.cpp - 視錐台カリングの処理速度を計測する
+//
+// CullBenchmark [境界ボックス数]
+//     原点から+x方向を見るカメラの周りに一様に配置した境界ボックスを、
+//     CPUが対応している命令セットごとに判定する(既定は100万個)
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+#include "BenchmarkCamera.h"
+#include "FrustumCuller.h"
+#include "MeshData.h"
+#include "TransformKernel.h"
+
+namespace
+{
+	// 計測する繰り返しの回数
+	const int ITERATIONS = 10;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t count = argc >= 2 ? size_t(std::max(atoi(argv[1]), 1)) : 1000000;
+
+	// 原点から+x方向を見るカメラの周りに境界ボックスを一様に配置する
+	float viewProjection[16];
+	CreateBenchmarkViewProjection(viewProjection);
+	std::mt19937 random(0);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::vector<MeshBounds> bounds(count);
+	for (MeshBounds& box : bounds)
+	{
+		float x = position(random), y = position(random), z = position(random);
+		box = { { x - 0.5f, y - 0.5f, z - 0.5f }, { x + 0.5f, y + 0.5f, z + 0.5f } };
+	}
+	std::vector<uint8_t> visible(count);
+
+	TransformKernel::InstructionSet supported = TransformKernel::GetSupportedInstructionSet();
+	for (int set = TransformKernel::SCALAR; set <= supported; set++)
+	{
+		TransformKernel::SetInstructionSet(TransformKernel::InstructionSet(set));
+		FrustumCuller culler(viewProjection);
+		size_t visibleCount = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int n = 0; n < ITERATIONS; n++)
+			visibleCount = culler.Cull(bounds.data(), count, visible.data());
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::setw(8) << std::left << TransformKernel::GetInstructionSetName(TransformKernel::InstructionSet(set))
+			<< std::fixed << std::setprecision(3) << seconds * 1000.0 / ITERATIONS << " ms  "
+			<< count * ITERATIONS / seconds / 1000000.0 << " Mboxes/s  visible " << visibleCount << std::endl;
+	}
+	TransformKernel::SetInstructionSet(supported);
+	return 0;
+}
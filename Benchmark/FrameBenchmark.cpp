@@ -0,0 +1,200 @@
+﻿#include "FrameBenchmark.h"
+#include <algorithm>
+#include <math.h>
+#include "FrameClock.h"
+#include "FrustumCuller.h"
+
+namespace
+{
+	// 処理段階の名前
+	const char* const STAGE_NAMES[FrameBenchmark::STAGE_COUNT] = { "traversal", "transforms", "culling", "batching", "submission" };
+
+	// カメラの視野角
+	const float FIELD_OF_VIEW = 1.0471976f;
+	// カメラの縦横比
+	const float ASPECT_RATIO = 4.0f / 3.0f;
+	// 近平面までの距離
+	const float NEAR_PLANE = 0.1f;
+	// シーンの半径に対する遠平面までの距離
+	const float FAR_PLANE_SCALE = 4.0f;
+	// カメラが1フレームで回る角度
+	const float CAMERA_SPEED = 0.01f;
+	// 回転させるノードが1フレームで回る角度
+	const float ANIMATION_SPEED = 0.02f;
+
+	// 3次元ベクトルを正規化する
+	SceneVector3 Normalize(const SceneVector3& v)
+	{
+		float length = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+		return { v.x / length, v.y / length, v.z / length };
+	}
+
+	// 外積を計算する
+	SceneVector3 Cross(const SceneVector3& a, const SceneVector3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	// 内積を計算する
+	float Dot(const SceneVector3& a, const SceneVector3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+}
+
+// 処理段階の名前を取得する
+const char* FrameBenchmark::GetStageName(int stage)
+{
+	return STAGE_NAMES[stage];
+}
+
+// シーンのリソースをヌルバックエンドに登録し、境界ボリューム階層を構築する
+FrameBenchmark::FrameBenchmark(GeneratedScene& scene, bool instanced)
+	: m_scene(scene), m_visibleCount(0), m_instanced(instanced)
+{
+	// シェーダとマテリアルは使われている番号まで、メッシュは形状ごとに登録する
+	uint32_t shaderCount = 0;
+	uint32_t materialCount = 0;
+	for (size_t i = 0; i < scene.meshNodes.size(); i++)
+	{
+		shaderCount = std::max(shaderCount, scene.meshShaders[i] + 1);
+		materialCount = std::max(materialCount, scene.meshMaterials[i] + 1);
+	}
+	for (uint32_t i = 0; i < shaderCount; i++)
+		m_backend.AddShader();
+	for (uint32_t i = 0; i < materialCount; i++)
+		m_backend.AddMaterial();
+	for (const MeshData& shape : scene.shapes)
+	{
+		m_backend.AddMesh(uint32_t(shape.subMeshes.size()), uint32_t(shape.indices.size() / 3));
+		m_shapeBounds.push_back(shape.bounds);
+	}
+
+	// 初期配置のワールド空間の境界ボックスで境界ボリューム階層を構築する
+	scene.sceneGraph.UpdateWorldTransforms();
+	m_worldBounds.resize(scene.meshNodes.size());
+	m_visible.resize(scene.meshNodes.size());
+	for (size_t i = 0; i < scene.meshNodes.size(); i++)
+	{
+		m_worldBounds[i] = FrustumCuller::TransformBounds(m_shapeBounds[scene.meshShapes[i]], scene.sceneGraph.GetWorldMatrix(scene.meshNodes[i]).m);
+	}
+	m_bvh.Build(m_worldBounds.data(), m_worldBounds.size());
+}
+
+// 指定された番号のフレームを実行し、処理段階ごとの時間(秒)を書き込む
+void FrameBenchmark::RunFrame(uint32_t frame, double stageSeconds[STAGE_COUNT])
+{
+	DX::ClockSource& clock = DX::GetDefaultClock();
+	double frequency = double(clock.GetFrequency());
+	SceneGraph& sceneGraph = m_scene.sceneGraph;
+
+	// 回転させるノードを動かし、変更されたノードとその子孫のワールド行列を更新する
+	uint64_t start = clock.GetCounter();
+	for (size_t i = 0; i < m_scene.animatedNodes.size(); i++)
+	{
+		float angle = float(frame) * ANIMATION_SPEED + float(i) * 0.1f;
+		sceneGraph.SetLocalRotation(m_scene.animatedNodes[i], { 0.0f, sinf(angle * 0.5f), 0.0f, cosf(angle * 0.5f) });
+	}
+	size_t updated = sceneGraph.UpdateWorldTransforms();
+	uint64_t end = clock.GetCounter();
+	stageSeconds[STAGE_TRAVERSAL] = double(end - start) / frequency;
+
+	// 変更があればワールド空間の境界ボックスを更新して再適合させる
+	start = end;
+	if (updated > 0)
+	{
+		for (size_t i = 0; i < m_scene.meshNodes.size(); i++)
+		{
+			m_worldBounds[i] = FrustumCuller::TransformBounds(m_shapeBounds[m_scene.meshShapes[i]], sceneGraph.GetWorldMatrix(m_scene.meshNodes[i]).m);
+		}
+		m_bvh.Refit(m_worldBounds.data());
+	}
+	end = clock.GetCounter();
+	stageSeconds[STAGE_TRANSFORMS] = double(end - start) / frequency;
+
+	// 視錐台と交差するメッシュを判定する
+	start = end;
+	SceneMatrix view, projection, viewProjection;
+	CreateCamera(frame, view.m, projection.m);
+	SceneGraph::Multiply(view, projection, viewProjection);
+	FrustumCuller culler(viewProjection.m);
+	m_visibleCount = m_bvh.CullFrustum(culler, m_visible.data());
+	end = clock.GetCounter();
+	stageSeconds[STAGE_CULLING] = double(end - start) / frequency;
+
+	// 見えるメッシュを境界ボックスの中心のビュー空間の深度で手前から並べ、状態の切り替えを省いたコマンド列にする
+	// インスタンス描画のシーンは同じ形状とマテリアルのメッシュをまとめ、インスタンスデータを作成する
+	start = end;
+	float farPlane = m_scene.radius * FAR_PLANE_SCALE;
+	m_renderQueue.Clear();
+	for (size_t i = 0; i < m_scene.meshNodes.size(); i++)
+	{
+		if (!m_visible[i])
+			continue;
+		if (m_instanced)
+		{
+			m_renderQueue.SubmitInstance(0, m_scene.meshShaders[i], m_scene.meshMaterials[i], m_scene.meshShapes[i],
+				sceneGraph.GetWorldMatrix(m_scene.meshNodes[i]).m, &m_scene.meshColors[i * 4]);
+			continue;
+		}
+
+		const MeshBounds& bounds = m_worldBounds[i];
+		float x = (bounds.minimum[0] + bounds.maximum[0]) * 0.5f;
+		float y = (bounds.minimum[1] + bounds.maximum[1]) * 0.5f;
+		float z = (bounds.minimum[2] + bounds.maximum[2]) * 0.5f;
+		float depth = -(x * view.m[2] + y * view.m[6] + z * view.m[10] + view.m[14]) / farPlane;
+		m_renderQueue.Submit(0, m_scene.meshShaders[i], m_scene.meshMaterials[i], m_scene.meshShapes[i], depth,
+			sceneGraph.GetWorldMatrix(m_scene.meshNodes[i]).m);
+	}
+	m_renderQueue.Sort();
+	m_commands.Clear();
+	m_renderQueue.Record(m_commands);
+	end = clock.GetCounter();
+	stageSeconds[STAGE_BATCHING] = double(end - start) / frequency;
+
+	// コマンド列をバックエンドで実行する
+	start = end;
+	m_backend.ResetStatistics();
+	m_backend.SetViewProjection(view.m, projection.m);
+	m_commands.Execute(m_backend);
+	end = clock.GetCounter();
+	stageSeconds[STAGE_SUBMISSION] = double(end - start) / frequency;
+}
+
+// フレーム番号のカメラのビュー行列と射影行列を作成する(右手系、クリップ空間のzは0～w)
+void FrameBenchmark::CreateCamera(uint32_t frame, float view[16], float projection[16]) const
+{
+	// シーンの内側を回り、シーンの一部だけが見えるようにする
+	float angle = float(frame) * CAMERA_SPEED;
+	float distance = m_scene.radius * 0.75f;
+	SceneVector3 target = { m_scene.center[0], m_scene.center[1], m_scene.center[2] };
+	SceneVector3 eye = { target.x + cosf(angle) * distance, target.y + distance * 0.25f, target.z + sinf(angle) * distance };
+	SceneVector3 up = { 0.0f, 1.0f, 0.0f };
+
+	SceneVector3 zAxis = Normalize({ eye.x - target.x, eye.y - target.y, eye.z - target.z });
+	SceneVector3 xAxis = Normalize(Cross(up, zAxis));
+	SceneVector3 yAxis = Cross(zAxis, xAxis);
+	const float viewMatrix[16] =
+	{
+		xAxis.x, yAxis.x, zAxis.x, 0.0f,
+		xAxis.y, yAxis.y, zAxis.y, 0.0f,
+		xAxis.z, yAxis.z, zAxis.z, 0.0f,
+		-Dot(xAxis, eye), -Dot(yAxis, eye), -Dot(zAxis, eye), 1.0f,
+	};
+
+	float farPlane = m_scene.radius * FAR_PLANE_SCALE;
+	float height = 1.0f / tanf(FIELD_OF_VIEW * 0.5f);
+	float range = farPlane / (NEAR_PLANE - farPlane);
+	const float projectionMatrix[16] =
+	{
+		height / ASPECT_RATIO, 0.0f, 0.0f, 0.0f,
+		0.0f, height, 0.0f, 0.0f,
+		0.0f, 0.0f, range, -1.0f,
+		0.0f, 0.0f, range * NEAR_PLANE, 0.0f,
+	};
+	for (int i = 0; i < 16; i++)
+	{
+		view[i] = viewMatrix[i];
+		projection[i] = projectionMatrix[i];
+	}
+}
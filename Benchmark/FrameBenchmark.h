@@ -0,0 +1,91 @@
+﻿#pragma once
+#ifndef FRAMEBENCHMARK_DEFINED
+#define FRAMEBENCHMARK_DEFINED
+
+#include <stdint.h>
+#include <vector>
+#include "SceneGenerator.h"
+#include "BoundingVolumeHierarchy.h"
+#include "NullRenderBackend.h"
+#include "RenderQueue.h"
+
+// 生成したシーンでフレームのCPU側の処理(MyGameのスナップショットの作成と描画キューの実行)を段階ごとに計測するクラス
+// カメラはシーンの周りを決まった速さで回るので、同じシーンとフレーム番号なら毎回同じ処理になる
+class FrameBenchmark
+{
+public:
+	// 処理段階
+	enum Stage
+	{
+		// シーングラフを辿ってワールド行列を更新する
+		STAGE_TRAVERSAL,
+		// 境界ボックスをワールド空間に変換して境界ボリューム階層を再適合させる
+		STAGE_TRANSFORMS,
+		// 境界ボリューム階層を辿って視錐台カリングをおこなう
+		STAGE_CULLING,
+		// 見えるメッシュを描画キューに積んでソートし、コマンド列を作る
+		STAGE_BATCHING,
+		// コマンド列をヌルバックエンドで実行する
+		STAGE_SUBMISSION,
+		// 処理段階の数
+		STAGE_COUNT
+	};
+
+	// 処理段階の名前を取得する
+	static const char* GetStageName(int stage);
+
+	// シーンのリソースをヌルバックエンドに登録し、境界ボリューム階層を構築する(instancedならインスタンス描画する)
+	explicit FrameBenchmark(GeneratedScene& scene, bool instanced = false);
+
+	// 指定された番号のフレームを実行し、処理段階ごとの時間(秒)を書き込む
+	void RunFrame(uint32_t frame, double stageSeconds[STAGE_COUNT]);
+
+	// 直前のフレームで見えたメッシュの数を取得する
+	size_t GetVisibleCount() const
+	{
+		return m_visibleCount;
+	}
+	// 直前のフレームの状態の切り替え数と描画数を取得する
+	const RenderStatistics& GetRenderStatistics() const
+	{
+		return m_backend.GetStatistics();
+	}
+	// 直前のフレームの三角形の数を取得する
+	uint64_t GetTriangles() const
+	{
+		return m_backend.GetTriangles();
+	}
+	// これまでの描画のチェックサムを取得する
+	uint64_t GetChecksum() const
+	{
+		return m_backend.GetChecksum();
+	}
+
+private:
+	// フレーム番号のカメラのビュー行列と射影行列を作成する
+	void CreateCamera(uint32_t frame, float view[16], float projection[16]) const;
+
+private:
+	// シーン
+	GeneratedScene& m_scene;
+	// 形状のローカル境界ボックス
+	std::vector<MeshBounds> m_shapeBounds;
+	// 描画項目ごとのワールド空間の境界ボックス
+	std::vector<MeshBounds> m_worldBounds;
+	// 描画項目ごとの可視判定結果
+	std::vector<uint8_t> m_visible;
+	// 境界ボリューム階層
+	BoundingVolumeHierarchy m_bvh;
+	// 描画キュー
+	RenderQueue m_renderQueue;
+	// 描画コマンド
+	RenderCommandList m_commands;
+	// ヌルバックエンド
+	NullRenderBackend m_backend;
+	// 直前のフレームで見えたメッシュの数
+	size_t m_visibleCount;
+	// インスタンス描画するかどうか
+	bool m_instanced;
+};
+
+#endif	// FRAMEBENCHMARK_DEFINED
@@ -0,0 +1,156 @@
+﻿// ImportBenchmark.cpp - メッシュの変換と最適化を並列化したときの速度向上を計測する
+//
+// ImportBenchmark [メッシュ数] [最大スレッド数]
+//     合成した球のメッシュ(コントロールポイントとポリゴン頂点の配列で、FBXからインポートした直後と同じ形式)を、
+//     FbxMeshImporter::Importと同じようにメッシュごとのジョブで変換・最適化し、1スレッドから最大スレッド数までの時間を比較する
+//     FBXの読み込みと三角ポリゴン化は逐次処理なので含めない
+
+#include <algorithm>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <memory>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BenchmarkTimer.h"
+#include "JobSystem.h"
+#include "MeshConverter.h"
+#include "MeshOptimizer.h"
+
+namespace
+{
+	// 合成したメッシュの変換元の配列
+	struct SyntheticMesh
+	{
+		std::string name;
+		std::vector<double> controlPoints;
+		std::vector<int> polygonVertices;
+		std::vector<int> polygonMaterials;
+		double worldMatrix[16];
+	};
+
+	// マテリアル名
+	const char* const MATERIAL_NAMES[] = { "upper", "lower" };
+
+	// 緯度と経度の格子で球を作成する(上半分と下半分でマテリアルを分ける)
+	void MakeSphere(uint32_t index, uint32_t rings, uint32_t segments, SyntheticMesh& mesh)
+	{
+		const double pi = 3.14159265358979;
+		mesh.name = "sphere" + std::to_string(index);
+		double radius = 1.0 + 0.01 * double(index % 17);
+		for (uint32_t ring = 0; ring <= rings; ring++)
+		{
+			double theta = pi * double(ring) / double(rings);
+			for (uint32_t segment = 0; segment < segments; segment++)
+			{
+				double phi = 2.0 * pi * double(segment) / double(segments);
+				double point[4] = { radius * sin(theta) * cos(phi), radius * cos(theta), radius * sin(theta) * sin(phi), 1.0 };
+				mesh.controlPoints.insert(mesh.controlPoints.end(), point, point + 4);
+			}
+		}
+		for (uint32_t ring = 0; ring < rings; ring++)
+		{
+			for (uint32_t segment = 0; segment < segments; segment++)
+			{
+				int a = int(ring * segments + segment);
+				int b = int(ring * segments + (segment + 1) % segments);
+				int quad[6] = { a, a + int(segments), b, b, a + int(segments), b + int(segments) };
+				mesh.polygonVertices.insert(mesh.polygonVertices.end(), quad, quad + 6);
+				int material = ring < rings / 2 ? 0 : 1;
+				mesh.polygonMaterials.push_back(material);
+				mesh.polygonMaterials.push_back(material);
+			}
+		}
+		MeshConverter::SetIdentity(mesh.worldMatrix);
+		mesh.worldMatrix[12] = 3.0 * double(index % 8);
+		mesh.worldMatrix[14] = 3.0 * double(index / 8);
+	}
+
+	// FbxMeshImporter::ConvertMeshと同じく、メッシュを変換して最適化する
+	void ConvertMesh(const SyntheticMesh& synthetic, MeshData& mesh)
+	{
+		MeshSource source;
+		source.name = synthetic.name.c_str();
+		source.controlPoints = synthetic.controlPoints.data();
+		source.controlPointCount = int(synthetic.controlPoints.size() / 4);
+		source.polygonVertices = synthetic.polygonVertices.data();
+		source.polygonVertexCount = int(synthetic.polygonVertices.size());
+		source.polygonMaterials = synthetic.polygonMaterials.data();
+		source.materialNames = MATERIAL_NAMES;
+		source.materialCount = 2;
+		std::copy(synthetic.worldMatrix, synthetic.worldMatrix + 16, source.worldMatrix);
+		MeshConverter::Convert(source, mesh);
+		MeshOptimizer::Optimize(mesh);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		uint32_t meshCount = argc >= 2 ? uint32_t(std::max(atoi(argv[1]), 1)) : 64;
+		unsigned maxThreads = argc >= 3 ? unsigned(std::max(atoi(argv[2]), 1)) : std::max(std::thread::hardware_concurrency(), 1u);
+
+		// 大きさの異なるメッシュが混ざるようにする
+		std::vector<SyntheticMesh> sources(meshCount);
+		uint64_t triangles = 0;
+		for (uint32_t i = 0; i < meshCount; i++)
+		{
+			MakeSphere(i, 32 + 32 * (i % 4), 128, sources[i]);
+			triangles += sources[i].polygonVertices.size() / 3;
+		}
+		std::cout << "meshes " << meshCount << "  triangles " << triangles << std::endl;
+
+		double baseline = 0.0;
+		for (unsigned threads = 1; threads <= maxThreads; threads++)
+		{
+			// 1スレッドの場合は逐次変換、それ以外は呼び出し元を含めてthreads本のスレッドで変換する
+			std::unique_ptr<JobSystem> jobSystem;
+			if (threads > 1)
+				jobSystem = std::make_unique<JobSystem>(threads - 1);
+			std::vector<MeshData> meshes(meshCount);
+			std::vector<std::exception_ptr> errors(meshCount);
+			auto convert = [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					try
+					{
+						ConvertMesh(sources[i], meshes[i]);
+					}
+					catch (...)
+					{
+						errors[i] = std::current_exception();
+					}
+				}
+			};
+			double seconds = MeasureFastest(3, [&]()
+			{
+				if (jobSystem)
+					jobSystem->ParallelFor(sources.size(), 1, convert);
+				else
+					convert(0, sources.size());
+			});
+			for (const std::exception_ptr& error : errors)
+			{
+				if (error)
+					std::rethrow_exception(error);
+			}
+			if (threads == 1)
+				baseline = seconds;
+
+			std::cout << "threads " << std::setw(3) << std::right << threads << std::fixed << std::setprecision(3)
+				<< "  " << seconds * 1000.0 << " ms  speedup " << baseline / seconds << std::endl;
+		}
+		return 0;
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << "error: " << exception.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,124 @@
+﻿// JobBenchmark.cpp - ジョブシステムとタスクグラフの負荷とスケーリングをスレッド数ごとに計測する
+//
+// JobBenchmark [ジョブ数] [最大スレッド数]
+//     外部スレッドとワーカーからの空のジョブの投入と実行の負荷、ParallelForのスケーリング、
+//     タスクグラフの実行時間を、1スレッドから最大スレッド数まで倍々に計測する(既定は100万ジョブ、ハードウェアスレッド数)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <memory>
+#include <stdint.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+#include "JobSystem.h"
+#include "TaskGraph.h"
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// ParallelForの要素数と粒度
+	const size_t ELEMENT_COUNT = 1 << 24;
+	const size_t GRAIN_SIZE = 4096;
+	// タスクグラフのステージごとのタスク数、ステージ数、実行回数
+	const int GRAPH_LANES = 16;
+	const int GRAPH_STAGES = 4;
+	const int GRAPH_RUNS = 1000;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t jobCount = argc >= 2 ? size_t(std::max(atoi(argv[1]), 64)) : 1000000;
+	unsigned maxThreads = argc >= 3 ? unsigned(std::max(atoi(argv[2]), 1)) : std::thread::hardware_concurrency();
+	maxThreads = std::min(std::max(maxThreads, 1u), 64u);
+
+	// ParallelForの負荷(要素ごとに平方根を足す)
+	std::vector<double> partials(ELEMENT_COUNT / GRAIN_SIZE);
+	auto sumRange = [&](size_t begin, size_t end)
+	{
+		double sum = 0.0;
+		for (size_t i = begin; i < end; i++)
+			sum += sqrt(double(i));
+		partials[begin / GRAIN_SIZE] = sum;
+	};
+	// タスクグラフ(ステージごとにGRAPH_LANES個のタスクを並べ、各タスクは前のステージの全タスクに依存する)
+	std::atomic<uint32_t> graphWork(0);
+	TaskGraph graph;
+	for (int stage = 0; stage < GRAPH_STAGES; stage++)
+	{
+		for (int lane = 0; lane < GRAPH_LANES; lane++)
+		{
+			TaskGraph::TaskId task = graph.AddTask("task", [&graphWork]() { graphWork.fetch_add(1, std::memory_order_relaxed); });
+			for (int previous = 0; stage > 0 && previous < GRAPH_LANES; previous++)
+				graph.AddDependency(TaskGraph::TaskId((stage - 1) * GRAPH_LANES + previous), task);
+		}
+	}
+
+	double forBaseline = 0.0;
+	for (unsigned threads = 1; threads <= maxThreads; threads = threads < maxThreads ? std::min(threads * 2, maxThreads) : threads + 1)
+	{
+		std::cout << "threads " << std::setw(3) << std::right << threads << std::fixed << std::setprecision(1);
+
+		// 1スレッドの場合は逐次実行、それ以外は呼び出し元を含めてthreads本のスレッドで実行する
+		std::unique_ptr<JobSystem> jobSystem;
+		if (threads > 1)
+		{
+			jobSystem = std::make_unique<JobSystem>(threads - 1);
+
+			// 外部スレッドから空のジョブを投入して完了を待つ
+			JobCounter counter;
+			auto start = Clock::now();
+			for (size_t i = 0; i < jobCount; i++)
+				jobSystem->Run([]() {}, counter);
+			jobSystem->Wait(counter);
+			double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+			std::cout << "  spawn " << seconds * 1e9 / jobCount << " ns/job";
+
+			// ワーカーから空のジョブを投入する(自分のキューに積んで他のワーカーが盗み取る)
+			start = Clock::now();
+			for (size_t root = 0; root < 64; root++)
+			{
+				jobSystem->Run([&jobSystem, jobCount]()
+				{
+					JobCounter children;
+					for (size_t i = 0; i < jobCount / 64; i++)
+						jobSystem->Run([]() {}, children);
+					jobSystem->Wait(children);
+				}, counter);
+			}
+			jobSystem->Wait(counter);
+			seconds = std::chrono::duration<double>(Clock::now() - start).count();
+			std::cout << "  nested " << seconds * 1e9 / (jobCount / 64 * 64) << " ns/job";
+		}
+
+		// ParallelFor
+		auto start = Clock::now();
+		if (jobSystem)
+			jobSystem->ParallelFor(ELEMENT_COUNT, GRAIN_SIZE, sumRange);
+		else
+			for (size_t begin = 0; begin < ELEMENT_COUNT; begin += GRAIN_SIZE)
+				sumRange(begin, begin + GRAIN_SIZE);
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		if (threads == 1)
+			forBaseline = seconds;
+		std::cout << std::setprecision(3) << "  parallel_for " << seconds * 1000.0 << " ms  speedup " << forBaseline / seconds;
+
+		// タスクグラフ
+		start = Clock::now();
+		for (int run = 0; run < GRAPH_RUNS; run++)
+		{
+			if (jobSystem)
+				graph.Run(*jobSystem);
+			else
+				graph.RunSerial();
+		}
+		seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		std::cout << std::setprecision(1) << "  graph " << seconds * 1e6 / GRAPH_RUNS << " us/run" << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,134 @@
+﻿// KernelBenchmark.cpp - 変換カーネルと要素ごとの変換の速度を比較する
+//
+// KernelBenchmark [要素数]
+//     行列の積、点の変換、コントロールポイントの変換を、要素ごとに関数を呼び出す素朴なループと、
+//     CPUが対応している命令セットごとの変換カーネルで計測する(既定は100万要素)
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "MeshData.h"
+#include "TransformKernel.h"
+
+namespace
+{
+	// 計測する繰り返しの回数
+	const int ITERATIONS = 10;
+
+	// 4x4行列(要素ごとの変換で使う、最適化されていない行列型)
+	struct Matrix4
+	{
+		float m[16];
+	};
+
+	// Z軸回りの回転と平行移動の行列を作成する
+	Matrix4 RotationTranslation(float angle, float x, float y, float z)
+	{
+		float c = cosf(angle), s = sinf(angle);
+		return { { c, s, 0.0f, 0.0f, -s, c, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, x, y, z, 1.0f } };
+	}
+
+	// 行列の積(要素ごとのループ)
+	Matrix4 Multiply(const Matrix4& a, const Matrix4& b)
+	{
+		Matrix4 result;
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				float sum = 0.0f;
+				for (int k = 0; k < 4; k++)
+					sum += a.m[row * 4 + k] * b.m[k * 4 + column];
+				result.m[row * 4 + column] = sum;
+			}
+		}
+		return result;
+	}
+
+	// 点の変換(要素ごとのループ)
+	void Transform(const float point[3], const Matrix4& matrix, float result[3])
+	{
+		for (int axis = 0; axis < 3; axis++)
+			result[axis] = point[0] * matrix.m[axis] + point[1] * matrix.m[4 + axis] + point[2] * matrix.m[8 + axis] + matrix.m[12 + axis];
+	}
+
+	// 計測して1回あたりのミリ秒を出力する
+	void Measure(const std::string& name, const std::function<void()>& body)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int n = 0; n < ITERATIONS; n++)
+			body();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::setw(32) << std::left << name << std::fixed << std::setprecision(3)
+			<< seconds * 1000.0 / ITERATIONS << " ms" << std::endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	size_t count = argc >= 2 ? size_t(std::max(atoi(argv[1]), 1)) : 1000000;
+	Matrix4 matrix = RotationTranslation(0.5f, 1.0f, 2.0f, 3.0f);
+	double controlMatrix[16];
+	for (int i = 0; i < 16; i++)
+		controlMatrix[i] = double(matrix.m[i]);
+	std::vector<Matrix4> matrices(count, RotationTranslation(0.25f, 0.0f, 0.0f, 0.0f));
+	std::vector<Matrix4> resultMatrices(count);
+	std::vector<MeshVertex> vertices(count, MeshVertex{ { 1.0f, 2.0f, 3.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } });
+	std::vector<double> controlPoints(count * 4, 1.0);
+
+	Measure("matrices  per element", [&]()
+	{
+		for (size_t i = 0; i < count; i++)
+			resultMatrices[i] = Multiply(matrices[i], matrix);
+	});
+	Measure("points    per element", [&]()
+	{
+		for (MeshVertex& vertex : vertices)
+		{
+			float position[3];
+			Transform(vertex.position, matrix, position);
+			std::copy(position, position + 3, vertex.position);
+		}
+	});
+	Measure("control   scalar loop", [&]()
+	{
+		const double* m = controlMatrix;
+		for (size_t i = 0; i < count; i++)
+		{
+			const double* point = controlPoints.data() + i * 4;
+			vertices[i].position[0] = float(point[0] * m[0] + point[1] * m[4] + point[2] * m[8] + m[12]);
+			vertices[i].position[1] = float(point[0] * m[1] + point[1] * m[5] + point[2] * m[9] + m[13]);
+			vertices[i].position[2] = float(point[0] * m[2] + point[1] * m[6] + point[2] * m[10] + m[14]);
+		}
+	});
+
+	// CPUが対応している命令セットごとに計測する
+	TransformKernel::InstructionSet supported = TransformKernel::GetSupportedInstructionSet();
+	for (int set = TransformKernel::SCALAR; set <= supported; set++)
+	{
+		TransformKernel::SetInstructionSet(TransformKernel::InstructionSet(set));
+		std::string name = TransformKernel::GetInstructionSetName(TransformKernel::InstructionSet(set));
+		Measure("matrices  " + name, [&]()
+		{
+			TransformKernel::MultiplyMatrices(resultMatrices[0].m, matrices[0].m, matrix.m, count);
+		});
+		Measure("points    " + name, [&]()
+		{
+			TransformKernel::TransformPoints(vertices[0].position, sizeof(MeshVertex),
+				vertices[0].position, sizeof(MeshVertex), count, matrix.m);
+		});
+		Measure("control   " + name, [&]()
+		{
+			TransformKernel::ConvertControlPoints(vertices[0].position, sizeof(MeshVertex),
+				controlPoints.data(), count, controlMatrix);
+		});
+	}
+	TransformKernel::SetInstructionSet(supported);
+	return 0;
+}
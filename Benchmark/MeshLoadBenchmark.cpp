@@ -0,0 +1,122 @@
+﻿// MeshLoadBenchmark.cpp - 大きな合成メッシュのバイナリメッシュファイルを開く時間を計測する
+//
+// MeshLoadBenchmark [格子の一辺の数] [繰り返し回数]
+//     格子状のメッシュ(一辺1024なら約105万頂点、210万三角形)を書き出し、
+//     メモリマップして検証するまでの時間、すべてのページに触れるまでの時間、ファイル全体を読み込んでコピーする時間を比較する
+//     直前に書き出したファイルなので、どれもOSのファイルキャッシュに載った状態での時間になる
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "BenchmarkTimer.h"
+#include "MeshConverter.h"
+#include "MeshFile.h"
+
+namespace
+{
+	// 書き出すファイル
+	const char* const FILENAME = "MeshLoadBenchmark.mesh";
+	// ページサイズ(ページに触れる間隔)
+	const size_t PAGE_SIZE = 4096;
+
+	// 凹凸のある格子状のメッシュを作成する
+	void MakeGrid(uint32_t side, MeshData& mesh)
+	{
+		mesh.name = "grid";
+		mesh.vertices.reserve(size_t(side + 1) * (side + 1));
+		for (uint32_t y = 0; y <= side; y++)
+		{
+			for (uint32_t x = 0; x <= side; x++)
+			{
+				float height = 0.25f * sinf(float(x) * 0.37f) * cosf(float(y) * 0.21f);
+				mesh.vertices.push_back({ { float(x), height, float(y) }, { 1.0f, 1.0f, 1.0f, 1.0f } });
+			}
+		}
+		mesh.indices.reserve(size_t(side) * side * 6);
+		for (uint32_t y = 0; y < side; y++)
+		{
+			for (uint32_t x = 0; x < side; x++)
+			{
+				uint32_t corner = y * (side + 1) + x;
+				uint32_t quad[6] = { corner, corner + side + 1, corner + 1, corner + 1, corner + side + 1, corner + side + 2 };
+				mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+			}
+		}
+		mesh.subMeshes = { { 0, uint32_t(mesh.indices.size()), 0 } };
+		mesh.materials = { "default" };
+		mesh.bounds = MeshConverter::ComputeBounds(mesh.vertices.data(), mesh.vertices.size());
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		uint32_t side = argc >= 2 ? uint32_t(std::max(atoi(argv[1]), 2)) : 1024;
+		uint32_t repetitions = argc >= 3 ? uint32_t(std::max(atoi(argv[2]), 1)) : 5;
+
+		std::vector<MeshData> meshes(1);
+		MakeGrid(side, meshes[0]);
+		MeshFile::Write(FILENAME, meshes);
+		const MeshData& mesh = meshes[0];
+		double megabytes = double(mesh.vertices.size() * sizeof(MeshVertex) + mesh.indices.size() * sizeof(uint32_t)) / (1024.0 * 1024.0);
+		std::cout << "vertices " << mesh.vertices.size() << "  triangles " << mesh.indices.size() / 3 << "  data "
+			<< std::fixed << std::setprecision(1) << megabytes << " MB" << std::endl;
+
+		// メモリマップしてヘッダ、範囲、インデックスを検証する(MyGameが起動時におこなう処理)
+		uint32_t vertexCount = 0;
+		double openSeconds = MeasureFastest(repetitions, [&]()
+		{
+			MeshFile file(FILENAME);
+			vertexCount = file.GetMesh(0).vertexCount;
+		});
+		// 開いた後に頂点とインデックスのすべてのページに触れる(GPUへの転送で読まれるのと同じ量)
+		uint32_t touched = 0;
+		double touchSeconds = MeasureFastest(repetitions, [&]()
+		{
+			MeshFile file(FILENAME);
+			MeshView view = file.GetMesh(0);
+			const uint8_t* vertices = reinterpret_cast<const uint8_t*>(view.vertices);
+			for (size_t offset = 0; offset < view.vertexCount * sizeof(MeshVertex); offset += PAGE_SIZE)
+				touched += vertices[offset];
+			const uint8_t* indices = reinterpret_cast<const uint8_t*>(view.indices);
+			for (size_t offset = 0; offset < view.indexCount * sizeof(uint32_t); offset += PAGE_SIZE)
+				touched += indices[offset];
+		});
+		// 比較のため、ファイル全体を読み込んで頂点とインデックスを配列にコピーする
+		size_t copied = 0;
+		double copySeconds = MeasureFastest(repetitions, [&]()
+		{
+			std::ifstream stream(FILENAME, std::ios::binary | std::ios::ate);
+			std::vector<char> image(size_t(stream.tellg()));
+			stream.seekg(0);
+			stream.read(image.data(), std::streamsize(image.size()));
+			const MeshFileHeader& header = *reinterpret_cast<const MeshFileHeader*>(image.data());
+			const MeshFileMesh& record = *reinterpret_cast<const MeshFileMesh*>(image.data() + header.meshTableOffset);
+			const MeshVertex* vertices = reinterpret_cast<const MeshVertex*>(image.data() + record.vertexOffset);
+			const uint32_t* indices = reinterpret_cast<const uint32_t*>(image.data() + record.indexOffset);
+			std::vector<MeshVertex> vertexCopy(vertices, vertices + record.vertexCount);
+			std::vector<uint32_t> indexCopy(indices, indices + record.indexCount);
+			copied = vertexCopy.size() + indexCopy.size();
+		});
+		remove(FILENAME);
+
+		std::cout << std::setprecision(3)
+			<< "map and validate  " << openSeconds * 1000.0 << " ms" << std::endl
+			<< "map and touch     " << touchSeconds * 1000.0 << " ms" << std::endl
+			<< "read and copy     " << copySeconds * 1000.0 << " ms" << std::endl;
+		// 結果を使い、計測した処理が最適化で消されないようにする
+		return vertexCount == mesh.vertices.size() && copied > 0 && touched != 0xFFFFFFFF ? 0 : 1;
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << "error: " << exception.what() << std::endl;
+		remove(FILENAME);
+		return 1;
+	}
+}
@@ -0,0 +1,171 @@
+﻿// MeshOptimizerBenchmark.cpp - メッシュの最適化の各パスの時間と、キャッシュの統計の変化を計測する
+//
+// MeshOptimizerBenchmark [メッシュファイル...]
+//     合成したメッシュ(三角形をシャッフルした格子、行の順に並んだ球、ベンチマークシーンの形状)と、
+//     指定されたバイナリメッシュファイルのメッシュ(「-bake 入力.fbx 出力.mesh -nooptimize」で最適化せずに書き出したもの)を最適化し、
+//     パスごとの時間とACMR、ATVR、オーバーフェッチを表示する
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "BenchmarkTimer.h"
+#include "MeshConverter.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "SceneGenerator.h"
+
+namespace
+{
+	// 三角形をシャッフルした格子状のメッシュを作成する
+	void MakeShuffledGrid(uint32_t side, MeshData& mesh)
+	{
+		mesh.name = "shuffled_grid";
+		for (uint32_t y = 0; y <= side; y++)
+		{
+			for (uint32_t x = 0; x <= side; x++)
+				mesh.vertices.push_back({ { float(x), 0.0f, float(y) }, { 1.0f, 1.0f, 1.0f, 1.0f } });
+		}
+		// 三角形の番号は、格子の升目の番号の2倍(左下)と2倍+1(右上)
+		std::vector<uint32_t> triangles(size_t(side) * side * 2);
+		for (uint32_t i = 0; i < triangles.size(); i++)
+			triangles[i] = i;
+		std::mt19937 random(1);
+		std::shuffle(triangles.begin(), triangles.end(), random);
+		for (uint32_t triangle : triangles)
+		{
+			uint32_t cell = triangle / 2;
+			uint32_t corner = cell / side * (side + 1) + cell % side;
+			if (triangle % 2 == 0)
+				mesh.indices.insert(mesh.indices.end(), { corner, corner + side + 1, corner + 1 });
+			else
+				mesh.indices.insert(mesh.indices.end(), { corner + 1, corner + side + 1, corner + side + 2 });
+		}
+	}
+
+	// 緯度と経度の格子で球を作成する(三角形は行の順に並ぶ)
+	void MakeSphere(uint32_t rings, uint32_t segments, MeshData& mesh)
+	{
+		const float pi = 3.14159265f;
+		mesh.name = "sphere";
+		for (uint32_t ring = 0; ring <= rings; ring++)
+		{
+			float theta = pi * float(ring) / float(rings);
+			for (uint32_t segment = 0; segment < segments; segment++)
+			{
+				float phi = 2.0f * pi * float(segment) / float(segments);
+				mesh.vertices.push_back({ { sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi) }, { 1.0f, 1.0f, 1.0f, 1.0f } });
+			}
+		}
+		for (uint32_t ring = 0; ring < rings; ring++)
+		{
+			for (uint32_t segment = 0; segment < segments; segment++)
+			{
+				uint32_t a = ring * segments + segment;
+				uint32_t b = ring * segments + (segment + 1) % segments;
+				mesh.indices.insert(mesh.indices.end(), { a, a + segments, b, b, a + segments, b + segments });
+			}
+		}
+	}
+
+	// バイナリメッシュファイルのメッシュを読み込む(量子化した頂点は復号する)
+	void LoadMeshes(const char* filename, std::vector<MeshData>& meshes)
+	{
+		MeshFile file(filename);
+		for (uint32_t i = 0; i < file.GetMeshCount(); i++)
+		{
+			MeshView view = file.GetMesh(i);
+			MeshData mesh;
+			mesh.name = std::string(filename) + ":" + view.name;
+			mesh.vertices.resize(view.vertexCount);
+			if (view.vertices)
+				std::copy(view.vertices, view.vertices + view.vertexCount, mesh.vertices.begin());
+			else
+				VertexQuantizer::Dequantize(mesh.vertices.data(), view.quantizedVertices, view.vertexCount, view.bounds);
+			mesh.indices.assign(view.indices, view.indices + view.indexCount);
+			mesh.subMeshes.assign(view.subMeshes, view.subMeshes + view.subMeshCount);
+			meshes.push_back(mesh);
+		}
+	}
+
+	// 統計を表示する(時間が負の場合は時間を表示しない)
+	void PrintStatistics(const char* pass, double seconds, const MeshCacheStatistics& statistics)
+	{
+		std::cout << "  " << std::left << std::setw(14) << pass << std::right << std::fixed << std::setprecision(3) << std::setw(10);
+		if (seconds < 0.0)
+			std::cout << "" << "   ";
+		else
+			std::cout << seconds * 1000.0 << " ms";
+		std::cout << "  acmr " << statistics.acmr << "  atvr " << statistics.atvr
+			<< "  overfetch " << statistics.overfetch << std::endl;
+	}
+
+	// メッシュを最適化し、パスごとの時間と統計を表示する
+	void Optimize(const MeshData& source)
+	{
+		MeshData mesh = source;
+		if (mesh.subMeshes.empty())
+			mesh.subMeshes.push_back({ 0, uint32_t(mesh.indices.size()), 0 });
+		mesh.bounds = MeshConverter::ComputeBounds(mesh.vertices.data(), mesh.vertices.size());
+		std::cout << mesh.name << "  vertices " << mesh.vertices.size() << "  triangles " << mesh.indices.size() / 3 << std::endl;
+		size_t vertexCount = mesh.vertices.size();
+		PrintStatistics("original", -1.0, MeshOptimizer::Analyze(mesh.indices.data(), mesh.indices.size(), vertexCount));
+
+		// Optimizeと同じ順に、サブメッシュごとに各パスを適用する
+		std::vector<uint32_t> work(mesh.indices.size());
+		double seconds = MeasureFastest(1, [&]()
+		{
+			for (const SubMesh& range : mesh.subMeshes)
+				MeshOptimizer::OptimizeVertexCache(work.data() + range.indexStart, mesh.indices.data() + range.indexStart, range.indexCount, vertexCount);
+		});
+		mesh.indices.swap(work);
+		PrintStatistics("vertex cache", seconds, MeshOptimizer::Analyze(mesh.indices.data(), mesh.indices.size(), vertexCount));
+
+		seconds = MeasureFastest(1, [&]()
+		{
+			for (const SubMesh& range : mesh.subMeshes)
+			{
+				MeshOptimizer::OptimizeOverdraw(work.data() + range.indexStart, mesh.indices.data() + range.indexStart, range.indexCount,
+					mesh.vertices.data(), vertexCount);
+			}
+		});
+		mesh.indices.swap(work);
+		PrintStatistics("overdraw", seconds, MeshOptimizer::Analyze(mesh.indices.data(), mesh.indices.size(), vertexCount));
+
+		std::vector<MeshVertex> vertices(vertexCount);
+		seconds = MeasureFastest(1, [&]()
+		{
+			vertexCount = MeshOptimizer::OptimizeVertexFetch(vertices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), vertexCount);
+		});
+		PrintStatistics("vertex fetch", seconds, MeshOptimizer::Analyze(mesh.indices.data(), mesh.indices.size(), vertexCount));
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		std::vector<MeshData> meshes(3);
+		MakeShuffledGrid(512, meshes[0]);
+		MakeSphere(256, 512, meshes[1]);
+		GeneratedScene scene;
+		SceneGenerator::Generate(*SceneGenerator::FindStandardScene("many_triangles"), 12345, scene);
+		meshes[2] = scene.shapes[0];
+		meshes[2].name = "scene_shape";
+		for (int i = 1; i < argc; i++)
+			LoadMeshes(argv[i], meshes);
+
+		for (const MeshData& mesh : meshes)
+			Optimize(mesh);
+		return 0;
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << "error: " << exception.what() << std::endl;
+		return 1;
+	}
+}
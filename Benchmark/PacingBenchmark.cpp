@@ -0,0 +1,37 @@
+﻿// PacingBenchmark.cpp - フレームレイト上限の間隔の精度を計測する
+//
+// PacingBenchmark [フレームレイト]
+//     StepTimerのフレームレイト上限を設定して5秒間Tickし、フレーム間隔の平均・標準偏差・最大のずれを出力する(既定は60)
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+#include "StepTimer.h"
+
+int main(int argc, char* argv[])
+{
+	double framesPerSecond = argc >= 2 ? std::max(atof(argv[1]), 1.0) : 60.0;
+	const int frameCount = int(framesPerSecond * 5.0);
+
+	DX::StepTimer timer;
+	timer.SetFrameRateLimit(framesPerSecond);
+	timer.Tick([]() {});
+
+	// フレーム間隔の平均・標準偏差・最大のずれを求める
+	double target = 1.0 / framesPerSecond, sum = 0.0, squareSum = 0.0, worst = 0.0;
+	for (int n = 0; n < frameCount; n++)
+	{
+		timer.Tick([]() {});
+		double interval = timer.GetElapsedSeconds();
+		sum += interval;
+		squareSum += interval * interval;
+		worst = std::max(worst, fabs(interval - target));
+	}
+	double mean = sum / frameCount;
+	double deviation = sqrt(std::max(squareSum / frameCount - mean * mean, 0.0));
+	std::cout << "target " << std::fixed << std::setprecision(3) << target * 1000.0 << " ms  mean " << mean * 1000.0
+		<< " ms  stddev " << deviation * 1000.0 << " ms  worst " << worst * 1000.0 << " ms" << std::endl;
+	return 0;
+}
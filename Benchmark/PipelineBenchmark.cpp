@@ -0,0 +1,93 @@
+﻿// PipelineBenchmark.cpp - 更新と描画の逐次実行とパイプラインの速度と遅延を比較する
+//
+// PipelineBenchmark [描画項目数] [先行フレーム数]
+//     描画キューの作成とソートを更新、コマンドの作成と記録バックエンドでの実行を描画として、
+//     200フレームを逐次実行とFramePipelineで実行する(既定は20万項目、先行1フレーム)
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdint.h>
+#include <stdlib.h>
+#include "FramePipeline.h"
+#include "RenderQueue.h"
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// 計測するフレーム数
+	const int FRAME_COUNT = 200;
+
+	// 1フレーム分の描画状態
+	struct Snapshot
+	{
+		RenderQueue queue;
+		Clock::time_point updated;
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	size_t count = argc >= 2 ? size_t(std::max(atoi(argv[1]), 1)) : 200000;
+	int frameLatency = argc >= 3 ? std::min(std::max(atoi(argv[2]), 1), int(FramePipeline::MAX_FRAME_LATENCY)) : 1;
+
+	Snapshot snapshots[FramePipeline::SNAPSHOT_COUNT];
+	const float world[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	std::mt19937 random(0);
+
+	// 更新:描画項目を無作為に積んでソートする
+	auto update = [&](Snapshot& snapshot)
+	{
+		snapshot.queue.Clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			uint32_t value = random();
+			snapshot.queue.Submit(0, value & 7, (value >> 3) & 63, (value >> 9) & 255, float(value >> 17) / 32768.0f, world);
+		}
+		snapshot.queue.Sort();
+		snapshot.updated = Clock::now();
+	};
+	// 描画:GPUを使わない記録バックエンドでコマンドを実行し、更新の完了から描画の完了までの遅延を返す
+	RenderCommandList commandList;
+	RecordingRenderBackend backend;
+	auto render = [&](const Snapshot& snapshot)
+	{
+		commandList.Clear();
+		backend.Reset();
+		snapshot.queue.Record(commandList);
+		commandList.Execute(backend);
+		return std::chrono::duration<double>(Clock::now() - snapshot.updated).count();
+	};
+
+	// 逐次実行
+	double latency = 0.0;
+	auto start = Clock::now();
+	for (int n = 0; n < FRAME_COUNT; n++)
+	{
+		update(snapshots[0]);
+		latency += render(snapshots[0]);
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	std::cout << "sequential  " << std::fixed << std::setprecision(1) << FRAME_COUNT / seconds << " fps  latency "
+		<< std::setprecision(3) << latency * 1000.0 / FRAME_COUNT << " ms" << std::endl;
+
+	// パイプライン
+	FramePipeline pipeline;
+	latency = 0.0;
+	start = Clock::now();
+	pipeline.Start(frameLatency, [&](int snapshot) { update(snapshots[snapshot]); return true; });
+	for (int n = 0; n < FRAME_COUNT; n++)
+	{
+		int snapshot = pipeline.Acquire(1000);
+		if (snapshot >= 0)
+			latency += render(snapshots[snapshot]);
+	}
+	seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	pipeline.Stop();
+	std::cout << "pipelined   " << std::setprecision(1) << FRAME_COUNT / seconds << " fps  latency "
+		<< std::setprecision(3) << latency * 1000.0 / FRAME_COUNT << " ms  frame latency " << frameLatency << std::endl;
+	return 0;
+}
@@ -0,0 +1,88 @@
+﻿// ProfilerBenchmark.cpp - プロファイラの計測区間のコストを計測し、タスクグラフを実行したトレースとフレーム時間の百分位数を出力する
+//
+// ProfilerBenchmark [トレースファイル]
+//     計測区間1つあたりの無効時と有効時のコストを計測した後、更新・変換・カリング・描画を模したタスクグラフを
+//     ジョブシステムで300フレーム実行し、フレーム時間の百分位数とChromeのトレース形式のファイルを出力する(既定はprofile.json)
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "TaskGraph.h"
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// コストを計測する計測区間の数
+	const int SCOPE_COUNT = 10000000;
+	// タスクグラフを実行するフレーム数
+	const int FRAME_COUNT = 300;
+	// 1つのタスクが処理する要素数
+	const size_t ELEMENT_COUNT = 1 << 16;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string traceFile = argc >= 2 ? argv[1] : "profile.json";
+	Profiler& profiler = Profiler::Get();
+	profiler.SetThreadName("Main");
+
+	// 計測区間1つあたりのコスト(ナノ秒)を計測する
+	volatile uint64_t sink = 0;
+	auto measure = [&]()
+	{
+		auto start = Clock::now();
+		for (int i = 0; i < SCOPE_COUNT; i++)
+		{
+			PROFILE_SCOPE("Scope");
+			sink = sink + 1;
+		}
+		return std::chrono::duration<double>(Clock::now() - start).count() * 1e9 / SCOPE_COUNT;
+	};
+	profiler.SetEnabled(false);
+	double disabled = measure();
+	profiler.SetEnabled(true);
+	double enabled = measure();
+	std::cout << "scope  disabled " << std::fixed << std::setprecision(2) << disabled << " ns  enabled " << enabled << " ns" << std::endl;
+
+	// 更新・変換・カリング・描画を模したタスクグラフを毎フレーム実行し、フレームの区切りを記録する
+	profiler.Clear();
+	JobSystem jobSystem;
+	std::vector<float> values(ELEMENT_COUNT);
+	auto work = [&](size_t begin, size_t end)
+	{
+		PROFILE_SCOPE("Range");
+		for (size_t i = begin; i < end; i++)
+			values[i] = sqrtf(values[i] + float(i));
+	};
+	TaskGraph graph;
+	TaskGraph::TaskId update = graph.AddTask("Update", [&]() { work(0, ELEMENT_COUNT); });
+	TaskGraph::TaskId transforms = graph.AddTask("Transforms", [&]() { jobSystem.ParallelFor(ELEMENT_COUNT, 4096, work); });
+	TaskGraph::TaskId culling = graph.AddTask("Culling", [&]() { jobSystem.ParallelFor(ELEMENT_COUNT, 4096, work); });
+	TaskGraph::TaskId audio = graph.AddTask("Audio", [&]() { work(0, ELEMENT_COUNT / 4); });
+	TaskGraph::TaskId render = graph.AddTask("Render", [&]() { work(0, ELEMENT_COUNT / 2); });
+	graph.AddDependency(update, transforms);
+	graph.AddDependency(transforms, culling);
+	graph.AddDependency(culling, render);
+	graph.AddDependency(update, audio);
+	for (int frame = 0; frame < FRAME_COUNT; frame++)
+	{
+		graph.Run(jobSystem);
+		profiler.MarkFrame();
+	}
+	profiler.SetEnabled(false);
+
+	const FrameTimeHistogram& frameTimes = profiler.GetFrameTimes();
+	std::cout << "frames " << frameTimes.GetCount() << std::setprecision(3)
+		<< "  p50 " << frameTimes.GetPercentile(50.0) * 1000.0 << " ms  p95 " << frameTimes.GetPercentile(95.0) * 1000.0
+		<< " ms  p99 " << frameTimes.GetPercentile(99.0) * 1000.0 << " ms" << std::endl;
+	profiler.SaveChromeTrace(traceFile);
+	std::cout << "trace  " << traceFile << std::endl;
+	return 0;
+}
@@ -0,0 +1,78 @@
+﻿// QueueBenchmark.cpp - 描画キューのソートと状態の切り替え数の削減を計測する
+//
+// QueueBenchmark [描画項目数]
+//     シェーダ・マテリアル・メッシュ・深度が無作為な描画項目について、追加順とソート後の状態の切り替え数、
+//     ソートとコマンド作成の速度を計測する(既定は10万項目)
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdint.h>
+#include <stdlib.h>
+#include "RenderQueue.h"
+
+namespace
+{
+	// 計測する繰り返しの回数
+	const int ITERATIONS = 10;
+
+	// 描画統計を出力する
+	void PrintStatistics(const char* name, const RenderStatistics& statistics)
+	{
+		std::cout << std::setw(10) << std::left << name << "shader " << statistics.shaderChanges << "  material " << statistics.materialChanges
+			<< "  mesh " << statistics.meshChanges << "  draw " << statistics.draws << std::endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	size_t count = argc >= 2 ? size_t(std::max(atoi(argv[1]), 1)) : 100000;
+
+	// シェーダ・マテリアル・メッシュ・深度が無作為な描画項目を作成する
+	std::mt19937 random(0);
+	std::uniform_int_distribution<uint32_t> shader(0, 7), material(0, 63), mesh(0, 255);
+	std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+	const float world[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	RenderQueue queue;
+	for (size_t i = 0; i < count; i++)
+	{
+		queue.Submit(0, shader(random), material(random), mesh(random), depth(random), world);
+	}
+
+	// 追加順のまま実行した場合の状態の切り替え数
+	RenderCommandList commandList;
+	RecordingRenderBackend backend;
+	queue.Record(commandList);
+	commandList.Execute(backend);
+	PrintStatistics("unsorted", backend.GetStatistics());
+
+	// ソートしてから実行した場合の状態の切り替え数
+	RenderQueue sorted = queue;
+	sorted.Sort();
+	commandList.Clear();
+	backend.Reset();
+	sorted.Record(commandList);
+	commandList.Execute(backend);
+	PrintStatistics("sorted", backend.GetStatistics());
+
+	// ソートとコマンド作成の速度
+	double sortSeconds = 0.0, recordSeconds = 0.0;
+	for (int n = 0; n < ITERATIONS; n++)
+	{
+		sorted = queue;
+		auto start = std::chrono::steady_clock::now();
+		sorted.Sort();
+		auto middle = std::chrono::steady_clock::now();
+		commandList.Clear();
+		sorted.Record(commandList);
+		auto end = std::chrono::steady_clock::now();
+		sortSeconds += std::chrono::duration<double>(middle - start).count();
+		recordSeconds += std::chrono::duration<double>(end - middle).count();
+	}
+	std::cout << "sort      " << std::fixed << std::setprecision(3) << sortSeconds * 1000.0 / ITERATIONS << " ms  "
+		<< count * ITERATIONS / sortSeconds / 1000000.0 << " Mitems/s" << std::endl;
+	std::cout << "record    " << recordSeconds * 1000.0 / ITERATIONS << " ms  commands " << commandList.GetCommands().size() << std::endl;
+	return 0;
+}
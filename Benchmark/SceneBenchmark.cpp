@@ -0,0 +1,72 @@
+﻿// SceneBenchmark.cpp - シーングラフのワールド行列の伝搬時間を計測する
+//
+// SceneBenchmark [ノード数]
+//     各ノードが4つの子を持つ木(既定は10万ノード)で、すべてのノードが変更された場合、
+//     葉に近い一部のノードだけが変更された場合、変更が無い場合の1回の更新時間を表示する
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include "SceneGraph.h"
+
+namespace
+{
+	// 計測する更新の回数
+	const int ITERATIONS = 100;
+
+	// 計測結果を表示する
+	void PrintResult(const char* name, size_t updated, std::chrono::steady_clock::time_point start)
+	{
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::left << std::setw(15) << name << std::right << updated << " nodes  " << std::fixed << std::setprecision(3)
+			<< seconds * 1000.0 / ITERATIONS << " ms/update" << std::endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int nodeCount = argc >= 2 ? std::max(atoi(argv[1]), 1) : 100000;
+
+	// 各ノードが4つの子を持つ木を親が子より前に来る順で作成する
+	SceneGraph sceneGraph;
+	sceneGraph.Reserve(nodeCount);
+	for (int i = 0; i < nodeCount; i++)
+	{
+		int32_t node = sceneGraph.AddNode(nullptr, i == 0 ? SceneGraph::NO_PARENT : (i - 1) / 4);
+		sceneGraph.SetLocalPosition(node, { 0.1f, 0.0f, 0.0f });
+		sceneGraph.SetLocalRotation(node, { 0.0f, 0.0f, 0.0998f, 0.9950f });
+	}
+
+	// すべてのノードが変更された場合
+	auto start = std::chrono::steady_clock::now();
+	size_t updated = 0;
+	for (int n = 0; n < ITERATIONS; n++)
+	{
+		sceneGraph.SetLocalPosition(0, { float(n), 0.0f, 0.0f });
+		updated = sceneGraph.UpdateWorldTransforms();
+	}
+	PrintResult("all dirty", updated, start);
+
+	// 葉に近い一部のノードだけが変更された場合
+	start = std::chrono::steady_clock::now();
+	for (int n = 0; n < ITERATIONS; n++)
+	{
+		for (int i = nodeCount - 1; i >= nodeCount / 2; i -= 100)
+		{
+			sceneGraph.SetLocalPosition(i, { float(n), 0.0f, 0.0f });
+		}
+		updated = sceneGraph.UpdateWorldTransforms();
+	}
+	PrintResult("partial dirty", updated, start);
+
+	// 変更が無い場合
+	start = std::chrono::steady_clock::now();
+	for (int n = 0; n < ITERATIONS; n++)
+	{
+		updated = sceneGraph.UpdateWorldTransforms();
+	}
+	PrintResult("clean", updated, start);
+	return 0;
+}
@@ -0,0 +1,185 @@
+﻿#include "SceneGenerator.h"
+#include <math.h>
+#include <stdexcept>
+
+namespace
+{
+	// 標準のシーン
+	const SceneDescription STANDARD_SCENES[SceneGenerator::STANDARD_SCENE_COUNT] =
+	{
+		// 名前, メッシュ数, 形状数, 三角形数, 深さ, マテリアル数, シェーダ数, 回転させる割合, インスタンス描画
+		{ "baseline", 2000, 64, 256, 4, 16, 4, 0.1f, false },
+		{ "many_meshes", 30000, 128, 64, 3, 32, 4, 0.05f, false },
+		{ "many_triangles", 500, 16, 20000, 2, 8, 2, 0.1f, false },
+		{ "deep_hierarchy", 8192, 64, 128, 128, 16, 4, 0.02f, false },
+		{ "many_materials", 8000, 256, 128, 2, 4000, 200, 0.1f, false },
+		{ "instanced_props", 50000, 8, 96, 2, 4, 1, 0.05f, true },
+	};
+
+	// 子ノードの親からの距離
+	const float CHAIN_OFFSET = 1.5f;
+	// 鎖の先頭のノードを並べる間隔
+	const float CHAIN_SPACING = 4.0f;
+
+	// 乱数を生成する(xorshift32)
+	uint32_t NextRandom(uint32_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	// 範囲内の乱数を生成する
+	float RandomFloat(uint32_t& state, float minimum, float maximum)
+	{
+		return minimum + (maximum - minimum) * float(NextRandom(state) >> 8) / float(1 << 24);
+	}
+
+	// Y軸回りの回転を作成する
+	SceneQuaternion RotationY(float angle)
+	{
+		return { 0.0f, sinf(angle * 0.5f), 0.0f, cosf(angle * 0.5f) };
+	}
+}
+
+// 標準のシーンの設定を取得する
+const SceneDescription& SceneGenerator::GetStandardScene(int index)
+{
+	if (index < 0 || index >= STANDARD_SCENE_COUNT)
+		throw std::out_of_range("SceneGenerator: scene index out of range");
+	return STANDARD_SCENES[index];
+}
+
+// 名前から標準のシーンの設定を探す
+const SceneDescription* SceneGenerator::FindStandardScene(const std::string& name)
+{
+	for (const SceneDescription& description : STANDARD_SCENES)
+	{
+		if (name == description.name)
+			return &description;
+	}
+	return nullptr;
+}
+
+// 設定からシーンを生成する
+void SceneGenerator::Generate(const SceneDescription& description, uint32_t seed, GeneratedScene& scene)
+{
+	if (description.meshCount == 0 || description.shapeCount == 0 || description.hierarchyDepth == 0 ||
+		description.materialCount == 0 || description.shaderCount == 0)
+	{
+		throw std::invalid_argument("SceneGenerator: scene counts must be positive");
+	}
+	uint32_t random = seed != 0 ? seed : 1;
+
+	// 形状を生成する
+	scene.shapes.clear();
+	scene.shapes.resize(description.shapeCount);
+	for (MeshData& shape : scene.shapes)
+	{
+		GenerateShape(description.trianglesPerShape, random, shape);
+	}
+
+	// ルートの下に親子の鎖を並べ、鎖の先頭は立方体の中に散らばらせる
+	uint32_t chainCount = (description.meshCount + description.hierarchyDepth - 1) / description.hierarchyDepth;
+	float extent = cbrtf(float(chainCount)) * CHAIN_SPACING;
+	SceneGraph& sceneGraph = scene.sceneGraph;
+	sceneGraph.Clear();
+	sceneGraph.Reserve(description.meshCount + 1);
+	sceneGraph.AddNode("root");
+
+	scene.meshNodes.clear();
+	scene.meshShapes.clear();
+	scene.meshShaders.clear();
+	scene.meshMaterials.clear();
+	scene.animatedNodes.clear();
+	scene.triangleCount = 0;
+	uint32_t animatedStride = description.animatedFraction > 0.0f ? uint32_t(1.0f / description.animatedFraction + 0.5f) : 0;
+	for (uint32_t i = 0; i < description.meshCount; i++)
+	{
+		bool chainStart = i % description.hierarchyDepth == 0;
+		int32_t parent = chainStart ? 0 : int32_t(i);
+		int32_t node = sceneGraph.AddNode(nullptr, parent, int32_t(i));
+		if (chainStart)
+		{
+			sceneGraph.SetLocalPosition(node, { RandomFloat(random, -extent, extent) * 0.5f,
+				RandomFloat(random, -extent, extent) * 0.5f, RandomFloat(random, -extent, extent) * 0.5f });
+		}
+		else
+		{
+			sceneGraph.SetLocalPosition(node, { CHAIN_OFFSET, 0.0f, 0.0f });
+		}
+		sceneGraph.SetLocalRotation(node, RotationY(RandomFloat(random, -0.5f, 0.5f)));
+		if (animatedStride != 0 && i % animatedStride == 0)
+			scene.animatedNodes.push_back(node);
+
+		uint32_t shape = NextRandom(random) % description.shapeCount;
+		scene.meshNodes.push_back(node);
+		scene.meshShapes.push_back(shape);
+		scene.meshShaders.push_back(NextRandom(random) % description.shaderCount);
+		scene.meshMaterials.push_back(NextRandom(random) % description.materialCount);
+		scene.triangleCount += scene.shapes[shape].indices.size() / 3;
+	}
+
+	// インスタンスの色(これまでのシーンと同じ配置になるよう、配置の乱数の後で生成する)
+	scene.meshColors.resize(size_t(description.meshCount) * 4);
+	for (uint32_t i = 0; i < description.meshCount; i++)
+	{
+		float* color = &scene.meshColors[size_t(i) * 4];
+		color[0] = RandomFloat(random, 0.5f, 1.0f);
+		color[1] = RandomFloat(random, 0.5f, 1.0f);
+		color[2] = RandomFloat(random, 0.5f, 1.0f);
+		color[3] = 1.0f;
+	}
+
+	// 鎖は曲がるが、鎖の長さより遠くへは伸びない
+	scene.center[0] = scene.center[1] = scene.center[2] = 0.0f;
+	scene.radius = extent * 0.5f * sqrtf(3.0f) + CHAIN_OFFSET * float(description.hierarchyDepth);
+}
+
+// 三角形の数が指定された数になる、凹凸のある格子状の形状を生成する
+void SceneGenerator::GenerateShape(uint32_t triangleCount, uint32_t& random, MeshData& shape)
+{
+	// 四角形を正方形に近い格子に並べ、奇数の場合は三角形を1つ加える
+	uint32_t quadCount = triangleCount / 2;
+	uint32_t columns = quadCount > 0 ? uint32_t(ceilf(sqrtf(float(quadCount)))) : 1;
+	uint32_t rows = quadCount > 0 ? (quadCount + columns - 1) / columns : 1;
+	float scale = RandomFloat(random, 0.5f, 1.5f);
+
+	shape.vertices.resize((columns + 1) * (rows + 1));
+	for (uint32_t y = 0; y <= rows; y++)
+	{
+		for (uint32_t x = 0; x <= columns; x++)
+		{
+			MeshVertex& vertex = shape.vertices[y * (columns + 1) + x];
+			vertex.position[0] = (float(x) / float(columns) - 0.5f) * scale;
+			vertex.position[1] = RandomFloat(random, -0.1f, 0.1f) * scale;
+			vertex.position[2] = (float(y) / float(rows) - 0.5f) * scale;
+			vertex.color[0] = vertex.color[1] = vertex.color[2] = vertex.color[3] = 1.0f;
+		}
+	}
+
+	shape.indices.clear();
+	shape.indices.reserve(triangleCount);
+	for (uint32_t quad = 0; quad < quadCount; quad++)
+	{
+		uint32_t corner = (quad / columns) * (columns + 1) + quad % columns;
+		uint32_t next = corner + columns + 1;
+		shape.indices.insert(shape.indices.end(), { corner, next, corner + 1, corner + 1, next, next + 1 });
+	}
+	if (triangleCount % 2 != 0)
+		shape.indices.insert(shape.indices.end(), { 0, columns + 1, 1 });
+	shape.subMeshes.assign(1, { 0, uint32_t(shape.indices.size()), 0 });
+
+	// 境界ボックスを頂点から求める
+	shape.bounds = { { shape.vertices[0].position[0], shape.vertices[0].position[1], shape.vertices[0].position[2] },
+		{ shape.vertices[0].position[0], shape.vertices[0].position[1], shape.vertices[0].position[2] } };
+	for (const MeshVertex& vertex : shape.vertices)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			shape.bounds.minimum[axis] = fminf(shape.bounds.minimum[axis], vertex.position[axis]);
+			shape.bounds.maximum[axis] = fmaxf(shape.bounds.maximum[axis], vertex.position[axis]);
+		}
+	}
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+#ifndef SCENEGENERATOR_DEFINED
+#define SCENEGENERATOR_DEFINED
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "MeshData.h"
+#include "SceneGraph.h"
+
+// 手続き的に生成するベンチマークシーンの設定
+struct SceneDescription
+{
+	// シーン名(レポートの比較に使う)
+	const char* name;
+	// メッシュを持つノードの数(描画項目の数)
+	uint32_t meshCount;
+	// 異なる形状の数(同じ形状のメッシュはメッシュ番号を共有する)
+	uint32_t shapeCount;
+	// 形状ごとの三角形の数
+	uint32_t trianglesPerShape;
+	// 階層の深さ(ルートの下に、この長さの親子の鎖を並べる)
+	uint32_t hierarchyDepth;
+	// マテリアルの数
+	uint32_t materialCount;
+	// シェーダの数
+	uint32_t shaderCount;
+	// フレームごとに回転させるノードの割合(0～1)
+	float animatedFraction;
+	// 同じ形状とマテリアルのメッシュをインスタンス描画するかどうか
+	bool instanced;
+};
+
+// 生成したシーン
+struct GeneratedScene
+{
+	// シーングラフ(0番がルート)
+	SceneGraph sceneGraph;
+	// 形状(頂点とインデックスを持つ)
+	std::vector<MeshData> shapes;
+	// 描画項目ごとのノード番号
+	std::vector<int32_t> meshNodes;
+	// 描画項目ごとの形状番号
+	std::vector<uint32_t> meshShapes;
+	// 描画項目ごとのシェーダ番号
+	std::vector<uint32_t> meshShaders;
+	// 描画項目ごとのマテリアル番号
+	std::vector<uint32_t> meshMaterials;
+	// 描画項目ごとのインスタンスの色(RGBAの4要素ずつ)
+	std::vector<float> meshColors;
+	// フレームごとに回転させるノード
+	std::vector<int32_t> animatedNodes;
+	// シーン全体の三角形の数
+	uint64_t triangleCount;
+	// シーンの中心と半径(カメラの配置に使う)
+	float center[3];
+	float radius;
+};
+
+// ベンチマーク用のシーンを乱数の種から決定的に生成するクラス
+// 乱数は独自の生成器を使うので、どの標準ライブラリでも同じシーンになる
+class SceneGenerator
+{
+public:
+	// 標準のシーンの数
+	static const int STANDARD_SCENE_COUNT = 6;
+
+	// 標準のシーンの設定を取得する(多数のメッシュ、多数の三角形、深い階層、多数のマテリアル、インスタンス描画など)
+	static const SceneDescription& GetStandardScene(int index);
+	// 名前から標準のシーンの設定を探す(無い場合はnullptr)
+	static const SceneDescription* FindStandardScene(const std::string& name);
+	// 設定からシーンを生成する
+	static void Generate(const SceneDescription& description, uint32_t seed, GeneratedScene& scene);
+
+private:
+	// 三角形の数が指定された数になる、凹凸のある格子状の形状を生成する
+	static void GenerateShape(uint32_t triangleCount, uint32_t& random, MeshData& shape);
+};
+
+#endif	// SCENEGENERATOR_DEFINED
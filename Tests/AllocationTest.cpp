@@ -0,0 +1,223 @@
+﻿// AllocationTest.cpp - ヘッドレス動作のゲームループが、暖機の後のフレームでヒープを確保しないことを検証する
+//
+// Game::StepとGame::RenderSnapshotと同じ順に、GameStepper(仮想クロック)で固定ステップの更新を進め、
+// タスクグラフでシーングラフの更新、境界ボックスの変換、BVHの再適合とカリングをおこない、デバッグ表示を積む
+// 描画では描画キューをNullRenderBackendで実行してNullRenderDeviceに表示し、デバッグ表示をまとめ、
+// フレームの統計とプロファイラのフレームの区切りを記録する。これをAllocationCounter.cppで置き換えたoperator newで数えながら繰り返す
+
+#include <cwchar>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+#include "AllocationCounter.h"
+#include "BenchmarkCamera.h"
+#include "BoundingVolumeHierarchy.h"
+#include "DebugDraw.h"
+#include "FrameStatistics.h"
+#include "FrustumCuller.h"
+#include "GameStepper.h"
+#include "JobSystem.h"
+#include "LinearArena.h"
+#include "MeshData.h"
+#include "NullRenderBackend.h"
+#include "NullRenderDevice.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "SceneGraph.h"
+#include "TaskGraph.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// 暖機のフレーム数と確認するフレーム数
+	const int WARMUP_FRAMES = 10;
+	const int FRAME_COUNT = 200;
+	// ノード数と親子の連なりの長さ
+	const int NODE_COUNT = 4096;
+	const int CHAIN_LENGTH = 64;
+	// 境界ボックスの変換の粒度
+	const size_t GRAIN_SIZE = 256;
+	// フレームアリーナに書き込む文字列の長さ
+	const size_t TEXT_LENGTH = 32;
+	// 描画キューで使うシェーダ、マテリアル、メッシュの数
+	const uint32_t SHADER_COUNT = 4;
+	const uint32_t MATERIAL_COUNT = 16;
+	const uint32_t MESH_COUNT = 256;
+	// デバッグ表示で境界ボックスを描くノードの数
+	const int DEBUG_BOX_COUNT = 16;
+	// フレームの統計の処理段階とカウンタの番号
+	const int UPDATE_STAGE = 0;
+	const int RENDER_STAGE = 1;
+	const int ALLOCATION_COUNTER = 0;
+
+	// 合わせの大きい型(operator new(size_t, std::align_val_t)で確保される)
+	struct alignas(64) AlignedBlock
+	{
+		float values[16];
+	};
+}
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		// 置き換えたoperator newが呼ばれていることを確かめる(合わせの大きい確保も数える)
+		uint64_t start = AllocationCounter::GetCount();
+		std::unique_ptr<int> probe(new int(0));
+		check(AllocationCounter::GetCount() == start + 1, "operator new is counted");
+		std::unique_ptr<AlignedBlock> alignedProbe(new AlignedBlock());
+		check(AllocationCounter::GetCount() == start + 2, "aligned operator new is counted");
+		check(reinterpret_cast<uintptr_t>(alignedProbe.get()) % alignof(AlignedBlock) == 0, "aligned operator new keeps the alignment");
+		std::unique_ptr<AlignedBlock[]> alignedArray(new AlignedBlock[3]);
+		check(AllocationCounter::GetCount() == start + 3 && reinterpret_cast<uintptr_t>(alignedArray.get()) % alignof(AlignedBlock) == 0, "aligned array new is counted");
+
+		// 長さCHAIN_LENGTHの親子の連なりを並べたシーン
+		JobSystem jobSystem;
+		SceneGraph sceneGraph;
+		sceneGraph.Reserve(NODE_COUNT);
+		for (int i = 0; i < NODE_COUNT; i++)
+			sceneGraph.AddNode("node", i % CHAIN_LENGTH == 0 ? SceneGraph::NO_PARENT : i - 1, i);
+		sceneGraph.UpdateWorldTransforms();
+
+		const MeshBounds localBounds = { { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
+		std::vector<MeshBounds> bounds(NODE_COUNT);
+		for (int i = 0; i < NODE_COUNT; i++)
+			bounds[i] = FrustumCuller::TransformBounds(localBounds, sceneGraph.GetWorldMatrix(i).m);
+		BoundingVolumeHierarchy bvh;
+		bvh.Build(bounds.data(), bounds.size(), &jobSystem);
+
+		float viewProjection[16];
+		CreateBenchmarkViewProjection(viewProjection);
+		FrustumCuller culler(viewProjection);
+		std::vector<uint8_t> visible(NODE_COUNT);
+		size_t visibleCount = 0;
+
+		// Game::SetHeadlessとGame::Initializeと同じく、仮想クロックの固定ステップで進める
+		GameStepper stepper;
+		stepper.SetHeadless();
+		stepper.GetTimer().SetFixedTimeStep(true);
+		stepper.GetTimer().SetTargetElapsedSeconds(1.0 / 60.0);
+		stepper.GetTimer().SetMaxUpdatesPerTick(4);
+		InterpolatedState<float> height;
+		stepper.AddInterpolatedState(&height);
+		stepper.StartInput("");
+		uint64_t updateCount = 0;
+
+		// GPUを使わない描画デバイスとバックエンド
+		NullRenderDevice device;
+		device.CreateDevice();
+		device.Resize(1280, 720);
+		NullRenderBackend backend;
+		for (uint32_t i = 0; i < SHADER_COUNT; i++)
+			backend.AddShader();
+		for (uint32_t i = 0; i < MATERIAL_COUNT; i++)
+			backend.AddMaterial();
+		for (uint32_t i = 0; i < MESH_COUNT; i++)
+			backend.AddMesh(1, 12);
+		RenderQueue queue;
+		RenderCommandList commandList;
+		const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+		// デバッグ表示、フレームの統計、プロファイラ(トレースを保存しない通常の動作と同じく記録は無効のまま)
+		DebugDraw& debugDraw = DebugDraw::Get();
+		debugDraw.SetEnabled(true);
+		DebugDrawList debugList;
+		const float debugColor[4] = { 1.0f, 1.0f, 0.0f, 1.0f };
+		FrameStatistics frameStatistics;
+		frameStatistics.AddStage("Update");
+		frameStatistics.AddStage("Render");
+		frameStatistics.AddCounter("allocations");
+		Profiler& profiler = Profiler::Get();
+		LinearArena frameArena;
+		uint64_t lastAllocationCount = AllocationCounter::GetCount();
+
+		// 更新、境界ボックスの変換、カリングをタスクグラフでつなぐ
+		TaskGraph graph;
+		TaskGraph::TaskId transforms = graph.AddTask("transforms", [&]()
+		{
+			for (int i = 0; i < NODE_COUNT; i += CHAIN_LENGTH)
+				sceneGraph.SetLocalPosition(i, { float(i % 37) - 18.0f, height.GetCurrent(), float(i % 23) - 11.0f });
+			sceneGraph.UpdateWorldTransforms();
+		});
+		TaskGraph::TaskId boundsTask = graph.AddTask("bounds", [&]()
+		{
+			jobSystem.ParallelFor(bounds.size(), GRAIN_SIZE, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+					bounds[i] = FrustumCuller::TransformBounds(localBounds, sceneGraph.GetWorldMatrix(int32_t(i)).m);
+			});
+		});
+		TaskGraph::TaskId culling = graph.AddTask("culling", [&]()
+		{
+			bvh.Refit(bounds.data());
+			visibleCount = bvh.CullFrustum(culler, visible.data());
+		});
+		graph.AddDependency(transforms, boundsTask);
+		graph.AddDependency(boundsTask, culling);
+
+		// 1フレームを処理する(Game::StepとGame::RenderSnapshotと同じ順)
+		auto runFrame = [&]()
+		{
+			stepper.Tick([&](const DX::StepTimer& timer)
+			{
+				PROFILE_SCOPE("Update");
+				height.GetCurrent() = float(timer.GetFrameCount() % 100) * 0.01f;
+				graph.Run(jobSystem);
+				for (int i = 0; i < DEBUG_BOX_COUNT; i++)
+					debugDraw.AddBox(bounds[i], debugColor);
+				debugDraw.AddText(bounds[0].minimum, "visible", debugColor);
+				updateCount++;
+			});
+
+			{
+				PROFILE_SCOPE("Render");
+				queue.Clear();
+				for (int i = 0; i < NODE_COUNT; i++)
+				{
+					if (visible[i])
+						queue.Submit(0, uint32_t(i) % SHADER_COUNT, uint32_t(i) % MATERIAL_COUNT, uint32_t(i) % MESH_COUNT, 0.5f, sceneGraph.GetWorldMatrix(i).m);
+				}
+				queue.Sort();
+				commandList.Clear();
+				queue.Record(commandList);
+				device.Clear(clearColor);
+				backend.ResetStatistics();
+				commandList.Execute(backend);
+				debugDraw.Collect(debugList);
+				wchar_t* text = frameArena.AllocateArray<wchar_t>(TEXT_LENGTH);
+				swprintf(text, TEXT_LENGTH, L"visible = %u", unsigned(visibleCount));
+				device.Present(false);
+			}
+
+			uint64_t allocationCount = AllocationCounter::GetCount();
+			frameStatistics.AddStageTime(UPDATE_STAGE, 0.001);
+			frameStatistics.AddStageTime(RENDER_STAGE, 0.002);
+			frameStatistics.SetCounter(ALLOCATION_COUNTER, allocationCount - lastAllocationCount);
+			lastAllocationCount = allocationCount;
+			frameArena.Reset();
+			double frameSeconds = profiler.MarkFrame();
+			frameStatistics.EndFrame(frameSeconds > 0.0 ? frameSeconds : 1.0 / 60.0);
+		};
+
+		for (int frame = 0; frame < WARMUP_FRAMES; frame++)
+			runFrame();
+		uint64_t before = AllocationCounter::GetCount();
+		for (int frame = 0; frame < FRAME_COUNT; frame++)
+			runFrame();
+		uint64_t allocations = AllocationCounter::GetCount() - before;
+		stepper.FinishInput();
+
+		check(visibleCount > 0 && backend.GetStatistics().draws == visibleCount, "frames cull and draw part of the scene");
+		check(updateCount == uint64_t(WARMUP_FRAMES + FRAME_COUNT), "headless stepper updates once per frame");
+		check(device.GetStatistics().presents == uint64_t(WARMUP_FRAMES + FRAME_COUNT), "every frame presents");
+		check(debugList.lines[DebugDrawList::DEPTH_TEST].size() == size_t(DEBUG_BOX_COUNT) * 24 && debugList.labels.size() == 1, "debug draw collects the frame");
+		check(frameStatistics.GetFrameCount() > 0 && frameStatistics.GetCounter(ALLOCATION_COUNTER) == 0, "frame statistics see no allocations");
+		check(allocations == 0, "steady-state frames do not allocate");
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
@@ -0,0 +1,132 @@
+﻿// BenchmarkSuiteTest.cpp - フレームのベンチマークのシーン生成の決定性と、レポートの読み書き・比較を検証する
+
+#include <fstream>
+#include <math.h>
+#include <sstream>
+#include <stdexcept>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "BenchmarkReport.h"
+#include "FrameBenchmark.h"
+#include "SceneGenerator.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// 小さなシーン(数フレームで実行できる大きさ)
+	const SceneDescription SMALL_SCENE = { "small", 300, 8, 32, 3, 6, 2, 0.2f, false };
+
+	// 同じ値の並びを少しずつ揺らした繰り返しごとの時間(秒)を作成する
+	std::vector<std::vector<double>> MakeRuns(double seconds, int runs, int frames)
+	{
+		std::vector<std::vector<double>> samples(runs);
+		for (int run = 0; run < runs; run++)
+		{
+			for (int frame = 0; frame < frames; frame++)
+				samples[run].push_back(seconds * (1.0 + 0.001 * ((run * 7 + frame * 3) % 5)));
+		}
+		return samples;
+	}
+
+	// 1つの処理段階を持つレポートを作成する
+	BenchmarkReport MakeReport(const char* label, double seconds)
+	{
+		BenchmarkReport report;
+		report.label = label;
+		report.instructionSet = "scalar";
+		report.frames = 20;
+		report.repetitions = 8;
+		SceneReport scene;
+		scene.name = "small";
+		scene.nodes = 301;
+		scene.meshes = 300;
+		scene.triangles = 9600;
+		scene.materials = 6;
+		scene.depth = 3;
+		scene.visible = 120;
+		scene.draws = 80;
+		scene.stateChanges = 30;
+		scene.checksum = "00000000deadbeef";
+		scene.stages.push_back(StageSummary::Summarize("frame", MakeRuns(seconds, report.repetitions, report.frames)));
+		report.scenes.push_back(scene);
+		return report;
+	}
+
+	// シーンを数フレーム実行し、描画のチェックサムを返す
+	uint64_t RunScene(GeneratedScene& scene, bool instanced, size_t& visible)
+	{
+		FrameBenchmark benchmark(scene, instanced);
+		double stageSeconds[FrameBenchmark::STAGE_COUNT];
+		for (uint32_t frame = 0; frame < 8; frame++)
+			benchmark.RunFrame(frame, stageSeconds);
+		visible = benchmark.GetVisibleCount();
+		return benchmark.GetChecksum();
+	}
+}
+
+int main()
+{
+	TestCheck check;
+
+	// 同じ種からは同じシーンが生成され、違う種からは違うシーンが生成される
+	GeneratedScene first, second, other;
+	SceneGenerator::Generate(SMALL_SCENE, 12345, first);
+	SceneGenerator::Generate(SMALL_SCENE, 12345, second);
+	SceneGenerator::Generate(SMALL_SCENE, 54321, other);
+	check(first.meshNodes.size() == SMALL_SCENE.meshCount && first.shapes.size() == SMALL_SCENE.shapeCount, "scene counts follow the description");
+	check(first.triangleCount == uint64_t(SMALL_SCENE.meshCount) * SMALL_SCENE.trianglesPerShape, "triangle count");
+	bool same = first.meshShapes == second.meshShapes && first.meshMaterials == second.meshMaterials && first.meshColors == second.meshColors;
+	for (size_t i = 0; same && i < first.shapes.size(); i++)
+	{
+		same = first.shapes[i].indices == second.shapes[i].indices && first.shapes[i].vertices.size() == second.shapes[i].vertices.size() &&
+			memcmp(first.shapes[i].vertices.data(), second.shapes[i].vertices.data(), first.shapes[i].vertices.size() * sizeof(MeshVertex)) == 0;
+	}
+	check(same, "same seed generates the same scene");
+	check(first.meshShapes != other.meshShapes || first.meshMaterials != other.meshMaterials, "different seed generates a different scene");
+
+	// 同じシーンのフレームは毎回同じ描画になる
+	size_t visibleFirst = 0, visibleSecond = 0;
+	uint64_t checksumFirst = RunScene(first, false, visibleFirst);
+	uint64_t checksumSecond = RunScene(second, false, visibleSecond);
+	check(checksumFirst == checksumSecond && visibleFirst == visibleSecond, "frames are deterministic");
+	check(visibleFirst > 0 && visibleFirst <= SMALL_SCENE.meshCount, "some meshes are visible");
+
+	// 要約は中央値・最小・最大・パーセンタイルを求める
+	std::vector<std::vector<double>> seconds = { { 0.004, 0.001, 0.003, 0.002, 0.005 } };
+	StageSummary summary = StageSummary::Summarize("stage", seconds);
+	check(summary.samples == 5 && fabs(summary.median - 3.0) < 1e-9 && fabs(summary.mean - 3.0) < 1e-9, "summary median and mean");
+	check(fabs(summary.minimum - 1.0) < 1e-9 && fabs(summary.maximum - 5.0) < 1e-9 && fabs(summary.p95 - 5.0) < 1e-9, "summary range and p95");
+	check(summary.runs.size() == 1 && fabs(summary.runs[0] - 3.0) < 1e-9, "summary keeps run medians");
+	bool thrown = false;
+	try { StageSummary::Summarize("empty", { {} }); } catch (const std::invalid_argument&) { thrown = true; }
+	check(thrown, "empty run throws");
+
+	// JSONに書き出して読み込むと同じ内容になる
+	BenchmarkReport baseline = MakeReport("base \"quoted\"", 0.010);
+	const char* filename = "BenchmarkSuiteTest.json";
+	{
+		std::ofstream stream(filename);
+		baseline.WriteJson(stream);
+	}
+	BenchmarkReport loaded = BenchmarkReport::ReadJson(filename);
+	remove(filename);
+	check(loaded.label == baseline.label && loaded.instructionSet == baseline.instructionSet, "label and instruction set round trip");
+	check(loaded.frames == baseline.frames && loaded.repetitions == baseline.repetitions && loaded.scenes.size() == 1, "counts round trip");
+	const SceneReport& scene = loaded.scenes[0];
+	check(scene.name == "small" && scene.nodes == 301 && scene.visible == 120 && scene.checksum == "00000000deadbeef", "scene round trips");
+	check(scene.stages.size() == 1 && scene.stages[0].runs.size() == baseline.scenes[0].stages[0].runs.size() &&
+		fabs(scene.stages[0].mean - baseline.scenes[0].stages[0].mean) < 1e-4, "stage summary round trips");
+
+	// 同じ結果は回帰にならず、有意に遅くなった場合だけ回帰として数える
+	std::ostringstream output;
+	check(CompareReports(baseline, baseline, 0.05, 0.99, output) == 0, "identical reports have no regression");
+	check(CompareReports(baseline, MakeReport("slow", 0.012), 0.05, 0.99, output) == 1, "20% slower is a regression");
+	check(CompareReports(baseline, MakeReport("fast", 0.008), 0.05, 0.99, output) == 0, "improvement is not a regression");
+	check(CompareReports(baseline, MakeReport("noise", 0.0102), 0.05, 0.99, output) == 0, "change under the threshold is not a regression");
+	thrown = false;
+	try { CompareReports(baseline, baseline, 0.05, 1.0, output); } catch (const std::invalid_argument&) { thrown = true; }
+	check(thrown, "invalid confidence throws");
+
+	return check.Finish();
+}
@@ -0,0 +1,195 @@
+﻿// BoundingVolumeHierarchyTest.cpp - 境界ボリューム階層の構造と問い合わせが総当たりの結果と一致することを検証する
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <random>
+#include <stdint.h>
+#include <vector>
+#include "BenchmarkCamera.h"
+#include "BoundingVolumeHierarchy.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+#include "MeshData.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// 境界ボックス数(並列に構築される大きさを超える)
+	const size_t COUNT = 20000;
+	// 総当たりと比較する問い合わせ回数
+	const int QUERY_COUNT = 200;
+
+	// bがaに含まれるか
+	bool Contains(const MeshBounds& a, const MeshBounds& b)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (b.minimum[axis] < a.minimum[axis] || b.maximum[axis] > a.maximum[axis])
+				return false;
+		}
+		return true;
+	}
+
+	// 二つの境界ボックスが重なるか
+	bool Overlaps(const MeshBounds& a, const MeshBounds& b)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (a.maximum[axis] < b.minimum[axis] || a.minimum[axis] > b.maximum[axis])
+				return false;
+		}
+		return true;
+	}
+
+	// ノードの包含関係と葉の範囲が正しいか(葉のプリミティブ数の合計を返す)
+	bool ValidTree(const BoundingVolumeHierarchy& bvh, const std::vector<MeshBounds>& bounds, size_t& leafPrimitives)
+	{
+		const BvhNode* nodes = bvh.GetNodes();
+		leafPrimitives = 0;
+		for (size_t i = 0; i < bvh.GetNodeCount(); i++)
+		{
+			const BvhNode& node = nodes[i];
+			if (node.left == 0)
+			{
+				leafPrimitives += node.count;
+				continue;
+			}
+			if (node.left <= i || node.left + 1 >= bvh.GetNodeCount())
+				return false;
+			const BvhNode& left = nodes[node.left];
+			const BvhNode& right = nodes[node.left + 1];
+			if (!Contains(node.bounds, left.bounds) || !Contains(node.bounds, right.bounds))
+				return false;
+			if (left.start != node.start || right.start != left.start + left.count || left.count + right.count != node.count)
+				return false;
+		}
+		return bvh.GetNodeCount() > 0 && nodes[0].count == bounds.size();
+	}
+
+	// 総当たりでレイと最も近くで交差する境界ボックスを求める(同じ距離なら小さい番号)
+	uint32_t BruteForceRaycast(const std::vector<MeshBounds>& bounds, const float* origin, const float* direction, float maxDistance)
+	{
+		float inverseDirection[3];
+		for (int axis = 0; axis < 3; axis++)
+			inverseDirection[axis] = direction[axis] != 0.0f ? 1.0f / direction[axis] : FLT_MAX;
+		float closest = maxDistance;
+		uint32_t result = BoundingVolumeHierarchy::NO_PRIMITIVE;
+		for (size_t i = 0; i < bounds.size(); i++)
+		{
+			float entry = 0.0f, leave = maxDistance;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float t0 = (bounds[i].minimum[axis] - origin[axis]) * inverseDirection[axis];
+				float t1 = (bounds[i].maximum[axis] - origin[axis]) * inverseDirection[axis];
+				if (t0 > t1)
+					std::swap(t0, t1);
+				entry = std::max(entry, t0);
+				leave = std::min(leave, t1);
+			}
+			if (entry <= leave && entry < closest)
+			{
+				closest = entry;
+				result = uint32_t(i);
+			}
+		}
+		return result;
+	}
+
+	// 問い合わせの結果が総当たりと一致するか
+	bool QueriesMatch(const BoundingVolumeHierarchy& bvh, const std::vector<MeshBounds>& bounds, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		bool match = true;
+		for (int n = 0; n < QUERY_COUNT; n++)
+		{
+			float origin[3] = { position(random), position(random), position(random) };
+			float direction[3] = { position(random), position(random), position(random) };
+			float length = std::max(sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]), 1e-6f);
+			for (float& value : direction)
+				value /= length;
+			match = match && bvh.Raycast(origin, direction, 1000.0f) == BruteForceRaycast(bounds, origin, direction, 1000.0f);
+
+			float half = 10.0f;
+			MeshBounds query = { { origin[0] - half, origin[1] - half, origin[2] - half }, { origin[0] + half, origin[1] + half, origin[2] + half } };
+			std::vector<uint32_t> results, expected;
+			bvh.QueryOverlap(query, results);
+			for (size_t i = 0; i < bounds.size(); i++)
+			{
+				if (Overlaps(bounds[i], query))
+					expected.push_back(uint32_t(i));
+			}
+			std::sort(results.begin(), results.end());
+			match = match && results == expected;
+		}
+		return match;
+	}
+}
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> size(0.1f, 1.0f);
+		std::vector<MeshBounds> bounds(COUNT);
+		for (MeshBounds& box : bounds)
+		{
+			float x = position(random), y = position(random), z = position(random), half = size(random);
+			box = { { x - half, y - half, z - half }, { x + half, y + half, z + half } };
+		}
+		float viewProjection[16];
+		CreateBenchmarkViewProjection(viewProjection);
+		FrustumCuller culler(viewProjection);
+		std::vector<uint8_t> flat(COUNT), hierarchical(COUNT);
+
+		// 単一スレッドと並列の構築
+		BoundingVolumeHierarchy serial, parallel;
+		serial.Build(bounds.data(), COUNT);
+		{
+			JobSystem jobSystem;
+			parallel.Build(bounds.data(), COUNT, &jobSystem);
+		}
+		size_t leafPrimitives = 0;
+		check(ValidTree(serial, bounds, leafPrimitives) && leafPrimitives == COUNT, "serial build forms a valid tree");
+		check(ValidTree(parallel, bounds, leafPrimitives) && leafPrimitives == COUNT, "parallel build forms a valid tree");
+		check(serial.GetPrimitiveCount() == COUNT && parallel.GetPrimitiveCount() == COUNT, "primitive count");
+
+		// 視錐台カリングは平坦な判定と一致する
+		size_t flatCount = culler.Cull(bounds.data(), COUNT, flat.data());
+		check(serial.CullFrustum(culler, hierarchical.data()) == flatCount && hierarchical == flat, "serial culling matches flat culling");
+		check(parallel.CullFrustum(culler, hierarchical.data()) == flatCount && hierarchical == flat, "parallel culling matches flat culling");
+
+		// レイと重なりは総当たりと一致する
+		check(QueriesMatch(serial, bounds, random), "serial queries match brute force");
+		check(QueriesMatch(parallel, bounds, random), "parallel queries match brute force");
+
+		// 再適合後も同じ結果になる
+		for (MeshBounds& box : bounds)
+		{
+			float offset = size(random) * 5.0f;
+			box.minimum[1] += offset;
+			box.maximum[1] += offset;
+		}
+		serial.Refit(bounds.data());
+		check(ValidTree(serial, bounds, leafPrimitives), "refit keeps parents enclosing children");
+		flatCount = culler.Cull(bounds.data(), COUNT, flat.data());
+		check(serial.CullFrustum(culler, hierarchical.data()) == flatCount && hierarchical == flat, "refit culling matches flat culling");
+		check(QueriesMatch(serial, bounds, random), "refit queries match brute force");
+
+		// 空の階層は何も返さない
+		BoundingVolumeHierarchy empty;
+		empty.Build(bounds.data(), 0);
+		const float origin[3] = { 0.0f, 0.0f, 0.0f }, direction[3] = { 1.0f, 0.0f, 0.0f };
+		std::vector<uint32_t> results;
+		empty.QueryOverlap(bounds[0], results);
+		check(empty.Raycast(origin, direction, 1000.0f) == BoundingVolumeHierarchy::NO_PRIMITIVE && results.empty(), "empty hierarchy");
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
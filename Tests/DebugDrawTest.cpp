@@ -0,0 +1,142 @@
+﻿// DebugDrawTest.cpp - ジョブシステムのワーカーから積んだデバッグ表示が、Collectで深度の扱いごとの線分リストにまとまるかを検証する
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "AllocationCounter.h"
+#include "DebugDraw.h"
+#include "JobSystem.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// 積む項目の数
+	const size_t ITEM_COUNT = 2000;
+	// 1つの項目が積む線分の頂点数(深度テストあり: 線分と球、深度テストなし: 境界ボックス)
+	const size_t DEPTH_VERTICES = 2 + DebugDraw::SPHERE_SEGMENTS * 6;
+	const size_t NO_DEPTH_VERTICES = 24;
+
+	// 項目の文字列
+	std::string ItemText(size_t item)
+	{
+		char text[32];
+		snprintf(text, sizeof(text), "item %u", unsigned(item));
+		return text;
+	}
+
+	// 項目ごとに線分・境界ボックス・球・文字列を積む(文字列の表示位置のXに項目の番号を入れる)
+	void AddItems(DebugDraw& debugDraw, size_t begin, size_t end)
+	{
+		const float color[4] = { 1.0f, 0.5f, 0.25f, 1.0f };
+		for (size_t i = begin; i < end; i++)
+		{
+			float position[3] = { float(i), 0.0f, 0.0f };
+			float to[3] = { float(i), 1.0f, 0.0f };
+			MeshBounds bounds = { { float(i), 0.0f, 0.0f }, { float(i) + 1.0f, 1.0f, 1.0f } };
+			debugDraw.AddLine(position, to, color);
+			debugDraw.AddBox(bounds, color, DebugDrawList::NO_DEPTH);
+			debugDraw.AddSphere(position, 0.5f, color);
+			debugDraw.AddText(position, ItemText(i).c_str(), color);
+		}
+	}
+
+	// すべての文字列が項目の文字列と一致し、どの項目も1回ずつ現れるか
+	bool LabelsMatch(const DebugDrawList& list)
+	{
+		if (list.labels.size() != ITEM_COUNT)
+			return false;
+		std::vector<bool> seen(ITEM_COUNT, false);
+		for (const DebugLabel& label : list.labels)
+		{
+			size_t item = size_t(label.position[0]);
+			if (item >= ITEM_COUNT || seen[item] || size_t(label.textOffset) + label.textLength > list.text.size())
+				return false;
+			seen[item] = true;
+			if (std::string(list.text.data() + label.textOffset, label.textLength) != ItemText(item))
+				return false;
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		// 複数のワーカーから積んだものが1つのリストにまとまり、文字列の開始位置はまとめたリストの位置に直される
+		DebugDraw debugDraw;
+		DebugDrawList list;
+		JobSystem jobSystem(3);
+		jobSystem.ParallelFor(ITEM_COUNT, 16, [&](size_t begin, size_t end) { AddItems(debugDraw, begin, end); });
+		debugDraw.Collect(list);
+		check(list.lines[DebugDrawList::DEPTH_TEST].size() == ITEM_COUNT * DEPTH_VERTICES, "depth-tested lines are merged");
+		check(list.lines[DebugDrawList::NO_DEPTH].size() == ITEM_COUNT * NO_DEPTH_VERTICES, "no-depth lines are merged");
+		check(list.GetLineCount() == ITEM_COUNT * (DEPTH_VERTICES + NO_DEPTH_VERTICES) / 2, "line count");
+		check(LabelsMatch(list), "label offsets are rebased across buffers");
+
+		// まとめたバッファは空になる
+		debugDraw.Collect(list);
+		check(list.GetLineCount() == 0 && list.labels.empty() && list.text.empty(), "collect empties the buffers");
+
+		// 文字列は最大長で切り捨てる
+		const float origin[3] = { 0.0f, 0.0f, 0.0f };
+		const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		std::string longText(DebugDraw::MAX_LABEL_LENGTH + 36, 'x');
+		longText[DebugDraw::MAX_LABEL_LENGTH - 1] = 'y';
+		debugDraw.AddText(origin, "short", white);
+		debugDraw.AddText(origin, longText.c_str(), white);
+		debugDraw.Collect(list);
+		check(list.labels.size() == 2 && list.labels[1].textOffset == 5 && list.labels[1].textLength == DebugDraw::MAX_LABEL_LENGTH &&
+			list.text.size() == 5 + DebugDraw::MAX_LABEL_LENGTH && list.text.back() == 'y', "labels are truncated to the maximum length");
+
+		// 無効な間は何も積まない
+		debugDraw.SetEnabled(false);
+		jobSystem.ParallelFor(ITEM_COUNT, 16, [&](size_t begin, size_t end) { AddItems(debugDraw, begin, end); });
+		const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+		debugDraw.AddFrustum(identity, white);
+		debugDraw.AddAxes(identity, 1.0f);
+		debugDraw.Collect(list);
+		check(list.GetLineCount() == 0 && list.labels.empty() && list.text.empty(), "disabled debug draw adds nothing");
+		debugDraw.SetEnabled(true);
+
+		// 一度大きくなったバッファは使い回し、同じ量を積んでもまとめたリストは大きくならない
+		jobSystem.ParallelFor(ITEM_COUNT, 16, [&](size_t begin, size_t end) { AddItems(debugDraw, begin, end); });
+		debugDraw.Collect(list);
+		size_t capacity = list.lines[DebugDrawList::DEPTH_TEST].capacity();
+		bool stable = true;
+		for (int frame = 0; frame < 20; frame++)
+		{
+			jobSystem.ParallelFor(ITEM_COUNT, 16, [&](size_t begin, size_t end) { AddItems(debugDraw, begin, end); });
+			debugDraw.Collect(list);
+			stable = stable && list.lines[DebugDrawList::DEPTH_TEST].capacity() == capacity && LabelsMatch(list);
+		}
+		check(stable, "merged list is reused without growth");
+
+		// 同じスレッドから同じ量を積む場合は、準備の後はヒープを確保しない
+		const float color[4] = { 0.0f, 1.0f, 0.0f, 1.0f };
+		const MeshBounds bounds = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+		auto frame = [&]()
+		{
+			for (int i = 0; i < 100; i++)
+			{
+				debugDraw.AddBox(bounds, color);
+				debugDraw.AddSphere(origin, 1.0f, color, DebugDrawList::NO_DEPTH);
+				debugDraw.AddText(origin, "label", color);
+			}
+			debugDraw.Collect(list);
+		};
+		frame();
+		uint64_t allocations = AllocationCounter::GetCount();
+		for (int i = 0; i < 10; i++)
+			frame();
+		check(AllocationCounter::GetCount() == allocations, "thread buffers are reused after warm-up");
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
@@ -0,0 +1,149 @@
+﻿// FramePipelineTest.cpp - 更新と描画のパイプラインのスナップショットの受け渡しと、入力の受け渡しを検証する
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include "FramePipeline.h"
+#include "InputState.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// 描画するフレーム数
+	const int FRAME_COUNT = 2000;
+	// 描画を待つ列が埋まるのを確かめる回数
+	const int QUEUE_ROUNDS = 50;
+	// 取得を待つ時間(ミリ秒)
+	const uint32_t TIMEOUT_MILLISECONDS = 1000;
+
+	// 1フレーム分の状態
+	struct Snapshot
+	{
+		// 公開した順番
+		int sequence;
+		// 更新で使った入力の番号
+		int input;
+	};
+}
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		// 描画は公開されたすべてのスナップショットを順に受け取り、更新は先行できるフレーム数を超えない
+		for (int latency = 1; latency <= FramePipeline::MAX_FRAME_LATENCY; latency++)
+		{
+			std::string name = "latency " + std::to_string(latency);
+			FramePipeline pipeline;
+			InputMailbox mailbox;
+			Snapshot snapshots[FramePipeline::SNAPSHOT_COUNT] = {};
+			std::atomic<int> produced(0), maximumAhead(0);
+			pipeline.Start(latency, [&](int snapshot)
+			{
+				// 更新スレッドは描画スレッドが書き込んだ最新の入力を読む
+				int ahead = int(pipeline.GetPublishedFrames() - pipeline.GetAcquiredFrames());
+				if (ahead > maximumAhead)
+					maximumAhead = ahead;
+				snapshots[snapshot].sequence = ++produced;
+				snapshots[snapshot].input = mailbox.Read().mouseX;
+				return true;
+			});
+
+			bool ordered = true, inputOrdered = true;
+			int lastSequence = 0, lastInput = 0;
+			for (int frame = 1; frame <= FRAME_COUNT; frame++)
+			{
+				InputFrame input = {};
+				input.mouseX = frame;
+				mailbox.Post(input);
+				int snapshot = pipeline.Acquire(TIMEOUT_MILLISECONDS);
+				if (snapshot < 0)
+				{
+					ordered = false;
+					break;
+				}
+				const Snapshot& current = snapshots[snapshot];
+				ordered = ordered && current.sequence == lastSequence + 1;
+				inputOrdered = inputOrdered && current.input >= lastInput && current.input <= frame;
+				lastSequence = current.sequence;
+				lastInput = current.input;
+			}
+			pipeline.Stop();
+			check(ordered, (name + " delivers snapshots in order").c_str());
+			check(inputOrdered, (name + " hands the latest input to the update thread").c_str());
+			check(maximumAhead <= latency, (name + " never runs ahead of the limit").c_str());
+			// 取得されていないフレームは描画を待つ列に残っている
+			check(pipeline.GetAcquiredFrames() == FRAME_COUNT &&
+				pipeline.GetPublishedFrames() - pipeline.GetAcquiredFrames() <= uint64_t(latency), (name + " counts every published frame").c_str());
+			check(!pipeline.IsRunning(), (name + " stops").c_str());
+		}
+
+		// 先行できるフレーム数が2以上の場合、描画が遅れると公開したフレームが上限まで列に並び、上書きされずに順に描画される
+		for (int latency = 2; latency <= FramePipeline::MAX_FRAME_LATENCY; latency++)
+		{
+			std::string name = "latency " + std::to_string(latency);
+			FramePipeline pipeline;
+			Snapshot snapshots[FramePipeline::SNAPSHOT_COUNT] = {};
+			int produced = 0;
+			pipeline.Start(latency, [&](int snapshot)
+			{
+				snapshots[snapshot].sequence = ++produced;
+				return true;
+			});
+
+			bool filled = true, consecutive = true;
+			int lastSequence = 0;
+			for (int round = 0; round < QUEUE_ROUNDS && filled && consecutive; round++)
+			{
+				// 更新が上限まで先行するのを待ち、少し待っても上限を超えないことを確かめる
+				auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TIMEOUT_MILLISECONDS);
+				while (pipeline.GetPublishedFrames() - pipeline.GetAcquiredFrames() < uint64_t(latency) && std::chrono::steady_clock::now() < deadline)
+					std::this_thread::yield();
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				filled = pipeline.GetPublishedFrames() - pipeline.GetAcquiredFrames() == uint64_t(latency);
+
+				// 列に並んだフレームを続けて取得すると、公開した順に1つずつ受け取る
+				for (int i = 0; i < latency; i++)
+				{
+					int snapshot = pipeline.Acquire(TIMEOUT_MILLISECONDS);
+					consecutive = consecutive && snapshot >= 0 && snapshots[snapshot].sequence == ++lastSequence;
+				}
+			}
+			pipeline.Stop();
+			check(filled, (name + " queues published frames up to the limit").c_str());
+			check(consecutive, (name + " delivers every queued frame in order").c_str());
+		}
+
+		// 公開しない更新では取得がタイムアウトする
+		{
+			FramePipeline pipeline;
+			pipeline.Start(1, [](int) { return false; });
+			check(pipeline.Acquire(10) < 0, "acquire times out without a published snapshot");
+			pipeline.Stop();
+			pipeline.Stop();
+			check(!pipeline.IsRunning(), "stop is idempotent");
+		}
+
+		// 範囲外の先行フレーム数は例外になる
+		bool threw = false;
+		try
+		{
+			FramePipeline pipeline;
+			pipeline.Start(0, [](int) { return true; });
+		}
+		catch (const std::out_of_range&)
+		{
+			threw = true;
+		}
+		check(threw, "frame latency 0 throws");
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
@@ -0,0 +1,88 @@
+﻿// FrameStatisticsTest.cpp - フレームの統計とフレーム時間の分布の集計を既知の系列で検証する
+
+#include <math.h>
+#include <stdexcept>
+#include <string.h>
+#include "FrameStatistics.h"
+#include "Profiler.h"
+#include "TestCheck.h"
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		auto near = [](double a, double b) { return fabs(a - b) < 1e-6; };
+		// 百分位数は値を含むバケットの上端を返す
+		const double bucket = FrameTimeHistogram::BUCKET_MICROSECONDS * 1e-6;
+		auto inBucket = [&](double value, double expected) { return value > expected - 1e-6 && value < expected + bucket + 1e-6; };
+
+		// 空の統計はすべて0を返し、範囲外の参照は例外を投げる
+		FrameStatistics statistics;
+		check(statistics.GetFrameCount() == 0 && statistics.GetAverage() == 0.0 && statistics.GetMaximum() == 0.0, "empty statistics");
+		bool thrown = false;
+		try { statistics.GetFrameTime(0); } catch (const std::out_of_range&) { thrown = true; }
+		check(thrown, "frame age out of range throws");
+
+		// 1～10ミリ秒のフレームを順に確定する
+		int update = statistics.AddStage("update");
+		int render = statistics.AddStage("render");
+		int draws = statistics.AddCounter("draws");
+		for (int i = 1; i <= 10; i++)
+		{
+			statistics.AddStageTime(update, 0.001);
+			statistics.AddStageTime(update, 0.001);
+			statistics.AddStageTime(render, 0.0005 * i);
+			statistics.SetCounter(draws, uint64_t(i * 10));
+			statistics.EndFrame(0.001 * i);
+		}
+		check(statistics.GetFrameCount() == 10, "frame count");
+		check(near(statistics.GetFrameTime(0), 0.010) && near(statistics.GetFrameTime(9), 0.001), "frame age order");
+		check(near(statistics.GetMinimum(), 0.001) && near(statistics.GetMaximum(), 0.010), "minimum and maximum");
+		check(near(statistics.GetAverage(), 0.0055), "average");
+		check(statistics.CountFramesOver(0.0075) == 3, "frames over threshold");
+		check(near(statistics.GetStageAverage(update), 0.002) && near(statistics.GetStageMaximum(update), 0.002), "accumulated stage time");
+		check(near(statistics.GetStageAverage(render), 0.00275) && near(statistics.GetStageMaximum(render), 0.005), "stage average and maximum");
+		check(statistics.GetCounter(draws) == 100, "counter keeps the last frame");
+		check(strcmp(statistics.GetStageName(render), "render") == 0 && strcmp(statistics.GetCounterName(draws), "draws") == 0, "names");
+
+		// 窓を一周させると古いフレームは平均・最小・最大・段階の合計から外れる
+		for (size_t i = 0; i < FrameStatistics::WINDOW_SIZE; i++)
+		{
+			statistics.AddStageTime(update, 0.003);
+			statistics.EndFrame(0.004);
+		}
+		check(statistics.GetFrameCount() == FrameStatistics::WINDOW_SIZE, "window is bounded");
+		check(near(statistics.GetAverage(), 0.004) && near(statistics.GetMinimum(), 0.004) && near(statistics.GetMaximum(), 0.004), "old frames leave the window");
+		check(near(statistics.GetStageAverage(update), 0.003) && near(statistics.GetStageAverage(render), 0.0), "old stage times leave the window");
+		check(statistics.GetCounter(draws) == 0, "unset counter reads zero");
+		check(inBucket(statistics.GetPercentile(50.0), 0.004) && inBucket(statistics.GetPercentile(99.0), 0.004), "percentiles follow the window");
+
+		// 登録数の上限と範囲外の番号は例外を投げる
+		thrown = false;
+		try
+		{
+			for (int i = 0; i <= FrameStatistics::MAX_STAGES; i++)
+				statistics.AddStage("stage");
+		}
+		catch (const std::out_of_range&) { thrown = true; }
+		check(thrown && statistics.GetStageCount() == FrameStatistics::MAX_STAGES, "stage limit throws");
+		thrown = false;
+		try { statistics.SetCounter(FrameStatistics::MAX_COUNTERS, 0); } catch (const std::out_of_range&) { thrown = true; }
+		check(thrown, "counter out of range throws");
+
+		// 分布の百分位数はバケットの幅の精度で求まる
+		FrameTimeHistogram histogram;
+		for (int i = 1; i <= 100; i++)
+			histogram.Add(0.001 * i);
+		check(histogram.GetCount() == 100, "histogram count");
+		check(inBucket(histogram.GetPercentile(50.0), 0.050) && inBucket(histogram.GetPercentile(99.0), 0.099), "histogram percentiles");
+		histogram.Clear();
+		check(histogram.GetCount() == 0 && histogram.GetPercentile(50.0) == 0.0, "histogram clear");
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
@@ -0,0 +1,93 @@
+﻿// FrustumCullerTest.cpp - 視錐台カリングの判定が既知の配置と一致し、どの命令セットでも同じ結果になることを検証する
+
+#include <math.h>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "FrustumCuller.h"
+#include "MeshData.h"
+#include "TestCheck.h"
+#include "TransformKernel.h"
+
+namespace
+{
+	// 右手系の透視射影行列を作成する(ビュー行列は単位行列とし、カメラは-z方向を見る)
+	void CreateProjection(float* result)
+	{
+		const float fieldOfView = 3.14159265f / 4.0f, aspect = 4.0f / 3.0f, nearZ = 0.1f, farZ = 100.0f;
+		float height = 1.0f / tanf(fieldOfView / 2.0f);
+		for (int i = 0; i < 16; i++)
+			result[i] = 0.0f;
+		result[0] = height / aspect;
+		result[5] = height;
+		result[10] = farZ / (nearZ - farZ);
+		result[11] = -1.0f;
+		result[14] = nearZ * farZ / (nearZ - farZ);
+	}
+
+	// 中心と半径から境界ボックスを作成する
+	MeshBounds Box(float x, float y, float z, float radius)
+	{
+		return { { x - radius, y - radius, z - radius }, { x + radius, y + radius, z + radius } };
+	}
+}
+
+int main()
+{
+	TestCheck check;
+	float projection[16];
+	CreateProjection(projection);
+
+	// 既知の配置: 正面、背後、横、遠平面の外、近平面の手前、遠平面をまたぐもの、左平面をまたぐもの
+	const MeshBounds cases[] = { Box(0.0f, 0.0f, -5.0f, 1.0f), Box(0.0f, 0.0f, 5.0f, 1.0f), Box(100.0f, 0.0f, -5.0f, 1.0f),
+		Box(0.0f, 0.0f, -200.0f, 1.0f), Box(0.0f, 0.0f, -0.05f, 0.01f), Box(0.0f, 0.0f, -100.5f, 1.0f), Box(-2.5f, 0.0f, -5.0f, 0.6f) };
+	const uint8_t expected[] = { 1, 0, 0, 0, 0, 1, 1 };
+	const size_t caseCount = sizeof(cases) / sizeof(cases[0]);
+
+	// 一様に配置した境界ボックス
+	const size_t count = 100003;
+	std::mt19937 random(2);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::vector<MeshBounds> bounds(count);
+	for (MeshBounds& box : bounds)
+	{
+		float x = position(random), y = position(random), z = position(random);
+		box = Box(x, y, z, 1.0f);
+	}
+
+	TransformKernel::InstructionSet supported = TransformKernel::GetSupportedInstructionSet();
+	std::vector<uint8_t> reference;
+	for (int set = TransformKernel::SCALAR; set <= supported; set++)
+	{
+		TransformKernel::SetInstructionSet(TransformKernel::InstructionSet(set));
+		std::string name = TransformKernel::GetInstructionSetName(TransformKernel::InstructionSet(set));
+		FrustumCuller culler(projection);
+
+		uint8_t visible[caseCount];
+		size_t visibleCount = culler.Cull(cases, caseCount, visible);
+		bool known = visibleCount == 3;
+		for (size_t i = 0; i < caseCount; i++)
+			known = known && visible[i] == expected[i] && culler.IsVisible(cases[i]) == (expected[i] != 0);
+		check(known, (name + " known cases").c_str());
+
+		std::vector<uint8_t> result(count);
+		visibleCount = culler.Cull(bounds.data(), count, result.data());
+		size_t ones = 0;
+		for (uint8_t value : result)
+			ones += value;
+		check(visibleCount == ones && visibleCount > 0 && visibleCount < count, (name + " visible count").c_str());
+		if (set == TransformKernel::SCALAR)
+			reference = result;
+		else
+			check(result == reference, (name + " agrees with scalar").c_str());
+	}
+	TransformKernel::SetInstructionSet(supported);
+
+	// 境界ボックスの変換(z軸回りに90度回転して+xに5移動する)
+	const float matrix[16] = { 0.0f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 5.0f, 0.0f, 0.0f, 1.0f };
+	MeshBounds transformed = FrustumCuller::TransformBounds({ { 0.0f, 0.0f, 0.0f }, { 2.0f, 1.0f, 1.0f } }, matrix);
+	check(transformed.minimum[0] == 4.0f && transformed.minimum[1] == 0.0f && transformed.minimum[2] == 0.0f &&
+		transformed.maximum[0] == 5.0f && transformed.maximum[1] == 2.0f && transformed.maximum[2] == 1.0f, "transformed bounds");
+	return check.Finish();
+}
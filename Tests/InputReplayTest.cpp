@@ -0,0 +1,187 @@
+﻿// InputReplayTest.cpp - 仮想クロックで更新しながら記録した入力を再生し、更新ごとの状態のハッシュが一致するかを検証する
+
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "GameStepper.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// 記録するフレーム数
+	const int FRAME_COUNT = 600;
+	// 入力ログのファイル名(テストの作業ディレクトリに作成して最後に削除する)
+	const char* LOG_FILE = "InputReplayTest.log";
+	// 前進するキーと横に移動するキー
+	const uint8_t KEY_FORWARD = 'W';
+	const uint8_t KEY_RIGHT = 'D';
+
+	// 入力で動かす状態
+	struct Simulation
+	{
+		// 位置(固定ステップごとに補間する)
+		InterpolatedState<float> x;
+		InterpolatedState<float> y;
+		// マウスの横の移動で回す向き
+		float yaw;
+		// 前回の更新のマウスのX座標
+		int32_t lastMouseX;
+		// マウスホイールの累積値
+		int32_t zoom;
+		// 左ボタンが押された回数
+		uint32_t clicks;
+		// 更新ごとの状態のハッシュ
+		std::vector<uint64_t> hashes;
+	};
+
+	// 値をFNV-1aのハッシュに加える
+	template<typename T>
+	void HashValue(uint64_t& hash, const T& value)
+	{
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+		for (size_t i = 0; i < sizeof(T); i++)
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+
+	// 入力で状態を更新し、更新後の状態のハッシュを加える
+	void Update(Simulation& simulation, const InputState& input, const DX::StepTimer& timer)
+	{
+		float seconds = float(timer.GetElapsedSeconds());
+		if (input.IsKeyDown(KEY_FORWARD))
+			simulation.y.GetCurrent() += 3.0f * seconds;
+		if (input.IsKeyDown(KEY_RIGHT))
+			simulation.x.GetCurrent() += 2.0f * seconds;
+		simulation.yaw += 0.01f * float(input.GetMouseX() - simulation.lastMouseX);
+		simulation.lastMouseX = input.GetMouseX();
+		simulation.zoom = input.GetScrollWheel();
+		if (input.IsMousePressed(InputState::MOUSE_LEFT))
+			simulation.clicks++;
+
+		uint64_t hash = simulation.hashes.empty() ? 14695981039346656037ull : simulation.hashes.back();
+		HashValue(hash, timer.GetTotalTicks());
+		HashValue(hash, simulation.x.GetPrevious());
+		HashValue(hash, simulation.x.GetCurrent());
+		HashValue(hash, simulation.y.GetPrevious());
+		HashValue(hash, simulation.y.GetCurrent());
+		HashValue(hash, simulation.yaw);
+		HashValue(hash, simulation.zoom);
+		HashValue(hash, simulation.clicks);
+		simulation.hashes.push_back(hash);
+	}
+
+	// ステッパーを60Hzの固定ステップで仮想クロックを使って進めるように設定し、状態を登録する
+	void Setup(GameStepper& stepper, Simulation& simulation, double stepSeconds = 1.0 / 60.0)
+	{
+		stepper.SetHeadless();
+		stepper.GetTimer().SetFixedTimeStep(true);
+		stepper.GetTimer().SetTargetElapsedSeconds(stepSeconds);
+		stepper.AddInterpolatedState(&simulation.x);
+		stepper.AddInterpolatedState(&simulation.y);
+		simulation.yaw = 0.0f;
+		simulation.lastMouseX = 0;
+		simulation.zoom = 0;
+		simulation.clicks = 0;
+	}
+
+	// デバイスから読んだことにする入力の列を作成する(マウスは毎フレーム動き、キーとボタンとホイールはときどき変化する)
+	std::vector<InputFrame> CreateInputScript()
+	{
+		std::mt19937 random(19);
+		std::uniform_int_distribution<int> move(-8, 8);
+		std::vector<InputFrame> frames(FRAME_COUNT);
+		InputFrame frame = {};
+		frame.mouseX = 320;
+		frame.mouseY = 240;
+		for (int i = 0; i < FRAME_COUNT; i++)
+		{
+			frame.mouseX += move(random);
+			frame.mouseY += move(random);
+			if (i % 50 == 0)
+				frame.scrollWheel += 120;
+			frame.mouseButtons = (i / 7) % 3 == 0 ? InputState::MOUSE_LEFT : 0;
+			if (i % 20 == 0)
+			{
+				uint8_t key = random() % 2 ? KEY_FORWARD : KEY_RIGHT;
+				frame.keys[key >> 3] ^= uint8_t(1 << (key & 7));
+			}
+			frames[i] = frame;
+		}
+		return frames;
+	}
+}
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		std::vector<InputFrame> script = CreateInputScript();
+
+		// デバイスの入力を渡しながら更新し、入力を記録する
+		Simulation recorded;
+		{
+			GameStepper stepper;
+			Setup(stepper, recorded);
+			stepper.StartInput(LOG_FILE);
+			for (const InputFrame& frame : script)
+			{
+				stepper.PostInput(frame);
+				stepper.Tick([&](const DX::StepTimer& timer) { Update(recorded, stepper.GetInput(), timer); });
+			}
+			stepper.FinishInput();
+		}
+		check(recorded.hashes.size() == FRAME_COUNT, "virtual clock updates once per tick");
+		check(recorded.clicks > 0 && recorded.zoom > 0 && recorded.x.GetCurrent() > 0.0f && recorded.y.GetCurrent() > 0.0f, "input drives the simulation");
+
+		// 入力ログを再生して同じ回数だけ更新する(デバイスの入力は無視される)
+		Simulation replayed;
+		{
+			GameStepper stepper;
+			Setup(stepper, replayed);
+			stepper.SetInputReplay(std::make_unique<InputPlayer>(LOG_FILE));
+			stepper.StartInput("");
+			check(stepper.GetReplayUpdateCount() == FRAME_COUNT, "log holds the recorded update count");
+			InputFrame noise = {};
+			noise.mouseX = 12345;
+			for (uint32_t i = 0; i < stepper.GetReplayUpdateCount(); i++)
+			{
+				stepper.PostInput(noise);
+				stepper.Tick([&](const DX::StepTimer& timer) { Update(replayed, stepper.GetInput(), timer); });
+			}
+			stepper.FinishInput();
+		}
+		check(replayed.hashes == recorded.hashes, "replay reproduces every update");
+
+		// 入力が無ければ別の状態になる(ハッシュが入力に依存していることの確認)
+		Simulation idle;
+		{
+			GameStepper stepper;
+			Setup(stepper, idle);
+			stepper.StartInput("");
+			for (int i = 0; i < FRAME_COUNT; i++)
+				stepper.Tick([&](const DX::StepTimer& timer) { Update(idle, stepper.GetInput(), timer); });
+		}
+		check(idle.hashes.size() == FRAME_COUNT && idle.hashes.back() != recorded.hashes.back(), "hash depends on the input");
+
+		// 別の固定ステップの間隔で記録したログは再生できない
+		Simulation mismatched;
+		bool thrown = false;
+		{
+			GameStepper stepper;
+			Setup(stepper, mismatched, 1.0 / 30.0);
+			stepper.SetInputReplay(std::make_unique<InputPlayer>(LOG_FILE));
+			try { stepper.StartInput(""); } catch (const std::runtime_error&) { thrown = true; }
+		}
+		check(thrown, "replay rejects a different time step");
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	remove(LOG_FILE);
+	return check.Finish();
+}
@@ -0,0 +1,160 @@
+﻿// InstancingTest.cpp - インスタンス描画のまとめ方とインスタンスデータの作成を、ヌルバックエンドと記録用のバックエンドで検証する
+
+#include <stdexcept>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "NullRenderBackend.h"
+#include "RenderQueue.h"
+#include "TransformKernel.h"
+#include "TestCheck.h"
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		// インスタンスデータが行列を転置した上3行と色になっているか
+		auto packed = [](const InstanceData& instance, const float* world, const float* color)
+		{
+			for (int row = 0; row < 3; row++)
+			{
+				for (int column = 0; column < 4; column++)
+				{
+					if (instance.world[row * 4 + column] != world[column * 4 + row])
+						return false;
+				}
+			}
+			return memcmp(instance.color, color, sizeof(instance.color)) == 0;
+		};
+
+		// 行列と色は要素ごとに異なる値にする
+		const int ITEM_COUNT = 16;
+		float worlds[ITEM_COUNT][16];
+		float colors[ITEM_COUNT][4];
+		for (int i = 0; i < ITEM_COUNT; i++)
+		{
+			for (int j = 0; j < 16; j++)
+				worlds[i][j] = float(i * 16 + j);
+			for (int j = 0; j < 4; j++)
+				colors[i][j] = float(i) + 0.25f * float(j);
+		}
+		const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+		// 通常の描画3個と、メッシュ2/マテリアル0が5個、メッシュ1/マテリアル0が3個、メッシュ2/マテリアル1が4個のインスタンスを交互に積む
+		// (インスタンスはシェーダ1、通常の描画はシェーダ0を使う)
+		RenderQueue queue;
+		const uint32_t instanceMeshes[12] = { 2, 1, 2, 2, 1, 2, 2, 2, 1, 2, 2, 2 };
+		const uint32_t instanceMaterials[12] = { 0, 0, 1, 0, 0, 1, 0, 0, 0, 1, 1, 0 };
+		for (int i = 0; i < 12; i++)
+		{
+			if (i % 4 == 0)
+				queue.Submit(0, 0, 0, 0, 0.5f, worlds[12 + i / 4]);
+			queue.SubmitInstance(0, 1, instanceMaterials[i], instanceMeshes[i], worlds[i], i == 11 ? nullptr : colors[i]);
+		}
+		queue.Sort();
+		RenderCommandList commands;
+		queue.Record(commands);
+
+		// 同じメッシュとマテリアルのインスタンスは1回のインスタンス描画にまとまる
+		uint32_t draws = 0, instancedDraws = 0, instances = 0;
+		for (const RenderCommand& command : commands.GetCommands())
+		{
+			if (command.type == RENDER_COMMAND_DRAW)
+				draws++;
+			if (command.type == RENDER_COMMAND_DRAW_INSTANCED)
+			{
+				instancedDraws++;
+				instances += command.value;
+			}
+		}
+		check(draws == 3, "plain items are drawn one by one");
+		check(instancedDraws == 3 && instances == 12, "instances are grouped by mesh and material");
+		check(commands.GetInstances().size() == 12, "instance data is stored once per instance");
+
+		// グループの中は追加順に並び、行列は転置され、色の無いインスタンスは白になる
+		// (ソート順はマテリアル0のメッシュ1、メッシュ2、マテリアル1のメッシュ2)
+		const int expected[12] = { 1, 4, 8, 0, 3, 6, 7, 11, 2, 5, 9, 10 };
+		bool order = true;
+		for (int i = 0; i < 12; i++)
+			order = order && packed(commands.GetInstances()[i], worlds[expected[i]], expected[i] == 11 ? white : colors[expected[i]]);
+		check(order, "instance data follows the sorted order");
+
+		// 記録用のバックエンドで実行すると同じコマンドとインスタンスデータが記録される
+		RecordingRenderBackend recorder;
+		commands.Execute(recorder);
+		const RenderStatistics& recorded = recorder.GetStatistics();
+		check(recorded.draws == 6 && recorded.instances == 12, "recording backend counts instanced draws");
+		check(recorder.GetRecorded().GetCommands().size() == commands.GetCommands().size(), "recorded command count");
+		check(memcmp(recorder.GetRecorded().GetInstances().data(), commands.GetInstances().data(), sizeof(InstanceData) * 12) == 0,
+			"recorded instance data");
+
+		// ヌルバックエンドはインスタンスの数だけ三角形を数える
+		NullRenderBackend backend;
+		backend.AddShader();
+		backend.AddShader();
+		backend.AddMaterial();
+		backend.AddMaterial();
+		backend.AddMesh(1, 10);
+		backend.AddMesh(2, 100);
+		backend.AddMesh(1, 1000);
+		commands.Execute(backend);
+		check(backend.GetStatistics().draws == 6 && backend.GetStatistics().instances == 12, "null backend counts instanced draws");
+		check(backend.GetDrawCalls() == 3 + 2 + 1 + 1, "one draw call per range and group");
+		check(backend.GetTriangles() == 3 * 10 + 3 * 100 + 9 * 1000, "triangles are multiplied by the instance count");
+
+		// パスが変わればインスタンスは分かれる
+		queue.Clear();
+		queue.SubmitInstance(0, 1, 0, 2, worlds[0]);
+		queue.SubmitInstance(1, 1, 0, 2, worlds[1]);
+		queue.SubmitInstance(0, 1, 0, 2, worlds[2]);
+		queue.Sort();
+		commands.Clear();
+		queue.Record(commands);
+		check(commands.GetCommands().back().type == RENDER_COMMAND_DRAW_INSTANCED && commands.GetCommands().back().value == 1 &&
+			commands.GetInstances().size() == 3, "passes split instance groups");
+
+		// シェーダもメッシュも無いインスタンス描画と、範囲外の番号は例外を投げる
+		bool thrown = false;
+		try { NullRenderBackend empty; empty.DrawInstanced(commands.GetInstances().data(), 1); } catch (const std::runtime_error&) { thrown = true; }
+		check(thrown, "instanced draw without state throws");
+		thrown = false;
+		try { queue.SubmitInstance(0, 1, 0, 1u << RenderQueue::MESH_BITS, worlds[0]); } catch (const std::out_of_range&) { thrown = true; }
+		check(thrown, "instance mesh out of range throws");
+
+		// どの命令セットでも同じインスタンスデータになる(AVX2の端数も確認するので奇数個にする)
+		const size_t PACK_COUNT = 37;
+		std::vector<RenderItem> items(PACK_COUNT);
+		for (size_t i = 0; i < PACK_COUNT; i++)
+		{
+			items[i].world = worlds[i % ITEM_COUNT];
+			items[i].color = colors[(i * 7) % ITEM_COUNT];
+		}
+		TransformKernel::InstructionSet current = TransformKernel::GetInstructionSet();
+		std::vector<InstanceData> reference(PACK_COUNT), result(PACK_COUNT);
+		TransformKernel::SetInstructionSet(TransformKernel::SCALAR);
+		TransformKernel::PackInstances(reference[0].world, &items[0].world, &items[0].color, sizeof(RenderItem), PACK_COUNT);
+		bool scalar = true;
+		for (size_t i = 0; i < PACK_COUNT; i++)
+			scalar = scalar && packed(reference[i], items[i].world, items[i].color);
+		check(scalar, "scalar packing");
+		const TransformKernel::InstructionSet sets[] = { TransformKernel::SSE2, TransformKernel::AVX2 };
+		for (TransformKernel::InstructionSet set : sets)
+		{
+			TransformKernel::SetInstructionSet(set);
+			if (TransformKernel::GetInstructionSet() != set)
+				continue;
+			memset(result.data(), 0, sizeof(InstanceData) * PACK_COUNT);
+			TransformKernel::PackInstances(result[0].world, &items[0].world, &items[0].color, sizeof(RenderItem), PACK_COUNT);
+			std::string description = std::string(TransformKernel::GetInstructionSetName(set)) + " packing matches scalar";
+			check(memcmp(result.data(), reference.data(), sizeof(InstanceData) * PACK_COUNT) == 0, description.c_str());
+		}
+		TransformKernel::SetInstructionSet(current);
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
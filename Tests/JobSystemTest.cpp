@@ -0,0 +1,165 @@
+﻿// JobSystemTest.cpp - ジョブシステムとタスクグラフの実行範囲、入れ子の投入、依存順序、例外の伝播を検証する
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "JobSystem.h"
+#include "TaskGraph.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// ワーカー数(ハードウェアスレッド数によらず盗み取りが起きるようにする)
+	const unsigned WORKER_COUNT = 4;
+	// 繰り返しの回数
+	const int REPEAT_COUNT = 50;
+
+	// 例外が投げられてメッセージが一致するか
+	template <typename Function>
+	bool ThrowsMessage(Function function, const std::string& message)
+	{
+		try
+		{
+			function();
+		}
+		catch (const std::exception& exception)
+		{
+			return exception.what() == message;
+		}
+		return false;
+	}
+}
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		JobSystem jobSystem(WORKER_COUNT);
+		check(jobSystem.GetWorkerCount() == WORKER_COUNT, "worker count");
+
+		// ParallelForはすべての要素を1回ずつ処理し、範囲は粒度の倍数から始まる
+		bool covered = true, aligned = true;
+		for (int repeat = 0; repeat < REPEAT_COUNT; repeat++)
+		{
+			std::vector<std::atomic<int>> hits(10007);
+			for (std::atomic<int>& hit : hits)
+				hit = 0;
+			jobSystem.ParallelFor(hits.size(), 7, [&](size_t begin, size_t end)
+			{
+				if (begin % 7 != 0 || end - begin > 7)
+					aligned = false;
+				for (size_t i = begin; i < end; i++)
+					hits[i]++;
+			});
+			for (std::atomic<int>& hit : hits)
+				covered = covered && hit == 1;
+		}
+		check(covered, "parallel for covers every element once");
+		check(aligned, "parallel for ranges follow the grain size");
+
+		// ワーカーの中から投入したジョブを待つ
+		std::atomic<int> nested(0);
+		JobCounter counter;
+		for (int i = 0; i < 2000; i++)
+		{
+			jobSystem.Run([&]()
+			{
+				JobCounter inner;
+				for (int k = 0; k < 10; k++)
+					jobSystem.Run([&]() { nested++; }, inner);
+				jobSystem.Wait(inner);
+			}, counter);
+		}
+		jobSystem.Wait(counter);
+		check(nested == 20000 && !counter.IsBusy(), "nested jobs complete");
+
+		// 記録に入らない大きな関数オブジェクトも実行される
+		std::vector<int> large(JobSystem::INLINE_JOB_SIZE, 1);
+		int largeSum = 0;
+		char padding[JobSystem::INLINE_JOB_SIZE * 2] = { 3 };
+		jobSystem.Run([&largeSum, large, padding]() { largeSum = int(large.size()) + padding[0]; }, counter);
+		jobSystem.Wait(counter);
+		check(largeSum == int(JobSystem::INLINE_JOB_SIZE) + 3, "heap-stored job runs");
+
+		// ジョブの例外はWaitで投げ直し、カウンタは0になって他のジョブも完了する
+		std::atomic<int> completed(0);
+		for (int i = 0; i < 100; i++)
+		{
+			jobSystem.Run([&completed, i]()
+			{
+				completed++;
+				if (i == 50)
+					throw std::runtime_error("job failed");
+			}, counter);
+		}
+		check(ThrowsMessage([&]() { jobSystem.Wait(counter); }, "job failed"), "wait rethrows a job exception");
+		check(!counter.IsBusy() && completed == 100, "failing job still completes the counter");
+		check(!ThrowsMessage([&]() { jobSystem.Wait(counter); }, "job failed"), "exception is rethrown only once");
+
+		// 記録の中に格納した関数オブジェクトは例外を投げても破棄される
+		std::shared_ptr<int> tracked = std::make_shared<int>(0);
+		jobSystem.Run([tracked]() { throw std::runtime_error("inline"); }, counter);
+		check(ThrowsMessage([&]() { jobSystem.Wait(counter); }, "inline") && tracked.use_count() == 1, "throwing inline job is destroyed");
+
+		// ParallelForの範囲の例外は全範囲が終わってから投げ直す
+		std::atomic<size_t> processed(0);
+		check(ThrowsMessage([&]()
+		{
+			jobSystem.ParallelFor(100000, 100, [&](size_t begin, size_t end)
+			{
+				processed += end - begin;
+				if (begin == 0)
+					throw std::runtime_error("range failed");
+			});
+		}, "range failed") && processed == 100000, "parallel for rethrows after every range ran");
+
+		// タスクグラフは依存順に実行する
+		TaskGraph graph;
+		std::atomic<int> order(0);
+		int a = -1, b = -1, c = -1;
+		TaskGraph::TaskId taskA = graph.AddTask("a", [&]() { a = order++; });
+		TaskGraph::TaskId taskB = graph.AddTask("b", [&]() { b = order++; });
+		TaskGraph::TaskId taskC = graph.AddTask("c", [&]() { c = order++; });
+		graph.AddDependency(taskA, taskB);
+		graph.AddDependency(taskB, taskC);
+		bool ordered = true;
+		for (int repeat = 0; repeat < 200; repeat++)
+		{
+			order = 0;
+			graph.Run(jobSystem);
+			ordered = ordered && a == 0 && b == 1 && c == 2;
+		}
+		order = 0;
+		graph.RunSerial();
+		check(ordered && a == 0 && b == 1 && c == 2, "task graph follows dependencies");
+
+		// タスクの例外はRunで投げ直し、後続は実行しない
+		TaskGraph failing;
+		bool successorRan = false;
+		std::atomic<int> independent(0);
+		TaskGraph::TaskId thrower = failing.AddTask("thrower", []() { throw std::runtime_error("task failed"); });
+		TaskGraph::TaskId successor = failing.AddTask("successor", [&]() { successorRan = true; });
+		failing.AddDependency(thrower, successor);
+		for (int i = 0; i < 8; i++)
+			failing.AddTask("independent", [&]() { independent++; });
+		check(ThrowsMessage([&]() { failing.Run(jobSystem); }, "task failed"), "task graph rethrows a task exception");
+		check(!successorRan && independent == 8, "failed task skips its successors only");
+
+		// 循環は例外になる
+		TaskGraph cycle;
+		TaskGraph::TaskId x = cycle.AddTask("x", []() {});
+		TaskGraph::TaskId y = cycle.AddTask("y", []() {});
+		cycle.AddDependency(x, y);
+		cycle.AddDependency(y, x);
+		check(ThrowsMessage([&]() { cycle.Run(jobSystem); }, "TaskGraph: dependency cycle"), "cycle is rejected");
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
@@ -0,0 +1,203 @@
+﻿// MeshConverterTest.cpp - メッシュの変換結果を参照ダンプと比較する
+//
+// MeshConverterTest 参照ダンプ
+//     すべての命令セットで決まった入力を変換し、結果のダンプが参照ダンプと一致するか確認する
+// MeshConverterTest -write 出力ファイル
+//     変換結果のダンプを書き出す(変換の仕様を変えた時に参照ダンプを作り直す)
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <sstream>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "MeshConverter.h"
+#include "TestCheck.h"
+#include "TransformKernel.h"
+
+namespace
+{
+	// 四角錐と、どの三角形からも参照されないコントロールポイント
+	const double CONTROL_POINTS[] =
+	{
+		-1.0, 0.0, -1.0, 1.0,
+		1.0, 0.0, -1.0, 1.0,
+		1.0, 0.0, 1.0, 1.0,
+		-1.0, 0.0, 1.0, 1.0,
+		0.0, 1.5, 0.0, 1.0,
+		0.25, -0.5, 0.125, 1.0,
+	};
+	// 三角形(底面はマテリアル0、側面はマテリアル1で、マテリアルが交互に現れる順に並べる)
+	const int POLYGON_VERTICES[] = { 0, 1, 4, 0, 2, 1, 1, 2, 4, 0, 3, 2, 2, 3, 4, 3, 0, 4 };
+	const int POLYGON_MATERIALS[] = { 1, 0, 1, 0, 1, 1 };
+	const char* const MATERIAL_NAMES[] = { "stone", "glass" };
+
+	// 変換元のメッシュを作成する(Y軸回りに90度回転し、2倍に拡大して平行移動する)
+	MeshSource MakeSource()
+	{
+		MeshSource source = {};
+		source.name = "pyramid";
+		source.controlPoints = CONTROL_POINTS;
+		source.controlPointCount = 6;
+		source.polygonVertices = POLYGON_VERTICES;
+		source.polygonVertexCount = 18;
+		source.polygonMaterials = POLYGON_MATERIALS;
+		source.materialNames = MATERIAL_NAMES;
+		source.materialCount = 2;
+		const double world[16] =
+		{
+			0.0, 0.0, -2.0, 0.0,
+			0.0, 2.0, 0.0, 0.0,
+			2.0, 0.0, 0.0, 0.0,
+			10.0, -5.0, 3.0, 1.0,
+		};
+		memcpy(source.worldMatrix, world, sizeof(world));
+		return source;
+	}
+
+	// 変換結果をテキストで書き出す(1行に1項目で、先頭の語が項目の種類を表す)
+	void WriteDump(const MeshData& mesh, std::ostream& stream)
+	{
+		stream << std::setprecision(9);
+		stream << "mesh " << mesh.name << "\n";
+		stream << "materials " << mesh.materials.size() << "\n";
+		for (const std::string& material : mesh.materials)
+			stream << "material " << material << "\n";
+		stream << "vertices " << mesh.vertices.size() << "\n";
+		for (const MeshVertex& vertex : mesh.vertices)
+		{
+			stream << "v " << vertex.position[0] << " " << vertex.position[1] << " " << vertex.position[2] << " "
+				<< vertex.color[0] << " " << vertex.color[1] << " " << vertex.color[2] << " " << vertex.color[3] << "\n";
+		}
+		stream << "triangles " << mesh.indices.size() / 3 << "\n";
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+			stream << "t " << mesh.indices[i] << " " << mesh.indices[i + 1] << " " << mesh.indices[i + 2] << "\n";
+		stream << "submeshes " << mesh.subMeshes.size() << "\n";
+		for (const SubMesh& subMesh : mesh.subMeshes)
+			stream << "s " << subMesh.indexStart << " " << subMesh.indexCount << " " << subMesh.materialIndex << "\n";
+		stream << "bounds " << mesh.bounds.minimum[0] << " " << mesh.bounds.minimum[1] << " " << mesh.bounds.minimum[2] << " "
+			<< mesh.bounds.maximum[0] << " " << mesh.bounds.maximum[1] << " " << mesh.bounds.maximum[2] << "\n";
+	}
+
+	// 2つのダンプを語ごとに比較する(数値は相対誤差1e-6まで許す)
+	// 異なる場合は最初に異なる語を表示する
+	bool CompareDumps(const std::string& expected, const std::string& actual)
+	{
+		std::istringstream expectedStream(expected), actualStream(actual);
+		std::string expectedWord, actualWord;
+		for (int word = 0; ; word++)
+		{
+			bool expectedEnd = !(expectedStream >> expectedWord);
+			bool actualEnd = !(actualStream >> actualWord);
+			if (expectedEnd || actualEnd)
+			{
+				if (expectedEnd != actualEnd)
+					std::cout << "dump length differs at word " << word << std::endl;
+				return expectedEnd == actualEnd;
+			}
+			if (expectedWord == actualWord)
+				continue;
+			char* expectedRest = nullptr;
+			char* actualRest = nullptr;
+			double expectedValue = strtod(expectedWord.c_str(), &expectedRest);
+			double actualValue = strtod(actualWord.c_str(), &actualRest);
+			bool numbers = *expectedRest == '\0' && *actualRest == '\0' && expectedRest != expectedWord.c_str() && actualRest != actualWord.c_str();
+			if (!numbers || fabs(expectedValue - actualValue) > 1e-6 * std::max(1.0, fabs(expectedValue)))
+			{
+				std::cout << "word " << word << ": expected " << expectedWord << ", got " << actualWord << std::endl;
+				return false;
+			}
+		}
+	}
+
+	// 変換が例外を投げるかどうか
+	template <class Exception>
+	bool Throws(const MeshSource& source)
+	{
+		MeshData mesh;
+		try { MeshConverter::Convert(source, mesh); } catch (const Exception&) { return true; }
+		return false;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		// 参照ダンプを作り直す
+		if (argc == 3 && strcmp(argv[1], "-write") == 0)
+		{
+			MeshData mesh;
+			MeshConverter::Convert(MakeSource(), mesh);
+			std::ofstream stream(argv[2]);
+			WriteDump(mesh, stream);
+			return stream ? 0 : 1;
+		}
+		if (argc != 2)
+		{
+			std::cerr << "usage: MeshConverterTest reference.txt\n       MeshConverterTest -write output.txt" << std::endl;
+			return 2;
+		}
+		std::ifstream file(argv[1]);
+		if (!file)
+			throw std::runtime_error(std::string("cannot open ") + argv[1]);
+		std::ostringstream reference;
+		reference << file.rdbuf();
+
+		TestCheck check;
+		// どの命令セットでも参照ダンプと同じ結果になる
+		const TransformKernel::InstructionSet sets[] = { TransformKernel::SCALAR, TransformKernel::SSE2, TransformKernel::AVX2 };
+		for (TransformKernel::InstructionSet set : sets)
+		{
+			if (set > TransformKernel::GetSupportedInstructionSet())
+				continue;
+			TransformKernel::SetInstructionSet(set);
+			MeshData mesh;
+			MeshConverter::Convert(MakeSource(), mesh);
+			std::ostringstream dump;
+			WriteDump(mesh, dump);
+			std::string description = std::string("matches reference dump (") + TransformKernel::GetInstructionSetName(set) + ")";
+			check(CompareDumps(reference.str(), dump.str()), description.c_str());
+		}
+		TransformKernel::SetInstructionSet(TransformKernel::GetSupportedInstructionSet());
+
+		// マテリアルが無いメッシュは1つのサブメッシュにまとまる
+		MeshSource source = MakeSource();
+		source.polygonMaterials = nullptr;
+		source.materialNames = nullptr;
+		source.materialCount = 0;
+		MeshData mesh;
+		MeshConverter::Convert(source, mesh);
+		check(mesh.materials.empty() && mesh.subMeshes.size() == 1 && mesh.subMeshes[0].indexCount == 18, "mesh without materials");
+		check(memcmp(mesh.indices.data(), POLYGON_VERTICES, sizeof(POLYGON_VERTICES)) == 0, "triangle order kept without materials");
+
+		// 空のメッシュ
+		source = MakeSource();
+		source.controlPointCount = 0;
+		source.polygonVertexCount = 0;
+		MeshConverter::Convert(source, mesh);
+		check(mesh.vertices.empty() && mesh.indices.empty() && mesh.subMeshes.empty() && mesh.materials.size() == 2, "empty mesh");
+
+		// 不正な入力は例外を投げる
+		source = MakeSource();
+		source.polygonVertexCount = 17;
+		check(Throws<std::runtime_error>(source), "incomplete triangle throws");
+		source = MakeSource();
+		source.controlPointCount = 4;
+		check(Throws<std::out_of_range>(source), "vertex index out of range throws");
+		source = MakeSource();
+		source.materialCount = 1;
+		check(Throws<std::out_of_range>(source), "material index out of range throws");
+
+		return check.Finish();
+	}
+	catch (const std::exception& exception)
+	{
+		std::cout << "error: " << exception.what() << std::endl;
+		return 1;
+	}
+}
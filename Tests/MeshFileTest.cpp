@@ -0,0 +1,309 @@
+﻿// MeshFileTest.cpp - バイナリメッシュファイルの書き出しと読み込みの往復と、壊れたファイルの検出を検証する
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <math.h>
+#include <stdexcept>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "MeshConverter.h"
+#include "MeshFile.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// テストで書き出すファイル
+	const char* const FILENAME = "MeshFileTest.mesh";
+	const char* const CORRUPT_FILENAME = "MeshFileTest.corrupt.mesh";
+
+	// 格子状のメッシュを作成する(三角形を左右で2つのマテリアルに分ける)
+	void MakeGrid(const char* name, uint32_t side, MeshData& mesh)
+	{
+		mesh = MeshData();
+		mesh.name = name;
+		for (uint32_t y = 0; y <= side; y++)
+		{
+			for (uint32_t x = 0; x <= side; x++)
+			{
+				float height = 0.25f * sinf(float(x) * 0.7f) * cosf(float(y) * 0.3f);
+				mesh.vertices.push_back({ { float(x), height, float(y) }, { float(x) / side, float(y) / side, 0.5f, 1.0f } });
+			}
+		}
+		for (uint32_t material = 0; material < 2; material++)
+		{
+			uint32_t start = uint32_t(mesh.indices.size());
+			for (uint32_t y = 0; y < side; y++)
+			{
+				for (uint32_t x = material * side / 2; x < (material + 1) * side / 2; x++)
+				{
+					uint32_t corner = y * (side + 1) + x;
+					uint32_t quad[6] = { corner, corner + side + 1, corner + 1, corner + 1, corner + side + 1, corner + side + 2 };
+					mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+				}
+			}
+			mesh.subMeshes.push_back({ start, uint32_t(mesh.indices.size()) - start, material });
+		}
+		mesh.materials = { "left", "right" };
+		mesh.bounds = MeshConverter::ComputeBounds(mesh.vertices.data(), mesh.vertices.size());
+	}
+
+	// 詳細度として粗い格子を加える
+	void AddLod(MeshData& mesh, uint32_t side, float error)
+	{
+		MeshData coarse;
+		MakeGrid("", side, coarse);
+		mesh.lods.push_back({ error, coarse.vertices, coarse.indices, coarse.subMeshes });
+	}
+
+	// テストに使うメッシュ配列を作成する(詳細度付き、マテリアル無し、空のメッシュを含む)
+	std::vector<MeshData> MakeMeshes()
+	{
+		std::vector<MeshData> meshes(3);
+		MakeGrid("grid", 16, meshes[0]);
+		AddLod(meshes[0], 8, 0.5f);
+		AddLod(meshes[0], 4, 1.25f);
+		MakeGrid("plain", 6, meshes[1]);
+		meshes[1].materials.clear();
+		meshes[1].subMeshes = { { 0, uint32_t(meshes[1].indices.size()), 0 } };
+		meshes[2].name = "empty";
+		meshes[2].bounds = MeshBounds();
+		return meshes;
+	}
+
+	// サブメッシュの配列が等しいか
+	bool SameSubMeshes(const SubMesh* subMeshes, uint32_t count, const std::vector<SubMesh>& expected)
+	{
+		if (count != expected.size())
+			return false;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (subMeshes[i].indexStart != expected[i].indexStart || subMeshes[i].indexCount != expected[i].indexCount ||
+				subMeshes[i].materialIndex != expected[i].materialIndex)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// インデックスの配列が等しいか
+	bool SameIndices(const uint32_t* indices, uint32_t count, const std::vector<uint32_t>& expected)
+	{
+		return count == expected.size() && (count == 0 || memcmp(indices, expected.data(), count * sizeof(uint32_t)) == 0);
+	}
+
+	// 量子化した頂点を復号し、元の頂点との位置の差の最大値を求める
+	float MaximumQuantizationError(const QuantizedVertex* vertices, const std::vector<MeshVertex>& expected, const MeshBounds& bounds)
+	{
+		std::vector<MeshVertex> decoded(expected.size());
+		VertexQuantizer::Dequantize(decoded.data(), vertices, decoded.size(), bounds);
+		float maximum = 0.0f;
+		for (size_t i = 0; i < decoded.size(); i++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+				maximum = std::max(maximum, fabsf(decoded[i].position[axis] - expected[i].position[axis]));
+		}
+		return maximum;
+	}
+
+	// ファイルの内容を読み込む
+	std::vector<uint8_t> ReadFile(const char* filename)
+	{
+		std::ifstream stream(filename, std::ios::binary);
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	}
+
+	// 書き出したファイルの一部を壊し、開く(validateならさらにValidateを呼ぶ)と例外を投げるか確認する
+	bool RejectsCorruption(const std::function<void(std::vector<uint8_t>& image)>& corrupt, bool validate = false)
+	{
+		std::vector<uint8_t> image = ReadFile(FILENAME);
+		corrupt(image);
+		{
+			std::ofstream stream(CORRUPT_FILENAME, std::ios::binary | std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(image.data()), std::streamsize(image.size()));
+		}
+		try
+		{
+			MeshFile file(CORRUPT_FILENAME);
+			if (validate)
+				file.Validate();
+		}
+		catch (const std::runtime_error&)
+		{
+			return true;
+		}
+		return false;
+	}
+
+	// イメージ内のヘッダとメッシュレコードを取得する
+	MeshFileHeader& HeaderOf(std::vector<uint8_t>& image)
+	{
+		return *reinterpret_cast<MeshFileHeader*>(image.data());
+	}
+	MeshFileMesh& MeshOf(std::vector<uint8_t>& image, uint32_t index)
+	{
+		return reinterpret_cast<MeshFileMesh*>(image.data() + HeaderOf(image).meshTableOffset)[index];
+	}
+	MeshFileLod& LodOf(std::vector<uint8_t>& image, uint32_t index, uint32_t level)
+	{
+		return reinterpret_cast<MeshFileLod*>(image.data() + MeshOf(image, index).lodOffset)[level];
+	}
+	SubMesh& SubMeshOf(std::vector<uint8_t>& image, uint64_t offset, uint32_t index)
+	{
+		return reinterpret_cast<SubMesh*>(image.data() + offset)[index];
+	}
+	uint32_t& IndexOf(std::vector<uint8_t>& image, uint64_t offset, uint32_t index)
+	{
+		return reinterpret_cast<uint32_t*>(image.data() + offset)[index];
+	}
+}
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		std::vector<MeshData> meshes = MakeMeshes();
+
+		// 浮動小数点数の形式で書き出して読み込むと同じ内容になる
+		MeshFile::Write(FILENAME, meshes);
+		{
+			MeshFile file(FILENAME);
+			file.Validate();
+			check(file.GetMeshCount() == 3, "mesh count");
+			for (uint32_t i = 0; i < file.GetMeshCount(); i++)
+			{
+				const MeshData& expected = meshes[i];
+				MeshView mesh = file.GetMesh(i);
+				check(strcmp(mesh.name, expected.name.c_str()) == 0, "mesh name");
+				check(mesh.vertexFormat == MeshFile::VERTEX_FORMAT_FLOAT && mesh.quantizedVertices == nullptr, "float vertex format");
+				check(mesh.vertexCount == expected.vertices.size() &&
+					(mesh.vertexCount == 0 || memcmp(mesh.vertices, expected.vertices.data(), mesh.vertexCount * sizeof(MeshVertex)) == 0), "vertices");
+				check(SameIndices(mesh.indices, mesh.indexCount, expected.indices), "indices");
+				check(SameSubMeshes(mesh.subMeshes, mesh.subMeshCount, expected.subMeshes), "submeshes");
+				check(memcmp(&mesh.bounds, &expected.bounds, sizeof(MeshBounds)) == 0, "bounds");
+				check(mesh.materialCount == expected.materials.size(), "material count");
+				for (uint32_t material = 0; material < mesh.materialCount; material++)
+					check(expected.materials[material] == file.GetMaterialName(mesh, material), "material name");
+				check(strcmp(file.GetMaterialName(mesh, mesh.materialCount), "") == 0, "material out of range has no name");
+				check(mesh.lodCount == expected.lods.size(), "lod count");
+				for (uint32_t level = 0; level < mesh.lodCount; level++)
+				{
+					MeshLodView lod = file.GetLod(mesh, level);
+					const MeshLod& expectedLod = expected.lods[level];
+					check(lod.error == expectedLod.error && lod.vertexCount == expectedLod.vertices.size() &&
+						memcmp(lod.vertices, expectedLod.vertices.data(), lod.vertexCount * sizeof(MeshVertex)) == 0, "lod vertices");
+					check(SameIndices(lod.indices, lod.indexCount, expectedLod.indices), "lod indices");
+					check(SameSubMeshes(lod.subMeshes, lod.subMeshCount, expectedLod.subMeshes), "lod submeshes");
+				}
+			}
+			// データはファイル内に揃えて配置される
+			MeshView mesh = file.GetMesh(0);
+			check(reinterpret_cast<uintptr_t>(mesh.vertices) % MeshFile::ALIGNMENT == 0 &&
+				reinterpret_cast<uintptr_t>(mesh.indices) % MeshFile::ALIGNMENT == 0, "sections are aligned");
+			bool thrown = false;
+			try { file.GetMesh(3); } catch (const std::out_of_range&) { thrown = true; }
+			check(thrown, "mesh index out of range throws");
+			thrown = false;
+			try { file.GetLod(mesh, 2); } catch (const std::out_of_range&) { thrown = true; }
+			check(thrown, "lod index out of range throws");
+		}
+
+		// 量子化した形式では位置は量子化の誤差の範囲で元に戻り、インデックスとサブメッシュはそのまま残る
+		MeshFile::Write(FILENAME, meshes, MeshFile::VERTEX_FORMAT_QUANTIZED);
+		{
+			MeshFile file(FILENAME);
+			file.Validate();
+			MeshView mesh = file.GetMesh(0);
+			const MeshData& expected = meshes[0];
+			float step = (expected.bounds.maximum[0] - expected.bounds.minimum[0]) / float(VertexQuantizer::POSITION_STEPS);
+			check(mesh.vertexFormat == MeshFile::VERTEX_FORMAT_QUANTIZED && mesh.vertices == nullptr && mesh.quantizedVertices != nullptr, "quantized vertex format");
+			check(mesh.vertexCount == expected.vertices.size() && MaximumQuantizationError(mesh.quantizedVertices, expected.vertices, mesh.bounds) <= step, "quantized vertices");
+			check(SameIndices(mesh.indices, mesh.indexCount, expected.indices) && SameSubMeshes(mesh.subMeshes, mesh.subMeshCount, expected.subMeshes), "quantized indices and submeshes");
+			MeshLodView lod = file.GetLod(mesh, 1);
+			check(lod.vertices == nullptr && MaximumQuantizationError(lod.quantizedVertices, expected.lods[1].vertices, mesh.bounds) <= step, "quantized lod uses mesh bounds");
+		}
+
+		// 範囲外のインデックスを持つメッシュは書き出す前に例外を投げる
+		{
+			std::vector<MeshData> invalid = meshes;
+			invalid[0].indices.back() = uint32_t(invalid[0].vertices.size());
+			bool thrown = false;
+			try { MeshFile::Write(CORRUPT_FILENAME, invalid); } catch (const std::invalid_argument&) { thrown = true; }
+			check(thrown, "writing an index past the vertex count throws");
+			invalid = meshes;
+			invalid[0].lods[1].indices[0] = uint32_t(invalid[0].lods[1].vertices.size());
+			thrown = false;
+			try { MeshFile::Write(CORRUPT_FILENAME, invalid); } catch (const std::invalid_argument&) { thrown = true; }
+			check(thrown, "writing a lod index past the lod vertex count throws");
+		}
+
+		// 壊れたファイルや切り詰められたファイルは開く時に例外を投げる
+		MeshFile::Write(FILENAME, meshes);
+		check(!RejectsCorruption([](std::vector<uint8_t>&) {}, true), "unchanged copy opens and validates");
+		check(RejectsCorruption([](std::vector<uint8_t>& image) { HeaderOf(image).magic = 0; }), "bad magic");
+		check(RejectsCorruption([](std::vector<uint8_t>& image) { HeaderOf(image).version = MeshFile::VERSION - 1; }), "old version");
+		check(RejectsCorruption([](std::vector<uint8_t>& image) { image.resize(image.size() - 16); }), "truncated file");
+		check(RejectsCorruption([](std::vector<uint8_t>& image)
+		{
+			image.resize(size_t(MeshOf(image, 0).indexOffset));
+			HeaderOf(image).fileSize = image.size();
+		}), "file truncated inside the mesh data");
+		check(RejectsCorruption([](std::vector<uint8_t>& image) { image[size_t(HeaderOf(image).fileSize) - 1] = 'x'; }), "unterminated string table");
+		check(RejectsCorruption([](std::vector<uint8_t>& image) { MeshOf(image, 0).vertexOffset += 4; }), "misaligned section");
+		check(RejectsCorruption([](std::vector<uint8_t>& image) { MeshOf(image, 1).vertexFormat = 7; }), "unknown vertex format");
+		check(RejectsCorruption([](std::vector<uint8_t>& image)
+		{
+			SubMeshOf(image, MeshOf(image, 0).subMeshOffset, 1).indexCount += 3;
+		}), "submesh range past the index buffer");
+		check(RejectsCorruption([](std::vector<uint8_t>& image)
+		{
+			SubMeshOf(image, MeshOf(image, 0).subMeshOffset, 1).indexStart = 0xFFFFFFFF;
+		}), "submesh start overflow");
+		check(RejectsCorruption([](std::vector<uint8_t>& image)
+		{
+			SubMeshOf(image, MeshOf(image, 0).subMeshOffset, 0).materialIndex = 2;
+		}), "submesh material out of range");
+		check(RejectsCorruption([](std::vector<uint8_t>& image)
+		{
+			SubMeshOf(image, MeshOf(image, 1).subMeshOffset, 0).materialIndex = 1;
+		}), "submesh material of a mesh without materials");
+		check(RejectsCorruption([](std::vector<uint8_t>& image) { MeshOf(image, 0).indexCount -= 1; }), "incomplete triangle");
+
+		// インデックスの値は開く時には読まず、Validateで検出する
+		auto indexPastVertexCount = [](std::vector<uint8_t>& image)
+		{
+			MeshFileMesh& mesh = MeshOf(image, 0);
+			IndexOf(image, mesh.indexOffset, mesh.indexCount - 1) = mesh.vertexCount;
+		};
+		check(!RejectsCorruption(indexPastVertexCount), "opening does not read the indices");
+		check(RejectsCorruption(indexPastVertexCount, true), "index past the vertex count");
+		auto lodIndexPastVertexCount = [](std::vector<uint8_t>& image)
+		{
+			MeshFileLod& lod = LodOf(image, 0, 1);
+			IndexOf(image, lod.indexOffset, 0) = lod.vertexCount;
+		};
+		check(!RejectsCorruption(lodIndexPastVertexCount), "opening does not read the lod indices");
+		check(RejectsCorruption(lodIndexPastVertexCount, true), "lod index past the lod vertex count");
+		check(RejectsCorruption([](std::vector<uint8_t>& image)
+		{
+			SubMeshOf(image, LodOf(image, 0, 0).subMeshOffset, 1).indexCount += 3;
+		}), "lod submesh range past the lod index buffer");
+
+		bool thrown = false;
+		try { MeshFile file("MeshFileTest.missing.mesh"); } catch (const std::runtime_error&) { thrown = true; }
+		check(thrown, "missing file throws");
+	}
+	catch (const std::exception& exception)
+	{
+		std::cout << "error: " << exception.what() << std::endl;
+		check(false, "unexpected exception");
+	}
+	remove(FILENAME);
+	remove(CORRUPT_FILENAME);
+	return check.Finish();
+}
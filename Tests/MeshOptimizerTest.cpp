@@ -0,0 +1,151 @@
+﻿// MeshOptimizerTest.cpp - キャッシュの統計と、最適化の各パスが三角形を保ったままキャッシュ効率を上げることを検証する
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <math.h>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "MeshConverter.h"
+#include "MeshOptimizer.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// 三角形を頂点の位置で表したもの(回転して最小の頂点を先頭にするので、向きは保たれる)
+	typedef std::array<std::array<float, 3>, 3> TrianglePositions;
+
+	// 格子状のメッシュを作成し、三角形の順序をサブメッシュの中でシャッフルする
+	// 頂点は格子の右上を除いて並べ、どの三角形からも参照されない頂点を1つ加える
+	void MakeShuffledGrid(uint32_t side, uint32_t seed, MeshData& mesh)
+	{
+		mesh = MeshData();
+		mesh.name = "grid";
+		for (uint32_t y = 0; y <= side; y++)
+		{
+			for (uint32_t x = 0; x <= side; x++)
+				mesh.vertices.push_back({ { float(x), 0.1f * float((x * 7 + y * 3) % 5), float(y) }, { 1.0f, 1.0f, 1.0f, 1.0f } });
+		}
+		mesh.vertices.push_back({ { -1.0f, -1.0f, -1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } });
+		std::mt19937 random(seed);
+		for (uint32_t material = 0; material < 2; material++)
+		{
+			std::vector<std::array<uint32_t, 3>> triangles;
+			for (uint32_t y = material * side / 2; y < (material + 1) * side / 2; y++)
+			{
+				for (uint32_t x = 0; x < side; x++)
+				{
+					uint32_t corner = y * (side + 1) + x;
+					triangles.push_back({ { corner, corner + side + 1, corner + 1 } });
+					triangles.push_back({ { corner + 1, corner + side + 1, corner + side + 2 } });
+				}
+			}
+			std::shuffle(triangles.begin(), triangles.end(), random);
+			uint32_t start = uint32_t(mesh.indices.size());
+			for (const std::array<uint32_t, 3>& triangle : triangles)
+				mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+			mesh.subMeshes.push_back({ start, uint32_t(mesh.indices.size()) - start, material });
+		}
+		mesh.materials = { "upper", "lower" };
+		mesh.bounds = MeshConverter::ComputeBounds(mesh.vertices.data(), mesh.vertices.size());
+	}
+
+	// サブメッシュの三角形を位置で表し、順序によらず比較できるように並べる
+	std::vector<TrianglePositions> SortedTriangles(const MeshData& mesh, const SubMesh& subMesh)
+	{
+		std::vector<TrianglePositions> triangles;
+		for (uint32_t i = subMesh.indexStart; i < subMesh.indexStart + subMesh.indexCount; i += 3)
+		{
+			TrianglePositions triangle;
+			for (int n = 0; n < 3; n++)
+			{
+				const float* position = mesh.vertices[mesh.indices[i + n]].position;
+				triangle[n] = { { position[0], position[1], position[2] } };
+			}
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	bool Near(float a, float b)
+	{
+		return fabsf(a - b) < 1e-4f;
+	}
+}
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		// 既知の統計(2つの三角形が辺を共有する場合、4頂点を1回ずつ変換し、2つの64バイトのラインを読む)
+		const uint32_t quad[] = { 0, 1, 2, 2, 1, 3 };
+		MeshCacheStatistics statistics = MeshOptimizer::Analyze(quad, 6, 4);
+		check(Near(statistics.acmr, 2.0f) && Near(statistics.atvr, 1.0f), "acmr and atvr of a quad");
+		check(Near(statistics.overfetch, 128.0f / 112.0f), "overfetch of a quad");
+		// FIFOキャッシュからあふれた頂点は再び変換される
+		const uint32_t fan[] = { 0, 1, 2, 3, 4, 0 };
+		check(Near(MeshOptimizer::Analyze(fan, 6, 5, 3).acmr, 3.0f), "vertex evicted from a 3-entry cache misses again");
+		check(Near(MeshOptimizer::Analyze(fan, 6, 5, 16).acmr, 2.5f), "vertex kept by a 16-entry cache hits");
+		check(MeshOptimizer::Analyze(nullptr, 0, 0).acmr == 0.0f, "empty mesh statistics");
+
+		// シャッフルした格子はすべてのパスを通しても同じ三角形(向きも含む)をサブメッシュごとに保つ
+		MeshData original;
+		MakeShuffledGrid(64, 1, original);
+		MeshData mesh = original;
+		MeshOptimizerReport report = MeshOptimizer::Optimize(mesh);
+		check(mesh.subMeshes.size() == 2 && mesh.subMeshes[0].indexCount == original.subMeshes[0].indexCount &&
+			mesh.subMeshes[1].indexStart == original.subMeshes[1].indexStart, "submesh ranges are kept");
+		check(SortedTriangles(mesh, mesh.subMeshes[0]) == SortedTriangles(original, original.subMeshes[0]) &&
+			SortedTriangles(mesh, mesh.subMeshes[1]) == SortedTriangles(original, original.subMeshes[1]), "triangles and winding are kept per submesh");
+
+		// 各パスの統計
+		check(report.original.acmr > 2.0f, "shuffled grid has a poor cache hit rate");
+		check(report.vertexCache.acmr < 0.8f, "vertex cache pass approaches the grid optimum");
+		// 分割したクラスタの最後の断片は許容範囲を超えることがあるので、閾値より少し余裕を持たせる
+		check(report.overdraw.acmr <= report.vertexCache.acmr * (MeshOptimizer::OVERDRAW_THRESHOLD + 0.05f), "overdraw pass keeps most of the cache gain");
+		check(Near(report.vertexFetch.acmr, report.overdraw.acmr), "vertex fetch pass keeps the cache hit rate");
+		check(report.vertexFetch.overfetch < report.original.overfetch * 0.25f, "vertex fetch pass reduces overfetch");
+
+		// 頂点は最初に参照される順に並び、参照されない頂点は取り除かれる
+		check(mesh.vertices.size() == original.vertices.size() - 1, "unreferenced vertex is removed");
+		uint32_t next = 0;
+		bool firstUse = true;
+		for (uint32_t index : mesh.indices)
+		{
+			if (index == next)
+				next++;
+			else if (index > next)
+				firstUse = false;
+		}
+		check(firstUse && next == mesh.vertices.size(), "vertices are in first-use order");
+		check(mesh.bounds.minimum[0] == 0.0f && mesh.bounds.minimum[1] >= 0.0f, "bounds exclude the removed vertex");
+
+		// 同じ入力からは同じ結果になる
+		MeshData again = original;
+		MeshOptimizer::Optimize(again);
+		check(again.indices == mesh.indices, "optimization is deterministic");
+
+		// サブメッシュの無いメッシュは全体を1つの範囲として並べ替える
+		MeshData single = original;
+		single.subMeshes.clear();
+		MeshOptimizer::Optimize(single);
+		SubMesh all = { 0, uint32_t(original.indices.size()), 0 };
+		check(SortedTriangles(single, all) == SortedTriangles(original, all), "mesh without submeshes keeps its triangles");
+
+		// 三角形でないインデックス数は例外を投げる
+		bool thrown = false;
+		uint32_t destination[6];
+		try { MeshOptimizer::OptimizeVertexCache(destination, quad, 5, 4); } catch (const std::invalid_argument&) { thrown = true; }
+		check(thrown, "incomplete triangle throws");
+	}
+	catch (const std::exception& exception)
+	{
+		std::cout << "error: " << exception.what() << std::endl;
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
@@ -0,0 +1,233 @@
+﻿// MeshSimplifierTest.cpp - 詳細度の生成と選択を検証する(三角形の数の目標、誤差の単調性と実際のずれ、メッシュファイルへの保存、並列生成、距離による選択)
+
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+#include <stdexcept>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "JobSystem.h"
+#include "MeshFile.h"
+#include "MeshLodSelector.h"
+#include "MeshSimplifier.h"
+#include "TestCheck.h"
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		// 格子状の平面(一辺の四角形の数がsize)を作成する
+		auto createPlane = [](uint32_t size)
+		{
+			MeshData mesh;
+			for (uint32_t y = 0; y <= size; y++)
+			{
+				for (uint32_t x = 0; x <= size; x++)
+					mesh.vertices.push_back({ { float(x) / float(size), 0.0f, float(y) / float(size) }, { 1.0f, 1.0f, 1.0f, 1.0f } });
+			}
+			for (uint32_t y = 0; y < size; y++)
+			{
+				for (uint32_t x = 0; x < size; x++)
+				{
+					uint32_t corner = y * (size + 1) + x, next = corner + size + 1;
+					mesh.indices.insert(mesh.indices.end(), { corner, next, corner + 1, corner + 1, next, next + 1 });
+				}
+			}
+			mesh.subMeshes.push_back({ 0, uint32_t(mesh.indices.size()), 0 });
+			mesh.bounds = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 1.0f } };
+			return mesh;
+		};
+		// 半径1の球を作成する(上半分をマテリアル0、下半分をマテリアル1にし、継ぎ目の頂点は重複させる)
+		auto createSphere = [](uint32_t rings, uint32_t segments)
+		{
+			MeshData mesh;
+			for (uint32_t ring = 0; ring <= rings; ring++)
+			{
+				float theta = 3.14159265f * float(ring) / float(rings);
+				for (uint32_t segment = 0; segment <= segments; segment++)
+				{
+					float phi = 6.28318531f * float(segment % segments) / float(segments);
+					// 極は1点に重なるように正確に置く
+					float radius = ring == 0 || ring == rings ? 0.0f : sinf(theta);
+					float y = ring == 0 ? 1.0f : ring == rings ? -1.0f : cosf(theta);
+					mesh.vertices.push_back({ { radius * cosf(phi), y, radius * sinf(phi) }, { 1.0f, 1.0f, 1.0f, 1.0f } });
+				}
+			}
+			for (uint32_t material = 0; material < 2; material++)
+			{
+				uint32_t start = uint32_t(mesh.indices.size());
+				for (uint32_t ring = material * rings / 2; ring < (material + 1) * rings / 2; ring++)
+				{
+					for (uint32_t segment = 0; segment < segments; segment++)
+					{
+						uint32_t corner = ring * (segments + 1) + segment, next = corner + segments + 1;
+						if (ring != 0)
+							mesh.indices.insert(mesh.indices.end(), { corner, corner + 1, next });
+						if (ring != rings - 1)
+							mesh.indices.insert(mesh.indices.end(), { corner + 1, next + 1, next });
+					}
+				}
+				mesh.subMeshes.push_back({ start, uint32_t(mesh.indices.size()) - start, material });
+			}
+			mesh.materials = { "upper", "lower" };
+			mesh.bounds = { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } };
+			return mesh;
+		};
+
+		// 平面はどこまで縮約しても形が変わらないので、誤差0のまま大きく減らせる
+		MeshData plane = createPlane(32);
+		std::vector<uint32_t> simplified;
+		float planeError = MeshSimplifier::Simplify(simplified, plane.indices.data(), plane.indices.size(),
+			plane.vertices.data(), plane.vertices.size(), 2, 1.0e-3f);
+		float planeArea = 0.0f;
+		for (size_t i = 0; i + 2 < simplified.size(); i += 3)
+		{
+			const float* a = plane.vertices[simplified[i]].position;
+			const float* b = plane.vertices[simplified[i + 1]].position;
+			const float* c = plane.vertices[simplified[i + 2]].position;
+			planeArea += 0.5f * fabsf((b[0] - a[0]) * (c[2] - a[2]) - (b[2] - a[2]) * (c[0] - a[0]));
+		}
+		check(planeError < 1.0e-5f, "flat plane simplifies without error");
+		check(simplified.size() / 3 <= plane.indices.size() / 3 / 50, "flat plane loses almost all triangles");
+		check(fabsf(planeArea - 1.0f) < 1.0e-4f, "flat plane keeps its boundary");
+
+		// 球の詳細度は三角形の数の目標を守り、誤差は単調に増えて上限を超えない
+		const uint32_t LEVEL_COUNT = 4;
+		const float REDUCTION = 0.5f, MAX_ERROR = 0.02f;
+		const float ERROR_LIMIT = MAX_ERROR * 2.0f * sqrtf(3.0f);
+		MeshData sphere = createSphere(32, 64);
+		auto sphereDeviation = [](const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices)
+		{
+			float deviation = 0.0f;
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				float centroid[3];
+				for (int axis = 0; axis < 3; axis++)
+				{
+					centroid[axis] = (vertices[indices[i]].position[axis] + vertices[indices[i + 1]].position[axis] +
+						vertices[indices[i + 2]].position[axis]) / 3.0f;
+				}
+				deviation = std::max(deviation, 1.0f - sqrtf(centroid[0] * centroid[0] + centroid[1] * centroid[1] + centroid[2] * centroid[2]));
+			}
+			return deviation;
+		};
+		float originalDeviation = sphereDeviation(sphere.vertices, sphere.indices);
+		MeshSimplifier::GenerateLods(sphere, LEVEL_COUNT, REDUCTION, MAX_ERROR);
+		check(sphere.lods.size() >= 3, "sphere produces at least three levels");
+		size_t budget = sphere.indices.size() / 3;
+		float previousError = 0.0f;
+		bool budgets = true, monotonic = true, bounded = true, valid = true, materials = true, deviation = true;
+		float maxDeviation = 0.0f;
+		for (const MeshLod& lod : sphere.lods)
+		{
+			budget = size_t(float(budget) * REDUCTION);
+			budgets = budgets && lod.indices.size() / 3 <= budget;
+			monotonic = monotonic && lod.error >= previousError;
+			bounded = bounded && lod.error <= ERROR_LIMIT;
+			previousError = lod.error;
+			for (uint32_t index : lod.indices)
+				valid = valid && index < lod.vertices.size();
+
+			// マテリアルごとのサブメッシュがインデックスを隙間なく覆う
+			uint32_t covered = 0;
+			materials = materials && lod.subMeshes.size() == 2;
+			for (size_t i = 0; i < lod.subMeshes.size(); i++)
+			{
+				materials = materials && lod.subMeshes[i].materialIndex == i && lod.subMeshes[i].indexStart == covered;
+				covered += lod.subMeshes[i].indexCount;
+			}
+			materials = materials && covered == lod.indices.size();
+
+			// 三角形の重心の球面からのずれを実際の形状の誤差として測る(元のメッシュ自体のずれは差し引く)
+			float levelDeviation = sphereDeviation(lod.vertices, lod.indices);
+			deviation = deviation && levelDeviation <= lod.error + originalDeviation;
+			maxDeviation = std::max(maxDeviation, levelDeviation);
+		}
+		check(budgets, "every level meets its triangle budget");
+		check(monotonic, "level errors increase monotonically");
+		check(bounded, "level errors stay within the error limit");
+		check(valid, "level indices reference level vertices");
+		check(materials, "levels keep one sub mesh per material");
+		check(deviation, "level errors cover the measured deviation");
+		std::cout << "sphere " << sphere.indices.size() / 3 << " triangles, levels";
+		for (const MeshLod& lod : sphere.lods)
+			std::cout << " " << lod.indices.size() / 3 << " (error " << lod.error << ")";
+		std::cout << ", max deviation " << maxDeviation << std::endl;
+
+		// 誤差の上限までに目標に届かない詳細度は作らない
+		MeshData strict = createSphere(16, 32);
+		MeshSimplifier::GenerateLods(strict, LEVEL_COUNT, REDUCTION, 1.0e-6f);
+		check(strict.lods.empty(), "levels over the error limit are not generated");
+
+		// 並列に生成しても逐次生成と同じ結果になる
+		std::vector<MeshData> serial, parallel;
+		for (uint32_t i = 0; i < 6; i++)
+			serial.push_back(createSphere(8 + i * 4, 16 + i * 8));
+		parallel = serial;
+		MeshSimplifier::GenerateLods(serial, LEVEL_COUNT, nullptr);
+		{
+			JobSystem jobSystem(3);
+			MeshSimplifier::GenerateLods(parallel, LEVEL_COUNT, &jobSystem);
+		}
+		bool same = true;
+		for (size_t i = 0; i < serial.size(); i++)
+		{
+			same = same && serial[i].lods.size() == parallel[i].lods.size();
+			for (size_t level = 0; same && level < serial[i].lods.size(); level++)
+			{
+				same = serial[i].lods[level].error == parallel[i].lods[level].error &&
+					serial[i].lods[level].indices == parallel[i].lods[level].indices;
+			}
+		}
+		check(same, "parallel generation matches serial generation");
+
+		// 詳細度はメッシュファイルに書き出して読み戻せる
+		const char* LOD_TEST_FILE = "MeshSimplifierTest.mesh";
+		sphere.name = "sphere";
+		MeshFile::Write(LOD_TEST_FILE, std::vector<MeshData>(1, sphere));
+		{
+			MeshFile file(LOD_TEST_FILE);
+			MeshView view = file.GetMesh(0);
+			bool stored = view.lodCount == sphere.lods.size();
+			for (uint32_t level = 0; stored && level < view.lodCount; level++)
+			{
+				MeshLodView lod = file.GetLod(view, level);
+				const MeshLod& source = sphere.lods[level];
+				stored = lod.error == source.error && lod.vertexCount == source.vertices.size() && lod.indexCount == source.indices.size() &&
+					lod.subMeshCount == source.subMeshes.size() &&
+					memcmp(lod.vertices, source.vertices.data(), source.vertices.size() * sizeof(MeshVertex)) == 0 &&
+					memcmp(lod.indices, source.indices.data(), source.indices.size() * sizeof(uint32_t)) == 0;
+			}
+			check(stored, "levels round trip through the mesh file");
+			bool thrown = false;
+			try { file.GetLod(view, view.lodCount); } catch (const std::out_of_range&) { thrown = true; }
+			check(thrown, "level out of range throws");
+		}
+		remove(LOD_TEST_FILE);
+
+		// 画面上の誤差で詳細度を選び、粗くするときだけしきい値を下げる
+		// (視野角90度、高さ200ピクセルでは距離1で誤差1が100ピクセルになる)
+		MeshLodSelector selector;
+		selector.SetProjection(1.5707963f, 200.0f);
+		const float errors[3] = { 0.01f, 0.04f, 0.16f };
+		check(selector.Select(errors, 3, 0.5f, 0) == 0, "near meshes use the original level");
+		check(selector.Select(errors, 3, 2.0f, 0) == 1, "coarser level within the threshold");
+		check(selector.Select(errors, 3, 100.0f, 0) == 3, "far meshes use the coarsest level");
+		check(selector.Select(errors, 3, 1.2f, 0) == 0 && selector.Select(errors, 3, 1.2f, 1) == 1, "hysteresis keeps the current level");
+		check(selector.Select(errors, 3, 0.9f, 1) == 0, "levels over the threshold refine immediately");
+		check(selector.Select(errors, 3, 10.0f, 3) == 2, "refining stops at the first level within the threshold");
+		check(selector.Select(errors, 3, 0.0f, 3) == 0, "zero distance uses the original level");
+		check(selector.Select(errors, 0, 100.0f, 0) == 0, "meshes without levels stay at the original level");
+		const MeshBounds box = { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } };
+		const float inside[3] = { 0.5f, 0.0f, 0.0f }, outside[3] = { 3.0f, 0.0f, 0.0f };
+		check(MeshLodSelector::Distance(box, inside) == 0.0f && MeshLodSelector::Distance(box, outside) == 2.0f, "distance to bounds");
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
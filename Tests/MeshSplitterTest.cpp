@@ -0,0 +1,137 @@
+﻿// MeshSplitterTest.cpp - 65,535頂点を超えるメッシュを16ビットインデックスのチャンクに分割できるか検証する
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string.h>
+#include <vector>
+#include "MeshSplitter.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// 格子状のメッシュを作成する(頂点の位置に頂点番号を書き込み、分割後の頂点の対応を確認できるようにする)
+	void MakeGrid(uint32_t side, std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		vertices.clear();
+		indices.clear();
+		for (uint32_t y = 0; y <= side; y++)
+		{
+			for (uint32_t x = 0; x <= side; x++)
+			{
+				float number = float(vertices.size());
+				vertices.push_back({ { float(x), number, float(y) }, { 1.0f, 1.0f, 1.0f, 1.0f } });
+			}
+		}
+		for (uint32_t y = 0; y < side; y++)
+		{
+			for (uint32_t x = 0; x < side; x++)
+			{
+				uint32_t corner = y * (side + 1) + x;
+				uint32_t quad[6] = { corner, corner + side + 1, corner + 1, corner + 1, corner + side + 1, corner + side + 2 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+	}
+
+	// チャンクの制限と、チャンクを順に復元すると元の三角形列になることを確認する
+	bool Reassembles(const std::vector<MeshChunk>& chunks, const std::vector<MeshVertex>* vertices, const std::vector<uint32_t>& indices,
+		uint32_t maxVertices, uint32_t maxIndices)
+	{
+		size_t position = 0;
+		for (const MeshChunk& chunk : chunks)
+		{
+			if (chunk.sourceVertices.empty() || chunk.sourceVertices.size() > maxVertices || chunk.indices.size() > maxIndices || chunk.indices.size() % 3 != 0)
+				return false;
+			if (vertices ? chunk.vertices.size() != chunk.sourceVertices.size() : !chunk.vertices.empty())
+				return false;
+			for (size_t i = 0; vertices && i < chunk.vertices.size(); i++)
+			{
+				if (memcmp(&chunk.vertices[i], &(*vertices)[chunk.sourceVertices[i]], sizeof(MeshVertex)) != 0)
+					return false;
+			}
+			for (uint16_t index : chunk.indices)
+			{
+				if (index >= chunk.sourceVertices.size() || position >= indices.size() || chunk.sourceVertices[index] != indices[position++])
+					return false;
+			}
+		}
+		return position == indices.size();
+	}
+}
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		// 16万頂点の格子は複数のチャンクに分かれ、元の三角形の順序で復元できる
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		MakeGrid(400, vertices, indices);
+		check(vertices.size() == 160801, "grid has 160k vertices");
+		std::vector<MeshChunk> chunks = MeshSplitter::Split(vertices.data(), uint32_t(vertices.size()), indices.data(), uint32_t(indices.size()));
+		check(chunks.size() >= 3, "large mesh is split into at least three chunks");
+		check(chunks.size() <= 4, "chunks are filled before a new one starts");
+		check(Reassembles(chunks, &vertices, indices, MeshSplitter::MAX_CHUNK_VERTICES, UINT32_MAX), "chunks reassemble the large mesh");
+		bool strip = false;
+		for (const MeshChunk& chunk : chunks)
+			strip = strip || std::find(chunk.indices.begin(), chunk.indices.end(), uint16_t(0xFFFF)) != chunk.indices.end();
+		check(!strip, "strip cut index is never used");
+
+		// 頂点を渡さない場合は元の頂点番号だけを記録する
+		chunks = MeshSplitter::Split(nullptr, uint32_t(vertices.size()), indices.data(), uint32_t(indices.size()));
+		check(Reassembles(chunks, nullptr, indices, MeshSplitter::MAX_CHUNK_VERTICES, UINT32_MAX), "split without vertices");
+
+		// 三角形の頂点が遠く離れて並ぶメッシュ(頂点を逆順と交互に参照する)
+		std::vector<uint32_t> scattered;
+		uint32_t count = uint32_t(vertices.size());
+		for (uint32_t i = 0; i + 2 < count; i += 3)
+		{
+			uint32_t triangle[3] = { i, count - 1 - i, (i * 7919u) % count };
+			scattered.insert(scattered.end(), triangle, triangle + 3);
+		}
+		chunks = MeshSplitter::Split(vertices.data(), count, scattered.data(), uint32_t(scattered.size()));
+		check(Reassembles(chunks, &vertices, scattered, MeshSplitter::MAX_CHUNK_VERTICES, UINT32_MAX), "scattered references reassemble");
+
+		// 頂点数とインデックス数の上限を小さくした場合
+		chunks = MeshSplitter::Split(vertices.data(), count, indices.data(), uint32_t(indices.size()), 1000, 3000);
+		check(chunks.size() >= indices.size() / 3000 && Reassembles(chunks, &vertices, indices, 1000, 3000), "smaller limits");
+
+		// ちょうど65,535頂点を参照するメッシュは1つのチャンクに収まり、65,536頂点では2つになる
+		std::vector<uint32_t> exact;
+		for (uint32_t i = 0; i < 65535; i += 3)
+		{
+			uint32_t triangle[3] = { i, i + 1, i + 2 };
+			exact.insert(exact.end(), triangle, triangle + 3);
+		}
+		chunks = MeshSplitter::Split(vertices.data(), count, exact.data(), uint32_t(exact.size()));
+		check(chunks.size() == 1 && chunks[0].sourceVertices.size() == 65535, "65,535 vertices fit one chunk");
+		uint32_t extra[3] = { 0, 65534, 65535 };
+		exact.insert(exact.end(), extra, extra + 3);
+		chunks = MeshSplitter::Split(vertices.data(), count, exact.data(), uint32_t(exact.size()));
+		check(chunks.size() == 2 && chunks[1].sourceVertices.size() == 3 && Reassembles(chunks, &vertices, exact, 65535, UINT32_MAX),
+			"65,536 vertices need a second chunk");
+
+		// 空のメッシュはチャンクを作らない
+		check(MeshSplitter::Split(vertices.data(), count, nullptr, 0).empty(), "empty mesh has no chunks");
+
+		// 不正な入力は例外を投げる
+		bool thrown = false;
+		uint32_t outside[3] = { 0, 1, count };
+		try { MeshSplitter::Split(vertices.data(), count, outside, 3); } catch (const std::out_of_range&) { thrown = true; }
+		check(thrown, "index out of range throws");
+		thrown = false;
+		try { MeshSplitter::Split(vertices.data(), count, indices.data(), 4); } catch (const std::invalid_argument&) { thrown = true; }
+		check(thrown, "incomplete triangle throws");
+		thrown = false;
+		try { MeshSplitter::Split(vertices.data(), count, indices.data(), 3, 0x10000); } catch (const std::invalid_argument&) { thrown = true; }
+		check(thrown, "chunk limit above 65,535 throws");
+	}
+	catch (const std::exception& exception)
+	{
+		std::cout << "error: " << exception.what() << std::endl;
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
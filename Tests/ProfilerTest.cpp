@@ -0,0 +1,145 @@
+﻿// ProfilerTest.cpp - フレーム時間の百分位数と、プロファイラの記録・上書き・書き出しを検証する
+
+#include <atomic>
+#include <math.h>
+#include <sstream>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include "Profiler.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// トレースを書き出す
+	std::string WriteTrace(Profiler& profiler)
+	{
+		std::ostringstream stream;
+		profiler.WriteChromeTrace(stream);
+		return stream.str();
+	}
+
+	// トレースに含まれる指定された名前の区間の数を数える
+	size_t CountEvents(const std::string& trace, const std::string& name)
+	{
+		std::string key = "{\"name\":\"" + name + "\",\"cat\":\"cpu\",\"ph\":\"X\"";
+		size_t count = 0;
+		for (size_t position = trace.find(key); position != std::string::npos; position = trace.find(key, position + key.size()))
+			count++;
+		return count;
+	}
+
+	// トレースの区間の長さが名前ごとに決めたカウント数と一致するか(書き出し中に上書きされた区間が混ざっていないか)
+	bool DurationsMatch(const std::string& trace, double microsecondsPerCount, size_t& checked)
+	{
+		const std::string key = "\"ph\":\"X\"";
+		for (size_t position = trace.find(key); position != std::string::npos; position = trace.find(key, position + key.size()))
+		{
+			size_t name = trace.rfind("{\"name\":\"", position);
+			size_t duration = trace.find("\"dur\":", position);
+			char letter = trace[name + 9];
+			long counts = lround(atof(trace.c_str() + duration + 6) / microsecondsPerCount);
+			if ((letter == 'A' && counts != 3000) || (letter == 'B' && counts != 7000))
+				return false;
+			checked++;
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		// 百分位数は区間の上端を返し、最後の区間は実際の最大値を返す
+		FrameTimeHistogram histogram;
+		for (int i = 1; i <= 100; i++)
+			histogram.Add(i / 1000.0);
+		check(histogram.GetCount() == 100, "histogram counts frames");
+		check(fabs(histogram.GetPercentile(50.0) - 0.0501) < 1e-6 && fabs(histogram.GetPercentile(99.0) - 0.0990) < 1e-6, "percentiles use bucket upper bounds");
+		histogram.Clear();
+		for (int i = 0; i < 1000; i++)
+			histogram.Add(i % 100 == 0 ? 0.25 : 0.0166);
+		check(histogram.GetCount() == FrameTimeHistogram::WINDOW_SIZE, "histogram keeps the recent window");
+		check(fabs(histogram.GetPercentile(50.0) - 0.0166) < 1e-4 && fabs(histogram.GetPercentile(99.9) - 0.25) < 1e-6, "overflow bucket reports the maximum");
+
+		// 無効な間は記録しない
+		Profiler& profiler = Profiler::Get();
+		profiler.SetThreadName("Main");
+		profiler.SetEnabled(false);
+		{
+			PROFILE_SCOPE("Disabled");
+		}
+		check(CountEvents(WriteTrace(profiler), "Disabled") == 0, "disabled scopes are not recorded");
+
+		// 有効な間は入れ子の区間を記録し、スレッド名はエスケープして書き出す
+		profiler.SetEnabled(true);
+		{
+			PROFILE_SCOPE("Outer");
+			for (int i = 0; i < 3; i++)
+			{
+				PROFILE_SCOPE("Inner");
+			}
+		}
+		std::thread worker([&]()
+		{
+			profiler.SetThreadName("Worker \"1\"");
+			PROFILE_SCOPE("Work");
+		});
+		worker.join();
+		std::string trace = WriteTrace(profiler);
+		check(CountEvents(trace, "Outer") == 1 && CountEvents(trace, "Inner") == 3, "enabled scopes are recorded");
+		check(CountEvents(trace, "Work") == 1 && trace.find("\"args\":{\"name\":\"Worker \\\"1\\\"\"}") != std::string::npos, "thread names are escaped");
+		check(trace.compare(0, 2, "{\"") == 0 && trace.rfind("]}") == trace.size() - 3, "trace is a JSON object");
+
+		// 破棄した区間は書き出さない
+		profiler.Clear();
+		check(CountEvents(WriteTrace(profiler), "Outer") == 0, "clear discards events");
+
+		// リングバッファは古い区間から上書きする
+		uint64_t base = profiler.GetCounter();
+		for (uint32_t i = 0; i < Profiler::EVENT_CAPACITY + 100; i++)
+			profiler.Record("Ring", base, base + 1);
+		check(CountEvents(WriteTrace(profiler), "Ring") == Profiler::EVENT_CAPACITY, "ring keeps the newest events");
+		profiler.Clear();
+
+		// 記録中に書き出しても、上書き中の区間は混ざらない
+		double microsecondsPerCount = 1000000.0 / DX::GetDefaultClock().GetFrequency();
+		std::atomic<bool> stop(false);
+		std::atomic<bool> started(false);
+		std::thread writer([&]()
+		{
+			static const char* names[2] = { "A", "B" };
+			uint64_t start = profiler.GetCounter() + 10;
+			for (uint64_t i = 0; !stop; i++)
+			{
+				uint64_t begin = start + i * 2;
+				profiler.Record(names[i & 1], begin, begin + ((i & 1) ? 7000 : 3000));
+				started = true;
+			}
+		});
+		while (!started)
+			std::this_thread::yield();
+		bool consistent = true;
+		size_t checked = 0;
+		for (int repeat = 0; repeat < 20; repeat++)
+			consistent = DurationsMatch(WriteTrace(profiler), microsecondsPerCount, checked) && consistent;
+		stop = true;
+		writer.join();
+		check(consistent && checked > 0, "concurrent export skips torn events");
+
+		// フレームの区切りはフレーム時間を分布に加える
+		profiler.MarkFrame();
+		size_t frames = profiler.GetFrameTimes().GetCount();
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		double frameSeconds = profiler.MarkFrame();
+		check(frameSeconds >= 0.002 && profiler.GetFrameTimes().GetCount() == frames + 1, "mark frame measures the frame time");
+		profiler.SetEnabled(false);
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
@@ -0,0 +1,133 @@
+﻿// RenderQueueTest.cpp - 描画キューのソートキー、ソート、コマンド作成とインスタンス描画のまとめ方を検証する
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "RenderQueue.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// 描画項目数
+	const size_t COUNT = 10000;
+
+	// ソートキーの深度フィールドを取り出す
+	uint32_t KeyDepth(uint64_t key)
+	{
+		return uint32_t(key >> RenderQueue::MESH_BITS) & ((1u << RenderQueue::DEPTH_BITS) - 1);
+	}
+}
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		// ソートキーの深度は切り詰められ、NaNは0になる
+		const uint32_t maxDepth = (1u << RenderQueue::DEPTH_BITS) - 1;
+		float nan = std::numeric_limits<float>::quiet_NaN();
+		check(KeyDepth(RenderQueue::MakeKey(0, 0, 0, nan, 0)) == 0, "NaN depth quantizes to 0");
+		check(KeyDepth(RenderQueue::MakeKey(0, 0, 0, -1.0f, 0)) == 0, "negative depth clamps to 0");
+		check(KeyDepth(RenderQueue::MakeKey(0, 0, 0, 2.0f, 0)) == maxDepth, "depth above 1 clamps to the maximum");
+		check(KeyDepth(RenderQueue::MakeKey(0, 0, 0, std::numeric_limits<float>::infinity(), 0)) == maxDepth, "infinite depth clamps");
+		check(RenderQueue::MakeKey(0, 0, 0, 0.25f, 0) < RenderQueue::MakeKey(0, 0, 0, 0.5f, 0), "depth orders the key");
+		const uint32_t maxMesh = (1u << RenderQueue::MESH_BITS) - 1;
+		check(RenderQueue::MakeKey(0, 1, 0, 0.0f, 0) > RenderQueue::MakeKey(0, 0, 4095, 1.0f, maxMesh), "shader outranks material, depth and mesh");
+		check(RenderQueue::MakeKey(1, 0, 0, 0.0f, 0) > RenderQueue::MakeKey(0, 255, 4095, 1.0f, maxMesh), "pass outranks everything");
+
+		// 範囲外の番号は例外になる
+		const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+		RenderQueue queue;
+		bool threw = false;
+		try
+		{
+			queue.Submit(0, 1u << RenderQueue::SHADER_BITS, 0, 0, 0.0f, identity);
+		}
+		catch (const std::out_of_range&)
+		{
+			threw = true;
+		}
+		check(threw && queue.GetItemCount() == 0, "shader id past the key field throws");
+		// 詳細度を含めたメッシュの番号は16ビットを超えてもよい
+		queue.Submit(0, 0, 0, 1u << 16, 0.0f, identity);
+		check(queue.GetItemCount() == 1 && (RenderQueue::MakeKey(0, 0, 0, 0.0f, 1u << 16) & maxMesh) == 1u << 16, "mesh ids past 16 bits fit in the key");
+		queue.Clear();
+
+		// 無作為な描画項目(NaNの深度を含む)
+		std::mt19937 random(1);
+		std::uniform_int_distribution<uint32_t> pass(0, 2), shader(0, 7), material(0, 31), mesh(0, 63);
+		std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+		std::vector<float> worlds(COUNT * 16);
+		std::set<std::pair<uint32_t, uint32_t>> passShaders;
+		for (size_t i = 0; i < COUNT; i++)
+		{
+			uint32_t p = pass(random), s = shader(random);
+			passShaders.insert({ p, s });
+			queue.Submit(p, s, material(random), mesh(random), i % 97 == 0 ? nan : depth(random), &worlds[i * 16]);
+		}
+
+		RenderCommandList commandList;
+		RecordingRenderBackend backend;
+		queue.Record(commandList);
+		commandList.Execute(backend);
+		RenderStatistics unsorted = backend.GetStatistics();
+
+		queue.Sort();
+		const RenderItem* items = queue.GetItems();
+		bool ascending = true, stable = true;
+		std::vector<const float*> submitted;
+		for (size_t i = 0; i < queue.GetItemCount(); i++)
+		{
+			submitted.push_back(items[i].world);
+			if (i > 0)
+			{
+				ascending = ascending && items[i - 1].key <= items[i].key;
+				stable = stable && (items[i - 1].key != items[i].key || items[i - 1].world < items[i].world);
+			}
+		}
+		std::sort(submitted.begin(), submitted.end());
+		bool complete = queue.GetItemCount() == COUNT;
+		for (size_t i = 0; complete && i < COUNT; i++)
+			complete = submitted[i] == &worlds[i * 16];
+		check(ascending, "sorted keys ascend");
+		check(stable, "equal keys keep submission order");
+		check(complete, "sorting keeps every item");
+
+		commandList.Clear();
+		backend.Reset();
+		queue.Record(commandList);
+		commandList.Execute(backend);
+		const RenderStatistics& sorted = backend.GetStatistics();
+		check(sorted.draws == COUNT && unsorted.draws == COUNT, "one draw per item");
+		check(sorted.passChanges == 3, "each pass starts once");
+		check(sorted.shaderChanges == passShaders.size(), "each pass and shader pair is set once");
+		check(sorted.materialChanges < unsorted.materialChanges && sorted.meshChanges < unsorted.meshChanges, "sorting removes state changes");
+
+		// 同じ状態のインスタンス描画は1回にまとめられる
+		RenderQueue instances;
+		const float red[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+		for (int i = 0; i < 5; i++)
+			instances.SubmitInstance(0, 1, 2, 3, identity, red);
+		instances.SubmitInstance(0, 1, 2, 4, identity);
+		instances.Submit(0, 1, 2, 4, 0.5f, identity);
+		instances.Sort();
+		commandList.Clear();
+		backend.Reset();
+		instances.Record(commandList);
+		commandList.Execute(backend);
+		check(backend.GetStatistics().draws == 3 && backend.GetStatistics().instances == 6, "instances batch by state");
+		const std::vector<InstanceData>& data = commandList.GetInstances();
+		check(data.size() == 6 && data[0].color[0] == 1.0f && data[0].color[1] == 0.0f && data[5].color[1] == 1.0f, "instance colors, white by default");
+		check(data[0].world[0] == 1.0f && data[0].world[3] == 0.0f && data[0].world[5] == 1.0f, "instance world is the transposed top rows");
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
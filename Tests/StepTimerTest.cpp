@@ -0,0 +1,116 @@
+﻿// StepTimerTest.cpp - 仮想クロックでStepTimerのフレームレイト上限、固定時間ステップ、追いつきの上限を検証する
+
+#include <math.h>
+#include <stdexcept>
+#include <stdint.h>
+#include "FrameClock.h"
+#include "StepTimer.h"
+#include "TestCheck.h"
+
+namespace
+{
+	// 60fpsの1フレームのテック数
+	const uint64_t STEP = DX::StepTimer::TicksPerSecond / 60;
+}
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		// フレームレイト上限では次のフレームの時刻まで待つ
+		{
+			DX::VirtualClock clock;
+			DX::StepTimer timer(clock);
+			timer.SetFrameRateLimit(60.0);
+			timer.Tick([]() {});
+			bool paced = true;
+			for (int n = 0; n < 10; n++)
+			{
+				timer.Tick([]() {});
+				paced = paced && timer.GetElapsedTicks() == STEP;
+			}
+			check(paced && clock.GetCounter() == 10 * STEP, "frame rate limit waits one interval per tick");
+
+			// 1フレーム以上遅れた場合は取り戻さず、経過時間は1/10秒に切り詰める
+			clock.AdvanceSeconds(1.0);
+			timer.Tick([]() {});
+			check(timer.GetElapsedTicks() == DX::StepTimer::TicksPerSecond / 10, "long stall is clamped");
+			timer.Tick([]() {});
+			check(timer.GetElapsedTicks() == STEP, "pacing restarts from the late frame");
+		}
+
+		// 固定時間ステップは端数を次のTickに持ち越す
+		{
+			DX::VirtualClock clock;
+			DX::StepTimer timer(clock);
+			timer.SetFixedTimeStep(true);
+			timer.SetTargetElapsedTicks(STEP);
+			int updates = 0;
+
+			// 目標との差が1/4ミリ秒未満なら目標の時間に丸める
+			clock.Advance(STEP + 1000);
+			timer.Tick([&]() { updates++; });
+			check(updates == 1 && timer.GetInterpolationAlpha() == 0.0, "small drift snaps to the target");
+
+			updates = 0;
+			clock.Advance(STEP * 2 + STEP / 2);
+			timer.Tick([&]() { updates++; });
+			check(updates == 2 && timer.GetFrameCount() == 3 && fabs(timer.GetInterpolationAlpha() - 0.5) < 1e-5, "fixed step keeps the remainder");
+
+			// 経過時間のリセットは持ち越した端数を捨てる
+			timer.ResetElapsedTime();
+			clock.Advance(STEP * 3 / 5);
+			check(!timer.Tick([]() {}), "reset drops the carried remainder");
+		}
+
+		// 追いつきの上限を超えた更新は捨て、更新が実時間より遅ければ上限を下げる
+		{
+			DX::VirtualClock clock;
+			DX::StepTimer timer(clock);
+			timer.SetFixedTimeStep(true);
+			timer.SetTargetElapsedTicks(STEP);
+			timer.SetMaxUpdatesPerTick(2);
+			int updates = 0;
+			clock.Advance(STEP * 6);
+			timer.Tick([&]() { updates++; });
+			check(updates == 2 && timer.GetDroppedUpdates() == 4, "updates past the catch-up limit are dropped");
+
+			DX::VirtualClock slowClock;
+			DX::StepTimer slowTimer(slowClock);
+			slowTimer.SetFixedTimeStep(true);
+			slowTimer.SetTargetElapsedTicks(STEP);
+			slowTimer.SetMaxUpdatesPerTick(4);
+			slowClock.Advance(STEP * 3);
+			slowTimer.Tick([&]() { slowClock.Advance(STEP * 2); });
+			check(slowTimer.GetCatchUpLimit() == 2, "slow updates halve the catch-up limit");
+		}
+
+		// 高い周波数の大きなカウンタ値でもテックへの変換はオーバーフローしない
+		{
+			DX::VirtualClock clock(3000000000ull);
+			DX::StepTimer timer(clock);
+			uint64_t counter = 1ull << 62;
+			double expected = double(counter) / 3000000000.0 * double(DX::StepTimer::TicksPerSecond);
+			check(fabs(double(timer.CounterToTicks(counter)) - expected) < expected * 1e-12, "counter conversion does not overflow");
+		}
+
+		// 周波数0のクロックは例外になる
+		bool threw = false;
+		try
+		{
+			DX::VirtualClock clock(0);
+			DX::StepTimer timer(clock);
+		}
+		catch (const std::runtime_error&)
+		{
+			threw = true;
+		}
+		check(threw, "zero frequency throws");
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}
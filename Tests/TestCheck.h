@@ -0,0 +1,46 @@
+﻿#pragma once
+#ifndef TESTCHECK_DEFINED
+#define TESTCHECK_DEFINED
+
+#include <iostream>
+
+// 自己診断のテストで条件を確認し、失敗した数を数えるクラス
+// check(条件, "説明")の形で呼び出し、最後にFinishの戻り値をmainから返す
+class TestCheck
+{
+public:
+	// コンストラクタ
+	TestCheck() : m_failures(0)
+	{
+	}
+
+	// 条件を確認する(成り立たない場合は説明を表示して失敗を数える)
+	bool operator()(bool condition, const char* description)
+	{
+		if (!condition)
+		{
+			std::cout << "FAILED  " << description << std::endl;
+			m_failures++;
+		}
+		return condition;
+	}
+
+	// 失敗した数を取得する
+	int GetFailures() const
+	{
+		return m_failures;
+	}
+
+	// 結果を表示し、プロセスの終了コードを返す
+	int Finish() const
+	{
+		std::cout << (m_failures == 0 ? "all checks passed" : "checks failed") << std::endl;
+		return m_failures == 0 ? 0 : 1;
+	}
+
+private:
+	// 失敗した数
+	int m_failures;
+};
+
+#endif	// TESTCHECK_DEFINED
@@ -0,0 +1,162 @@
+﻿// TransformKernelTest.cpp - 変換カーネルの結果が参照の計算と一致し、どの命令セットでもビット単位で同じになることを検証する
+
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "MeshData.h"
+#include "TestCheck.h"
+#include "TransformKernel.h"
+
+namespace
+{
+	// 要素数(SIMDの幅で割り切れない端数を含む)
+	const size_t COUNT = 1003;
+
+	// 命令セットごとの結果
+	struct KernelResults
+	{
+		std::vector<float> matrices;
+		std::vector<MeshVertex> points;
+		std::vector<MeshVertex> inPlace;
+		std::vector<MeshVertex> controlPoints;
+		std::vector<float> instances;
+	};
+
+	// 行列の積を倍精度で計算する(行ベクトル規約、result = a * b)
+	void ReferenceMultiply(const float* a, const float* b, double* result)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+			{
+				double sum = 0.0;
+				for (int k = 0; k < 4; k++)
+					sum += double(a[row * 4 + k]) * double(b[k * 4 + column]);
+				result[row * 4 + column] = sum;
+			}
+		}
+	}
+
+	// 相対誤差の範囲内で等しいか
+	bool Near(double value, double expected)
+	{
+		return fabs(value - expected) <= 1e-4 * std::max(1.0, fabs(expected));
+	}
+}
+
+int main()
+{
+	TestCheck check;
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> uniform(-10.0f, 10.0f);
+	float matrix[16];
+	double controlMatrix[16];
+	for (int i = 0; i < 16; i++)
+	{
+		matrix[i] = uniform(random);
+		controlMatrix[i] = double(matrix[i]) * 0.5;
+	}
+	std::vector<float> matrices(COUNT * 16);
+	for (float& value : matrices)
+		value = uniform(random);
+	std::vector<MeshVertex> points(COUNT);
+	for (MeshVertex& vertex : points)
+	{
+		for (float& value : vertex.position)
+			value = uniform(random);
+		for (float& value : vertex.color)
+			value = 7.0f;
+	}
+	std::vector<double> controlPoints(COUNT * 4);
+	for (double& value : controlPoints)
+		value = double(uniform(random));
+	std::vector<float> colors(COUNT * 4);
+	for (float& value : colors)
+		value = uniform(random);
+	std::vector<const float*> worldPointers(COUNT), colorPointers(COUNT);
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		worldPointers[i] = &matrices[i * 16];
+		colorPointers[i] = &colors[i * 4];
+	}
+
+	// 対応しているすべての命令セットで計算する
+	TransformKernel::InstructionSet supported = TransformKernel::GetSupportedInstructionSet();
+	std::vector<KernelResults> results(supported + 1);
+	for (int set = TransformKernel::SCALAR; set <= supported; set++)
+	{
+		TransformKernel::SetInstructionSet(TransformKernel::InstructionSet(set));
+		check(TransformKernel::GetInstructionSet() == set, "instruction set can be selected");
+		KernelResults& result = results[set];
+		result.matrices.resize(COUNT * 16);
+		TransformKernel::MultiplyMatrices(result.matrices.data(), matrices.data(), matrix, COUNT);
+		result.points = points;
+		TransformKernel::TransformPoints(result.points[0].position, sizeof(MeshVertex), points[0].position, sizeof(MeshVertex), COUNT, matrix);
+		result.inPlace = points;
+		TransformKernel::TransformPoints(result.inPlace[0].position, sizeof(MeshVertex), result.inPlace[0].position, sizeof(MeshVertex), COUNT, matrix);
+		result.controlPoints = points;
+		TransformKernel::ConvertControlPoints(result.controlPoints[0].position, sizeof(MeshVertex), controlPoints.data(), COUNT, controlMatrix);
+		result.instances.resize(COUNT * 16);
+		TransformKernel::PackInstances(result.instances.data(), worldPointers.data(), colorPointers.data(), sizeof(const float*), COUNT);
+	}
+	TransformKernel::SetInstructionSet(supported);
+
+	// スカラー版は参照の計算と一致する
+	const KernelResults& scalar = results[TransformKernel::SCALAR];
+	bool matricesMatch = true, pointsMatch = true, controlMatch = true, instancesMatch = true, colorsKept = true;
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		double expected[16];
+		ReferenceMultiply(&matrices[i * 16], matrix, expected);
+		for (int k = 0; k < 16; k++)
+			matricesMatch = matricesMatch && Near(scalar.matrices[i * 16 + k], expected[k]);
+
+		const float* p = points[i].position;
+		const double* c = &controlPoints[i * 4];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			double point = double(p[0]) * matrix[axis] + double(p[1]) * matrix[4 + axis] + double(p[2]) * matrix[8 + axis] + matrix[12 + axis];
+			pointsMatch = pointsMatch && Near(scalar.points[i].position[axis], point);
+			double control = c[0] * controlMatrix[axis] + c[1] * controlMatrix[4 + axis] + c[2] * controlMatrix[8 + axis] + controlMatrix[12 + axis];
+			controlMatch = controlMatch && scalar.controlPoints[i].position[axis] == float(control);
+		}
+		colorsKept = colorsKept && scalar.points[i].color[0] == 7.0f && scalar.controlPoints[i].color[3] == 7.0f;
+
+		// インスタンスデータは転置したワールド行列の上3行と色
+		const float* instance = &scalar.instances[i * 16];
+		for (int row = 0; row < 3; row++)
+		{
+			for (int column = 0; column < 4; column++)
+				instancesMatch = instancesMatch && instance[row * 4 + column] == matrices[i * 16 + column * 4 + row];
+		}
+		instancesMatch = instancesMatch && memcmp(instance + 12, &colors[i * 4], 4 * sizeof(float)) == 0;
+	}
+	check(matricesMatch, "scalar matrices match the reference");
+	check(pointsMatch, "scalar points match the reference");
+	check(controlMatch, "scalar control points match the double-precision reference");
+	check(instancesMatch, "scalar instances hold the transposed world and color");
+	check(colorsKept, "strided output leaves the other members untouched");
+	check(memcmp(scalar.inPlace.data(), scalar.points.data(), COUNT * sizeof(MeshVertex)) == 0, "in-place transform matches");
+
+	// SIMD版はスカラー版とビット単位で一致する
+	for (int set = TransformKernel::SCALAR + 1; set <= supported; set++)
+	{
+		const KernelResults& result = results[set];
+		std::string name = TransformKernel::GetInstructionSetName(TransformKernel::InstructionSet(set));
+		check(result.matrices == scalar.matrices, (name + " matrices are bit-identical").c_str());
+		check(memcmp(result.points.data(), scalar.points.data(), COUNT * sizeof(MeshVertex)) == 0, (name + " points are bit-identical").c_str());
+		check(memcmp(result.inPlace.data(), scalar.inPlace.data(), COUNT * sizeof(MeshVertex)) == 0, (name + " in-place points are bit-identical").c_str());
+		check(memcmp(result.controlPoints.data(), scalar.controlPoints.data(), COUNT * sizeof(MeshVertex)) == 0, (name + " control points are bit-identical").c_str());
+		check(result.instances == scalar.instances, (name + " instances are bit-identical").c_str());
+	}
+
+	// 要素数0は何も書き込まない
+	float untouched = 3.0f;
+	TransformKernel::MultiplyMatrices(&untouched, matrices.data(), matrix, 0);
+	check(untouched == 3.0f, "empty batch writes nothing");
+	return check.Finish();
+}
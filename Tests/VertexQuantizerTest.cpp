@@ -0,0 +1,221 @@
+﻿// VertexQuantizerTest.cpp - 頂点の量子化を検証する(位置と色の誤差、復号行列、八面体符号化の角度の誤差、半精度浮動小数点数の丸め、メッシュファイルへの保存、頂点を渡さない分割)
+
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "MeshFile.h"
+#include "MeshSplitter.h"
+#include "VertexQuantizer.h"
+#include "TestCheck.h"
+
+int main()
+{
+	TestCheck check;
+	try
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		// 位置は境界ボックスの大きさの1/65535の半分、色は1/255の半分まで戻る(最初と最後の頂点は境界ボックスの角)
+		const MeshBounds bounds = { { -3.0f, 0.5f, -100.0f }, { 5.0f, 0.75f, 100.0f } };
+		std::vector<MeshVertex> vertices(4096);
+		for (MeshVertex& vertex : vertices)
+		{
+			for (int axis = 0; axis < 3; axis++)
+				vertex.position[axis] = bounds.minimum[axis] + (bounds.maximum[axis] - bounds.minimum[axis]) * unit(random);
+			for (int channel = 0; channel < 4; channel++)
+				vertex.color[channel] = unit(random);
+		}
+		vertices.front() = { { bounds.minimum[0], bounds.minimum[1], bounds.minimum[2] }, { 0.0f, 0.0f, 0.0f, 0.0f } };
+		vertices.back() = { { bounds.maximum[0], bounds.maximum[1], bounds.maximum[2] }, { 1.0f, 1.0f, 1.0f, 1.0f } };
+		std::vector<QuantizedVertex> quantized(vertices.size());
+		std::vector<MeshVertex> decoded(vertices.size());
+		VertexQuantizer::Quantize(quantized.data(), vertices.data(), vertices.size(), bounds);
+		VertexQuantizer::Dequantize(decoded.data(), quantized.data(), quantized.size(), bounds);
+		bool positionsClose = true, colorsClose = true, wOne = true;
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float extent = bounds.maximum[axis] - bounds.minimum[axis];
+				float error = fabsf(decoded[i].position[axis] - vertices[i].position[axis]);
+				positionsClose = positionsClose && error <= extent * (0.5f / float(VertexQuantizer::POSITION_STEPS) + 1.0e-6f);
+			}
+			for (int channel = 0; channel < 4; channel++)
+				colorsClose = colorsClose && fabsf(decoded[i].color[channel] - vertices[i].color[channel]) <= 0.5f / 255.0f + 1.0e-6f;
+			wOne = wOne && quantized[i].position[3] == 0xFFFF;
+		}
+		check(positionsClose, "positions within half a quantization step");
+		check(colorsClose, "colors within half a quantization step");
+		check(wOne, "quantized w is one");
+		check(memcmp(decoded.front().position, bounds.minimum, sizeof(bounds.minimum)) == 0 &&
+			memcmp(decoded.back().position, bounds.maximum, sizeof(bounds.maximum)) == 0, "bounds corners are exact");
+		check(decoded.front().color[0] == 0.0f && decoded.back().color[3] == 1.0f, "color extremes are exact");
+
+		// 境界ボックスの外の位置は境界に丸め、厚みの無い軸は最小値に戻る
+		const MeshBounds flat = { { 0.0f, 2.0f, 0.0f }, { 1.0f, 2.0f, 1.0f } };
+		const MeshVertex outside[2] = { { { -1.0f, 2.0f, 0.5f }, { -1.0f, 2.0f, 0.5f, 1.0f } }, { { 2.0f, 2.0f, 0.5f }, { 0.0f, 0.0f, 0.0f, 0.0f } } };
+		QuantizedVertex clamped[2];
+		MeshVertex flatDecoded[2];
+		VertexQuantizer::Quantize(clamped, outside, 2, flat);
+		VertexQuantizer::Dequantize(flatDecoded, clamped, 2, flat);
+		check(clamped[0].position[0] == 0 && clamped[1].position[0] == 0xFFFF, "positions outside the bounds are clamped");
+		check(clamped[0].color[0] == 0 && clamped[0].color[1] == 0xFF, "colors outside 0-1 are clamped");
+		check(clamped[0].position[1] == 0 && flatDecoded[0].position[1] == 2.0f, "flat axis decodes to the minimum");
+
+		// 復号行列を正規化した位置に掛けるとDequantizeと同じ位置になる
+		float decode[16];
+		VertexQuantizer::GetDecodeMatrix(bounds, decode);
+		bool matrixMatches = true;
+		for (size_t i = 0; i < quantized.size(); i++)
+		{
+			float normalized[4];
+			for (int axis = 0; axis < 4; axis++)
+				normalized[axis] = float(quantized[i].position[axis]) / float(VertexQuantizer::POSITION_STEPS);
+			for (int axis = 0; axis < 4; axis++)
+			{
+				float value = normalized[0] * decode[axis] + normalized[1] * decode[4 + axis] + normalized[2] * decode[8 + axis] + normalized[3] * decode[12 + axis];
+				float expected = axis < 3 ? decoded[i].position[axis] : 1.0f;
+				matrixMatches = matrixMatches && fabsf(value - expected) <= 1.0e-5f * (fabsf(expected) + 1.0f);
+			}
+		}
+		check(matrixMatches, "decode matrix matches dequantize");
+
+		// 八面体符号化は全方向で角度の誤差が小さく、軸方向は正確に戻る
+		std::normal_distribution<float> gaussian;
+		float maxAngle = 0.0f;
+		bool unitLength = true;
+		for (int i = 0; i < 100000 + 26; i++)
+		{
+			float normal[3];
+			if (i < 26)
+			{
+				// 軸と辺と頂点の方向
+				int code = i < 13 ? i : i + 1;
+				normal[0] = float(code % 3) - 1.0f;
+				normal[1] = float(code / 3 % 3) - 1.0f;
+				normal[2] = float(code / 9) - 1.0f;
+			}
+			else
+			{
+				normal[0] = gaussian(random);
+				normal[1] = gaussian(random);
+				normal[2] = gaussian(random);
+			}
+			float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			for (int axis = 0; axis < 3; axis++)
+				normal[axis] /= length;
+			int16_t encoded[2];
+			float result[3];
+			VertexQuantizer::EncodeOctahedral(normal, encoded);
+			VertexQuantizer::DecodeOctahedral(encoded, result);
+			// 1に近い内積のacosは精度が落ちるので、外積の大きさとの比から角度を求める
+			float dot = normal[0] * result[0] + normal[1] * result[1] + normal[2] * result[2];
+			float cross[3] = { normal[1] * result[2] - normal[2] * result[1], normal[2] * result[0] - normal[0] * result[2], normal[0] * result[1] - normal[1] * result[0] };
+			maxAngle = std::max(maxAngle, atan2f(sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]), dot));
+			unitLength = unitLength && fabsf(result[0] * result[0] + result[1] * result[1] + result[2] * result[2] - 1.0f) <= 1.0e-5f;
+		}
+		std::cout << "octahedral max angle error " << maxAngle << " rad" << std::endl;
+		check(maxAngle <= 1.0e-4f, "octahedral angle error within 1e-4 rad");
+		check(unitLength, "octahedral decode is unit length");
+		const float down[3] = { 0.0f, 0.0f, -1.0f };
+		int16_t downEncoded[2];
+		float downDecoded[3];
+		VertexQuantizer::EncodeOctahedral(down, downEncoded);
+		VertexQuantizer::DecodeOctahedral(downEncoded, downDecoded);
+		check(downDecoded[0] == 0.0f && downDecoded[1] == 0.0f && downDecoded[2] == -1.0f, "negative z axis is exact");
+
+		// 半精度はNaN以外のすべての値が同じビット列に戻り、正規化数の範囲の相対誤差は2^-11以内になる
+		bool halfRoundTrip = true;
+		for (uint32_t bits = 0; bits <= 0xFFFF; bits++)
+		{
+			uint16_t half = uint16_t(bits);
+			uint16_t result = VertexQuantizer::FloatToHalf(VertexQuantizer::HalfToFloat(half));
+			bool nan = (half & 0x7C00) == 0x7C00 && (half & 0x03FF) != 0;
+			halfRoundTrip = halfRoundTrip && (nan ? (result & 0x7C00) == 0x7C00 && (result & 0x03FF) != 0 && (result & 0x8000) == (half & 0x8000) : result == half);
+		}
+		check(halfRoundTrip, "every half value round trips");
+		bool halfClose = true;
+		for (int i = 0; i < 100000; i++)
+		{
+			float value = ldexpf(1.0f + unit(random), int(random() % 30) - 14);
+			value = std::min(value, 65504.0f);
+			float result = VertexQuantizer::HalfToFloat(VertexQuantizer::FloatToHalf(value));
+			halfClose = halfClose && fabsf(result - value) <= value * ldexpf(1.0f, -11);
+		}
+		check(halfClose, "half relative error within 2^-11");
+		check(VertexQuantizer::FloatToHalf(1.0f) == 0x3C00 && VertexQuantizer::FloatToHalf(-2.0f) == 0xC000 &&
+			VertexQuantizer::FloatToHalf(-0.0f) == 0x8000, "half exact values");
+		check(VertexQuantizer::FloatToHalf(1.0f + ldexpf(1.0f, -11)) == 0x3C00 &&
+			VertexQuantizer::FloatToHalf(1.0f + 3.0f * ldexpf(1.0f, -11)) == 0x3C02, "half ties round to even");
+		check(VertexQuantizer::FloatToHalf(65504.0f) == 0x7BFF && VertexQuantizer::FloatToHalf(65519.0f) == 0x7BFF &&
+			VertexQuantizer::FloatToHalf(65520.0f) == 0x7C00 && VertexQuantizer::FloatToHalf(-1.0e10f) == 0xFC00, "half overflow becomes infinity");
+		check(VertexQuantizer::FloatToHalf(ldexpf(1.0f, -24)) == 0x0001 && VertexQuantizer::FloatToHalf(ldexpf(1.0f, -25)) == 0x0000 &&
+			VertexQuantizer::FloatToHalf(ldexpf(1.5f, -25)) == 0x0001 && VertexQuantizer::FloatToHalf(ldexpf(1.0f, -14) - ldexpf(1.0f, -25)) == 0x0400,
+			"half subnormals round to nearest even");
+		check(VertexQuantizer::FloatToHalf(INFINITY) == 0x7C00 && VertexQuantizer::FloatToHalf(-INFINITY) == 0xFC00 &&
+			isnan(VertexQuantizer::HalfToFloat(VertexQuantizer::FloatToHalf(NAN))), "half infinity and NaN");
+
+		// 量子化した頂点はメッシュファイルに書き出して読み戻せ、詳細度もメッシュの境界ボックスで量子化される
+		MeshData mesh;
+		mesh.name = "quantized";
+		mesh.vertices = vertices;
+		for (uint32_t i = 0; i + 2 < uint32_t(vertices.size()); i += 3)
+			mesh.indices.insert(mesh.indices.end(), { i, i + 1, i + 2 });
+		mesh.subMeshes.push_back({ 0, uint32_t(mesh.indices.size()), 0 });
+		mesh.materials.push_back("default");
+		mesh.bounds = bounds;
+		MeshLod lod;
+		lod.error = 0.5f;
+		lod.vertices.assign(vertices.begin() + 3, vertices.begin() + 9);
+		lod.indices = { 0, 1, 2, 3, 4, 5 };
+		lod.subMeshes.push_back({ 0, 6, 0 });
+		mesh.lods.push_back(lod);
+		const char* QUANTIZE_TEST_FILE = "VertexQuantizerTest.mesh";
+		MeshFile::Write(QUANTIZE_TEST_FILE, std::vector<MeshData>(1, mesh), MeshFile::VERTEX_FORMAT_QUANTIZED);
+		{
+			MeshFile file(QUANTIZE_TEST_FILE);
+			MeshView view = file.GetMesh(0);
+			check(view.vertexFormat == MeshFile::VERTEX_FORMAT_QUANTIZED && !view.vertices && view.quantizedVertices, "quantized format is stored");
+			check(view.vertexCount == quantized.size() &&
+				memcmp(view.quantizedVertices, quantized.data(), quantized.size() * sizeof(QuantizedVertex)) == 0, "quantized vertices round trip");
+			check(memcmp(view.indices, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t)) == 0, "indices round trip with quantized vertices");
+			QuantizedVertex lodQuantized[6];
+			VertexQuantizer::Quantize(lodQuantized, lod.vertices.data(), lod.vertices.size(), bounds);
+			MeshLodView lodView = file.GetLod(view, 0);
+			check(!lodView.vertices && lodView.quantizedVertices && lodView.vertexCount == 6 &&
+				memcmp(lodView.quantizedVertices, lodQuantized, sizeof(lodQuantized)) == 0, "levels are quantized with the mesh bounds");
+		}
+		MeshFile::Write(QUANTIZE_TEST_FILE, std::vector<MeshData>(1, mesh));
+		{
+			MeshFile file(QUANTIZE_TEST_FILE);
+			MeshView view = file.GetMesh(0);
+			check(view.vertexFormat == MeshFile::VERTEX_FORMAT_FLOAT && view.vertices && !view.quantizedVertices &&
+				!file.GetLod(view, 0).quantizedVertices, "float format is the default");
+		}
+		remove(QUANTIZE_TEST_FILE);
+
+		// 頂点を渡さずに分割しても、元の頂点番号から同じチャンクを組み立てられる
+		std::vector<MeshChunk> chunks = MeshSplitter::Split(mesh.vertices.data(), uint32_t(mesh.vertices.size()), mesh.indices.data(), uint32_t(mesh.indices.size()), 1000);
+		std::vector<MeshChunk> sourceChunks = MeshSplitter::Split(nullptr, uint32_t(mesh.vertices.size()), mesh.indices.data(), uint32_t(mesh.indices.size()), 1000);
+		bool sameChunks = chunks.size() == sourceChunks.size() && chunks.size() > 1;
+		for (size_t i = 0; sameChunks && i < chunks.size(); i++)
+		{
+			sameChunks = sourceChunks[i].vertices.empty() && chunks[i].indices == sourceChunks[i].indices &&
+				chunks[i].sourceVertices == sourceChunks[i].sourceVertices && chunks[i].vertices.size() == sourceChunks[i].sourceVertices.size();
+			for (size_t vertex = 0; sameChunks && vertex < chunks[i].vertices.size(); vertex++)
+				sameChunks = memcmp(&chunks[i].vertices[vertex], &mesh.vertices[sourceChunks[i].sourceVertices[vertex]], sizeof(MeshVertex)) == 0;
+		}
+		check(sameChunks, "chunks split without vertices record source vertices");
+	}
+	catch (...)
+	{
+		check(false, "unexpected exception");
+	}
+	return check.Finish();
+}